@@ -22,11 +22,110 @@
 #define RELEASE_DEBOUNCE_COUNT  3      // wymagana liczba kolejnych HIGH dla potwierdzenia
 #define WATER_TRIGGER_MAX_TIME  30    // max czas na reakcję czujników po starcie pompy (sekundy)
 
+// ============== ADAPTACJA HARMONOGRAMU FAZY 1 ==============
+// Parametry powyżej są wartościami startowymi. Profil (debounce_profile.cpp)
+// uczy się szumu instalacji i skaluje je w granicach bezpieczeństwa poniżej:
+// spokojny zbiornik -> MIN, domyślnie -> wartości powyżej, hałaśliwy -> MAX.
+#define ENABLE_ADAPTIVE_DEBOUNCE    true
+#define ADAPT_MIN_PROCESSES         5      // procesów zanim harmonogram zejdzie poniżej domyślnego
+
+#define PRE_QUAL_WINDOW_MIN         20
+#define PRE_QUAL_WINDOW_MAX         60
+#define PRE_QUAL_INTERVAL_MIN       5
+#define PRE_QUAL_INTERVAL_MAX       15
+#define PRE_QUAL_CONFIRM_COUNT_MIN  2
+#define PRE_QUAL_CONFIRM_COUNT_MAX  5
+#define SETTLING_TIME_MIN           30
+#define SETTLING_TIME_MAX           120
+#define TOTAL_DEBOUNCE_TIME_MIN     600
+#define TOTAL_DEBOUNCE_TIME_MAX     2400
+#define DEBOUNCE_INTERVAL_MIN       30
+#define DEBOUNCE_INTERVAL_MAX       120
+#define DEBOUNCE_COUNTER_MIN        2
+#define DEBOUNCE_COUNTER_MAX        10
+
+// ============== FILTR CZUJNIKÓW (oversampling) ==============
+// Próbkowanie w tle, głosowanie po oknie próbek z histerezą. Każdy pomiar
+// faz (pre-qual / debounce / release) czyta stan przefiltrowany zamiast
+// jednej próbki. Większość bez histerezy: LOW=51, HIGH=50.
+#define SENSOR_SAMPLE_PERIOD_US     1000   // µs - 1 kHz
+#define SENSOR_FILTER_WINDOW        256    // próbek w oknie (256 ms)
+#define SENSOR_FILTER_LOW_PERCENT   70     // % próbek LOW w oknie -> stan LOW
+#define SENSOR_FILTER_HIGH_PERCENT  30     // % próbek LOW w oknie -> stan HIGH
+
+// ============== GŁOSOWANIE CZUJNIKÓW (WATER_SENSOR_COUNT pływaków na kanał) ==============
+// Stany pływaków kanału to maska bitowa; polityka decyduje ile głosów
+// wystarcza: ANY = 1, MAJORITY = n/2+1, K_OF_N = SENSOR_VOTE_K (n = liczba
+// głosujących). Domyślnie ANY wszędzie - zachowanie jak dla dwóch pływaków.
+enum SensorVotePolicy : uint8_t {
+    SENSOR_VOTE_ANY = 0,
+    SENSOR_VOTE_MAJORITY,
+    SENSOR_VOTE_K_OF_N
+};
+
+#define SENSOR_TRIGGER_VOTE     SENSOR_VOTE_ANY    // Start procesu i pomiary PRE_QUAL (LOW)
+#define SENSOR_DEBOUNCE_VOTE    SENSOR_VOTE_ANY    // Zaliczone debounce przy timeout -> cykl z GAP1_FAIL
+#define SENSOR_RELEASE_VOTE     SENSOR_VOTE_ANY    // Potwierdzone release (spośród wymaganych) -> bez ERR_NO_WATER
+#define SENSOR_VOTE_K           2                  // Próg dla SENSOR_VOTE_K_OF_N
+
+// ============== KALIBRACJA PRZEPŁYWU (auto) ==============
+// Czas od startu pompy do podniesienia pływaka ~ objętość histerezy / przepływ.
+// Po ręcznym ustawieniu volumePerSecond pierwsze cykle wyznaczają objętość
+// odniesienia, kolejne - estymatę przepływu (Theil-Sen po oknie cykli).
+#define FLOW_CAL_WINDOW                 12     // cykli w oknie regresji
+#define FLOW_CAL_BASELINE_CYCLES        5      // cykli do wyznaczenia odniesienia
+#define FLOW_CAL_MIN_SAMPLES            6      // próbek przed oceną dryfu
+#define FLOW_DRIFT_THRESHOLD_PERCENT    10     // |dryf| powyżej -> flaga
+#define FLOW_AUTO_APPLY                 false  // true = korekta volumePerSecond bez operatora
+#define FLOW_AUTO_APPLY_MAX_STEP_PERCENT 20    // max zmiana przy jednej korekcie
+#define RELEASE_CONFIRM_LAG     ((RELEASE_DEBOUNCE_COUNT - 1) * RELEASE_CHECK_INTERVAL)  // s od pierwszego HIGH do potwierdzenia
+
 // ============== PARAMETRY POMPY ==============
 #define PUMP_MAX_ATTEMPTS       3      // Maksymalna liczba prób pompy
+// Przekaźnik zajęty przez źródło o wyższym priorytecie (arbiter odrzuca AUTO):
+// cykl czeka na przydział bez startu weryfikacji, po PUMP_GRANT_WAIT_MAX przerwany
+#define PUMP_GRANT_RETRY_INTERVAL   5      // s między ponowieniami żądania AUTO
+#define PUMP_GRANT_WAIT_MAX         300    // s - dłużej niż TTL kolejki arbitra (60 s)
 #define SINGLE_DOSE_VOLUME      200    // ml - objętość jednej dolewki
 #define FILL_WATER_MAX          2000   // ml - max dolewka na dobę
 
+// ============== DAWKA PROPORCJONALNA DO DEFICYTU ==============
+// Dawka = max(SINGLE_DOSE_VOLUME, ubytek od ostatniej dolewki, zapas na
+// release), ograniczona DOSE_MAX_VOLUME, limitem dziennym i
+// WATER_TRIGGER_MAX_TIME. false = stała dawka SINGLE_DOSE_VOLUME.
+#define ENABLE_DOSE_SIZING          true
+#define DOSE_MAX_VOLUME             600    // ml - górna granica jednej dawki
+#define DOSE_HISTORY_CYCLES         8      // dolewek do estymaty tempa ubytku
+#define DOSE_RELEASE_MARGIN_PERCENT 125    // dawka >= 125% objętości do release
+
+// ============== MODEL PAROWANIA ==============
+// Tempo ubytku [ml/h] dla każdej godziny doby (czas lokalny), EWMA z
+// przedziałów między dolewkami. Prognoza następnej dolewki i opróżnienia
+// zbiornika; przed spodziewaną dolewką control nie wchodzi w spoczynek.
+#define ENABLE_EVAPORATION_MODEL    true
+#define EVAP_EWMA_SHIFT             3      // alfa = 1/8 na pełną godzinę obserwacji
+#define EVAP_MAX_INTERVAL_HOURS     72     // dłuższa przerwa (wyłączenie) nie uczy
+#define EVAP_MIN_LEARNED_HOURS      18     // godzin doby z danymi przed użyciem modelu
+#define EVAP_PREWARM_MINUTES        30     // okno przed prognozą dolewki bez trybu spoczynku
+#define EVAP_FORECAST_MAX_DAYS      60     // horyzont prognozy opróżnienia
+
+// ============== DETEKCJA ANOMALII ==============
+// EWMA + dwustronny CUSUM na time_gap_1, water_trigger_time i tempie
+// ubytku (ml/h między dolewkami). Alarm = sygnał ERR4 bez STATE_ERROR -
+// dolewki działają dalej, operator potwierdza przyciskiem lub z API.
+#define ENABLE_ANOMALY_DETECTION    true
+#define ANOMALY_WARMUP_CYCLES       8      // próbek na wyznaczenie bazy
+#define ANOMALY_EWMA_SHIFT          5      // alfa bazy = 1/32 (wolniej niż CUSUM)
+#define ANOMALY_CUSUM_K             0.5f   // tolerancja [sigma] na próbkę
+#define ANOMALY_CUSUM_H             5.0f   // próg alarmu [sigma]
+
+// ============== CHECKPOINT CYKLU ==============
+// Kontekst cyklu w toku zapisywany w FRAM przy każdym przejściu stanu i
+// odtwarzany przy starcie. Faza 1 wznawiana tylko po krótkiej przerwie z
+// ważnym RTC - po dłuższej poziom wody mógł się zmienić, detekcja od nowa.
+#define ENABLE_CYCLE_CHECKPOINT     true
+#define CHECKPOINT_MAX_DOWNTIME     300    // s - dłuższa przerwa unieważnia fazę 1
+
 // ============== SYGNALIZACJA BŁĘDÓW ==============
 #define ERROR_PULSE_HIGH        100    // ms - czas impulsu HIGH
 #define ERROR_PULSE_LOW         100    // ms - czas przerwy między impulsami
@@ -37,16 +136,38 @@
 #define DEBOUNCE_COUNTER_1      DEBOUNCE_COUNTER     // alias dla starych odwołań
 
 // ============== SPRAWDZENIA INTEGRALNOŚCI ==============
-static_assert(PRE_QUAL_WINDOW >= 20 && PRE_QUAL_WINDOW <= 60, "PRE_QUAL_WINDOW must be 20-60s");
-static_assert(PRE_QUAL_INTERVAL >= 5 && PRE_QUAL_INTERVAL <= 15, "PRE_QUAL_INTERVAL must be 5-15s");
-static_assert(PRE_QUAL_CONFIRM_COUNT >= 2 && PRE_QUAL_CONFIRM_COUNT <= 5, "PRE_QUAL_CONFIRM_COUNT must be 2-5");
-static_assert(SETTLING_TIME >= 30 && SETTLING_TIME <= 120, "SETTLING_TIME must be 30-120s");
-static_assert(TOTAL_DEBOUNCE_TIME >= 600 && TOTAL_DEBOUNCE_TIME <= 2400, "TOTAL_DEBOUNCE_TIME must be 600-2400s");
-static_assert(DEBOUNCE_INTERVAL >= 30 && DEBOUNCE_INTERVAL <= 120, "DEBOUNCE_INTERVAL must be 30-120s");
-static_assert(DEBOUNCE_COUNTER >= 2 && DEBOUNCE_COUNTER <= 10, "DEBOUNCE_COUNTER must be 2-10");
+static_assert(PRE_QUAL_WINDOW >= PRE_QUAL_WINDOW_MIN && PRE_QUAL_WINDOW <= PRE_QUAL_WINDOW_MAX, "PRE_QUAL_WINDOW must be 20-60s");
+static_assert(PRE_QUAL_INTERVAL >= PRE_QUAL_INTERVAL_MIN && PRE_QUAL_INTERVAL <= PRE_QUAL_INTERVAL_MAX, "PRE_QUAL_INTERVAL must be 5-15s");
+static_assert(PRE_QUAL_CONFIRM_COUNT >= PRE_QUAL_CONFIRM_COUNT_MIN && PRE_QUAL_CONFIRM_COUNT <= PRE_QUAL_CONFIRM_COUNT_MAX, "PRE_QUAL_CONFIRM_COUNT must be 2-5");
+static_assert(SETTLING_TIME >= SETTLING_TIME_MIN && SETTLING_TIME <= SETTLING_TIME_MAX, "SETTLING_TIME must be 30-120s");
+static_assert(TOTAL_DEBOUNCE_TIME >= TOTAL_DEBOUNCE_TIME_MIN && TOTAL_DEBOUNCE_TIME <= TOTAL_DEBOUNCE_TIME_MAX, "TOTAL_DEBOUNCE_TIME must be 600-2400s");
+static_assert(DEBOUNCE_INTERVAL >= DEBOUNCE_INTERVAL_MIN && DEBOUNCE_INTERVAL <= DEBOUNCE_INTERVAL_MAX, "DEBOUNCE_INTERVAL must be 30-120s");
+static_assert(DEBOUNCE_COUNTER >= DEBOUNCE_COUNTER_MIN && DEBOUNCE_COUNTER <= DEBOUNCE_COUNTER_MAX, "DEBOUNCE_COUNTER must be 2-10");
+static_assert(PRE_QUAL_WINDOW_MAX >= (PRE_QUAL_CONFIRM_COUNT_MAX - 1) * PRE_QUAL_INTERVAL_MAX,
+              "Adaptive pre-qual window must fit the confirm count");
+static_assert(TOTAL_DEBOUNCE_TIME_MAX >= (DEBOUNCE_COUNTER_MAX + 1) * DEBOUNCE_INTERVAL_MAX,
+              "Adaptive debounce time must fit the counter plus one retry");
 static_assert(SINGLE_DOSE_VOLUME >= 100 && SINGLE_DOSE_VOLUME <= 800, "SINGLE_DOSE_VOLUME must be 100-300ml");
 static_assert(FILL_WATER_MAX >= 1000 && FILL_WATER_MAX <= 3000, "FILL_WATER_MAX must be 1000-3000ml");
 static_assert(LOGGING_TIME == 5, "LOGGING_TIME must be 5 seconds");
+static_assert(DOSE_MAX_VOLUME >= SINGLE_DOSE_VOLUME && DOSE_MAX_VOLUME <= 1000, "DOSE_MAX_VOLUME must be SINGLE_DOSE_VOLUME-1000ml");
+static_assert(DOSE_HISTORY_CYCLES >= 3 && DOSE_HISTORY_CYCLES <= 16, "DOSE_HISTORY_CYCLES must be 3-16");
+static_assert(DOSE_RELEASE_MARGIN_PERCENT >= 100 && DOSE_RELEASE_MARGIN_PERCENT <= 200, "DOSE_RELEASE_MARGIN_PERCENT must be 100-200");
+static_assert(EVAP_EWMA_SHIFT >= 1 && EVAP_EWMA_SHIFT <= 6, "EVAP_EWMA_SHIFT must be 1-6");
+static_assert(EVAP_MAX_INTERVAL_HOURS >= 12 && EVAP_MAX_INTERVAL_HOURS <= 168, "EVAP_MAX_INTERVAL_HOURS must be 12-168");
+static_assert(EVAP_MIN_LEARNED_HOURS >= 1 && EVAP_MIN_LEARNED_HOURS <= 24, "EVAP_MIN_LEARNED_HOURS must be 1-24");
+static_assert(EVAP_PREWARM_MINUTES >= 5 && EVAP_PREWARM_MINUTES <= 120, "EVAP_PREWARM_MINUTES must be 5-120");
+static_assert(ANOMALY_WARMUP_CYCLES >= 4 && ANOMALY_WARMUP_CYCLES <= 32, "ANOMALY_WARMUP_CYCLES must be 4-32");
+static_assert(ANOMALY_EWMA_SHIFT >= 3 && ANOMALY_EWMA_SHIFT <= 8, "ANOMALY_EWMA_SHIFT must be 3-8");
+static_assert(ANOMALY_CUSUM_K > 0.0f && ANOMALY_CUSUM_K < ANOMALY_CUSUM_H, "ANOMALY_CUSUM_K must be below ANOMALY_CUSUM_H");
+static_assert(FLOW_CAL_WINDOW >= FLOW_CAL_MIN_SAMPLES && FLOW_CAL_WINDOW <= 16, "FLOW_CAL_WINDOW must be MIN_SAMPLES-16");
+static_assert(FLOW_CAL_BASELINE_CYCLES >= 3 && FLOW_CAL_BASELINE_CYCLES <= FLOW_CAL_WINDOW, "FLOW_CAL_BASELINE_CYCLES must be 3-WINDOW");
+static_assert(FLOW_DRIFT_THRESHOLD_PERCENT >= 5 && FLOW_DRIFT_THRESHOLD_PERCENT <= 50, "FLOW_DRIFT_THRESHOLD_PERCENT must be 5-50");
+static_assert(SENSOR_SAMPLE_PERIOD_US >= 500 && SENSOR_SAMPLE_PERIOD_US <= 10000, "SENSOR_SAMPLE_PERIOD_US must be 500-10000us");
+static_assert(SENSOR_FILTER_WINDOW >= 32 && SENSOR_FILTER_WINDOW <= 512 && SENSOR_FILTER_WINDOW % 32 == 0,
+              "SENSOR_FILTER_WINDOW must be 32-512 samples, multiple of 32");
+static_assert(SENSOR_FILTER_LOW_PERCENT > 50 && SENSOR_FILTER_LOW_PERCENT <= 100, "SENSOR_FILTER_LOW_PERCENT must be 51-100");
+static_assert(SENSOR_FILTER_HIGH_PERCENT >= 0 && SENSOR_FILTER_HIGH_PERCENT <= 50, "SENSOR_FILTER_HIGH_PERCENT must be 0-50");
 
 // ============== STANY ALGORYTMU ==============
 enum AlgorithmState {
@@ -78,7 +199,8 @@ enum ErrorCode {
     ERROR_NONE = 0,
     ERROR_DAILY_LIMIT = 1,      // ERR1: przekroczono FILL_WATER_MAX
     ERROR_PUMP_FAILURE = 2,     // ERR2: 3 nieudane próby pompy
-    ERROR_BOTH = 3              // ERR0: oba błędy
+    ERROR_BOTH = 3,             // ERR0: oba błędy
+    ERROR_ANOMALY = 4           // ERR4: dryf statystyczny - tylko sygnał, bez STATE_ERROR
 };
 
 // ============== STRUKTURA CYKLU ==============
@@ -105,6 +227,15 @@ struct PumpCycle {
     static const uint8_t RESULT_WATER_FAIL = 0x04;           // Żaden czujnik nie potwierdził
     static const uint8_t RESULT_SENSOR1_RELEASE_FAIL = 0x08; // S1 nie potwierdził (S2 OK)
     static const uint8_t RESULT_SENSOR2_RELEASE_FAIL = 0x10; // S2 nie potwierdził (S1 OK)
+
+    // Flagi per czujnik istnieją tylko dla S1/S2 (format rekordu w FRAM);
+    // czujniki 3+ widać wyłącznie w RESULT_GAP1_FAIL / RESULT_WATER_FAIL
+    static uint8_t debounceFailFlag(uint8_t sensor) {
+        return sensor == 0 ? RESULT_SENSOR1_DEBOUNCE_FAIL : sensor == 1 ? RESULT_SENSOR2_DEBOUNCE_FAIL : 0;
+    }
+    static uint8_t releaseFailFlag(uint8_t sensor) {
+        return sensor == 0 ? RESULT_SENSOR1_RELEASE_FAIL : sensor == 1 ? RESULT_SENSOR2_RELEASE_FAIL : 0;
+    }
 };
 
 // ============== OBLICZANIE CZASU POMPY ==============
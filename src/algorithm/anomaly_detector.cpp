@@ -0,0 +1,244 @@
+#include "anomaly_detector.h"
+#include "../core/logging.h"
+#include "../core/metrics.h"
+#include "../hardware/fram_controller.h"
+#include "../hardware/storage_queue.h"
+#include "../hardware/rtc_controller.h"
+
+#define ANOMALY_Z_CLAMP         4.0f
+#define ANOMALY_Z_LEARN         3.0f            // Próbki dalej od bazy nie uczą
+#define ANOMALY_MAD_TO_SIGMA    1.25f           // Średnie odchylenie bezwzględne -> sigma (rozkład normalny)
+
+// Zapisywany w FRAM (FRAM_ADDR_ANOMALY_STATE + seria * FRAM_ANOMALY_SLOT_SIZE)
+struct AnomalyRecord {
+    float mean;
+    float deviation;                // EWMA |x - średnia|
+    float cusumHigh;
+    float cusumLow;
+    float lastValue;
+    uint16_t samples;
+    int8_t alarm;
+    uint8_t reserved;
+};
+
+static_assert(sizeof(AnomalyRecord) + FRAM_RECORD_OVERHEAD <= FRAM_ANOMALY_SLOT_SIZE, "AnomalyRecord does not fit its FRAM slot");
+
+struct SeriesInfo {
+    const char* name;
+    float sigmaFloor;               // Rozdzielczość serii - cichsza baza nie zawęża progu
+};
+
+static const SeriesInfo SERIES_INFO[ANOMALY_SERIES_COUNT] = {
+    { "time_gap_1",         (float)DEBOUNCE_INTERVAL / 2 },
+    { "water_trigger_time", (float)RELEASE_CHECK_INTERVAL },
+    { "loss_rate",          2.0f },
+};
+
+static AnomalyRecord series[ANOMALY_SERIES_COUNT];
+static uint32_t lastRefillUnix = 0;
+
+static uint16_t slotAddr(uint8_t s) {
+    return FRAM_ADDR_ANOMALY_STATE + s * FRAM_ANOMALY_SLOT_SIZE;
+}
+
+static float sigmaOf(uint8_t s) {
+    float sigma = series[s].deviation * ANOMALY_MAD_TO_SIGMA;
+    return sigma > SERIES_INFO[s].sigmaFloor ? sigma : SERIES_INFO[s].sigmaFloor;
+}
+
+static void updateActiveGauge() {
+    int32_t active = 0;
+    for (uint8_t s = 0; s < ANOMALY_SERIES_COUNT; s++) {
+        if (series[s].alarm != 0) {
+            active++;
+        }
+    }
+    metricsSetGauge(MG_ANOMALY_ACTIVE, active);
+}
+
+// Jedna próbka serii, O(1). Zwraca true przy nowym alarmie.
+static bool addSample(uint8_t s, float x) {
+    AnomalyRecord& r = series[s];
+    r.lastValue = x;
+
+    if (r.samples < ANOMALY_WARMUP_CYCLES) {
+        // Rozgrzewka: zwykła średnia krocząca zamiast EWMA
+        r.samples++;
+        r.mean += (x - r.mean) / r.samples;
+        r.deviation += (fabsf(x - r.mean) - r.deviation) / r.samples;
+        return false;
+    }
+
+    float z = (x - r.mean) / sigmaOf(s);
+    if (z > ANOMALY_Z_CLAMP) z = ANOMALY_Z_CLAMP;
+    if (z < -ANOMALY_Z_CLAMP) z = -ANOMALY_Z_CLAMP;
+
+    r.cusumHigh = fmaxf(0.0f, r.cusumHigh + z - ANOMALY_CUSUM_K);
+    r.cusumLow = fmaxf(0.0f, r.cusumLow - z - ANOMALY_CUSUM_K);
+
+    bool raised = false;
+    if (r.alarm == 0 && (r.cusumHigh > ANOMALY_CUSUM_H || r.cusumLow > ANOMALY_CUSUM_H)) {
+        r.alarm = r.cusumHigh > ANOMALY_CUSUM_H ? 1 : -1;
+        raised = true;
+    }
+
+    if (r.alarm == 0 && fabsf(z) < ANOMALY_Z_LEARN) {
+        r.mean += (x - r.mean) / (1 << ANOMALY_EWMA_SHIFT);
+        r.deviation += (fabsf(x - r.mean) - r.deviation) / (1 << ANOMALY_EWMA_SHIFT);
+    }
+    if (r.samples < UINT16_MAX) {
+        r.samples++;
+    }
+    return raised;
+}
+
+// Zwraca maskę serii z nowym alarmem (bit = AnomalySeries)
+static uint8_t feedCycle(const PumpCycle& cycle, bool* changed) {
+    uint8_t raised = 0;
+    bool delivered = cycle.volume_dose > 0 && isUnixTimeValid(cycle.timestamp);
+    bool clean = cycle.error_code == ERROR_NONE &&
+                 !(cycle.sensor_results & (PumpCycle::RESULT_WATER_FAIL | PumpCycle::RESULT_FALSE_TRIGGER));
+
+    // time_gap_1 ma sens tylko gdy oba pływaki zaliczyły debouncing
+    if (clean && !(cycle.sensor_results & PumpCycle::RESULT_GAP1_FAIL)) {
+        if (addSample(ANOMALY_TIME_GAP_1, cycle.time_gap_1)) {
+            raised |= 1 << ANOMALY_TIME_GAP_1;
+        }
+        changed[ANOMALY_TIME_GAP_1] = true;
+    }
+
+    if (clean && cycle.pump_attempts == 1 && cycle.water_trigger_time < WATER_TRIGGER_MAX_TIME) {
+        if (addSample(ANOMALY_WATER_TRIGGER, cycle.water_trigger_time)) {
+            raised |= 1 << ANOMALY_WATER_TRIGGER;
+        }
+        changed[ANOMALY_WATER_TRIGGER] = true;
+    }
+
+    if (delivered && cycle.timestamp > lastRefillUnix) {
+        uint32_t interval = cycle.timestamp - lastRefillUnix;
+        if (clean && lastRefillUnix > 0 && interval <= EVAP_MAX_INTERVAL_HOURS * 3600UL) {
+            if (addSample(ANOMALY_LOSS_RATE, cycle.volume_dose * 3600.0f / interval)) {
+                raised |= 1 << ANOMALY_LOSS_RATE;
+            }
+            changed[ANOMALY_LOSS_RATE] = true;
+        }
+        lastRefillUnix = cycle.timestamp;
+    }
+    return raised;
+}
+
+static void saveSeries(uint8_t s) {
+    queueRecordSave(slotAddr(s), &series[s], sizeof(AnomalyRecord));
+}
+
+static void logAlarms() {
+    for (uint8_t s = 0; s < ANOMALY_SERIES_COUNT; s++) {
+        if (series[s].alarm != 0) {
+            LOG_WARNING("");
+            LOG_WARNING("Anomaly: %s drifting %s (mean %.1f, last %.1f, CUSUM +%.1f/-%.1f)",
+                        SERIES_INFO[s].name, series[s].alarm > 0 ? "up" : "down",
+                        series[s].mean, series[s].lastValue, series[s].cusumHigh, series[s].cusumLow);
+        }
+    }
+}
+
+void initAnomalyDetector(const std::vector<PumpCycle>& history) {
+    bool loaded[ANOMALY_SERIES_COUNT];
+    bool allLoaded = true;
+    for (uint8_t s = 0; s < ANOMALY_SERIES_COUNT; s++) {
+        loaded[s] = loadRecordFromFRAM(slotAddr(s), &series[s], sizeof(AnomalyRecord)) &&
+                    series[s].alarm >= -1 && series[s].alarm <= 1;
+        if (!loaded[s]) {
+            memset(&series[s], 0, sizeof(AnomalyRecord));
+            allLoaded = false;
+        }
+    }
+
+    // Rozgrzewka z historii tylko dla serii bez stanu w FRAM; reszta
+    // historii jest już w zapisanym stanie - odtwarzany jest tylko czas dolewki
+    AnomalyRecord saved[ANOMALY_SERIES_COUNT];
+    memcpy(saved, series, sizeof(series));
+    bool changed[ANOMALY_SERIES_COUNT] = {false};
+    for (const auto& cycle : history) {
+        feedCycle(cycle, changed);
+    }
+    for (uint8_t s = 0; s < ANOMALY_SERIES_COUNT; s++) {
+        if (loaded[s]) {
+            series[s] = saved[s];
+        } else if (changed[s]) {
+            saveSeries(s);
+        }
+    }
+    updateActiveGauge();
+
+    LOG_INFO("");
+    LOG_INFO("Anomaly detector: %s, samples gap1=%d trigger=%d loss=%d%s",
+             allLoaded ? "FRAM state" : "warm-up from cycle history",
+             series[ANOMALY_TIME_GAP_1].samples, series[ANOMALY_WATER_TRIGGER].samples,
+             series[ANOMALY_LOSS_RATE].samples, isAnomalyActive() ? ", ALARM ACTIVE" : "");
+    logAlarms();
+}
+
+bool anomalyOnCycle(const PumpCycle& cycle) {
+    if (!ENABLE_ANOMALY_DETECTION) {
+        return false;
+    }
+    bool changed[ANOMALY_SERIES_COUNT] = {false};
+    uint8_t raised = feedCycle(cycle, changed);
+
+    for (uint8_t s = 0; s < ANOMALY_SERIES_COUNT; s++) {
+        if (changed[s]) {
+            saveSeries(s);
+        }
+        if (raised & (1 << s)) {
+            metricsInc((MetricCounter)(MC_ANOMALY_TIME_GAP_1 + s));
+        }
+    }
+    if (raised) {
+        updateActiveGauge();
+        logAlarms();
+    }
+    return raised != 0;
+}
+
+void acknowledgeAnomalies() {
+    for (uint8_t s = 0; s < ANOMALY_SERIES_COUNT; s++) {
+        AnomalyRecord& r = series[s];
+        if (r.alarm != 0) {
+            // Operator przyjął nowy poziom - od niego liczony dalszy dryf
+            r.mean = r.lastValue;
+            r.alarm = 0;
+        }
+        r.cusumHigh = 0.0f;
+        r.cusumLow = 0.0f;
+        saveSeries(s);
+    }
+    updateActiveGauge();
+
+    LOG_INFO("");
+    LOG_INFO("Anomaly alarms acknowledged, CUSUM cleared");
+}
+
+bool isAnomalyActive() {
+    for (uint8_t s = 0; s < ANOMALY_SERIES_COUNT; s++) {
+        if (series[s].alarm != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+AnomalySeriesStatus getAnomalyStatus(AnomalySeries s) {
+    AnomalySeriesStatus status;
+    const AnomalyRecord& r = series[s];
+    status.name = SERIES_INFO[s].name;
+    status.ready = r.samples >= ANOMALY_WARMUP_CYCLES;
+    status.samples = r.samples;
+    status.mean = r.mean;
+    status.sigma = sigmaOf(s);
+    status.lastValue = r.lastValue;
+    status.cusumHigh = r.cusumHigh;
+    status.cusumLow = r.cusumLow;
+    status.alarm = r.alarm;
+    return status;
+}
@@ -0,0 +1,47 @@
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+#include <Arduino.h>
+#include <vector>
+#include "algorithm_config.h"
+
+// ============== ANOMALY DETECTOR ==============
+// Wolny wyciek albo degradacja pływaka nie przekracza żadnego progu -
+// widać je jako dryf serii cyklu. Dla każdej serii O(1) na cykl:
+//   baza: EWMA średniej i średniego odchylenia bezwzględnego (alfa 1/32)
+//   z = (x - średnia) / sigma, obcięte do ±4 (pojedynczy wyskok nie alarmuje)
+//   CUSUM: S+ = max(0, S+ + z - k), S- = max(0, S- - z - k); alarm gdy > h
+// Baza nie uczy się w alarmie ani z próbek |z| >= 3, więc dryf nie jest
+// wchłaniany zanim CUSUM go zsumuje. Stan serii w FRAM (FRAM_ADDR_ANOMALY_STATE).
+
+enum AnomalySeries {
+    ANOMALY_TIME_GAP_1 = 0,         // Rozjazd pływaków przy opadaniu [s]
+    ANOMALY_WATER_TRIGGER,          // Reakcja pływaków na pompę [s]
+    ANOMALY_LOSS_RATE,              // Dawka / czas od poprzedniej dolewki [ml/h]
+
+    ANOMALY_SERIES_COUNT
+};
+
+struct AnomalySeriesStatus {
+    const char* name;
+    bool ready;                     // Po ANOMALY_WARMUP_CYCLES próbkach
+    uint16_t samples;
+    float mean;
+    float sigma;
+    float lastValue;
+    float cusumHigh;                // Suma dryfu w górę [sigma]
+    float cusumLow;                 // Suma dryfu w dół [sigma]
+    int8_t alarm;                   // +1 wzrost, -1 spadek, 0 brak
+};
+
+// Po loadCyclesFromStorage(): stan z FRAM, a bez niego rozgrzewka z historii
+void initAnomalyDetector(const std::vector<PumpCycle>& history);  // Historia od najstarszego
+
+// Zadanie control
+bool anomalyOnCycle(const PumpCycle& cycle);    // true = nowy alarm w tym cyklu
+void acknowledgeAnomalies();                    // Zeruje CUSUM, obecny poziom = nowa baza
+
+bool isAnomalyActive();
+AnomalySeriesStatus getAnomalyStatus(AnomalySeries series);
+
+#endif
@@ -0,0 +1,52 @@
+#include "bucket_store.h"
+#include "../hardware/fram_controller.h"
+#include "../hardware/storage_queue.h"
+
+static uint8_t* bucketAt(const BucketStore& store, uint16_t slot) {
+    return (uint8_t*)store.buckets + slot * store.bucketSize;
+}
+
+static uint16_t bucketAddr(const BucketStore& store, uint16_t slot) {
+    return store.baseAddr + slot * store.slotSize;
+}
+
+static bool isBucketEmpty(const BucketStore& store, uint16_t slot) {
+    const uint8_t* bytes = bucketAt(store, slot);
+    for (uint16_t i = 0; i < store.bucketSize; i++) {
+        if (bytes[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint16_t loadBucketsFromFRAM(const BucketStore& store) {
+    uint16_t loaded = 0;
+    for (uint16_t slot = 0; slot < store.count; slot++) {
+        if (loadRecordFromFRAM(bucketAddr(store, slot), bucketAt(store, slot), store.bucketSize)) {
+            loaded++;
+        } else {
+            memset(bucketAt(store, slot), 0, store.bucketSize);
+        }
+    }
+    return loaded;
+}
+
+uint16_t rebuildBucketsFromHistory(const BucketStore& store, const std::vector<PumpCycle>& history,
+                                   BucketRebuildFn addCycle) {
+    uint16_t rebuilt = 0;
+    for (const auto& cycle : history) {
+        if (addCycle(cycle)) {
+            rebuilt++;
+        }
+    }
+    if (rebuilt == 0) {
+        return 0;
+    }
+    for (uint16_t slot = 0; slot < store.count; slot++) {
+        if (!isBucketEmpty(store, slot)) {
+            queueRecordSave(bucketAddr(store, slot), bucketAt(store, slot), store.bucketSize);
+        }
+    }
+    return rebuilt;
+}
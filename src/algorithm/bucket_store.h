@@ -0,0 +1,29 @@
+#ifndef BUCKET_STORE_H
+#define BUCKET_STORE_H
+
+#include <Arduino.h>
+#include <vector>
+#include "algorithm_config.h"
+
+// ============== BUCKET STORE ==============
+// Wspólne dla agregatów cykli i archiwum zużycia: tablica kubełków w RAM,
+// każdy w osobnym rekordzie FRAM (baseAddr + slot * slotSize). Przy starcie
+// kubełki wracają z FRAM; gdy żaden nie był zapisany (pierwsze uruchomienie),
+// odbudowa z ringu cykli (FRAM_MAX_CYCLES) i zapis niepustych przez storage.
+// Pusty kubełek = same zera (memset przy braku rekordu).
+
+struct BucketStore {
+    void* buckets;
+    uint16_t bucketSize;
+    uint16_t count;
+    uint16_t baseAddr;
+    uint16_t slotSize;
+};
+
+typedef bool (*BucketRebuildFn)(const PumpCycle& cycle);   // true = cykl zaksięgowany
+
+uint16_t loadBucketsFromFRAM(const BucketStore& store);    // Liczba wczytanych kubełków
+uint16_t rebuildBucketsFromHistory(const BucketStore& store, const std::vector<PumpCycle>& history,
+                                   BucketRebuildFn addCycle);  // Liczba zaksięgowanych cykli
+
+#endif
@@ -0,0 +1,173 @@
+#include "consumption_archive.h"
+#include "bucket_store.h"
+#include "../core/logging.h"
+#include "../hardware/fram_controller.h"
+#include "../hardware/storage_queue.h"
+#include "../hardware/rtc_controller.h"
+#include <freertos/FreeRTOS.h>
+
+#define ARCHIVE_WEEK_OFFSET     (3 * 86400UL)   // 1970-01-01 to czwartek: +3 doby -> granice w poniedziałki
+
+static_assert(sizeof(ArchiveBucket) + FRAM_RECORD_OVERHEAD <= FRAM_ARCHIVE_SLOT_SIZE, "ArchiveBucket does not fit its FRAM slot");
+
+struct ArchiveInfo {
+    const char* name;
+    uint32_t bucketSeconds;
+    uint32_t offset;                // Przesunięcie granic okresu
+    uint8_t buckets;
+    uint8_t firstSlot;
+};
+
+static const ArchiveInfo ARCHIVES[ARCHIVE_RESOLUTION_COUNT] = {
+    { "half_hour", 1800,       0,                   48,  0 },
+    { "day",       86400,      0,                   90,  48 },
+    { "week",      7 * 86400,  ARCHIVE_WEEK_OFFSET, 104, 138 },
+};
+
+static_assert(FRAM_ARCHIVE_BUCKETS == 48 + 90 + 104, "FRAM_ARCHIVE_BUCKETS must match ARCHIVES");
+
+static ArchiveBucket buckets[FRAM_ARCHIVE_BUCKETS];
+static portMUX_TYPE archiveMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t lastTickPeriod = 0;         // Najkrótszy okres - archiveTick() pracuje raz na 30 min
+
+static uint16_t slotAddr(uint8_t slot) {
+    return FRAM_ADDR_CONSUMPTION_ARCHIVE + slot * FRAM_ARCHIVE_SLOT_SIZE;
+}
+
+static uint32_t periodOf(uint8_t a, uint32_t timestamp) {
+    return (timestamp + ARCHIVES[a].offset) / ARCHIVES[a].bucketSeconds;
+}
+
+static inline uint16_t addSaturated16(uint16_t value, uint16_t amount) {
+    return (uint32_t)value + amount > UINT16_MAX ? UINT16_MAX : value + amount;
+}
+
+// Slot bieżącego okresu; nieaktualny zerowany. 0xFF = okres starszy niż slot.
+static uint8_t currentSlot(uint8_t a, uint32_t nowUnix) {
+    uint32_t period = periodOf(a, nowUnix);
+    uint8_t slot = ARCHIVES[a].firstSlot + period % ARCHIVES[a].buckets;
+    ArchiveBucket& b = buckets[slot];
+    if (b.period != period) {
+        if (b.period > period) {
+            return 0xFF;            // Czas cofnięty (korekta RTC)
+        }
+        memset(&b, 0, sizeof(b));
+        b.period = period;
+    }
+    return slot;
+}
+
+static void saveSlots(const uint8_t* slots) {
+    for (uint8_t a = 0; a < ARCHIVE_RESOLUTION_COUNT; a++) {
+        if (slots[a] != 0xFF) {
+            queueRecordSave(slotAddr(slots[a]), &buckets[slots[a]], sizeof(ArchiveBucket));
+        }
+    }
+}
+
+static bool addVolume(uint32_t nowUnix, uint16_t autoMl, uint16_t manualMl, bool cycle, bool error, uint8_t* slots) {
+    if (!isUnixTimeValid(nowUnix)) {
+        return false;
+    }
+    portENTER_CRITICAL(&archiveMux);
+    for (uint8_t a = 0; a < ARCHIVE_RESOLUTION_COUNT; a++) {
+        slots[a] = currentSlot(a, nowUnix);
+        if (slots[a] == 0xFF) {
+            continue;
+        }
+        ArchiveBucket& b = buckets[slots[a]];
+        b.autoMl = addSaturated16(b.autoMl, autoMl);
+        b.manualMl = addSaturated16(b.manualMl, manualMl);
+        if (cycle && b.cycles < 255) b.cycles++;
+        if (error && b.errors < 255) b.errors++;
+    }
+    portEXIT_CRITICAL(&archiveMux);
+    return true;
+}
+
+static bool rebuildCycle(const PumpCycle& cycle) {
+    uint8_t slots[ARCHIVE_RESOLUTION_COUNT];
+    return addVolume(cycle.timestamp, cycle.volume_dose, 0, true, cycle.error_code != ERROR_NONE, slots);
+}
+
+void initConsumptionArchive(const std::vector<PumpCycle>& history) {
+    BucketStore store = { buckets, sizeof(ArchiveBucket), FRAM_ARCHIVE_BUCKETS,
+                          FRAM_ADDR_CONSUMPTION_ARCHIVE, FRAM_ARCHIVE_SLOT_SIZE };
+    uint16_t loaded = loadBucketsFromFRAM(store);
+
+    // Pierwsze uruchomienie: odbudowa z ringu cykli (FRAM_MAX_CYCLES)
+    uint16_t rebuilt = loaded == 0 ? rebuildBucketsFromHistory(store, history, rebuildCycle) : 0;
+
+    LOG_INFO("");
+    LOG_INFO("Consumption archive: %d/%d buckets from FRAM, %d cycles rebuilt from history",
+             loaded, FRAM_ARCHIVE_BUCKETS, rebuilt);
+}
+
+void archiveRecordCycle(const PumpCycle& cycle) {
+    // Start cyklu, nie czas logu - ten sam klucz co odbudowa z historii i agregaty.
+    // Okres startu nadal ma swój slot (ring obejmuje co najmniej dobę).
+    uint8_t slots[ARCHIVE_RESOLUTION_COUNT];
+    if (addVolume(cycle.timestamp, cycle.volume_dose, 0, true, cycle.error_code != ERROR_NONE, slots)) {
+        saveSlots(slots);
+    }
+}
+
+void archiveRecordManual(uint32_t nowUnix, uint16_t volumeMl) {
+    uint8_t slots[ARCHIVE_RESOLUTION_COUNT];
+    if (addVolume(nowUnix, 0, volumeMl, false, false, slots)) {
+        saveSlots(slots);
+    }
+}
+
+void archiveTick(uint32_t nowUnix) {
+    if (!isUnixTimeValid(nowUnix) || periodOf(ARCHIVE_HALF_HOUR, nowUnix) == lastTickPeriod) {
+        return;
+    }
+    lastTickPeriod = periodOf(ARCHIVE_HALF_HOUR, nowUnix);
+
+    // Zerowy kubełek tylko gdy okres jeszcze nie istnieje - bez zbędnych zapisów
+    uint8_t slots[ARCHIVE_RESOLUTION_COUNT];
+    portENTER_CRITICAL(&archiveMux);
+    for (uint8_t a = 0; a < ARCHIVE_RESOLUTION_COUNT; a++) {
+        uint32_t period = periodOf(a, nowUnix);
+        uint8_t slot = ARCHIVES[a].firstSlot + period % ARCHIVES[a].buckets;
+        slots[a] = buckets[slot].period == period ? 0xFF : currentSlot(a, nowUnix);
+    }
+    portEXIT_CRITICAL(&archiveMux);
+    saveSlots(slots);
+}
+
+uint8_t getArchiveBuckets(ArchiveResolution resolution, uint32_t nowUnix, ArchiveBucket* out, uint8_t maxCount) {
+    const ArchiveInfo& info = ARCHIVES[resolution];
+    uint8_t count = info.buckets < maxCount ? info.buckets : maxCount;
+    uint32_t current = periodOf(resolution, nowUnix);
+
+    portENTER_CRITICAL(&archiveMux);
+    for (uint8_t n = 0; n < count; n++) {
+        uint32_t period = current - (count - 1 - n);
+        const ArchiveBucket& b = buckets[info.firstSlot + period % info.buckets];
+        if (b.period == period) {
+            out[n] = b;
+        } else {
+            memset(&out[n], 0, sizeof(ArchiveBucket));
+        }
+    }
+    portEXIT_CRITICAL(&archiveMux);
+    return count;
+}
+
+uint32_t getArchiveBucketSeconds(ArchiveResolution resolution) {
+    return ARCHIVES[resolution].bucketSeconds;
+}
+
+uint32_t getArchiveBucketStart(ArchiveResolution resolution, uint32_t period) {
+    return period * ARCHIVES[resolution].bucketSeconds - ARCHIVES[resolution].offset;
+}
+
+uint8_t getArchiveBucketCount(ArchiveResolution resolution) {
+    return ARCHIVES[resolution].buckets;
+}
+
+const char* getArchiveResolutionName(ArchiveResolution resolution) {
+    return resolution < ARCHIVE_RESOLUTION_COUNT ? ARCHIVES[resolution].name : "unknown";
+}
@@ -0,0 +1,49 @@
+#ifndef CONSUMPTION_ARCHIVE_H
+#define CONSUMPTION_ARCHIVE_H
+
+#include <Arduino.h>
+#include <vector>
+#include "algorithm_config.h"
+
+// ============== CONSUMPTION ARCHIVE ==============
+// Archiwum w stylu RRD: trzy ringi kubełków zużycia w FRAM
+//   48 x 30 min  (doba)
+//   90 x 1 doba  (kwartał)
+//   104 x 1 tydzień (2 lata)
+// Kubełek niesie numer okresu (czas / szerokość), więc nieaktualny slot
+// rozpoznaje się bez przesuwania ringu; brak kubełka = urządzenie nie
+// działało, kubełek z zerem = działało bez zużycia (zakładany przy
+// przejściu okresu). Każdy zapis to jeden rekord FRAM na ring.
+
+enum ArchiveResolution {
+    ARCHIVE_HALF_HOUR = 0,
+    ARCHIVE_DAY,
+    ARCHIVE_WEEK,
+
+    ARCHIVE_RESOLUTION_COUNT
+};
+
+struct ArchiveBucket {
+    uint32_t period;                // Czas / szerokość kubełka, 0 = pusty
+    uint16_t autoMl;                // Dolewki automatyczne (jak dailyVolumeML)
+    uint16_t manualMl;              // Pompa ręczna
+    uint8_t cycles;
+    uint8_t errors;                 // Cykle z error_code != ERROR_NONE
+};
+
+// Po loadCyclesFromStorage(): ringi z FRAM, a bez nich odbudowa z historii
+void initConsumptionArchive(const std::vector<PumpCycle>& history);  // Historia od najstarszego
+
+// Zadanie control
+void archiveRecordCycle(const PumpCycle& cycle);   // Kubełek wg cycle.timestamp (jak odbudowa z historii)
+void archiveRecordManual(uint32_t nowUnix, uint16_t volumeMl);
+void archiveTick(uint32_t nowUnix);         // Przejście okresu -> pusty kubełek
+
+// Dowolne zadanie: kubełki od najstarszego, out[i].period == 0 = brak danych
+uint8_t getArchiveBuckets(ArchiveResolution resolution, uint32_t nowUnix, ArchiveBucket* out, uint8_t maxCount);
+uint32_t getArchiveBucketSeconds(ArchiveResolution resolution);
+uint32_t getArchiveBucketStart(ArchiveResolution resolution, uint32_t period);    // Unix
+uint8_t getArchiveBucketCount(ArchiveResolution resolution);
+const char* getArchiveResolutionName(ArchiveResolution resolution);
+
+#endif
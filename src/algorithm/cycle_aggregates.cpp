@@ -0,0 +1,194 @@
+#include "cycle_aggregates.h"
+#include "bucket_store.h"
+#include "../core/logging.h"
+#include "../hardware/fram_controller.h"
+#include "../hardware/storage_queue.h"
+#include "../hardware/rtc_controller.h"
+#include <freertos/FreeRTOS.h>
+
+static_assert(sizeof(AggregateBucket) <= FRAM_RECORD_MAX_DATA, "AggregateBucket too large for FRAM record");
+static_assert(sizeof(AggregateBucket) + FRAM_RECORD_OVERHEAD <= FRAM_AGGREGATE_SLOT_SIZE, "AggregateBucket does not fit its FRAM slot");
+
+struct RingInfo {
+    const char* name;
+    uint32_t bucketSeconds;
+    uint8_t buckets;
+    uint8_t firstSlot;              // Indeks w buckets[] i w FRAM
+};
+
+static const RingInfo RINGS[AGG_WINDOW_COUNT] = {
+    { "hour", 300,   12, 0 },
+    { "day",  3600,  24, 12 },
+    { "week", 86400, 7,  36 },
+};
+
+static const char* const SERIES_NAMES[AGG_SERIES_COUNT] = {
+    "volume", "time_gap_1", "time_gap_2", "water_trigger_time"
+};
+
+static AggregateBucket buckets[FRAM_AGGREGATE_BUCKETS];
+static portMUX_TYPE aggregatesMux = portMUX_INITIALIZER_UNLOCKED;
+
+static_assert(FRAM_AGGREGATE_BUCKETS == 12 + 24 + 7, "FRAM_AGGREGATE_BUCKETS must match RINGS");
+
+static uint16_t slotAddr(uint8_t slot) {
+    return FRAM_ADDR_AGGREGATES + slot * FRAM_AGGREGATE_SLOT_SIZE;
+}
+
+static inline void incSaturated(uint8_t& counter, uint8_t amount = 1) {
+    counter = (uint16_t)counter + amount > 255 ? 255 : counter + amount;
+}
+
+static void statAdd(AggregateBucket& b, uint8_t series, uint32_t value) {
+    uint16_t v = value > UINT16_MAX ? UINT16_MAX : value;
+    AggregateStat& s = b.stat[series];
+    if (b.count[series] == 0) {
+        s.min = v;
+        s.max = v;
+    } else {
+        if (v < s.min) s.min = v;
+        if (v > s.max) s.max = v;
+    }
+    s.sum += v;
+    incSaturated(b.count[series]);
+}
+
+static void bucketAdd(AggregateBucket& b, const PumpCycle& cycle) {
+    const uint8_t releaseFail = PumpCycle::RESULT_SENSOR1_RELEASE_FAIL | PumpCycle::RESULT_SENSOR2_RELEASE_FAIL;
+    bool falseTrigger = cycle.sensor_results & PumpCycle::RESULT_FALSE_TRIGGER;
+    bool waterFail = cycle.sensor_results & PumpCycle::RESULT_WATER_FAIL;
+
+    incSaturated(b.cycles);
+    if (cycle.error_code == ERROR_NONE && cycle.sensor_results == 0) {
+        incSaturated(b.clean);
+    }
+    if (cycle.pump_attempts > 1) {
+        incSaturated(b.retries, cycle.pump_attempts - 1);
+    }
+    if (cycle.error_code == ERROR_PUMP_FAILURE) incSaturated(b.pumpFailures);
+    if (cycle.sensor_results & PumpCycle::RESULT_GAP1_FAIL) incSaturated(b.gap1Fails);
+    if (cycle.sensor_results & releaseFail) incSaturated(b.releaseFails);
+    if (waterFail) incSaturated(b.waterFails);
+    if (falseTrigger) incSaturated(b.falseTriggers);
+
+    if (cycle.volume_dose > 0) {
+        statAdd(b, AGG_VOLUME, cycle.volume_dose);
+    }
+    if (!falseTrigger && !(cycle.sensor_results & PumpCycle::RESULT_GAP1_FAIL)) {
+        statAdd(b, AGG_GAP1, cycle.time_gap_1);
+    }
+    if (!falseTrigger && !waterFail) {
+        statAdd(b, AGG_WATER_TRIGGER, cycle.water_trigger_time);
+        if (!(cycle.sensor_results & releaseFail)) {
+            statAdd(b, AGG_GAP2, cycle.time_gap_2);
+        }
+    }
+}
+
+// Kubełek dla cyklu; przeterminowany slot zerowany (O(1), bez przesuwania ringu)
+static uint8_t addToRing(uint8_t ring, const PumpCycle& cycle) {
+    const RingInfo& info = RINGS[ring];
+    uint32_t start = cycle.timestamp - cycle.timestamp % info.bucketSeconds;
+    uint8_t slot = info.firstSlot + (cycle.timestamp / info.bucketSeconds) % info.buckets;
+
+    AggregateBucket& b = buckets[slot];
+    if (b.start != start) {
+        if (b.start > start) {
+            return 0xFF;            // Cykl starszy niż zawartość slotu (korekta RTC) - pomiń
+        }
+        memset(&b, 0, sizeof(b));
+        b.start = start;
+    }
+    bucketAdd(b, cycle);
+    return slot;
+}
+
+static bool addCycle(const PumpCycle& cycle, uint8_t* slots) {
+    if (!isUnixTimeValid(cycle.timestamp)) {
+        return false;
+    }
+    portENTER_CRITICAL(&aggregatesMux);
+    for (uint8_t ring = 0; ring < AGG_WINDOW_COUNT; ring++) {
+        slots[ring] = addToRing(ring, cycle);
+    }
+    portEXIT_CRITICAL(&aggregatesMux);
+    return true;
+}
+
+static bool rebuildCycle(const PumpCycle& cycle) {
+    uint8_t slots[AGG_WINDOW_COUNT];
+    return addCycle(cycle, slots);
+}
+
+void initCycleAggregates(const std::vector<PumpCycle>& history) {
+    BucketStore store = { buckets, sizeof(AggregateBucket), FRAM_AGGREGATE_BUCKETS,
+                          FRAM_ADDR_AGGREGATES, FRAM_AGGREGATE_SLOT_SIZE };
+    uint16_t loaded = loadBucketsFromFRAM(store);
+
+    // Pierwsze uruchomienie: odbudowa z ringu cykli (FRAM_MAX_CYCLES)
+    uint16_t rebuilt = loaded == 0 ? rebuildBucketsFromHistory(store, history, rebuildCycle) : 0;
+
+    LOG_INFO("");
+    LOG_INFO("Cycle aggregates: %d buckets from FRAM, %d cycles rebuilt from history", loaded, rebuilt);
+}
+
+void aggregatesOnCycle(const PumpCycle& cycle) {
+    uint8_t slots[AGG_WINDOW_COUNT];
+    if (!addCycle(cycle, slots)) {
+        return;
+    }
+    for (uint8_t ring = 0; ring < AGG_WINDOW_COUNT; ring++) {
+        if (slots[ring] != 0xFF) {
+            queueRecordSave(slotAddr(slots[ring]), &buckets[slots[ring]], sizeof(AggregateBucket));
+        }
+    }
+}
+
+AggregateSummary getAggregateSummary(AggregateWindow window, uint32_t nowUnix) {
+    const RingInfo& info = RINGS[window];
+    AggregateSummary s;
+    memset(&s, 0, sizeof(s));
+    s.windowSeconds = info.bucketSeconds * info.buckets;
+
+    // Okno = kubełki, których początek mieści się w ostatnich N okresach
+    uint32_t current = nowUnix - nowUnix % info.bucketSeconds;
+    uint32_t oldest = current - (info.buckets - 1) * info.bucketSeconds;
+
+    portENTER_CRITICAL(&aggregatesMux);
+    for (uint8_t n = 0; n < info.buckets; n++) {
+        const AggregateBucket& b = buckets[info.firstSlot + n];
+        if (b.start == 0 || b.start < oldest || b.start > current) {
+            continue;
+        }
+        if (s.from == 0 || b.start < s.from) {
+            s.from = b.start;
+        }
+        s.cycles += b.cycles;
+        s.clean += b.clean;
+        s.retries += b.retries;
+        s.pumpFailures += b.pumpFailures;
+        s.gap1Fails += b.gap1Fails;
+        s.releaseFails += b.releaseFails;
+        s.waterFails += b.waterFails;
+        s.falseTriggers += b.falseTriggers;
+        for (uint8_t k = 0; k < AGG_SERIES_COUNT; k++) {
+            if (b.count[k] == 0) {
+                continue;
+            }
+            if (s.count[k] == 0 || b.stat[k].min < s.min[k]) s.min[k] = b.stat[k].min;
+            if (s.count[k] == 0 || b.stat[k].max > s.max[k]) s.max[k] = b.stat[k].max;
+            s.count[k] += b.count[k];
+            s.sum[k] += b.stat[k].sum;
+        }
+    }
+    portEXIT_CRITICAL(&aggregatesMux);
+    return s;
+}
+
+const char* getAggregateWindowName(AggregateWindow window) {
+    return window < AGG_WINDOW_COUNT ? RINGS[window].name : "unknown";
+}
+
+const char* getAggregateSeriesName(AggregateSeries series) {
+    return series < AGG_SERIES_COUNT ? SERIES_NAMES[series] : "unknown";
+}
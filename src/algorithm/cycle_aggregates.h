@@ -0,0 +1,83 @@
+#ifndef CYCLE_AGGREGATES_H
+#define CYCLE_AGGREGATES_H
+
+#include <Arduino.h>
+#include <vector>
+#include "algorithm_config.h"
+
+// ============== CYCLE AGGREGATES ==============
+// Kroczące statystyki cykli dla okien 1h / 24h / 7 dni bez skanowania
+// historii. Każde okno to ring kubełków (12 x 5 min, 24 x 1 h, 7 x 1 doba,
+// wyrównanych do UTC). Cykl trafia do bieżącego kubełka każdego ringu -
+// O(1); przeterminowany kubełek jest zerowany przy ponownym użyciu slotu.
+// Zapytanie scala kubełki z okna (max 24), więc odpowiedź jest natychmiastowa.
+// Kubełki w FRAM (FRAM_ADDR_AGGREGATES), zapis obok logu cykli.
+
+enum AggregateWindow {
+    AGG_WINDOW_HOUR = 0,
+    AGG_WINDOW_DAY,
+    AGG_WINDOW_WEEK,
+
+    AGG_WINDOW_COUNT
+};
+
+enum AggregateSeries {
+    AGG_VOLUME = 0,                 // volume_dose dolewek [ml]
+    AGG_GAP1,                       // time_gap_1 gdy oba czujniki zaliczyły [s]
+    AGG_GAP2,                       // time_gap_2 gdy oba potwierdziły release [s]
+    AGG_WATER_TRIGGER,              // water_trigger_time z potwierdzeniem [s]
+
+    AGG_SERIES_COUNT
+};
+
+struct AggregateStat {
+    uint32_t sum;
+    uint16_t min;
+    uint16_t max;
+};
+
+// Jeden kubełek = jeden rekord FRAM (48 bajtów danych)
+struct AggregateBucket {
+    uint32_t start;                 // Unix początku kubełka, 0 = pusty
+    uint8_t cycles;                 // Liczniki nasycają się na 255
+    uint8_t clean;                  // Bez błędu i flag
+    uint8_t retries;                // Suma (pump_attempts - 1)
+    uint8_t pumpFailures;           // ERROR_PUMP_FAILURE
+    uint8_t gap1Fails;
+    uint8_t releaseFails;           // Któryś czujnik nie potwierdził release
+    uint8_t waterFails;
+    uint8_t falseTriggers;
+    uint8_t count[AGG_SERIES_COUNT];
+    AggregateStat stat[AGG_SERIES_COUNT];
+};
+
+// Scalone okno (wynik zapytania)
+struct AggregateSummary {
+    uint32_t windowSeconds;
+    uint32_t from;                  // Najstarszy kubełek w oknie, 0 = brak danych
+    uint16_t cycles;
+    uint16_t clean;
+    uint16_t retries;
+    uint16_t pumpFailures;
+    uint16_t gap1Fails;
+    uint16_t releaseFails;
+    uint16_t waterFails;
+    uint16_t falseTriggers;
+    uint16_t count[AGG_SERIES_COUNT];
+    uint32_t sum[AGG_SERIES_COUNT];
+    uint16_t min[AGG_SERIES_COUNT];
+    uint16_t max[AGG_SERIES_COUNT];
+};
+
+// Po loadCyclesFromStorage(): kubełki z FRAM, a bez nich odbudowa z historii
+void initCycleAggregates(const std::vector<PumpCycle>& history);  // Historia od najstarszego
+
+// Zadanie control (logCycleComplete)
+void aggregatesOnCycle(const PumpCycle& cycle);
+
+// Dowolne zadanie - kopia pod sekcją krytyczną
+AggregateSummary getAggregateSummary(AggregateWindow window, uint32_t nowUnix);
+const char* getAggregateWindowName(AggregateWindow window);
+const char* getAggregateSeriesName(AggregateSeries series);
+
+#endif
@@ -0,0 +1,190 @@
+#include "debounce_profile.h"
+#include "../core/logging.h"
+#include "../hardware/fram_controller.h"
+#include "../hardware/storage_queue.h"
+#include "../hardware/sensor_edges.h"
+
+static_assert(sizeof(DebounceProfile) <= FRAM_RECORD_MAX_DATA, "DebounceProfile too large for FRAM record");
+
+static DebounceProfile profile;
+static DebounceSchedule schedule;
+
+// Bieżący proces
+static bool processActive = false;
+static uint32_t processResets = 0;
+static uint32_t processBouncesStart = 0;
+
+static const char* OUTCOME_NAMES[] = { "PASS", "PREQUAL_FAIL", "PARTIAL", "FALSE_TRIGGER" };
+
+// Interpolacja odcinkami: 0 -> minV, 500 -> defV, 1000 -> maxV
+static uint16_t scaleParam(uint16_t minV, uint16_t defV, uint16_t maxV, uint16_t score) {
+    if (score <= NOISE_SCORE_DEFAULT) {
+        return minV + (uint32_t)(defV - minV) * score / NOISE_SCORE_DEFAULT;
+    }
+    return defV + (uint32_t)(maxV - defV) * (score - NOISE_SCORE_DEFAULT) /
+                  (NOISE_SCORE_MAX - NOISE_SCORE_DEFAULT);
+}
+
+static void rebuildSchedule() {
+    uint16_t score = profile.noiseScore;
+    if (!ENABLE_ADAPTIVE_DEBOUNCE) {
+        score = NOISE_SCORE_DEFAULT;
+    } else if (profile.processes < ADAPT_MIN_PROCESSES && score < NOISE_SCORE_DEFAULT) {
+        score = NOISE_SCORE_DEFAULT;    // Za mało danych na skrócenie
+    }
+
+    schedule.preQualWindow = scaleParam(PRE_QUAL_WINDOW_MIN, PRE_QUAL_WINDOW, PRE_QUAL_WINDOW_MAX, score);
+    schedule.preQualInterval = scaleParam(PRE_QUAL_INTERVAL_MIN, PRE_QUAL_INTERVAL, PRE_QUAL_INTERVAL_MAX, score);
+    schedule.preQualConfirmCount = scaleParam(PRE_QUAL_CONFIRM_COUNT_MIN, PRE_QUAL_CONFIRM_COUNT,
+                                              PRE_QUAL_CONFIRM_COUNT_MAX, score);
+    schedule.settlingTime = scaleParam(SETTLING_TIME_MIN, SETTLING_TIME, SETTLING_TIME_MAX, score);
+    schedule.totalDebounceTime = scaleParam(TOTAL_DEBOUNCE_TIME_MIN, TOTAL_DEBOUNCE_TIME,
+                                            TOTAL_DEBOUNCE_TIME_MAX, score);
+    schedule.debounceInterval = scaleParam(DEBOUNCE_INTERVAL_MIN, DEBOUNCE_INTERVAL, DEBOUNCE_INTERVAL_MAX, score);
+    schedule.debounceCounter = scaleParam(DEBOUNCE_COUNTER_MIN, DEBOUNCE_COUNTER, DEBOUNCE_COUNTER_MAX, score);
+
+    // Okna muszą pomieścić wymagane pomiary (granice MAX sprawdza static_assert)
+    uint16_t minWindow = (schedule.preQualConfirmCount - 1) * schedule.preQualInterval;
+    if (schedule.preQualWindow < minWindow) {
+        schedule.preQualWindow = minWindow;
+    }
+    uint16_t minDebounce = (schedule.debounceCounter + 1) * schedule.debounceInterval;
+    if (schedule.totalDebounceTime < minDebounce) {
+        schedule.totalDebounceTime = minDebounce;
+    }
+}
+
+static uint32_t totalBounces() {
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+        sum += getSensorEdgeStats(i).bounces;
+    }
+    return sum;
+}
+
+static void logSchedule() {
+    LOG_INFO("Debounce schedule (noise %d/%d, %lu processes): PRE_QUAL=%ds/%d×%ds, SETTLING=%ds, DEBOUNCE=%ds/%d×%ds",
+             profile.noiseScore, NOISE_SCORE_MAX, profile.processes,
+             schedule.preQualWindow, schedule.preQualConfirmCount, schedule.preQualInterval,
+             schedule.settlingTime,
+             schedule.totalDebounceTime, schedule.debounceCounter, schedule.debounceInterval);
+}
+
+static void setDefaults() {
+    memset(&profile, 0, sizeof(profile));
+    profile.noiseScore = NOISE_SCORE_DEFAULT;
+}
+
+void initDebounceProfile() {
+    if (!loadRecordFromFRAM(FRAM_ADDR_DEBOUNCE_PROFILE, &profile, sizeof(profile)) ||
+        profile.noiseScore > NOISE_SCORE_MAX) {
+        setDefaults();
+        LOG_INFO("");
+        LOG_INFO("Debounce profile: no valid FRAM record, starting from defaults");
+    }
+    rebuildSchedule();
+
+    LOG_INFO("");
+    logSchedule();
+}
+
+const DebounceSchedule& getDebounceSchedule() {
+    return schedule;
+}
+
+DebounceSchedule getDefaultDebounceSchedule() {
+    DebounceSchedule fixed;
+    fixed.preQualWindow = PRE_QUAL_WINDOW;
+    fixed.preQualInterval = PRE_QUAL_INTERVAL;
+    fixed.preQualConfirmCount = PRE_QUAL_CONFIRM_COUNT;
+    fixed.settlingTime = SETTLING_TIME;
+    fixed.totalDebounceTime = TOTAL_DEBOUNCE_TIME;
+    fixed.debounceInterval = DEBOUNCE_INTERVAL;
+    fixed.debounceCounter = DEBOUNCE_COUNTER;
+    return fixed;
+}
+
+DebounceProfile getDebounceProfile() {
+    return profile;
+}
+
+bool isAdaptiveDebounceActive() {
+    return ENABLE_ADAPTIVE_DEBOUNCE;
+}
+
+void debounceProfileBeginProcess() {
+    processActive = true;
+    processResets = 0;
+    processBouncesStart = totalBounces();
+}
+
+void debounceProfileCounterReset() {
+    if (processActive) {
+        processResets++;
+    }
+}
+
+void debounceProfileEndProcess(DebounceOutcome outcome) {
+    if (!processActive) {
+        return;
+    }
+    processActive = false;
+
+    uint32_t bounces = totalBounces() - processBouncesStart;
+    uint32_t sample;
+
+    switch (outcome) {
+        case DEBOUNCE_OUTCOME_FALSE_TRIGGER:
+            sample = NOISE_SCORE_MAX;
+            profile.falseTriggers++;
+            break;
+        case DEBOUNCE_OUTCOME_PREQUAL_FAIL:
+            sample = NOISE_SCORE_MAX * 3 / 4;
+            profile.preQualFails++;
+            break;
+        case DEBOUNCE_OUTCOME_PARTIAL:
+            sample = NOISE_SCORE_MAX * 3 / 4;
+            profile.gap1Fails++;
+            break;
+        default:
+            // Sukces: wynik rośnie z liczbą resetów liczników i drgań
+            sample = processResets * 200 + bounces * 20;
+            if (sample > NOISE_SCORE_MAX) {
+                sample = NOISE_SCORE_MAX;
+            }
+            if (processResets == 0 && bounces == 0) {
+                profile.cleanPasses++;
+            }
+            break;
+    }
+
+    profile.processes++;
+    profile.counterResets += processResets;
+    profile.bounces += bounces;
+
+    uint16_t oldScore = profile.noiseScore;
+    if (sample > profile.noiseScore) {
+        profile.noiseScore += (sample - profile.noiseScore + 1) / 2;
+    } else {
+        profile.noiseScore -= (profile.noiseScore - sample) / 8;
+    }
+
+    rebuildSchedule();
+    queueRecordSave(FRAM_ADDR_DEBOUNCE_PROFILE, &profile, sizeof(profile));
+
+    LOG_INFO("");
+    LOG_INFO("Debounce profile: %s (resets=%lu, bounces=%lu), noise %d -> %d",
+             OUTCOME_NAMES[outcome], processResets, bounces, oldScore, profile.noiseScore);
+    logSchedule();
+}
+
+void resetDebounceProfile() {
+    setDefaults();
+    processActive = false;
+    rebuildSchedule();
+    queueRecordSave(FRAM_ADDR_DEBOUNCE_PROFILE, &profile, sizeof(profile));
+
+    LOG_INFO("");
+    LOG_INFO("Debounce profile reset to defaults");
+    logSchedule();
+}
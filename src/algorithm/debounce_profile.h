@@ -0,0 +1,63 @@
+#ifndef DEBOUNCE_PROFILE_H
+#define DEBOUNCE_PROFILE_H
+
+#include <Arduino.h>
+#include "algorithm_config.h"
+
+// ============== ADAPTIVE DEBOUNCE PROFILE ==============
+// Statystyki szumu instalacji (drgania pływaków, resety liczników,
+// PRE_QUAL fail, GAP1, FALSE_TRIGGER) -> wynik szumu 0..1000 (EWMA).
+// Harmonogram fazy 1 skalowany z wyniku w granicach *_MIN/*_MAX z
+// algorithm_config.h: 0 = MIN, 500 = wartości domyślne, 1000 = MAX.
+// Zdarzenia "hałaśliwe" podnoszą wynik szybko (alfa 1/2), spokojne
+// procesy obniżają go powoli (alfa 1/8) - w razie wątpliwości ostrożnie.
+// Harmonogram zmienia się tylko po zakończeniu procesu, nigdy w trakcie.
+
+#define NOISE_SCORE_DEFAULT     500
+#define NOISE_SCORE_MAX         1000
+
+struct DebounceSchedule {
+    uint16_t preQualWindow;         // s
+    uint16_t preQualInterval;       // s
+    uint8_t preQualConfirmCount;
+    uint16_t settlingTime;          // s
+    uint16_t totalDebounceTime;     // s
+    uint16_t debounceInterval;      // s
+    uint8_t debounceCounter;
+};
+
+// Zapisywany w FRAM (FRAM_ADDR_DEBOUNCE_PROFILE)
+struct DebounceProfile {
+    uint16_t noiseScore;            // 0..NOISE_SCORE_MAX
+    uint16_t reserved;
+    uint32_t processes;             // Procesy zakończone wynikiem
+    uint32_t cleanPasses;           // Oba czujniki bez resetów i drgań
+    uint32_t preQualFails;
+    uint32_t gap1Fails;             // Tylko jeden czujnik zaliczył
+    uint32_t falseTriggers;         // RESULT_FALSE_TRIGGER
+    uint32_t counterResets;         // HIGH w trakcie PRE_QUAL / DEBOUNCING
+    uint32_t bounces;               // Drgania zboczy w trakcie procesów
+};
+
+enum DebounceOutcome {
+    DEBOUNCE_OUTCOME_PASS = 0,      // Oba czujniki zaliczyły
+    DEBOUNCE_OUTCOME_PREQUAL_FAIL,
+    DEBOUNCE_OUTCOME_PARTIAL,       // GAP1_FAIL
+    DEBOUNCE_OUTCOME_FALSE_TRIGGER
+};
+
+void initDebounceProfile();         // Po initFRAM()
+
+const DebounceSchedule& getDebounceSchedule();
+DebounceSchedule getDefaultDebounceSchedule();  // Stały harmonogram (kanały 1+, bez profilu)
+DebounceProfile getDebounceProfile();
+bool isAdaptiveDebounceActive();
+
+// Wywołania z water_sensors.cpp (zadanie control, tylko kanał 0)
+void debounceProfileBeginProcess();
+void debounceProfileCounterReset();
+void debounceProfileEndProcess(DebounceOutcome outcome);
+
+void resetDebounceProfile();        // Powrót do harmonogramu domyślnego
+
+#endif
@@ -0,0 +1,206 @@
+#include "dose_sizing.h"
+#include "../core/logging.h"
+#include "../hardware/rtc_controller.h"
+#include "evaporation_model.h"
+#include "consumption_archive.h"
+
+#define DOSE_MIN_SPAN_S         3600            // Krótsza historia nie daje tempa
+
+struct RefillEvent {
+    uint32_t timestamp;
+    uint16_t volumeMl;
+};
+
+static RefillEvent events[DOSE_HISTORY_CYCLES];
+static uint8_t eventCount = 0;
+static uint8_t eventHead = 0;
+static float lastReleaseMl = 0.0f;
+static float consumptionRate = 0.0f;       // Przeliczane przy każdej dolewce
+static DoseDecision lastDecision;
+
+static float computeConsumptionRate();
+
+static const RefillEvent& eventAt(uint8_t n) {     // 0 = najstarsza
+    return events[(eventHead + DOSE_HISTORY_CYCLES - eventCount + n) % DOSE_HISTORY_CYCLES];
+}
+
+static bool addEvent(uint32_t timestamp, uint16_t volumeMl) {
+    if (eventCount > 0 && timestamp <= eventAt(eventCount - 1).timestamp) {
+        return false;   // Czas cofnięty (korekta RTC) - pomiń
+    }
+    events[eventHead].timestamp = timestamp;
+    events[eventHead].volumeMl = volumeMl;
+    eventHead = (eventHead + 1) % DOSE_HISTORY_CYCLES;
+    if (eventCount < DOSE_HISTORY_CYCLES) {
+        eventCount++;
+    }
+    consumptionRate = computeConsumptionRate();
+    return true;
+}
+
+static bool isDeliveredCycle(const PumpCycle& cycle) {
+    return cycle.volume_dose > 0 && cycle.error_code == ERROR_NONE &&
+           isUnixTimeValid(cycle.timestamp);
+}
+
+// Objętość od startu pompy do podniesienia pływaków w czystym cyklu
+static void updateReleaseVolume(const PumpCycle& cycle, float volumePerSecond) {
+    if (cycle.pump_attempts != 1 || (cycle.sensor_results & PumpCycle::RESULT_WATER_FAIL) ||
+        cycle.water_trigger_time >= WATER_TRIGGER_MAX_TIME) {
+        return;
+    }
+    float reaction = cycle.water_trigger_time + cycle.time_gap_2 / 2.0f - RELEASE_CONFIRM_LAG;
+    if (reaction > 0.0f) {
+        lastReleaseMl = reaction * volumePerSecond;
+    }
+}
+
+void initDoseSizing(const std::vector<PumpCycle>& history) {
+    eventCount = 0;
+    eventHead = 0;
+    lastReleaseMl = 0.0f;
+    consumptionRate = 0.0f;
+    memset(&lastDecision, 0, sizeof(lastDecision));
+    lastDecision.limitedBy = "none";
+    lastDecision.rateSource = "none";
+
+    for (const auto& cycle : history) {
+        if (isDeliveredCycle(cycle)) {
+            addEvent(cycle.timestamp, cycle.volume_dose);
+        }
+    }
+
+    LOG_INFO("");
+    LOG_INFO("Dose sizing: %s, %d refills in history, consumption %.1f ml/h",
+             ENABLE_DOSE_SIZING ? "deficit-proportional" : "fixed SINGLE_DOSE_VOLUME",
+             eventCount, getConsumptionRateMlPerHour());
+}
+
+static float computeConsumptionRate() {
+    if (eventCount < 3) {
+        return 0.0f;
+    }
+    uint32_t span = eventAt(eventCount - 1).timestamp - eventAt(0).timestamp;
+    if (span < DOSE_MIN_SPAN_S) {
+        return 0.0f;
+    }
+    // Dolewka i uzupełnia ubytek z przedziału (i-1, i] - pierwsza nie wchodzi
+    uint32_t volume = 0;
+    for (uint8_t n = 1; n < eventCount; n++) {
+        volume += eventAt(n).volumeMl;
+    }
+    return volume * 3600.0f / span;
+}
+
+float getConsumptionRateMlPerHour() {
+    return consumptionRate;
+}
+
+void doseSizingOnCycle(const PumpCycle& cycle, float volumePerSecond) {
+    if (!isDeliveredCycle(cycle)) {
+        return;
+    }
+    addEvent(cycle.timestamp, cycle.volume_dose);
+    updateReleaseVolume(cycle, volumePerSecond);
+}
+
+// Pompa poza cyklem AUTO też uzupełnia zbiornik - bez tego deficyt po ręcznej
+// dolewce liczony byłby od ostatniego cyklu AUTO, do pełnego DOSE_MAX_VOLUME
+void doseSizingOnManualRefill(uint32_t nowUnix, uint16_t volumeMl) {
+    if (volumeMl == 0 || !isUnixTimeValid(nowUnix)) {
+        return;
+    }
+    addEvent(nowUnix, volumeMl);
+}
+
+// Historia cykli zna tylko AUTO: ręczne dolewki po ostatniej z nich odtwarzane
+// z kubełków 30 min archiwum (czas = koniec kubełka, nie później niż teraz)
+void doseSizingSeedManualRefills(uint32_t nowUnix) {
+    if (!isUnixTimeValid(nowUnix)) {
+        return;
+    }
+    ArchiveBucket buckets[48];
+    uint8_t count = getArchiveBuckets(ARCHIVE_HALF_HOUR, nowUnix, buckets, 48);
+    uint32_t bucketSeconds = getArchiveBucketSeconds(ARCHIVE_HALF_HOUR);
+    uint8_t seeded = 0;
+    for (uint8_t n = 0; n < count; n++) {
+        if (buckets[n].period == 0 || buckets[n].manualMl == 0) {
+            continue;
+        }
+        uint32_t end = getArchiveBucketStart(ARCHIVE_HALF_HOUR, buckets[n].period) + bucketSeconds - 1;
+        // Starsze niż ostatnia dolewka z historii - pominięte
+        if (addEvent(end < nowUnix ? end : nowUnix, buckets[n].manualMl)) {
+            seeded++;
+        }
+    }
+    if (seeded > 0) {
+        LOG_INFO("");
+        LOG_INFO("Dose sizing: %d manual refills restored from the archive", seeded);
+    }
+}
+
+DoseDecision planDose(uint32_t nowUnix, float volumePerSecond, uint16_t dailyRemainingMl) {
+    DoseDecision d;
+    d.rateMlPerHour = consumptionRate;
+    d.rateSource = consumptionRate > 0.0f ? "history" : "none";
+    d.hoursSinceRefill = 0.0f;
+    d.deficitMl = 0.0f;
+    if (eventCount > 0 && isUnixTimeValid(nowUnix) && nowUnix > eventAt(eventCount - 1).timestamp) {
+        uint32_t lastRefill = eventAt(eventCount - 1).timestamp;
+        d.hoursSinceRefill = (nowUnix - lastRefill) / 3600.0f;
+        if (isEvaporationModelReady()) {
+            // Profil godzinowy: noc i dzień z własnym tempem zamiast średniej
+            d.deficitMl = getEvaporationConsumptionMl(lastRefill, nowUnix);
+            d.rateMlPerHour = d.hoursSinceRefill > 0.0f ? d.deficitMl / d.hoursSinceRefill : 0.0f;
+            d.rateSource = "model";
+        } else {
+            d.deficitMl = d.rateMlPerHour * d.hoursSinceRefill;
+        }
+    }
+    d.releaseFloorMl = lastReleaseMl * DOSE_RELEASE_MARGIN_PERCENT / 100.0f;
+
+    float volume = SINGLE_DOSE_VOLUME;
+    d.limitedBy = "min_dose";
+
+    if (!ENABLE_DOSE_SIZING) {
+        d.limitedBy = "fixed";
+    } else {
+        if (d.deficitMl > volume) {
+            volume = d.deficitMl;
+            d.limitedBy = "deficit";
+        }
+        if (d.releaseFloorMl > volume) {
+            volume = d.releaseFloorMl;
+            d.limitedBy = "release";
+        }
+        if (volume > DOSE_MAX_VOLUME) {
+            volume = DOSE_MAX_VOLUME;
+            d.limitedBy = "max_dose";
+        }
+        // Limit dzienny nie schodzi poniżej stałej dawki - przekroczenie
+        // obsługuje jak dotąd ERROR_DAILY_LIMIT po cyklu
+        float dailyCap = dailyRemainingMl > SINGLE_DOSE_VOLUME ? dailyRemainingMl : SINGLE_DOSE_VOLUME;
+        if (volume > dailyCap) {
+            volume = dailyCap;
+            d.limitedBy = "daily_limit";
+        }
+    }
+
+    uint16_t seconds = (uint16_t)(volume / volumePerSecond);
+    if (seconds == 0) {
+        seconds = 1;
+    }
+    if (!validatePumpWorkTime(seconds)) {
+        seconds = WATER_TRIGGER_MAX_TIME - 10;
+        d.limitedBy = "trigger_time";
+    }
+    d.pumpSeconds = seconds;
+    d.volumeMl = (uint16_t)(seconds * volumePerSecond);
+
+    lastDecision = d;
+    return d;
+}
+
+const DoseDecision& getLastDoseDecision() {
+    return lastDecision;
+}
@@ -0,0 +1,40 @@
+#ifndef DOSE_SIZING_H
+#define DOSE_SIZING_H
+
+#include <Arduino.h>
+#include <vector>
+#include "algorithm_config.h"
+
+// ============== DOSE SIZING ==============
+// Wielkość dawki z deficytu zamiast stałej SINGLE_DOSE_VOLUME:
+//   tempo ubytku [ml/h] = objętość ostatnich dolewek / czas między nimi
+//   deficyt = tempo × godziny od ostatniej dolewki (po nauczeniu modelu
+//             parowania: suma profilu godzinowego od ostatniej dolewki)
+//   zapas release = objętość potrzebna w ostatnim cyklu do podniesienia
+//                   pływaków (przepływ × czas reakcji) × margines
+// Po długiej przerwie / przy dużym parowaniu jeden cykl uzupełnia cały
+// ubytek zamiast kilku 20-minutowych procesów detekcji.
+
+struct DoseDecision {
+    uint16_t volumeMl;              // Dawka po ograniczeniach
+    uint16_t pumpSeconds;
+    float deficitMl;                // Tempo × czas od ostatniej dolewki
+    float releaseFloorMl;           // Zapas na release (0 = brak danych)
+    float rateMlPerHour;            // 0 = za mało historii
+    const char* rateSource;         // "model" (profil godzinowy), "history", "none"
+    float hoursSinceRefill;
+    const char* limitedBy;          // Co zdecydowało o wielkości dawki
+};
+
+void initDoseSizing(const std::vector<PumpCycle>& history);  // Historia od najstarszego
+
+// Zadanie control
+void doseSizingOnCycle(const PumpCycle& cycle, float volumePerSecond);
+void doseSizingOnManualRefill(uint32_t nowUnix, uint16_t volumeMl);    // Ręczna / kalibracja / direct
+void doseSizingSeedManualRefills(uint32_t nowUnix);     // Po restarcie, z archiwum 30 min (RTC gotowy)
+DoseDecision planDose(uint32_t nowUnix, float volumePerSecond, uint16_t dailyRemainingMl);
+const DoseDecision& getLastDoseDecision();
+
+float getConsumptionRateMlPerHour();
+
+#endif
@@ -0,0 +1,289 @@
+#include "evaporation_model.h"
+#include "../core/logging.h"
+#include "../hardware/fram_controller.h"
+#include "../hardware/storage_queue.h"
+#include "../hardware/rtc_controller.h"
+#include <time.h>
+
+#define EVAP_RATE_UNKNOWN       0xFFFF
+#define EVAP_RATE_MAX           65000           // 6500 ml/h - poza zakresem = błąd pomiaru
+#define EVAP_DAY_S              86400UL
+
+// Zapisywany w FRAM (FRAM_ADDR_EVAPORATION_PROFILE)
+struct EvaporationProfile {
+    uint16_t rate[24];              // [0.1 ml/h] dla godziny lokalnej, EVAP_RATE_UNKNOWN = brak
+};
+
+static_assert(sizeof(EvaporationProfile) <= FRAM_RECORD_MAX_DATA, "EvaporationProfile too large for FRAM record");
+
+static float rates[24];             // [ml/h], < 0 = brak danych
+static uint8_t learnedHours = 0;
+static float meanRate = 0.0f;       // Zastępuje godziny bez danych
+static float dailyMl = 0.0f;
+static float triggerDeficitMl = 0.0f;
+static uint32_t lastRefillUnix = 0;
+static uint32_t nextRefillUnix = 0; // Przeliczane przy dolewce - control tylko porównuje
+
+static bool isDeliveredCycle(const PumpCycle& cycle) {
+    return cycle.volume_dose > 0 && isUnixTimeValid(cycle.timestamp);
+}
+
+// Przedział uczy tylko po czystej dolewce - przy błędzie woda mogła nie dojść
+static bool isCleanCycle(const PumpCycle& cycle) {
+    return cycle.error_code == ERROR_NONE && !(cycle.sensor_results & PumpCycle::RESULT_WATER_FAIL);
+}
+
+// Godzina lokalna i sekundy do jej końca
+static uint8_t localHour(uint32_t timestamp, uint32_t* secondsLeft) {
+    time_t t = timestamp;
+    struct tm tmv;
+    localtime_r(&t, &tmv);
+    *secondsLeft = 3600 - (tmv.tm_min * 60 + tmv.tm_sec);
+    return tmv.tm_hour;
+}
+
+static void updateSummary() {
+    learnedHours = 0;
+    float sum = 0.0f;
+    for (uint8_t h = 0; h < 24; h++) {
+        if (rates[h] >= 0.0f) {
+            learnedHours++;
+            sum += rates[h];
+        }
+    }
+    meanRate = learnedHours > 0 ? sum / learnedHours : 0.0f;
+    dailyMl = sum + meanRate * (24 - learnedHours);
+}
+
+static float rateAt(uint8_t hour) {
+    return rates[hour] >= 0.0f ? rates[hour] : meanRate;
+}
+
+static void saveProfile() {
+    EvaporationProfile profile;
+    for (uint8_t h = 0; h < 24; h++) {
+        if (rates[h] < 0.0f) {
+            profile.rate[h] = EVAP_RATE_UNKNOWN;
+        } else {
+            float deci = rates[h] * 10.0f + 0.5f;
+            profile.rate[h] = deci > EVAP_RATE_MAX ? EVAP_RATE_MAX : (uint16_t)deci;
+        }
+    }
+    queueRecordSave(FRAM_ADDR_EVAPORATION_PROFILE, &profile, sizeof(profile));
+}
+
+static bool loadProfile() {
+    EvaporationProfile profile;
+    if (!loadRecordFromFRAM(FRAM_ADDR_EVAPORATION_PROFILE, &profile, sizeof(profile))) {
+        return false;
+    }
+    for (uint8_t h = 0; h < 24; h++) {
+        if (profile.rate[h] != EVAP_RATE_UNKNOWN && profile.rate[h] > EVAP_RATE_MAX) {
+            return false;
+        }
+        rates[h] = profile.rate[h] == EVAP_RATE_UNKNOWN ? -1.0f : profile.rate[h] / 10.0f;
+    }
+    return true;
+}
+
+// Ubytek volumeMl w przedziale (fromUnix, toUnix] -> EWMA pokrytych godzin
+static bool learnInterval(uint32_t fromUnix, uint32_t toUnix, uint16_t volumeMl) {
+    if (toUnix <= fromUnix || toUnix - fromUnix > EVAP_MAX_INTERVAL_HOURS * 3600UL) {
+        return false;
+    }
+    float rate = volumeMl * 3600.0f / (toUnix - fromUnix);
+    if (rate * 10.0f > EVAP_RATE_MAX) {
+        return false;
+    }
+
+    float coverage[24] = {0};       // Godziny obserwacji w danym slocie doby
+    uint32_t t = fromUnix;
+    while (t < toUnix) {
+        uint32_t secondsLeft;
+        uint8_t hour = localHour(t, &secondsLeft);
+        uint32_t step = secondsLeft < toUnix - t ? secondsLeft : toUnix - t;
+        coverage[hour] += step / 3600.0f;
+        t += step;
+    }
+
+    for (uint8_t h = 0; h < 24; h++) {
+        if (coverage[h] <= 0.0f) {
+            continue;
+        }
+        if (rates[h] < 0.0f) {
+            rates[h] = rate;
+            continue;
+        }
+        float weight = coverage[h] < 1.0f ? coverage[h] : 1.0f;
+        rates[h] += weight * (rate - rates[h]) / (1 << EVAP_EWMA_SHIFT);
+    }
+    updateSummary();
+    return true;
+}
+
+// Typowa dawka: EWMA objętości dolewek (alfa 1/4)
+static void updateTriggerDeficit(uint16_t volumeMl) {
+    if (triggerDeficitMl <= 0.0f) {
+        triggerDeficitMl = volumeMl;
+    } else {
+        triggerDeficitMl += (volumeMl - triggerDeficitMl) / 4.0f;
+    }
+}
+
+// Moment, w którym ubytek od startUnix osiągnie volumeMl (0 = poza horyzontem)
+static uint32_t forecastReach(uint32_t startUnix, float volumeMl, uint32_t horizonS) {
+    if (dailyMl <= 0.0f || volumeMl <= 0.0f) {
+        return 0;
+    }
+    uint32_t t = startUnix;
+    float remaining = volumeMl;
+
+    // Każde pełne 24h ubywa dailyMl - przeskocz całe doby, dokończ godzinami
+    uint32_t days = (uint32_t)(remaining / dailyMl);
+    if (days > 1) {
+        days--;
+        if ((uint64_t)days * EVAP_DAY_S > horizonS) {
+            return 0;
+        }
+        t += days * EVAP_DAY_S;
+        remaining -= days * dailyMl;
+    }
+
+    while (t - startUnix < horizonS) {
+        uint32_t secondsLeft;
+        float rate = rateAt(localHour(t, &secondsLeft));
+        float slotMl = rate * secondsLeft / 3600.0f;
+        if (slotMl >= remaining) {
+            return t + (uint32_t)(remaining / rate * 3600.0f);
+        }
+        remaining -= slotMl;
+        t += secondsLeft;
+    }
+    return 0;
+}
+
+static void updateNextRefill() {
+    nextRefillUnix = 0;
+    if (isEvaporationModelReady() && lastRefillUnix > 0) {
+        nextRefillUnix = forecastReach(lastRefillUnix, triggerDeficitMl, EVAP_MAX_INTERVAL_HOURS * 3600UL);
+    }
+}
+
+void initEvaporationModel(const std::vector<PumpCycle>& history) {
+    for (uint8_t h = 0; h < 24; h++) {
+        rates[h] = -1.0f;
+    }
+    triggerDeficitMl = 0.0f;
+    lastRefillUnix = 0;
+
+    bool loaded = loadProfile();
+    uint8_t learned = 0;
+
+    for (const auto& cycle : history) {
+        if (!isDeliveredCycle(cycle) || cycle.timestamp <= lastRefillUnix) {
+            continue;
+        }
+        if (isCleanCycle(cycle)) {
+            // Profil z FRAM zawiera już te przedziały - tylko bez niego ucz z historii
+            if (!loaded && lastRefillUnix > 0 && learnInterval(lastRefillUnix, cycle.timestamp, cycle.volume_dose)) {
+                learned++;
+            }
+            updateTriggerDeficit(cycle.volume_dose);
+        }
+        lastRefillUnix = cycle.timestamp;
+    }
+
+    updateSummary();
+    updateNextRefill();
+    if (learned > 0) {
+        saveProfile();
+    }
+
+    LOG_INFO("");
+    LOG_INFO("Evaporation model: %s, %d/24 hours learned%s, %.0f ml/day, typical dose %.0f ml",
+             loaded ? "FRAM profile" : "no FRAM profile", learnedHours,
+             learned > 0 ? " (from cycle history)" : "", dailyMl, triggerDeficitMl);
+}
+
+void evaporationOnCycle(const PumpCycle& cycle) {
+    if (!ENABLE_EVAPORATION_MODEL || !isDeliveredCycle(cycle) || cycle.timestamp <= lastRefillUnix) {
+        return;
+    }
+    if (isCleanCycle(cycle)) {
+        if (lastRefillUnix > 0 && learnInterval(lastRefillUnix, cycle.timestamp, cycle.volume_dose)) {
+            saveProfile();
+        }
+        updateTriggerDeficit(cycle.volume_dose);
+    }
+    lastRefillUnix = cycle.timestamp;
+    updateNextRefill();
+
+    if (nextRefillUnix > 0) {
+        LOG_INFO("");
+        LOG_INFO("Evaporation model: %.0f ml/day, next refill expected in %.1fh",
+                 dailyMl, (nextRefillUnix - lastRefillUnix) / 3600.0f);
+    }
+}
+
+bool isEvaporationModelReady() {
+    return ENABLE_EVAPORATION_MODEL && learnedHours >= EVAP_MIN_LEARNED_HOURS;
+}
+
+bool isRefillExpectedSoon(uint32_t nowUnix) {
+    if (nextRefillUnix == 0 || !isUnixTimeValid(nowUnix)) {
+        return false;
+    }
+    // Okno symetryczne - spóźniona dolewka nie blokuje spoczynku na stałe
+    const uint32_t window = EVAP_PREWARM_MINUTES * 60UL;
+    return nowUnix + window >= nextRefillUnix && nowUnix <= nextRefillUnix + window;
+}
+
+float getEvaporationConsumptionMl(uint32_t fromUnix, uint32_t toUnix) {
+    if (toUnix <= fromUnix || learnedHours == 0) {
+        return 0.0f;
+    }
+    uint32_t t = fromUnix;
+    float total = 0.0f;
+
+    uint32_t days = (toUnix - fromUnix) / EVAP_DAY_S;
+    if (days > 1) {
+        t += (days - 1) * EVAP_DAY_S;
+        total += (days - 1) * dailyMl;
+    }
+
+    while (t < toUnix) {
+        uint32_t secondsLeft;
+        float rate = rateAt(localHour(t, &secondsLeft));
+        uint32_t step = secondsLeft < toUnix - t ? secondsLeft : toUnix - t;
+        total += rate * step / 3600.0f;
+        t += step;
+    }
+    return total;
+}
+
+float getHourlyEvaporationRate(uint8_t hour) {
+    return hour < 24 ? rates[hour] : -1.0f;
+}
+
+EvaporationForecast getEvaporationForecast(uint32_t nowUnix, uint32_t reservoirMl) {
+    EvaporationForecast forecast;
+    forecast.ready = isEvaporationModelReady();
+    forecast.learnedHours = learnedHours;
+    forecast.dailyMl = dailyMl;
+    forecast.triggerDeficitMl = triggerDeficitMl;
+    forecast.lastRefillUnix = lastRefillUnix;
+    forecast.nextRefillUnix = nextRefillUnix;
+    forecast.prewarm = isRefillExpectedSoon(nowUnix);
+    forecast.currentRateMlPerHour = 0.0f;
+    forecast.reservoirEmptyUnix = 0;
+
+    if (learnedHours > 0 && isUnixTimeValid(nowUnix)) {
+        uint32_t secondsLeft;
+        forecast.currentRateMlPerHour = rateAt(localHour(nowUnix, &secondsLeft));
+        if (forecast.ready) {
+            forecast.reservoirEmptyUnix = reservoirMl == 0 ? nowUnix :
+                forecastReach(nowUnix, reservoirMl, EVAP_FORECAST_MAX_DAYS * EVAP_DAY_S);
+        }
+    }
+    return forecast;
+}
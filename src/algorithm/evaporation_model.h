@@ -0,0 +1,43 @@
+#ifndef EVAPORATION_MODEL_H
+#define EVAPORATION_MODEL_H
+
+#include <Arduino.h>
+#include <vector>
+#include "algorithm_config.h"
+
+// ============== EVAPORATION MODEL ==============
+// Tempo ubytku wody dla każdej godziny doby (czas lokalny). Dolewka
+// uzupełnia to, co ubyło od poprzedniej, więc objętość / czas przedziału
+// rozkładana jest na godziny, które przedział pokrył, i wchodzi do EWMA
+// tych godzin (waga = pokryta część godziny).
+// Prognozy:
+//   następna dolewka  - gdy ubytek od ostatniej dolewki osiągnie typową
+//                       dawkę (EWMA objętości dolewek)
+//   opróżnienie zbiornika - gdy ubytek od teraz osiągnie availableVolumeCurrent
+// Profil godzinowy w FRAM (FRAM_ADDR_EVAPORATION_PROFILE).
+
+struct EvaporationForecast {
+    bool ready;                     // >= EVAP_MIN_LEARNED_HOURS godzin z danymi
+    uint8_t learnedHours;
+    float dailyMl;                  // Suma profilu (brakujące godziny = średnia)
+    float currentRateMlPerHour;     // Godzina 'now'
+    float triggerDeficitMl;         // Typowy ubytek wyzwalający dolewkę
+    uint32_t lastRefillUnix;        // 0 = brak
+    uint32_t nextRefillUnix;        // 0 = brak prognozy
+    uint32_t reservoirEmptyUnix;    // 0 = brak prognozy / poza horyzontem
+    bool prewarm;                   // Okno przed prognozowaną dolewką
+};
+
+// Po loadCyclesFromStorage(): profil z FRAM, a bez niego nauka z historii
+void initEvaporationModel(const std::vector<PumpCycle>& history);  // Historia od najstarszego
+
+// Zadanie control
+void evaporationOnCycle(const PumpCycle& cycle);
+bool isRefillExpectedSoon(uint32_t nowUnix);
+
+bool isEvaporationModelReady();
+float getEvaporationConsumptionMl(uint32_t fromUnix, uint32_t toUnix);
+float getHourlyEvaporationRate(uint8_t hour);   // < 0 = godzina bez danych
+EvaporationForecast getEvaporationForecast(uint32_t nowUnix, uint32_t reservoirMl);
+
+#endif
@@ -0,0 +1,245 @@
+#include "flow_calibration.h"
+#include "../core/logging.h"
+#include "../core/metrics.h"
+#include "../config/config.h"
+#include "../hardware/fram_controller.h"
+#include "../hardware/storage_queue.h"
+
+#define FLOW_RATE_MIN   0.1f    // Ten sam zakres co /api/pump-settings
+#define FLOW_RATE_MAX   20.0f
+
+// Zapisywany w FRAM (FRAM_ADDR_FLOW_CALIBRATION)
+struct FlowCalibrationRecord {
+    float referenceVolumeMl;        // 0 = odniesienie w trakcie zbierania
+    float baselineRate;             // ml/s przy wyznaczaniu odniesienia
+    uint8_t sampleCount;
+    uint8_t sampleHead;             // Następny slot do zapisu
+    uint8_t baselineSamples;
+    uint8_t reserved;
+    uint16_t samples[FLOW_CAL_WINDOW];  // Czas reakcji [0.1 s], ring
+};
+
+static_assert(sizeof(FlowCalibrationRecord) <= FRAM_RECORD_MAX_DATA, "FlowCalibrationRecord too large for FRAM record");
+
+static FlowCalibrationRecord record;
+static float estimatedRate = 0.0f;
+static float driftPercent = 0.0f;
+static float trendPercentPerCycle = 0.0f;
+static float lastReactionTime = 0.0f;
+static bool driftFlag = false;
+static uint32_t appliedCount = 0;
+
+static void sortFloats(float* values, uint8_t count) {
+    for (uint8_t i = 1; i < count; i++) {
+        float v = values[i];
+        int8_t j = i - 1;
+        while (j >= 0 && values[j] > v) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = v;
+    }
+}
+
+static float median(float* values, uint8_t count) {
+    sortFloats(values, count);
+    if (count % 2) {
+        return values[count / 2];
+    }
+    return (values[count / 2 - 1] + values[count / 2]) / 2.0f;
+}
+
+// Próbki w kolejności od najstarszej [s]
+static uint8_t orderedSamples(float* out) {
+    uint8_t start = (record.sampleHead + FLOW_CAL_WINDOW - record.sampleCount) % FLOW_CAL_WINDOW;
+    for (uint8_t n = 0; n < record.sampleCount; n++) {
+        out[n] = record.samples[(start + n) % FLOW_CAL_WINDOW] / 10.0f;
+    }
+    return record.sampleCount;
+}
+
+static void resetRecord(float rate) {
+    memset(&record, 0, sizeof(record));
+    record.baselineRate = rate;
+    estimatedRate = 0.0f;
+    driftPercent = 0.0f;
+    trendPercentPerCycle = 0.0f;
+    driftFlag = false;
+}
+
+static void saveRecord() {
+    queueRecordSave(FRAM_ADDR_FLOW_CALIBRATION, &record, sizeof(record));
+}
+
+// Theil-Sen: mediana nachyleń par, wyraz wolny = mediana reszt
+static void updateEstimate() {
+    float t[FLOW_CAL_WINDOW];
+    uint8_t n = orderedSamples(t);
+
+    if (record.referenceVolumeMl <= 0.0f || n < FLOW_CAL_MIN_SAMPLES) {
+        estimatedRate = 0.0f;
+        driftPercent = 0.0f;
+        driftFlag = false;
+        return;
+    }
+
+    float slopes[FLOW_CAL_WINDOW * (FLOW_CAL_WINDOW - 1) / 2];
+    uint8_t pairs = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t j = i + 1; j < n; j++) {
+            slopes[pairs++] = (t[j] - t[i]) / (float)(j - i);
+        }
+    }
+    float slope = median(slopes, pairs);
+
+    float residuals[FLOW_CAL_WINDOW];
+    for (uint8_t i = 0; i < n; i++) {
+        residuals[i] = t[i] - slope * i;
+    }
+    float intercept = median(residuals, n);
+
+    float tNow = intercept + slope * (n - 1);
+    if (tNow < 0.5f) {
+        tNow = 0.5f;
+    }
+
+    float configured = currentPumpSettings.volumePerSecond;
+    estimatedRate = record.referenceVolumeMl / tNow;
+    driftPercent = (estimatedRate - configured) * 100.0f / configured;
+    trendPercentPerCycle = -slope * 100.0f / tNow;   // t rośnie = przepływ spada
+
+    bool wasFlagged = driftFlag;
+    driftFlag = fabsf(driftPercent) >= FLOW_DRIFT_THRESHOLD_PERCENT;
+    metricsSetGauge(MG_FLOW_DRIFT_PERMILLE, (int32_t)(driftPercent * 10.0f));
+
+    if (driftFlag && !wasFlagged) {
+        LOG_WARNING("");
+        LOG_WARNING("Flow drift %.1f%%: configured %.2f ml/s, estimated %.2f ml/s",
+                    driftPercent, configured, estimatedRate);
+    } else if (!driftFlag && wasFlagged) {
+        LOG_INFO("");
+        LOG_INFO("Flow drift back within %d%% (%.1f%%)", FLOW_DRIFT_THRESHOLD_PERCENT, driftPercent);
+    }
+}
+
+static void setRate(float rate) {
+    if (rate < FLOW_RATE_MIN) rate = FLOW_RATE_MIN;
+    if (rate > FLOW_RATE_MAX) rate = FLOW_RATE_MAX;
+
+    float oldRate = currentPumpSettings.volumePerSecond;
+    currentPumpSettings.volumePerSecond = rate;
+    queueVolumeSave(rate);
+    appliedCount++;
+    metricsInc(MC_FLOW_CAL_APPLIED);
+
+    LOG_INFO("");
+    LOG_INFO("Flow calibration applied: %.2f -> %.2f ml/s", oldRate, rate);
+    updateEstimate();
+}
+
+void initFlowCalibration() {
+    if (!loadRecordFromFRAM(FRAM_ADDR_FLOW_CALIBRATION, &record, sizeof(record)) ||
+        record.sampleCount > FLOW_CAL_WINDOW || record.sampleHead >= FLOW_CAL_WINDOW) {
+        resetRecord(currentPumpSettings.volumePerSecond);
+        LOG_INFO("");
+        LOG_INFO("Flow calibration: no valid FRAM record, collecting baseline at %.2f ml/s",
+                 currentPumpSettings.volumePerSecond);
+        return;
+    }
+
+    updateEstimate();
+    LOG_INFO("");
+    if (record.referenceVolumeMl > 0.0f) {
+        LOG_INFO("Flow calibration: reference %.1f ml, %d samples, estimate %.2f ml/s (drift %.1f%%)",
+                 record.referenceVolumeMl, record.sampleCount, estimatedRate, driftPercent);
+    } else {
+        LOG_INFO("Flow calibration: baseline %d/%d cycles", record.baselineSamples, FLOW_CAL_BASELINE_CYCLES);
+    }
+}
+
+void flowCalibrationAddCycle(const PumpCycle& cycle, uint32_t reactionMs) {
+    // Tylko czyste cykle: jedna próba, potwierdzony release w trakcie pompowania
+    const uint8_t rejectFlags = PumpCycle::RESULT_WATER_FAIL | PumpCycle::RESULT_FALSE_TRIGGER |
+                                PumpCycle::RESULT_SENSOR1_RELEASE_FAIL | PumpCycle::RESULT_SENSOR2_RELEASE_FAIL;
+    if (cycle.error_code != ERROR_NONE || (cycle.sensor_results & rejectFlags) ||
+        cycle.pump_attempts != 1 || cycle.pump_duration == 0 ||
+        cycle.water_trigger_time >= WATER_TRIGGER_MAX_TIME) {
+        return;
+    }
+
+    if (reactionMs == 0) {
+        return;     // Brak znacznika zbocza (przepełniony ring, wznowiony cykl)
+    }
+
+    float reaction = reactionMs / 1000.0f;
+    if (reaction < 1.0f || reaction > cycle.pump_duration) {
+        return;     // Poziom podniósł się po zatrzymaniu pompy - czas nie mierzy przepływu
+    }
+
+    lastReactionTime = reaction;
+    record.samples[record.sampleHead] = (uint16_t)(reaction * 10.0f + 0.5f);
+    record.sampleHead = (record.sampleHead + 1) % FLOW_CAL_WINDOW;
+    if (record.sampleCount < FLOW_CAL_WINDOW) {
+        record.sampleCount++;
+    }
+    metricsInc(MC_FLOW_CAL_SAMPLES);
+
+    if (record.referenceVolumeMl <= 0.0f) {
+        record.baselineSamples++;
+        if (record.baselineSamples >= FLOW_CAL_BASELINE_CYCLES) {
+            float t[FLOW_CAL_WINDOW];
+            uint8_t n = orderedSamples(t);
+            record.referenceVolumeMl = record.baselineRate * median(t, n);
+            LOG_INFO("");
+            LOG_INFO("Flow calibration baseline: %.1f ml reference at %.2f ml/s",
+                     record.referenceVolumeMl, record.baselineRate);
+        }
+    }
+
+    updateEstimate();
+    saveRecord();
+
+    if (FLOW_AUTO_APPLY && driftFlag) {
+        float configured = currentPumpSettings.volumePerSecond;
+        float maxStep = configured * FLOW_AUTO_APPLY_MAX_STEP_PERCENT / 100.0f;
+        float target = estimatedRate;
+        if (target > configured + maxStep) target = configured + maxStep;
+        if (target < configured - maxStep) target = configured - maxStep;
+        setRate(target);
+    }
+}
+
+void flowCalibrationOnManualRate(float rate) {
+    if (fabsf(rate - record.baselineRate) < 0.001f) {
+        return;     // Ta sama wartość - odniesienie bez zmian
+    }
+    resetRecord(rate);
+    saveRecord();
+    LOG_INFO("");
+    LOG_INFO("Flow calibration: manual rate %.2f ml/s, collecting new baseline", rate);
+}
+
+bool applyFlowEstimate() {
+    if (estimatedRate <= 0.0f) {
+        return false;
+    }
+    setRate(estimatedRate);
+    return true;
+}
+
+FlowCalibrationStatus getFlowCalibrationStatus() {
+    FlowCalibrationStatus status;
+    status.baselineReady = record.referenceVolumeMl > 0.0f;
+    status.baselineSamples = record.baselineSamples;
+    status.samples = record.sampleCount;
+    status.referenceVolumeMl = record.referenceVolumeMl;
+    status.configuredRate = currentPumpSettings.volumePerSecond;
+    status.estimatedRate = estimatedRate;
+    status.driftPercent = driftPercent;
+    status.trendPercentPerCycle = trendPercentPerCycle;
+    status.lastReactionTime = lastReactionTime;
+    status.driftFlag = driftFlag;
+    status.autoApply = FLOW_AUTO_APPLY;
+    status.applied = appliedCount;
+    return status;
+}
@@ -0,0 +1,41 @@
+#ifndef FLOW_CALIBRATION_H
+#define FLOW_CALIBRATION_H
+
+#include <Arduino.h>
+#include "algorithm_config.h"
+
+// ============== FLOW AUTO-CALIBRATION ==============
+// Model: pompa podnosi poziom od progu LOW do progu HIGH pływaka - stała
+// objętość odniesienia V. Czas reakcji t (od startu pompy do zbocza HIGH
+// pływaków, średnia czujników, ze znaczników µs przechwytywania zboczy) = V / Q.
+// Potwierdzenie 3×HIGH co 2s (water_trigger_time, 1s) jest za zgrubne przy
+// progu dryfu 10%. Po ręcznej kalibracji pierwsze
+// FLOW_CAL_BASELINE_CYCLES cykli wyznacza V = Q_set * median(t), potem
+// Q_est = V / t_now, gdzie t_now to wartość prostej Theil-Sena (odporna na
+// pojedyncze cykle z falą / ślimakiem) dla ostatniego cyklu.
+
+struct FlowCalibrationStatus {
+    bool baselineReady;             // V wyznaczone
+    uint8_t baselineSamples;        // Próbki zebrane do odniesienia
+    uint8_t samples;                // Próbki w oknie regresji
+    float referenceVolumeMl;        // V
+    float configuredRate;           // currentPumpSettings.volumePerSecond
+    float estimatedRate;            // Q_est (0 = brak estymaty)
+    float driftPercent;             // (Q_est - Q_set) / Q_set
+    float trendPercentPerCycle;     // Zmiana przepływu na cykl (nachylenie)
+    float lastReactionTime;         // s, ostatnia przyjęta próbka
+    bool driftFlag;                 // |dryf| >= FLOW_DRIFT_THRESHOLD_PERCENT
+    bool autoApply;                 // FLOW_AUTO_APPLY
+    uint32_t applied;               // Liczba korekt od startu
+};
+
+void initFlowCalibration();         // Po loadVolumeFromNVS()
+
+// Zadanie control
+void flowCalibrationAddCycle(const PumpCycle& cycle, uint32_t reactionMs);    // reactionMs = 0: brak zboczy
+void flowCalibrationOnManualRate(float rate);   // Nowe odniesienie
+bool applyFlowEstimate();           // Ręczne zatwierdzenie estymaty
+
+FlowCalibrationStatus getFlowCalibrationStatus();
+
+#endif
@@ -0,0 +1,23 @@
+#include "sensor_vote.h"
+
+const char* getSensorVotePolicyName(SensorVotePolicy policy) {
+    switch (policy) {
+        case SENSOR_VOTE_ANY:       return "any";
+        case SENSOR_VOTE_MAJORITY:  return "majority";
+        case SENSOR_VOTE_K_OF_N:    return "k_of_n";
+        default:                    return "unknown";
+    }
+}
+
+void formatSensorMask(SensorMask mask, const char* setLabel, const char* clearLabel, char* out, size_t outSize) {
+    size_t pos = 0;
+    out[0] = '\0';
+    for (uint8_t i = 0; i < WATER_SENSOR_COUNT && pos < outSize; i++) {
+        int n = snprintf(out + pos, outSize - pos, "%sS%d=%s", i > 0 ? " " : "", i + 1,
+                         (mask & (1U << i)) ? setLabel : clearLabel);
+        if (n < 0) {
+            break;
+        }
+        pos += (size_t)n;
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef SENSOR_VOTE_H
+#define SENSOR_VOTE_H
+
+#include <Arduino.h>
+#include "algorithm_config.h"
+#include "../hardware/hardware_pins.h"
+
+// ============== SENSOR VOTE ==============
+// Stan pływaków kanału jako maska bitowa (bit i = czujnik i kanału).
+// Tick sprawdza wszystkie czujniki kilkoma operacjami bitowymi: popcount
+// maski głosów porównany z progiem polityki (algorithm_config.h).
+
+typedef uint8_t SensorMask;
+
+#define SENSOR_MASK_ALL     ((SensorMask)((1U << WATER_SENSOR_COUNT) - 1))
+
+static_assert(WATER_SENSOR_COUNT >= 1 && WATER_SENSOR_COUNT <= 8, "SensorMask holds 1-8 sensors per channel");
+// K sprawdzane tylko gdy któraś polityka go używa (domyślne K=2 przy jednym
+// pływaku nie blokuje kompilacji); próg i tak obcinany do liczby głosujących.
+static_assert(SENSOR_VOTE_K >= 1, "SENSOR_VOTE_K must be at least 1");
+static_assert((SENSOR_TRIGGER_VOTE != SENSOR_VOTE_K_OF_N && SENSOR_DEBOUNCE_VOTE != SENSOR_VOTE_K_OF_N &&
+               SENSOR_RELEASE_VOTE != SENSOR_VOTE_K_OF_N) || SENSOR_VOTE_K <= WATER_SENSOR_COUNT,
+              "SENSOR_VOTE_K must be 1-WATER_SENSOR_COUNT when a policy is SENSOR_VOTE_K_OF_N");
+
+inline uint8_t sensorMaskCount(SensorMask mask) {
+    return (uint8_t)__builtin_popcount(mask);
+}
+
+// Minimalna liczba głosów spośród voters czujników (0 głosujących = brak progu)
+inline uint8_t sensorVoteThreshold(SensorVotePolicy policy, uint8_t voters) {
+    if (voters == 0) {
+        return 0;
+    }
+    switch (policy) {
+        case SENSOR_VOTE_MAJORITY:  return voters / 2 + 1;
+        case SENSOR_VOTE_K_OF_N:    return SENSOR_VOTE_K < voters ? SENSOR_VOTE_K : voters;
+        case SENSOR_VOTE_ANY:
+        default:                    return 1;
+    }
+}
+
+// Głosy liczone tylko w obrębie voters (np. czujniki wymagane w release)
+inline bool sensorVotePasses(SensorMask votes, SensorVotePolicy policy, SensorMask voters = SENSOR_MASK_ALL) {
+    uint8_t n = sensorMaskCount(voters);
+    return n > 0 && sensorMaskCount(votes & voters) >= sensorVoteThreshold(policy, n);
+}
+
+const char* getSensorVotePolicyName(SensorVotePolicy policy);
+
+// "S1=LOW S2=HIGH S3=LOW" - do logów faz
+void formatSensorMask(SensorMask mask, const char* setLabel, const char* clearLabel, char* out, size_t outSize);
+
+#endif
@@ -7,14 +7,67 @@
 #include "../hardware/hardware_pins.h"
 #include "algorithm_config.h" 
 #include "../hardware/fram_controller.h"  
+#include "../hardware/storage_queue.h"
 #include "../network/vps_logger.h"
 #include "../hardware/rtc_controller.h" 
+#include "../core/metrics.h"
+#include "../core/trace.h"
+#include "flow_calibration.h"
+#include "dose_sizing.h"
+#include "evaporation_model.h"
+#include "anomaly_detector.h"
+#include "cycle_aggregates.h"
+#include "consumption_archive.h"
+#include <esp_timer.h>
+
+#define CHECKPOINT_FLAG_LOGGED      0x01
+#define CHECKPOINT_FLAG_WATER_FAIL  0x02
+#define CHECKPOINT_FLAG_RESUMED     0x04
+
+// Zapisywany w FRAM (FRAM_ADDR_CYCLE_CHECKPOINT + kanał * FRAM_CYCLE_CHECKPOINT_SLOT_SIZE).
+// millis() nie przeżywa restartu - czasy jako wiek w chwili zapisu, przerwę
+// dolicza restoreCheckpoint() z różnicy znaczników RTC.
+struct CycleCheckpoint {
+    PumpCycle cycle;
+    uint32_t savedUnix;                         // 0 = RTC nieważny przy zapisie
+    uint16_t stateAge;                          // s od wejścia w stan (PUMPING: od startu pompy)
+    uint16_t plannedPumpSeconds;
+    uint16_t debounceAge[WATER_SENSOR_COUNT];   // s od zaliczenia debouncingu + 1, 0 = brak
+    uint8_t state;
+    uint8_t pumpAttempts;
+    SensorMask triggeredMask;
+    uint8_t flags;
+};
+
+static_assert(sizeof(CycleCheckpoint) <= FRAM_RECORD_MAX_DATA, "CycleCheckpoint exceeds a storage record");
+static_assert(sizeof(CycleCheckpoint) + FRAM_RECORD_OVERHEAD <= FRAM_CYCLE_CHECKPOINT_SLOT_SIZE,
+              "CycleCheckpoint does not fit its FRAM slot");
+static_assert(WATER_CHANNEL_MAX <= FRAM_CYCLE_CHECKPOINT_CHANNELS,
+              "FRAM_ADDR_CYCLE_CHECKPOINT has no slot for every channel");
+
+static uint16_t checkpointAddr(uint8_t channel) {
+    return FRAM_ADDR_CYCLE_CHECKPOINT + channel * FRAM_CYCLE_CHECKPOINT_SLOT_SIZE;
+}
+
+static WaterAlgorithm waterChannels[WATER_CHANNEL_COUNT] = {
+    WaterAlgorithm(0),
+#if WATER_CHANNEL_COUNT > 1
+    WaterAlgorithm(1),
+#endif
+};
+
+WaterAlgorithm& waterAlgorithm = waterChannels[0];
 
+WaterAlgorithm* WaterAlgorithm::signalOwner = nullptr;
 
-WaterAlgorithm waterAlgorithm;
+WaterAlgorithm& getWaterChannel(uint8_t channel) {
+    return waterChannels[channel < WATER_CHANNEL_COUNT ? channel : 0];
+}
 
-WaterAlgorithm::WaterAlgorithm() {
+WaterAlgorithm::WaterAlgorithm(uint8_t channel) : channel(channel) {
     currentState = STATE_IDLE;
+    metricsLastState = STATE_IDLE;
+    stateStartTime = 0;
     resetCycle();
     dayStartTime = millis();
     
@@ -29,30 +82,37 @@ WaterAlgorithm::WaterAlgorithm() {
     
     lastError = ERROR_NONE;
     errorSignalActive = false;
-    lastSensor1State = false;
-    lastSensor2State = false;
+    resetFeedbackStart = 0;
     todayCycles.clear();
 
-    sensor1DebounceCompleteTime = 0;
-    sensor2DebounceCompleteTime = 0;
+    memset(debounceCompleteTime, 0, sizeof(debounceCompleteTime));
     debouncePhaseActive = false;
 
     // ============== RELEASE VERIFICATION INIT ==============
-    sensor1TriggeredCycle = false;
-    sensor2TriggeredCycle = false;
-    lastReleaseCheck = 0;
-    for (int i = 0; i < 2; i++) {
-        releaseDebounce[i].counter = 0;
-        releaseDebounce[i].confirmed = false;
-        releaseDebounce[i].confirmTime = 0;
-    }
+    triggeredMask = 0;
+    resetReleaseDebounce();
 
     framDataLoaded = false;
     framCycles.clear();
 
+    // Pierwszy update() zapisuje checkpoint (także odtworzony z FRAM)
+    checkpointState = STATE_IDLE;
+    checkpointStateStart = UINT32_MAX;
+    checkpointDebounced = 0;
+    checkpointLogged = false;
+
     // ============== SYSTEM DISABLE FLAG INIT ==============
     systemWasDisabled = false;
 
+    channelVolumePerSecond = 1.0;
+    plannedPumpSeconds = 0;
+    lastRtcWarning = 0;
+    lastInvalidDayWarning = 0;
+    lastRegressionWarning = 0;
+    lastButtonState = HIGH;
+    lastButtonChange = 0;
+    buttonPressed = false;
+
     // NOTE: FRAM data loaded later via initFromFRAM() — called from setup() after initNVS()
 
     pinMode(ERROR_SIGNAL_PIN, OUTPUT);
@@ -63,26 +123,43 @@ WaterAlgorithm::WaterAlgorithm() {
     LOG_INFO("WaterAlgorithm constructor completed (minimal init)");
 }
 
+float WaterAlgorithm::getVolumePerSecond() const {
+    return channel == 0 ? currentPumpSettings.volumePerSecond : channelVolumePerSecond;
+}
+
+void WaterAlgorithm::setVolumePerSecond(float volumePerSecond) {
+    if (channel == 0) {
+        currentPumpSettings.volumePerSecond = volumePerSecond;
+    } else {
+        channelVolumePerSecond = volumePerSecond;
+    }
+    queueVolumeSave(volumePerSecond, channel);
+}
+
 void WaterAlgorithm::resetCycle() {
     currentCycle = {};
-    currentCycle.timestamp = getUnixTimestamp();
+    currentCycle.timestamp = getCachedUnixTimestamp();
     triggerStartTime = 0;
-    sensor1TriggerTime = 0;
-    sensor2TriggerTime = 0;
     pumpStartTime = 0;
+    pumpStartUs = 0;
+    pumpWaitSeconds = 0;
+    pumpWaitStart = 0;
+    pumpWaitLastTry = 0;
+    pumpWaitQueued = false;
     pumpAttempts = 0;
     cycleLogged = false;
     permission_log = true;
     waterFailDetected = false;
-    sensor1DebounceCompleteTime = 0;
-    sensor2DebounceCompleteTime = 0;
+    memset(debounceCompleteTime, 0, sizeof(debounceCompleteTime));
     debouncePhaseActive = false;
 
     // Release verification reset
-    sensor1TriggeredCycle = false;
-    sensor2TriggeredCycle = false;
-    lastReleaseCheck = 0;
+    triggeredMask = 0;
     resetReleaseDebounce();
+
+    cycleResumed = false;
+    verifyResumed = false;
+    cyclePreviousDay = false;
 }
 
 // ============== SYSTEM DISABLE HANDLER ==============
@@ -124,11 +201,11 @@ void WaterAlgorithm::handleSystemDisable() {
     LOG_WARNING("====================================");
     
     // Stop pump if active
-    if (isPumpActive()) {
+    if (pump().isActive()) {
         LOG_WARNING("Stopping active pump");
         LOG_WARNING("");
 
-        stopPump();
+        pump().stop();
     }
     
     // Log partial cycle data to FRAM and VPS
@@ -147,7 +224,7 @@ void WaterAlgorithm::handleSystemDisable() {
             if (pumpedSeconds > currentCycle.pump_duration) {
                 pumpedSeconds = currentCycle.pump_duration;
             }
-            actualVolumeML = (uint16_t)(pumpedSeconds * currentPumpSettings.volumePerSecond);
+            actualVolumeML = autoRunVolumeMl(pumpedSeconds);
         }
         currentCycle.volume_dose = actualVolumeML;
         
@@ -155,13 +232,16 @@ void WaterAlgorithm::handleSystemDisable() {
         framBusy = true;
         if (actualVolumeML > 0) {
             dailyVolumeML += actualVolumeML;
-            saveDailyVolumeToFRAM(dailyVolumeML, lastResetUTCDay);
+            queueDailyVolumeSave(dailyVolumeML, lastResetUTCDay, channel);
             LOG_INFO("");
             LOG_INFO("Partial volume added: %dml, daily total: %dml", actualVolumeML, dailyVolumeML);
         }
 
         // Save to FRAM
         saveCycleToStorage(currentCycle);
+        if (channel == 0) {
+            archiveRecordCycle(currentCycle);
+        }
         framBusy = false;
     }
     
@@ -174,7 +254,109 @@ void WaterAlgorithm::handleSystemDisable() {
     LOG_WARNING("Cycle interrupted - returned to IDLE");
 }
 
+// Metryki i ścieżka trace algorytmu nie mają etykiety kanału - kanał 0
+void WaterAlgorithm::publishTelemetry() {
+    if (channel != 0) {
+        return;
+    }
+    if (currentState != metricsLastState) {
+        metricsInc((MetricCounter)(MC_STATE_ENTER_IDLE + currentState));
+        traceEnd(TRACE_TRACK_ALGORITHM);
+        traceBegin(TRACE_TRACK_ALGORITHM, getStateString());
+        metricsLastState = currentState;
+    }
+    metricsSetGauge(MG_ALGORITHM_STATE, currentState);
+    metricsSetGauge(MG_DAILY_VOLUME_ML, dailyVolumeML);
+    metricsSetGauge(MG_AVAILABLE_VOLUME_ML, availableVolumeCurrent);
+}
+
+// ============== UTC DAY CHECK (scheduler: DATE_CHECK_PERIOD_MS) ==============
+
+void WaterAlgorithm::checkUtcDay() {
+    if (isSystemDisabled()) {
+        return;
+    }
+
+    if (!isRTCWorkingCached()) {
+        if (millis() - lastRtcWarning > 30000) {
+            LOG_ERROR("");
+            LOG_ERROR("RTC not working - skipping date check");
+            lastRtcWarning = millis();
+        }
+        return;
+    }
+    
+    uint32_t currentUTCDay = getCachedUnixTimestamp() / 86400;
+    
+    // ✅ SANITY CHECK: Sprawdź czy UTC day jest sensowny (2024-2035)
+    // 2024-01-01 = 19723 days, 2035-12-31 = 24106 days
+    if (currentUTCDay < 19723 || currentUTCDay > 24106) {
+        if (millis() - lastInvalidDayWarning > 10000) {
+            LOG_ERROR("");
+            LOG_ERROR("===========================================");
+            LOG_ERROR("Invalid UTC day from RTC: %lu (expected 19723-24106)", currentUTCDay);
+            LOG_ERROR("Skipping date check - RTC data corrupted");
+            LOG_ERROR("===========================================");
+            lastInvalidDayWarning = millis();
+        }
+        return;
+    }
+    
+    // ✅ DATE REGRESSION PROTECTION: Jeśli nowy < stary, ignoruj (RTC error)
+    if (currentUTCDay < lastResetUTCDay) {
+        if (millis() - lastRegressionWarning > 10000) {
+            LOG_ERROR("");
+            LOG_ERROR("===========================================");
+            LOG_ERROR("DATE REGRESSION DETECTED - IGNORING!");
+            LOG_ERROR("Current UTC day: %lu, Last: %lu (diff: %ld days BACK)", 
+                     currentUTCDay, lastResetUTCDay, 
+                     (long)(lastResetUTCDay - currentUTCDay));
+            LOG_ERROR("This indicates RTC read error - skipping reset");
+            LOG_ERROR("===========================================");
+            lastRegressionWarning = millis();
+        }
+        return;
+    }
+
+    // Przejście okresu archiwum (30 min / doba / tydzień) - pusty kubełek
+    if (channel == 0) {
+        archiveTick(getCachedUnixTimestamp());
+    }
+    
+    if (currentUTCDay != lastResetUTCDay) {
+        LOG_WARNING("");
+        LOG_WARNING("===========================================");
+        LOG_WARNING("UTC DAY CHANGE DETECTED - RESET TRIGGERED!");
+        LOG_WARNING("Previous UTC day: %lu", lastResetUTCDay);
+        LOG_WARNING("Current UTC day:  %lu", currentUTCDay);
+        LOG_WARNING("Difference: +%lu days", currentUTCDay - lastResetUTCDay);
+        LOG_WARNING("Daily volume BEFORE: %dml", dailyVolumeML);
+        LOG_WARNING("===========================================");
+        
+        if (pump().isActive()) {
+            if (!resetPending) {
+                LOG_INFO("");
+                LOG_INFO("Reset delayed - pump active");
+
+                resetPending = true;
+            }
+        } else {
+            dailyVolumeML = 0;
+            todayCycles.clear();
+            lastResetUTCDay = currentUTCDay;
+            queueDailyVolumeSave(dailyVolumeML, lastResetUTCDay, channel);
+            resetPending = false;
+            
+            LOG_WARNING("");
+            LOG_WARNING("RESET EXECUTED: new UTC day = %lu", lastResetUTCDay);
+        }
+    }
+}
+
 void WaterAlgorithm::update() {
+    collectSavedCycles();
+    publishTelemetry();
+    checkpointCycle();          // Przejścia z callbacków czujników i stop przy wyłączeniu systemu
     checkResetButton();
     updateErrorSignal();
     
@@ -195,15 +377,14 @@ void WaterAlgorithm::update() {
         systemWasDisabled = false;
         
         // Check if sensors are currently active
-        bool sensor1 = readWaterSensor1();
-        bool sensor2 = readWaterSensor2();
+        SensorMask active = sensors().readLowMask();
+        char states[48];
+        formatSensorMask(active, "ACTIVE", "inactive", states, sizeof(states));
         
         LOG_INFO("");
-        LOG_INFO("Sensor 1: %s", sensor1 ? "ACTIVE" : "inactive");
-        LOG_INFO("");
-        LOG_INFO("Sensor 2: %s", sensor2 ? "ACTIVE" : "inactive");
+        LOG_INFO("Sensors: %s", states);
         
-        if (sensor1 || sensor2) {
+        if (sensorVotePasses(active, SENSOR_TRIGGER_VOTE)) {
             // Sensors active - let debounce process handle it naturally
             LOG_INFO("");
             LOG_INFO("Sensors active - debounce process will start");
@@ -214,99 +395,17 @@ void WaterAlgorithm::update() {
         }
     }
     
-    // UTC day check - throttled to 1x/second
-    static uint32_t lastDateCheck = 0;
-    
-    if (millis() - lastDateCheck >= 1000) {
-        // uint32_t currentTime = getCurrentTimeSeconds();
-        lastDateCheck = millis();
-        
-        if (!isRTCWorking()) {
-            static uint32_t lastWarning = 0;
-            if (millis() - lastWarning > 30000) {
-                LOG_ERROR("");
-                LOG_ERROR("RTC not working - skipping date check");
-                lastWarning = millis();
-            }
-            goto skip_date_check;
-        }
-        
-        uint32_t currentUTCDay = getUnixTimestamp() / 86400;
-        
-        // ✅ SANITY CHECK: Sprawdź czy UTC day jest sensowny (2024-2035)
-        // 2024-01-01 = 19723 days, 2035-12-31 = 24106 days
-        if (currentUTCDay < 19723 || currentUTCDay > 24106) {
-            static uint32_t lastInvalidWarning = 0;
-            if (millis() - lastInvalidWarning > 10000) {
-                LOG_ERROR("");
-                LOG_ERROR("===========================================");
-                LOG_ERROR("Invalid UTC day from RTC: %lu (expected 19723-24106)", currentUTCDay);
-                LOG_ERROR("Skipping date check - RTC data corrupted");
-                LOG_ERROR("===========================================");
-                lastInvalidWarning = millis();
-            }
-            goto skip_date_check;
-        }
-        
-        // ✅ DATE REGRESSION PROTECTION: Jeśli nowy < stary, ignoruj (RTC error)
-        if (currentUTCDay < lastResetUTCDay) {
-            static uint32_t lastRegressionWarning = 0;
-            if (millis() - lastRegressionWarning > 10000) {
-                LOG_ERROR("");
-                LOG_ERROR("===========================================");
-                LOG_ERROR("DATE REGRESSION DETECTED - IGNORING!");
-                LOG_ERROR("Current UTC day: %lu, Last: %lu (diff: %ld days BACK)", 
-                         currentUTCDay, lastResetUTCDay, 
-                         (long)(lastResetUTCDay - currentUTCDay));
-                LOG_ERROR("This indicates RTC read error - skipping reset");
-                LOG_ERROR("===========================================");
-                lastRegressionWarning = millis();
-            }
-            goto skip_date_check;
-        }
-        
-        if (currentUTCDay != lastResetUTCDay) {
-            LOG_WARNING("");
-            LOG_WARNING("===========================================");
-            LOG_WARNING("UTC DAY CHANGE DETECTED - RESET TRIGGERED!");
-            LOG_WARNING("Previous UTC day: %lu", lastResetUTCDay);
-            LOG_WARNING("Current UTC day:  %lu", currentUTCDay);
-            LOG_WARNING("Difference: +%lu days", currentUTCDay - lastResetUTCDay);
-            LOG_WARNING("Daily volume BEFORE: %dml", dailyVolumeML);
-            LOG_WARNING("===========================================");
-            
-            if (isPumpActive()) {
-                if (!resetPending) {
-                    LOG_INFO("");
-                    LOG_INFO("Reset delayed - pump active");
-
-                    resetPending = true;
-                }
-            } else {
-                dailyVolumeML = 0;
-                todayCycles.clear();
-                lastResetUTCDay = currentUTCDay;
-                saveDailyVolumeToFRAM(dailyVolumeML, lastResetUTCDay);
-                resetPending = false;
-                
-                LOG_WARNING("");
-                LOG_WARNING("RESET EXECUTED: new UTC day = %lu", lastResetUTCDay);
-            }
-        }
-    }
-       
-    skip_date_check:
     uint32_t currentTime = getCurrentTimeSeconds();
     
-    if (resetPending && !isPumpActive() && currentState == STATE_IDLE) {
+    if (resetPending && !pump().isActive() && currentState == STATE_IDLE) {
         LOG_INFO("");
         LOG_INFO("Executing delayed reset (pump finished)");
         
-        uint32_t currentUTCDay = getUnixTimestamp() / 86400;
+        uint32_t currentUTCDay = getCachedUnixTimestamp() / 86400;
         dailyVolumeML = 0;
         todayCycles.clear();
         lastResetUTCDay = currentUTCDay;
-        saveDailyVolumeToFRAM(dailyVolumeML, lastResetUTCDay);
+        queueDailyVolumeSave(dailyVolumeML, lastResetUTCDay, channel);
         resetPending = false;
         
         LOG_INFO("");
@@ -314,6 +413,10 @@ void WaterAlgorithm::update() {
 
 
     }
+
+    if (pumpWaitSeconds != 0) {
+        servicePumpWait();
+    }
     
     uint32_t stateElapsed = currentTime - stateStartTime;
 
@@ -334,29 +437,18 @@ void WaterAlgorithm::update() {
 
         case STATE_DEBOUNCING:
             // Debouncing - obsługiwane przez water_sensors.cpp
-            // Callbacki: onDebounceBothComplete() lub onDebounceTimeout()
+            // Callbacki: onDebounceAllComplete() lub onDebounceTimeout()
             break;
 
         // ============== FAZA 2: POMPOWANIE + RELEASE VERIFICATION ==============
         case STATE_PUMPING_AND_VERIFY: {
-            // Aktualizuj release debounce (co 2s sprawdzaj czujniki)
-            updateReleaseDebounce();
-
-            // Status log co 10s
-            static uint32_t lastStatusLog = 0;
-            if (currentTime - lastStatusLog >= 10) {
-                uint32_t timeSincePumpStart = currentTime - pumpStartTime;
-                LOG_INFO("");                        
-                LOG_INFO("PUMPING_AND_VERIFY: %ds/%ds, pump=%s, S1=%d/%d, S2=%d/%d",
-                        timeSincePumpStart, WATER_TRIGGER_MAX_TIME,
-                        isPumpActive() ? "ON" : "OFF",
-                        releaseDebounce[0].counter, releaseDebounce[0].confirmed ? 1 : 0,
-                        releaseDebounce[1].counter, releaseDebounce[1].confirmed ? 1 : 0);
-                lastStatusLog = currentTime;
+            // Release debounce i log statusu: wpisy harmonogramu (releaseCheckTick/logStatus)
+            if (pumpWaitSeconds != 0) {
+                break;      // Ponowienie czeka na przekaźnik - weryfikacja od przydziału
             }
 
             // Sprawdź warunki zakończenia
-            bool pumpFinished = !isPumpActive();
+            bool pumpFinished = !pump().isActive();
             bool allConfirmed = checkAllReleaseConfirmed();
 
             // SUKCES: Pompa skończyła + wszystkie wymagane potwierdzone
@@ -409,16 +501,35 @@ void WaterAlgorithm::update() {
             }
             break;
     }
+
+    checkpointCycle();
 }
    
 
 void WaterAlgorithm::initFromFRAM() {
     LOG_INFO("");
-    LOG_INFO("Loading cycle history and error stats from FRAM...");
+    LOG_INFO("CH%d: loading cycle history and error stats from FRAM...", channel);
     loadCyclesFromStorage();
 
+    // Modele uczone (dawka, parowanie, anomalie, agregaty, archiwum) - kanał 0
+    if (channel == 0) {
+        initDoseSizing(framCycles);
+        initEvaporationModel(framCycles);
+        initAnomalyDetector(framCycles);
+        initCycleAggregates(framCycles);
+        initConsumptionArchive(framCycles);
+        if (ENABLE_ANOMALY_DETECTION && isAnomalyActive()) {
+            startErrorSignal(ERROR_ANOMALY);    // Niepotwierdzony alarm sprzed restartu
+        }
+    } else {
+        float volume;
+        if (loadVolumeFromFRAM(volume, channel)) {
+            channelVolumePerSecond = volume;
+        }
+    }
+
     ErrorStats stats;
-    if (loadErrorStatsFromFRAM(stats)) {
+    if (loadErrorStatsFromFRAM(stats, channel)) {
         LOG_INFO("");
         LOG_INFO("Error statistics loaded from FRAM");
     } else {
@@ -433,27 +544,27 @@ void WaterAlgorithm::initDailyVolume() {
     
     // Load Available Volume from FRAM (not dependent on RTC)
     uint32_t loadedMax, loadedCurrent;
-    if (loadAvailableVolumeFromFRAM(loadedMax, loadedCurrent)) {
+    if (loadAvailableVolumeFromFRAM(loadedMax, loadedCurrent, channel)) {
         availableVolumeMax = loadedMax;
         availableVolumeCurrent = loadedCurrent;
         LOG_INFO("");
         LOG_INFO("Available volume restored: %lu/%lu ml", availableVolumeCurrent, availableVolumeMax);
     } else {
         // First run - save defaults
-        saveAvailableVolumeToFRAM(availableVolumeMax, availableVolumeCurrent);
+        saveAvailableVolumeToFRAM(availableVolumeMax, availableVolumeCurrent, channel);
         LOG_INFO("");
         LOG_INFO("Available volume initialized with defaults: %lu ml", availableVolumeMax);
     }
 
     // Load Fill Water Max from FRAM (not dependent on RTC)
     uint16_t loadedFillMax;
-    if (loadFillWaterMaxFromFRAM(loadedFillMax)) {
+    if (loadFillWaterMaxFromFRAM(loadedFillMax, channel)) {
         fillWaterMaxConfig = loadedFillMax;
         LOG_INFO("");
         LOG_INFO("Fill water max restored: %d ml", fillWaterMaxConfig);
     } else {
         // First run - save default
-        saveFillWaterMaxToFRAM(fillWaterMaxConfig);
+        saveFillWaterMaxToFRAM(fillWaterMaxConfig, channel);
         LOG_INFO("");
         LOG_INFO("Fill water max initialized with default: %d ml", fillWaterMaxConfig);
     }
@@ -465,7 +576,7 @@ void WaterAlgorithm::initDailyVolume() {
         // Try to restore last known value from FRAM instead of losing it
         uint32_t loadedUTCDay = 0;
         uint16_t loadedVolume = 0;
-        if (loadDailyVolumeFromFRAM(loadedVolume, loadedUTCDay)) {
+        if (loadDailyVolumeFromFRAM(loadedVolume, loadedUTCDay, channel)) {
             dailyVolumeML = loadedVolume;
             lastResetUTCDay = loadedUTCDay;
             LOG_WARNING("Restored daily volume from FRAM: %dml (day=%lu), but cannot verify date",
@@ -485,7 +596,7 @@ void WaterAlgorithm::initDailyVolume() {
         uint32_t loadedUTCDay = 0;
         uint16_t loadedVolume = 0;
 
-        if (loadDailyVolumeFromFRAM(loadedVolume, loadedUTCDay)) {
+        if (loadDailyVolumeFromFRAM(loadedVolume, loadedUTCDay, channel)) {
             LOG_INFO("");
             LOG_INFO("===========================================");
             LOG_INFO("FRAM data: %dml, UTC day=%lu", loadedVolume, loadedUTCDay);
@@ -502,7 +613,7 @@ void WaterAlgorithm::initDailyVolume() {
                 // Different day - reset
                 dailyVolumeML = 0;
                 lastResetUTCDay = currentUTCDay;
-                saveDailyVolumeToFRAM(dailyVolumeML, lastResetUTCDay);
+                saveDailyVolumeToFRAM(dailyVolumeML, lastResetUTCDay, channel);
                 LOG_INFO("");
                 LOG_INFO("===========================================");
                 LOG_INFO("Day changed from %lu to %lu", loadedUTCDay, currentUTCDay);
@@ -513,13 +624,18 @@ void WaterAlgorithm::initDailyVolume() {
             // No valid data in FRAM
             dailyVolumeML = 0;
             lastResetUTCDay = currentUTCDay;
-            saveDailyVolumeToFRAM(dailyVolumeML, lastResetUTCDay);
+            saveDailyVolumeToFRAM(dailyVolumeML, lastResetUTCDay, channel);
             LOG_INFO("");
             LOG_INFO("===========================================");
             LOG_INFO("No valid FRAM data - initializing");
             LOG_INFO("Initialized to 0ml");
             LOG_INFO("===========================================");
         }
+
+        // Ręczne dolewki sprzed restartu (archiwum zna czas dopiero z RTC)
+        if (channel == 0) {
+            doseSizingSeedManualRefills(getUnixTimestamp());
+        }
     }
 
     LOG_INFO("");
@@ -544,13 +660,12 @@ void WaterAlgorithm::onPreQualificationStart() {
         uint32_t currentTime = getCurrentTimeSeconds();
         triggerStartTime = currentTime;
         currentCycle.trigger_time = currentTime;
-        currentCycle.timestamp = getUnixTimestamp();
+        currentCycle.timestamp = getCachedUnixTimestamp();
         currentState = STATE_PRE_QUALIFICATION;
         stateStartTime = currentTime;
 
         // Reset czasów zaliczenia
-        sensor1DebounceCompleteTime = 0;
-        sensor2DebounceCompleteTime = 0;
+        memset(debounceCompleteTime, 0, sizeof(debounceCompleteTime));
         debouncePhaseActive = false;
 
         LOG_INFO("");
@@ -574,7 +689,7 @@ void WaterAlgorithm::onPreQualificationSuccess() {
     LOG_INFO("");
     LOG_INFO("====================================");
     LOG_INFO("ALGORITHM: Pre-qualification SUCCESS");
-    LOG_INFO("State changed: PRE_QUALIFICATION -> SETTLING (%ds)", SETTLING_TIME);
+    LOG_INFO("State changed: PRE_QUALIFICATION -> SETTLING (%ds)", sensors().getActiveSchedule().settlingTime);
     LOG_INFO("====================================");
 }
 
@@ -616,11 +731,10 @@ void WaterAlgorithm::onSettlingComplete() {
     debouncePhaseActive = true;
 
     // Reset czasów zaliczenia dla fazy debouncing
-    sensor1DebounceCompleteTime = 0;
-    sensor2DebounceCompleteTime = 0;
+    memset(debounceCompleteTime, 0, sizeof(debounceCompleteTime));
 
     LOG_INFO("");
-    LOG_INFO("State changed: SETTLING -> DEBOUNCING (%ds timeout)", TOTAL_DEBOUNCE_TIME);
+    LOG_INFO("State changed: SETTLING -> DEBOUNCING (%ds timeout)", sensors().getActiveSchedule().totalDebounceTime);
 }
 
 void WaterAlgorithm::onSensorDebounceComplete(uint8_t sensorNum) {
@@ -629,32 +743,65 @@ void WaterAlgorithm::onSensorDebounceComplete(uint8_t sensorNum) {
     LOG_INFO("");
     LOG_INFO("ALGORITHM: Sensor %d debounce complete at %lu", sensorNum, currentTime);
     
-    if (sensorNum == 1) {
-        sensor1DebounceCompleteTime = currentTime;
-    } else if (sensorNum == 2) {
-        sensor2DebounceCompleteTime = currentTime;
+    if (sensorNum >= 1 && sensorNum <= WATER_SENSOR_COUNT) {
+        debounceCompleteTime[sensorNum - 1] = currentTime;
+    }
+}
+
+// Rozrzut czasów (max - min) czujników z maski; 0 gdy mniej niż dwa.
+// Dla dwóch pływaków to dotychczasowa różnica |S2 - S1|. Różnice względem
+// pierwszego czasu - czasy odtworzone z checkpointu mogą być sprzed zera millis().
+static uint32_t sensorTimeSpread(const uint32_t* times, SensorMask mask) {
+    if (sensorMaskCount(mask) < 2) {
+        return 0;
+    }
+    bool first = true;
+    uint32_t reference = 0;
+    int32_t earliest = 0;
+    int32_t latest = 0;
+    for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+        if (mask & (1U << i)) {
+            if (first) {
+                reference = times[i];
+                first = false;
+            }
+            int32_t offset = (int32_t)(times[i] - reference);
+            if (offset < earliest) earliest = offset;
+            if (offset > latest) latest = offset;
+        }
     }
+    return (uint32_t)(latest - earliest);
 }
 
-void WaterAlgorithm::onDebounceBothComplete() {
+// Maska czujników z niezerowym czasem
+static SensorMask sensorTimeMask(const uint32_t* times) {
+    SensorMask mask = 0;
+    for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+        if (times[i] > 0) {
+            mask |= (1U << i);
+        }
+    }
+    return mask;
+}
+
+void WaterAlgorithm::onDebounceAllComplete() {
     // Safety check - only proceed if in expected state
     if (currentState != STATE_DEBOUNCING) {
         LOG_WARNING("");            
-        LOG_WARNING("onDebounceBothComplete ignored - state is %s, not DEBOUNCING",
+        LOG_WARNING("onDebounceAllComplete ignored - state is %s, not DEBOUNCING",
                     getStateString());
         return;
     }
 
     LOG_INFO("");
-    LOG_INFO("ALGORITHM: Both sensors debounce OK");
+    LOG_INFO("ALGORITHM: All %d sensors debounce OK", WATER_SENSOR_COUNT);
 
-    uint32_t currentTime = getCurrentTimeSeconds();
     debouncePhaseActive = false;
 
-    // Oblicz time_gap_1 jako różnicę między zaliczeniami
-    if (sensor1DebounceCompleteTime > 0 && sensor2DebounceCompleteTime > 0) {
-        currentCycle.time_gap_1 = abs((int32_t)sensor2DebounceCompleteTime -
-        (int32_t)sensor1DebounceCompleteTime);
+    // Oblicz time_gap_1 jako rozrzut zaliczeń
+    SensorMask timed = sensorTimeMask(debounceCompleteTime);
+    if (timed == SENSOR_MASK_ALL && WATER_SENSOR_COUNT >= 2) {
+        currentCycle.time_gap_1 = sensorTimeSpread(debounceCompleteTime, timed);
         LOG_INFO("");
         LOG_INFO("TIME_GAP_1 (debounce diff): %lu seconds", currentCycle.time_gap_1);
     } else {
@@ -662,40 +809,349 @@ void WaterAlgorithm::onDebounceBothComplete() {
     }
 
     // ============== USTAW KONTEKST DLA FAZY 2 ==============
-    // Oba czujniki zaliczyły - oba wymagane w release verification
-    sensor1TriggeredCycle = true;
-    sensor2TriggeredCycle = true;
+    // Wszystkie czujniki zaliczyły - wszystkie wymagane w release verification
+    triggeredMask = SENSOR_MASK_ALL;
     resetReleaseDebounce();
 
+    char context[64];
+    formatSensorMask(triggeredMask, "required", "NOT required", context, sizeof(context));
     LOG_INFO("");
-    LOG_INFO("Release context: S1=required, S2=required");
+    LOG_INFO("Release context: %s", context);
 
     // Sukces - nie ustawiamy flagi błędu GAP1
     // Przechodzimy do uruchomienia pompy + release verification
     LOG_INFO("Starting pump + release verification");
     LOG_INFO("");
 
+    pumpAttempts = 1;
+
+    uint16_t pumpWorkTime = planCycleDose();
+
+    if (requestAutoPump(pumpWorkTime)) {
+        LOG_INFO("");
+        LOG_INFO("Pump started for %d seconds", pumpWorkTime);
+    }
+}
+
+uint16_t WaterAlgorithm::planCycleDose() {
+    if (channel != 0) {
+        // Bez modelu dawki - stała SINGLE_DOSE_VOLUME
+        plannedPumpSeconds = calculatePumpWorkTime(getVolumePerSecond());
+        if (!validatePumpWorkTime(plannedPumpSeconds)) {
+            LOG_ERROR("");
+            LOG_ERROR("CH%d PUMP_WORK_TIME (%ds) exceeds WATER_TRIGGER_MAX_TIME (%ds)",
+                      channel, plannedPumpSeconds, WATER_TRIGGER_MAX_TIME);
+            plannedPumpSeconds = WATER_TRIGGER_MAX_TIME - 10;
+        }
+        LOG_INFO("");
+        LOG_INFO("Dose CH%d: %dml / %ds (fixed)", channel,
+                 (int)(plannedPumpSeconds * getVolumePerSecond()), plannedPumpSeconds);
+        return plannedPumpSeconds;
+    }
+
+    uint16_t dailyRemaining = fillWaterMaxConfig > dailyVolumeML ? fillWaterMaxConfig - dailyVolumeML : 0;
+    DoseDecision dose = planDose(getCachedUnixTimestamp(), getVolumePerSecond(), dailyRemaining);
+
+    LOG_INFO("");
+    LOG_INFO("Dose: %dml / %ds (%s) - deficit %.0fml (%.1fml/h x %.1fh, %s), release floor %.0fml",
+             dose.volumeMl, dose.pumpSeconds, dose.limitedBy, dose.deficitMl,
+             dose.rateMlPerHour, dose.hoursSinceRefill, dose.rateSource, dose.releaseFloorMl);
+    plannedPumpSeconds = dose.pumpSeconds;
+    return plannedPumpSeconds;
+}
+
+// Pompa mierzy czas pracy w µs (wyłączenie timerem). Gdy ostatni przebieg
+// nie był AUTO (np. wywłaszczony ręcznym) - szacunek z sekund jak dotąd.
+uint16_t WaterAlgorithm::autoRunVolumeMl(uint32_t fallbackSeconds) const {
+    if (pump().getLastRunSource() == PUMP_SOURCE_AUTO && !pump().isActive()) {
+        return pump().getLastRunVolumeMl();
+    }
+    return (uint16_t)(fallbackSeconds * getVolumePerSecond());
+}
+
+// ============== PRZYDZIAŁ PRZEKAŹNIKA ==============
+// AUTO ma najniższy priorytet: gdy przekaźnik ma inny właściciel (ręczna dawka,
+// direct) albo pompa jest globalnie wyłączona, arbiter odrzuca żądanie. Cykl
+// nie wchodzi wtedy w weryfikację ani nie księguje dawki - czeka w bieżącym
+// stanie (DEBOUNCING albo ponowienie w PUMPING_AND_VERIFY) na przydział.
+bool WaterAlgorithm::requestAutoPump(uint16_t pumpWorkTime) {
+    uint32_t currentTime = getCurrentTimeSeconds();
+    PumpRequestResult result = pump().request(PUMP_SOURCE_AUTO, pumpWorkTime);
+    if (result == PUMP_GRANTED) {
+        onAutoPumpGranted(pumpWorkTime);
+        return true;
+    }
+
+    if (pumpWaitSeconds == 0) {
+        pumpWaitStart = currentTime;
+        LOG_WARNING("");
+        LOG_WARNING("CH%d: AUTO pump %s (owner %s) - cycle waits for the relay", channel,
+                    getPumpRequestResultName(result), getPumpSourceName(pump().getOwner()));
+    }
+    pumpWaitSeconds = pumpWorkTime;
+    pumpWaitLastTry = currentTime;
+    pumpWaitQueued = result == PUMP_QUEUED;
+    return false;
+}
+
+void WaterAlgorithm::onAutoPumpGranted(uint16_t pumpWorkTime) {
+    uint32_t currentTime = getCurrentTimeSeconds();
+    pumpWaitSeconds = 0;
+    pumpWaitQueued = false;
+
     currentState = STATE_PUMPING_AND_VERIFY;
     stateStartTime = currentTime;
     pumpStartTime = currentTime;
-    pumpAttempts = 1;
+    pumpStartUs = (uint32_t)esp_timer_get_time();
+    currentCycle.pump_duration = pumpWorkTime;
+    verifyResumed = false;
+    resetReleaseDebounce();
+}
+
+void WaterAlgorithm::servicePumpWait() {
+    uint32_t currentTime = getCurrentTimeSeconds();
+    uint32_t waited = currentTime - pumpWaitStart;
+
+    if (pumpWaitQueued) {
+        if (pump().getOwner() == PUMP_SOURCE_AUTO) {
+            onAutoPumpGranted(pumpWaitSeconds);
+            LOG_INFO("");
+            LOG_INFO("CH%d: queued AUTO pump started after %lus", channel, waited);
+            return;
+        }
+        if (waited * 1000UL >= PUMP_ARBITER_QUEUE_TTL_MS) {
+            pumpWaitQueued = false;     // Żądanie wygasło w kolejce - ponawiamy
+        }
+    } else if (!pump().isActive() && currentTime - pumpWaitLastTry >= PUMP_GRANT_RETRY_INTERVAL) {
+        uint16_t pumpWorkTime = pumpWaitSeconds;
+        if (requestAutoPump(pumpWorkTime)) {
+            LOG_INFO("");
+            LOG_INFO("CH%d: pump started for %d seconds after %lus wait", channel, pumpWorkTime, waited);
+            return;
+        }
+    }
 
-    uint16_t pumpWorkTime = calculatePumpWorkTime(currentPumpSettings.volumePerSecond);
-    if (!validatePumpWorkTime(pumpWorkTime)) {
-        LOG_ERROR("");        
-        LOG_ERROR("PUMP_WORK_TIME (%ds) exceeds WATER_TRIGGER_MAX_TIME (%ds)",
-                pumpWorkTime, WATER_TRIGGER_MAX_TIME);
-        pumpWorkTime = WATER_TRIGGER_MAX_TIME - 10;
+    if (waited < PUMP_GRANT_WAIT_MAX) {
+        return;
     }
 
-    triggerPump(pumpWorkTime, "AUTO_PUMP");
-    currentCycle.pump_duration = pumpWorkTime;
+    LOG_ERROR("");
+    LOG_ERROR("CH%d: AUTO pump not granted within %ds - cycle aborted (attempt %d)",
+              channel, PUMP_GRANT_WAIT_MAX, pumpAttempts);
+    // Ponowienie: poprzednia próba pompowała - zapis jak przy resetSystem().
+    // Pierwsza próba: pompa nie ruszyła, nic do zapisu - czujniki wykryją niski poziom od nowa.
+    closePartialCycle();
+    currentState = STATE_IDLE;
+    resetCycle();
+}
 
-    LOG_INFO("");
-    LOG_INFO("Pump started for %d seconds", pumpWorkTime);
+// Pompa pracowała w tym cyklu (przebieg AUTO) - zapis częściowej objętości
+void WaterAlgorithm::closePartialCycle() {
+    if (pumpStartTime == 0 || currentCycle.pump_duration == 0) {
+        return;
+    }
+    uint32_t pumpedSeconds = getCurrentTimeSeconds() - pumpStartTime;
+    if (pumpedSeconds > currentCycle.pump_duration) {
+        pumpedSeconds = currentCycle.pump_duration;
+    }
+    uint16_t actualVolumeML = autoRunVolumeMl(pumpedSeconds);
+    currentCycle.volume_dose = actualVolumeML;
+
+    framBusy = true;
+    if (actualVolumeML > 0) {
+        dailyVolumeML += actualVolumeML;
+        queueDailyVolumeSave(dailyVolumeML, lastResetUTCDay, channel);
+        LOG_INFO("Partial volume saved: %dml, daily total: %dml", actualVolumeML, dailyVolumeML);
+    }
+    saveCycleToStorage(currentCycle);
+    if (channel == 0) {
+        archiveRecordCycle(currentCycle);
+    }
+    framBusy = false;
+}
+
+// ============== CHECKPOINT CYKLU ==============
+
+static uint16_t checkpointAge(uint32_t now, uint32_t since) {
+    uint32_t age = now - since;
+    return age > UINT16_MAX ? UINT16_MAX : (uint16_t)age;
+}
+
+// Czas sprzed restartu na osi getCurrentTimeSeconds() - modulo 2^32, bo
+// wiek bywa większy niż czas od startu. 0 zostaje zarezerwowane dla "brak".
+static uint32_t checkpointTimeBefore(uint32_t now, uint32_t age) {
+    uint32_t time = now - age;
+    return time == 0 ? UINT32_MAX : time;
+}
+
+// Zapis tylko gdy zmienił się kontekst: stan, wejście w stan (ponowienie
+// pompy), zaliczenia debouncingu albo zalogowanie cyklu. IDLE też -
+// czyści checkpoint zakończonego cyklu.
+void WaterAlgorithm::checkpointCycle() {
+    if (!ENABLE_CYCLE_CHECKPOINT) {
+        return;
+    }
+
+    SensorMask debounced = sensorTimeMask(debounceCompleteTime);
+    if (currentState == checkpointState && stateStartTime == checkpointStateStart &&
+        debounced == checkpointDebounced && cycleLogged == checkpointLogged) {
+        return;
+    }
+    checkpointState = currentState;
+    checkpointStateStart = stateStartTime;
+    checkpointDebounced = debounced;
+    checkpointLogged = cycleLogged;
+
+    uint32_t currentTime = getCurrentTimeSeconds();
+    uint32_t nowUnix = getCachedUnixTimestamp();
+
+    CycleCheckpoint cp;
+    memset(&cp, 0, sizeof(cp));
+    cp.state = currentState;
+    if (currentState != STATE_IDLE) {
+        cp.cycle = currentCycle;
+        cp.savedUnix = isUnixTimeValid(nowUnix) ? nowUnix : 0;
+        cp.stateAge = checkpointAge(currentTime, stateStartTime);
+        cp.plannedPumpSeconds = plannedPumpSeconds;
+        for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+            if (debounceCompleteTime[i] != 0) {
+                uint16_t age = checkpointAge(currentTime, debounceCompleteTime[i]);
+                cp.debounceAge[i] = age < UINT16_MAX ? age + 1 : UINT16_MAX;
+            }
+        }
+        cp.pumpAttempts = pumpAttempts;
+        cp.triggeredMask = triggeredMask;
+        cp.flags = (cycleLogged ? CHECKPOINT_FLAG_LOGGED : 0) |
+                   (waterFailDetected ? CHECKPOINT_FLAG_WATER_FAIL : 0) |
+                   (cycleResumed ? CHECKPOINT_FLAG_RESUMED : 0);
+    }
+    queueRecordSave(checkpointAddr(channel), &cp, sizeof(cp));
+}
+
+// Wywołanie z setup() po initDailyVolume() (objętość dnia dla zamknięcia cyklu),
+// przed startem zadań. Reguły:
+// - SETTLING/DEBOUNCING: wznowienie w water_sensors z czasem fazy powiększonym
+//   o przerwę; bez ważnego RTC albo po przerwie > CHECKPOINT_MAX_DOWNTIME - odrzucony
+// - PUMPING_AND_VERIFY: przekaźnik wyłączył restart. W oknie WATER_TRIGGER_MAX_TIME
+//   od startu pompy weryfikacja release trwa dalej (bez ponownego startu pompy,
+//   timeout = zwykłe ponowienie); po oknie cykl zamknięty jak resetSystem()
+//   z pełną dawką - limit dzienny liczony po bezpiecznej stronie
+// - LOGGING: niezalogowany cykl zapisany w pierwszym update(); z innej doby UTC
+//   niż bieżąca - bez doliczenia do dziennej objętości (initDailyVolume ją wyzerował)
+// - ERROR: błąd zatrzaśnięty jak przed restartem - wymaga resetu; ERROR_DAILY_LIMIT
+//   tylko z bieżącej doby UTC (nowa doba zeruje limit)
+// - PRE_QUAL, MANUAL_OVERRIDE: odrzucony, detekcja od nowa
+void WaterAlgorithm::restoreCheckpoint() {
+    CycleCheckpoint cp;
+    if (!ENABLE_CYCLE_CHECKPOINT || !loadRecordFromFRAM(checkpointAddr(channel), &cp, sizeof(cp)) ||
+        cp.state == STATE_IDLE || cp.state > STATE_MANUAL_OVERRIDE) {
+        return;
+    }
+
+    uint32_t nowUnix = isRTCWorking() ? getUnixTimestamp() : 0;
+    bool timeValid = isUnixTimeValid(cp.savedUnix) && nowUnix >= cp.savedUnix;
+    uint32_t downtime = timeValid ? nowUnix - cp.savedUnix : 0;
+    bool sameUtcDay = timeValid && nowUnix / 86400 == cp.savedUnix / 86400;
+    uint32_t currentTime = getCurrentTimeSeconds();
+
+    currentState = (AlgorithmState)cp.state;
+    LOG_WARNING("");
+    LOG_WARNING("====================================");
+    LOG_WARNING("CH%d CYCLE CHECKPOINT: interrupted in %s", channel, getStateString());
+    if (timeValid) {
+        LOG_WARNING("State age %us + downtime %lus, attempts %d", cp.stateAge, downtime, cp.pumpAttempts);
+    } else {
+        LOG_WARNING("Downtime unknown (RTC not valid), attempts %d", cp.pumpAttempts);
+    }
+    LOG_WARNING("====================================");
+
+    // Kontekst cyklu - wspólny dla wznowienia i zamknięcia
+    currentCycle = cp.cycle;
+    plannedPumpSeconds = cp.plannedPumpSeconds;
+    pumpAttempts = cp.pumpAttempts;
+    triggeredMask = cp.triggeredMask & SENSOR_MASK_ALL;
+    waterFailDetected = (cp.flags & CHECKPOINT_FLAG_WATER_FAIL) != 0;
+    cycleLogged = (cp.flags & CHECKPOINT_FLAG_LOGGED) != 0;
+    cycleResumed = true;
+
+    uint32_t elapsed = cp.stateAge + downtime;
+    stateStartTime = checkpointTimeBefore(currentTime, elapsed);
+    triggerStartTime = stateStartTime;
+
+    MetricCounter outcome = MC_CHECKPOINT_DISCARDED;
+
+    switch (currentState) {
+        case STATE_SETTLING:
+        case STATE_DEBOUNCING:
+            if (!timeValid || downtime > CHECKPOINT_MAX_DOWNTIME) {
+                LOG_WARNING("Phase 1 context stale - detection restarts");
+                break;
+            }
+            for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+                debounceCompleteTime[i] = cp.debounceAge[i] != 0
+                    ? checkpointTimeBefore(currentTime, cp.debounceAge[i] - 1 + downtime) : 0;
+            }
+            debouncePhaseActive = currentState == STATE_DEBOUNCING;
+            sensors().resumeProcess(currentState == STATE_SETTLING ? PHASE_SETTLING : PHASE_DEBOUNCING,
+                                    elapsed, sensorTimeMask(debounceCompleteTime));
+            outcome = MC_CHECKPOINT_RESUMED;
+            break;
+
+        case STATE_PUMPING_AND_VERIFY:
+            if (timeValid && elapsed < WATER_TRIGGER_MAX_TIME) {
+                pumpStartTime = stateStartTime;
+                resetReleaseDebounce();
+                verifyResumed = true;
+                LOG_WARNING("Resuming release verification at %lus/%ds (pump not restarted)",
+                            elapsed, WATER_TRIGGER_MAX_TIME);
+                outcome = MC_CHECKPOINT_RESUMED;
+                break;
+            }
+            LOG_WARNING("Verification window passed - closing cycle with the planned dose");
+            pumpStartTime = checkpointTimeBefore(currentTime, timeValid ? elapsed : currentCycle.pump_duration);
+            resetSystem();
+            outcome = MC_CHECKPOINT_CLOSED;
+            break;
+
+        case STATE_LOGGING:
+            if (cycleLogged) {
+                LOG_INFO("Cycle already logged before restart");
+                break;
+            }
+            // Bez ważnego czasu licznik dnia odtworzony bez zmian - cykl liczony jak dotąd
+            cyclePreviousDay = timeValid && !sameUtcDay;
+            LOG_WARNING("Logging the confirmed cycle%s",
+                        cyclePreviousDay ? " (previous UTC day - not counted in daily volume)" : "");
+            stateStartTime = currentTime;
+            outcome = MC_CHECKPOINT_CLOSED;
+            break;
+
+        case STATE_ERROR:
+            if (cp.cycle.error_code == ERROR_NONE) {
+                break;
+            }
+            if (cp.cycle.error_code == ERROR_DAILY_LIMIT && !sameUtcDay) {
+                LOG_WARNING("Daily limit error not from the current UTC day - cleared");
+                break;
+            }
+            startErrorSignal((ErrorCode)cp.cycle.error_code);
+            LOG_WARNING("Error state restored - reset required");
+            outcome = MC_CHECKPOINT_RESUMED;
+            break;
+
+        default:
+            LOG_WARNING("Nothing to resume - detection restarts");
+            break;
+    }
+
+    if (outcome == MC_CHECKPOINT_DISCARDED) {
+        currentState = STATE_IDLE;
+        resetCycle();
+    }
+    metricsInc(outcome);
 }
 
-void WaterAlgorithm::onDebounceTimeout(bool sensor1OK, bool sensor2OK) {
+void WaterAlgorithm::onDebounceTimeout(SensorMask passed) {
     // Safety check - only proceed if in expected state
     if (currentState != STATE_DEBOUNCING) {
         LOG_WARNING("");
@@ -707,63 +1163,54 @@ void WaterAlgorithm::onDebounceTimeout(bool sensor1OK, bool sensor2OK) {
     LOG_INFO("");
     LOG_INFO("====================================");
     LOG_INFO("ALGORITHM: Debounce timeout");
-    LOG_INFO("Sensor1: %s, Sensor2: %s",
-        sensor1OK ? "OK" : "FAIL",
-        sensor2OK ? "OK" : "FAIL");
+    char states[48];
+    formatSensorMask(passed, "OK", "FAIL", states, sizeof(states));
+    LOG_INFO("%s (%d/%d, vote %s)", states, sensorMaskCount(passed), WATER_SENSOR_COUNT,
+             getSensorVotePolicyName(SENSOR_DEBOUNCE_VOTE));
     LOG_INFO("====================================");
 
-    uint32_t currentTime = getCurrentTimeSeconds();
     debouncePhaseActive = false;
 
-    if (sensor1OK || sensor2OK) {
-        // Przynajmniej jeden czujnik OK - uruchamiamy pompę ale z błędem
+    if (sensorVotePasses(passed, SENSOR_DEBOUNCE_VOTE)) {
+        // Wystarczająco wiele czujników OK - uruchamiamy pompę ale z błędem
         LOG_WARNING("");
-        LOG_WARNING("Only one sensor OK - pump will start with GAP1_FAIL flag");
+        LOG_WARNING("Not all sensors OK - pump will start with GAP1_FAIL flag");
 
         // Oblicz time_gap_1
-        if (sensor1DebounceCompleteTime > 0 && sensor2DebounceCompleteTime > 0) {
-            currentCycle.time_gap_1 = abs((int32_t)sensor2DebounceCompleteTime -
-                                          (int32_t)sensor1DebounceCompleteTime);
+        SensorMask timed = sensorTimeMask(debounceCompleteTime);
+        if (timed == SENSOR_MASK_ALL && WATER_SENSOR_COUNT >= 2) {
+            currentCycle.time_gap_1 = sensorTimeSpread(debounceCompleteTime, timed);
         } else {
-            currentCycle.time_gap_1 = TIME_GAP_1_MAX;  // Timeout value
+            currentCycle.time_gap_1 = sensors().getActiveSchedule().totalDebounceTime;  // Timeout value
         }
 
         // Ustaw flagi bledu
         currentCycle.sensor_results |= PumpCycle::RESULT_GAP1_FAIL;
-        if (!sensor1OK) {
-            currentCycle.sensor_results |= PumpCycle::RESULT_SENSOR1_DEBOUNCE_FAIL;
-        }
-        if (!sensor2OK) {
-            currentCycle.sensor_results |= PumpCycle::RESULT_SENSOR2_DEBOUNCE_FAIL;
+        for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+            if (!(passed & (1U << i))) {
+                currentCycle.sensor_results |= PumpCycle::debounceFailFlag(i);
+            }
         }
 
         // ============== USTAW KONTEKST DLA FAZY 2 ==============
         // Tylko te czujniki które zaliczyły będą wymagane w release verification
-        sensor1TriggeredCycle = sensor1OK;
-        sensor2TriggeredCycle = sensor2OK;
+        triggeredMask = passed;
         resetReleaseDebounce();
 
+        char context[64];
+        formatSensorMask(triggeredMask, "required", "NOT required", context, sizeof(context));
         LOG_INFO("");         
-        LOG_INFO("Release context: S1=%s, S2=%s",
-                 sensor1OK ? "required" : "NOT required",
-                 sensor2OK ? "required" : "NOT required");
+        LOG_INFO("Release context: %s", context);
 
         // Uruchom pompę + release verification
-        currentState = STATE_PUMPING_AND_VERIFY;
-        stateStartTime = currentTime;
-        pumpStartTime = currentTime;
         pumpAttempts = 1;
 
-        uint16_t pumpWorkTime = calculatePumpWorkTime(currentPumpSettings.volumePerSecond);
-        if (!validatePumpWorkTime(pumpWorkTime)) {
-            pumpWorkTime = WATER_TRIGGER_MAX_TIME - 10;
-        }
-
-        triggerPump(pumpWorkTime, "AUTO_PUMP");
-        currentCycle.pump_duration = pumpWorkTime;
+        uint16_t pumpWorkTime = planCycleDose();
 
-        LOG_INFO("");
-        LOG_INFO("Pump started for %d seconds (with GAP1_FAIL)", pumpWorkTime);
+        if (requestAutoPump(pumpWorkTime)) {
+            LOG_INFO("");
+            LOG_INFO("Pump started for %d seconds (with GAP1_FAIL)", pumpWorkTime);
+        }
 
     } else {
         // Żaden czujnik nie zaliczył - ERR_FALSE_TRIGGER
@@ -772,7 +1219,7 @@ void WaterAlgorithm::onDebounceTimeout(bool sensor1OK, bool sensor2OK) {
         currentCycle.sensor_results |= PumpCycle::RESULT_FALSE_TRIGGER;
         
         // Loguj cykl z błędem
-        currentCycle.time_gap_1 = TOTAL_DEBOUNCE_TIME;
+        currentCycle.time_gap_1 = sensors().getActiveSchedule().totalDebounceTime;
         currentCycle.error_code = ERROR_NONE;
         logCycleComplete();
         
@@ -781,8 +1228,9 @@ void WaterAlgorithm::onDebounceTimeout(bool sensor1OK, bool sensor2OK) {
         
         LOG_ERROR("");
         LOG_ERROR("====================================");
-        LOG_ERROR("ERR_FALSE_TRIGGER: No sensor passed debounce");
-        LOG_ERROR("Pre-qualification passed, but debounce failed for both sensors");
+        LOG_ERROR("ERR_FALSE_TRIGGER: Not enough sensors passed debounce (%d/%d)",
+                  sensorMaskCount(passed), WATER_SENSOR_COUNT);
+        LOG_ERROR("Pre-qualification passed, but the debounce vote failed");
         LOG_ERROR("Possible causes: snail, temporary blockage, sensor noise");
         LOG_ERROR("Returned to IDLE with FALSE_TRIGGER flag");
         LOG_ERROR("====================================");
@@ -791,39 +1239,44 @@ void WaterAlgorithm::onDebounceTimeout(bool sensor1OK, bool sensor2OK) {
 
 void WaterAlgorithm::calculateTimeGap2() {
     // ============== NOWA LOGIKA: używamy czasów z release debounce ==============
-    if (releaseDebounce[0].confirmed && releaseDebounce[1].confirmed) {
-        // Oba potwierdzone - oblicz różnicę
-        currentCycle.time_gap_2 = abs((int32_t)releaseDebounce[0].confirmTime -
-        (int32_t)releaseDebounce[1].confirmTime);
+    if (releaseConfirmed == SENSOR_MASK_ALL && WATER_SENSOR_COUNT >= 2) {
+        // Wszystkie potwierdzone - rozrzut potwierdzeń
+        currentCycle.time_gap_2 = sensorTimeSpread(releaseConfirmTime, releaseConfirmed);
         
         LOG_INFO("");        
-        LOG_INFO("TIME_GAP_2: %ds (S1@%lus, S2@%lus)",
-                currentCycle.time_gap_2,
-                releaseDebounce[0].confirmTime,
-                releaseDebounce[1].confirmTime);
+        LOG_INFO("TIME_GAP_2: %ds (all %d sensors confirmed)",
+                currentCycle.time_gap_2, WATER_SENSOR_COUNT);
     } else {
-        // Tylko jeden czujnik potwierdzony lub żaden - brak gap2
+        // Nie wszystkie czujniki potwierdzone - brak gap2
         currentCycle.time_gap_2 = 0;
         LOG_INFO("");
-        LOG_INFO("TIME_GAP_2: 0 (only one sensor confirmed or none)");
+        LOG_INFO("TIME_GAP_2: 0 (%d/%d sensors confirmed)", sensorMaskCount(releaseConfirmed), WATER_SENSOR_COUNT);
     }
 }
 
 void WaterAlgorithm::calculateWaterTrigger() {
     // ============== NOWA LOGIKA: używamy czasów z release debounce ==============
+    if (verifyResumed) {
+        // Start pompy sprzed restartu - czas reakcji obejmowałby przerwę
+        currentCycle.water_trigger_time = WATER_TRIGGER_MAX_TIME;
+        LOG_WARNING("");
+        LOG_WARNING("Verification resumed after restart - water_trigger_time = MAX");
+        return;
+    }
+
+    // Odstępy od startu pompy (pumpStartTime odtworzony z checkpointu bywa sprzed zera millis())
     uint32_t earliestConfirm = UINT32_MAX;
 
-    if (releaseDebounce[0].confirmed && releaseDebounce[0].confirmTime > pumpStartTime) {
-        earliestConfirm = releaseDebounce[0].confirmTime;
-    }
-    if (releaseDebounce[1].confirmed && releaseDebounce[1].confirmTime > pumpStartTime) {
-        if (releaseDebounce[1].confirmTime < earliestConfirm) {
-            earliestConfirm = releaseDebounce[1].confirmTime;
+    for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+        uint32_t sincePump = releaseConfirmTime[i] - pumpStartTime;
+        if ((releaseConfirmed & (1U << i)) && (int32_t)sincePump > 0 &&
+            sincePump < earliestConfirm) {
+            earliestConfirm = sincePump;
         }
     }
 
     if (earliestConfirm != UINT32_MAX) {
-        currentCycle.water_trigger_time = earliestConfirm - pumpStartTime;
+        currentCycle.water_trigger_time = earliestConfirm;
 
         // Sanity check
         if (currentCycle.water_trigger_time > WATER_TRIGGER_MAX_TIME) {
@@ -840,78 +1293,97 @@ void WaterAlgorithm::calculateWaterTrigger() {
     }
 }
 
+uint32_t WaterAlgorithm::releaseReactionMs() const {
+    if (verifyResumed) {
+        return 0;   // Start pompy sprzed restartu - brak wspólnej podstawy czasu
+    }
+    uint64_t sumUs = 0;
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+        if ((releaseConfirmed & (1U << i)) && releaseEdgeUs[i] != 0) {
+            sumUs += releaseEdgeUs[i] - pumpStartUs;
+            count++;
+        }
+    }
+    return count > 0 ? (uint32_t)(sumUs / count / 1000) : 0;
+}
+
 // ============== RELEASE VERIFICATION METHODS ==============
 
 void WaterAlgorithm::resetReleaseDebounce() {
-    for (int i = 0; i < 2; i++) {
-        releaseDebounce[i].counter = 0;
-        releaseDebounce[i].confirmed = false;
-        releaseDebounce[i].confirmTime = 0;
-    }
-    lastReleaseCheck = 0;
+    memset(releaseCounter, 0, sizeof(releaseCounter));
+    memset(releaseConfirmTime, 0, sizeof(releaseConfirmTime));
+    memset(releaseEdgeUs, 0, sizeof(releaseEdgeUs));
+    releaseConfirmed = 0;
 }
 
-void WaterAlgorithm::updateReleaseDebounce() {
-    uint32_t currentTime = getCurrentTimeSeconds();
+void WaterAlgorithm::releaseCheckTick() {
+    if (isSystemDisabled() || currentState != STATE_PUMPING_AND_VERIFY || pumpWaitSeconds != 0) {
+        return;
+    }
+    updateReleaseDebounce();
+}
 
-    // Sprawdzaj co RELEASE_CHECK_INTERVAL (2s)
-    if (currentTime - lastReleaseCheck < RELEASE_CHECK_INTERVAL) {
+void WaterAlgorithm::logStatus() {
+    if (isSystemDisabled() || currentState != STATE_PUMPING_AND_VERIFY || pumpWaitSeconds != 0) {
         return;
     }
-    lastReleaseCheck = currentTime;
+    uint32_t timeSincePumpStart = getCurrentTimeSeconds() - pumpStartTime;
+    char release[64];
+    size_t pos = 0;
+    release[0] = '\0';
+    for (uint8_t i = 0; i < WATER_SENSOR_COUNT && pos < sizeof(release); i++) {
+        pos += snprintf(release + pos, sizeof(release) - pos, "%sS%d=%d/%d", i > 0 ? ", " : "",
+                        i + 1, releaseCounter[i], (releaseConfirmed >> i) & 1);
+    }
+    LOG_INFO("");
+    LOG_INFO("CH%d PUMPING_AND_VERIFY: %ds/%ds, pump=%s, %s",
+            channel, timeSincePumpStart, WATER_TRIGGER_MAX_TIME,
+            pump().isActive() ? "ON" : "OFF", release);
+}
+
+void WaterAlgorithm::updateReleaseDebounce() {
+    uint32_t currentTime = getCurrentTimeSeconds();
 
-    // Odczytaj czujniki (HIGH = woda podniesiona = !readWaterSensorX())
-    bool sensor1High = !readWaterSensor1();
-    bool sensor2High = !readWaterSensor2();
+    // Odczytaj czujniki (HIGH = woda podniesiona = bit LOW wyzerowany)
+    SensorMask highMask = SENSOR_MASK_ALL & ~sensors().readLowMask();
 
-    // Aktualizuj release debounce dla S1 (jeśli wymagany)
-    if (sensor1TriggeredCycle && !releaseDebounce[0].confirmed) {
-        if (sensor1High) {
-            releaseDebounce[0].counter++;
-            if (releaseDebounce[0].counter >= RELEASE_DEBOUNCE_COUNT) {
-                releaseDebounce[0].confirmed = true;
-                releaseDebounce[0].confirmTime = currentTime;
-                LOG_INFO("");
-                LOG_INFO("Sensor1 release CONFIRMED at %lus (3x HIGH)", currentTime);
-            }
-        } else {
-            if (releaseDebounce[0].counter > 0) {
-                LOG_INFO("");
-                LOG_INFO("Sensor1 release reset (was %d)", releaseDebounce[0].counter);
-            }
-            releaseDebounce[0].counter = 0;
+    // Aktualizuj release debounce dla wymaganych, jeszcze niepotwierdzonych
+    SensorMask pending = triggeredMask & ~releaseConfirmed;
+    for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+        SensorMask bit = (SensorMask)(1U << i);
+        if (!(pending & bit)) {
+            continue;
         }
-    }
 
-    // Aktualizuj release debounce dla S2 (jeśli wymagany)
-    if (sensor2TriggeredCycle && !releaseDebounce[1].confirmed) {
-        if (sensor2High) {
-            releaseDebounce[1].counter++;
-            if (releaseDebounce[1].counter >= RELEASE_DEBOUNCE_COUNT) {
-                releaseDebounce[1].confirmed = true;
-                releaseDebounce[1].confirmTime = currentTime;
+        if (highMask & bit) {
+            releaseCounter[i]++;
+            if (releaseCounter[i] >= RELEASE_DEBOUNCE_COUNT) {
+                releaseConfirmed |= bit;
+                releaseConfirmTime[i] = currentTime;
+
+                // Moment podniesienia z przechwytywania zboczy (µs) - potwierdzenie
+                // 3×HIGH co RELEASE_CHECK_INTERVAL ma rozdzielczość 2s
+                uint32_t edgeUs;
+                if (sensors().getReleaseEdgeUs(i, edgeUs) && (int32_t)(edgeUs - pumpStartUs) > 0) {
+                    releaseEdgeUs[i] = edgeUs;
+                }
                 LOG_INFO("");
-                LOG_INFO("Sensor2 release CONFIRMED at %lus (3x HIGH)", currentTime);
+                LOG_INFO("Sensor%d release CONFIRMED at %lus (3x HIGH)", i + 1, currentTime);
             }
         } else {
-            if (releaseDebounce[1].counter > 0) {
+            if (releaseCounter[i] > 0) {
                 LOG_INFO("");
-                LOG_INFO("Sensor2 release reset (was %d)", releaseDebounce[1].counter);
+                LOG_INFO("Sensor%d release reset (was %d)", i + 1, releaseCounter[i]);
             }
-            releaseDebounce[1].counter = 0;
+            releaseCounter[i] = 0;
         }
     }
 }
 
 bool WaterAlgorithm::checkAllReleaseConfirmed() {
     // Sprawdź czy wszystkie WYMAGANE czujniki potwierdziły
-    if (sensor1TriggeredCycle && !releaseDebounce[0].confirmed) {
-        return false;
-    }
-    if (sensor2TriggeredCycle && !releaseDebounce[1].confirmed) {
-        return false;
-    }
-    return true;
+    return (triggeredMask & ~releaseConfirmed) == 0;
 }
 
 void WaterAlgorithm::handleReleaseTimeout() {
@@ -919,35 +1391,30 @@ void WaterAlgorithm::handleReleaseTimeout() {
     LOG_WARNING("RELEASE VERIFICATION TIMEOUT (240s)");
 
     // Zatrzymaj pompę jeśli jeszcze pracuje
-    if (isPumpActive()) {
-        stopPump();
+    if (pump().isActive()) {
+        pump().stop();
         LOG_WARNING("");
         LOG_WARNING("Pump stopped due to timeout");
     }
 
-    bool s1Required = sensor1TriggeredCycle;
-    bool s2Required = sensor2TriggeredCycle;
-    bool s1OK = releaseDebounce[0].confirmed;
-    bool s2OK = releaseDebounce[1].confirmed;
-
     LOG_INFO("");
     LOG_INFO("====================================");
-    LOG_INFO("S1: required=%d, confirmed=%d, counter=%d", s1Required, s1OK, releaseDebounce[0].counter);
-    LOG_INFO("S2: required=%d, confirmed=%d, counter=%d", s2Required, s2OK, releaseDebounce[1].counter);
+    for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+        LOG_INFO("S%d: required=%d, confirmed=%d, counter=%d", i + 1,
+                 (triggeredMask >> i) & 1, (releaseConfirmed >> i) & 1, releaseCounter[i]);
+    }
     LOG_INFO("====================================");
 
-    // Przypadek 1: Przynajmniej jeden wymagany potwierdził
-    if ((s1Required && s1OK) || (s2Required && s2OK)) {
-        // Sukces częściowy - loguj błąd dla niepotwierdzonego
-        if (s1Required && !s1OK) {
-            currentCycle.sensor_results |= PumpCycle::RESULT_SENSOR1_RELEASE_FAIL;
-            LOG_ERROR("");
-            LOG_ERROR("ERR_SENSOR1_RELEASE: S1 did not confirm");
-        }
-        if (s2Required && !s2OK) {
-            currentCycle.sensor_results |= PumpCycle::RESULT_SENSOR2_RELEASE_FAIL;
-            LOG_ERROR("");
-            LOG_ERROR("ERR_SENSOR2_RELEASE: S2 did not confirm");
+    // Przypadek 1: Wymagane czujniki przegłosowały release (SENSOR_RELEASE_VOTE)
+    if (sensorVotePasses(releaseConfirmed, SENSOR_RELEASE_VOTE, triggeredMask)) {
+        // Sukces częściowy - loguj błąd dla niepotwierdzonych
+        SensorMask missing = triggeredMask & ~releaseConfirmed;
+        for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+            if (missing & (1U << i)) {
+                currentCycle.sensor_results |= PumpCycle::releaseFailFlag(i);
+                LOG_ERROR("");
+                LOG_ERROR("ERR_SENSOR%d_RELEASE: S%d did not confirm", i + 1, i + 1);
+            }
         }
 
         calculateWaterTrigger();
@@ -961,7 +1428,8 @@ void WaterAlgorithm::handleReleaseTimeout() {
     currentCycle.sensor_results |= PumpCycle::RESULT_WATER_FAIL;
     waterFailDetected = true;
     LOG_ERROR("");
-    LOG_ERROR("ERR_NO_WATER: No sensor confirmed water delivery");
+    LOG_ERROR("ERR_NO_WATER: Not enough sensors confirmed water delivery (%d/%d)",
+              sensorMaskCount(releaseConfirmed & triggeredMask), sensorMaskCount(triggeredMask));
 
     if (pumpAttempts < PUMP_MAX_ATTEMPTS) {
         // Retry
@@ -972,20 +1440,9 @@ void WaterAlgorithm::handleReleaseTimeout() {
         // Reset release debounce dla nowej próby
         resetReleaseDebounce();
 
-        // Uruchom pompę ponownie
-        uint32_t currentTime = getCurrentTimeSeconds();
-        pumpStartTime = currentTime;
-
-        uint16_t pumpWorkTime = calculatePumpWorkTime(currentPumpSettings.volumePerSecond);
-        if (!validatePumpWorkTime(pumpWorkTime)) {
-            pumpWorkTime = WATER_TRIGGER_MAX_TIME - 10;
-        }
-
-        triggerPump(pumpWorkTime, "AUTO_PUMP_RETRY");
-        currentCycle.pump_duration = pumpWorkTime;
-
-        // Pozostajemy w STATE_PUMPING_AND_VERIFY
-        stateStartTime = currentTime;
+        // Uruchom pompę ponownie - z tą samą dawką co pierwsza próba.
+        // Pozostajemy w STATE_PUMPING_AND_VERIFY; czas próby liczony od przydziału
+        requestAutoPump(plannedPumpSeconds);
     } else {
         // Wszystkie próby wyczerpane
         LOG_ERROR("");
@@ -1001,9 +1458,24 @@ void WaterAlgorithm::handleReleaseTimeout() {
     }
 }
 
+// ============== STORAGE BURST ==============
+// Zlecenia storage z jednego ticka, w którym kanał kończy cykl (logCycleComplete
+// + licznik pompy + checkpoint). Kolejka mieści naraz koniec cyklu na każdym
+// kanale - bez czekania w submit() i bez gubienia zapisów.
+static const uint8_t STORAGE_JOBS_CYCLE_BASE = 4 +     // Dzienny wolumen, zbiornik, cykl, statystyki błędów
+                                               2 +     // Licznik + duty pompy (koniec przebiegu AUTO)
+                                               1;      // Checkpoint (cykl zalogowany)
+static const uint8_t STORAGE_JOBS_CYCLE_MODELS = 2 +   // Kalibracja przepływu (rekord + auto-korekta)
+                                                 1 +   // Model parowania
+                                                 ANOMALY_SERIES_COUNT +
+                                                 AGG_WINDOW_COUNT +
+                                                 ARCHIVE_RESOLUTION_COUNT;
+static_assert(STORAGE_QUEUE_DEPTH >= STORAGE_JOBS_CYCLE_BASE * WATER_CHANNEL_COUNT + STORAGE_JOBS_CYCLE_MODELS,
+              "STORAGE_QUEUE_DEPTH too small for a cycle-end burst on every channel (models run on channel 0)");
+
 void WaterAlgorithm::logCycleComplete() {
     // SPRAWDZENIE: czy currentCycle zostało gdzieś wyzerowane
-    if (currentCycle.time_gap_1 == 0 && sensor1TriggerTime == 0 && sensor2TriggerTime == 0) {
+    if (currentCycle.time_gap_1 == 0) {
         LOG_ERROR("");
         LOG_ERROR("CRITICAL: currentCycle.time_gap_1 was RESET! Reconstructing...");
         
@@ -1014,7 +1486,7 @@ void WaterAlgorithm::logCycleComplete() {
     }
 
     // Calculate volume based on actual pump duration
-    // uint16_t actualVolumeML = (uint16_t)(currentCycle.pump_duration * currentPumpSettings.volumePerSecond);
+    // uint16_t actualVolumeML = (uint16_t)(currentCycle.pump_duration * getVolumePerSecond());
     // currentCycle.volume_dose = actualVolumeML;
 
         uint16_t actualVolumeML;
@@ -1038,8 +1510,7 @@ void WaterAlgorithm::logCycleComplete() {
         
     } else {
         // Manual cycle - water confirmed by sensors
-        actualVolumeML = (uint16_t)(currentCycle.pump_duration * 
-                                     currentPumpSettings.volumePerSecond);
+        actualVolumeML = autoRunVolumeMl(currentCycle.pump_duration);
                                      
         LOG_INFO("");
         LOG_INFO("====================================");
@@ -1060,15 +1531,16 @@ void WaterAlgorithm::logCycleComplete() {
     }
     
     // Add to daily volume (use actual volume, not fixed SINGLE_DOSE_VOLUME)
-    dailyVolumeML += actualVolumeML;
+    // Cykl z checkpointu sprzed zmiany doby UTC należy do wyzerowanego już dnia
+    if (!cyclePreviousDay) {
+        dailyVolumeML += actualVolumeML;
+    }
 
-    // --- FRAM write section (block HTTP reads during writes) ---
+    // --- FRAM write section (block HTTP reads of framCycles during update) ---
+    // Zapisy I2C wykonuje zadanie storage - tutaj tylko kolejkowanie
     framBusy = true;
 
-    if (!saveDailyVolumeToFRAM(dailyVolumeML, lastResetUTCDay)) {
-        LOG_WARNING("");
-        LOG_WARNING("Failed to save daily volume to FRAM");
-    }
+    queueDailyVolumeSave(dailyVolumeML, lastResetUTCDay, channel);
 
     if (availableVolumeCurrent >= actualVolumeML) {
         availableVolumeCurrent -= actualVolumeML;
@@ -1076,10 +1548,7 @@ void WaterAlgorithm::logCycleComplete() {
         availableVolumeCurrent = 0;
     }
 
-    if (!saveAvailableVolumeToFRAM(availableVolumeMax, availableVolumeCurrent)) {
-        LOG_WARNING("");
-        LOG_WARNING("Failed to save available volume to FRAM");
-    }
+    queueAvailableVolumeSave(availableVolumeMax, availableVolumeCurrent, channel);
 
     // Store in today's cycles (RAM)
     todayCycles.push_back(currentCycle);
@@ -1098,23 +1567,40 @@ void WaterAlgorithm::logCycleComplete() {
     uint8_t water_increment = (currentCycle.sensor_results & PumpCycle::RESULT_WATER_FAIL) ? 1 : 0;
 
     if (gap1_increment || gap2_increment || water_increment) {
-        if (incrementErrorStats(gap1_increment, gap2_increment, water_increment)) {
-            LOG_INFO("");        
-            LOG_INFO("Error stats updated: GAP1+%d, GAP2+%d, WATER+%d",
-                    gap1_increment, gap2_increment, water_increment);
-        } else {
-            LOG_WARNING("");
-            LOG_WARNING("Failed to update error stats in FRAM");
-        }
+        queueErrorStatsIncrement(gap1_increment, gap2_increment, water_increment, channel);
+        LOG_INFO("");        
+        LOG_INFO("Error stats update queued: GAP1+%d, GAP2+%d, WATER+%d",
+                gap1_increment, gap2_increment, water_increment);
     }
 
     framBusy = false;
+
+    if (channel == 0) {
+        flowCalibrationAddCycle(currentCycle, releaseReactionMs());
+        doseSizingOnCycle(currentCycle, getVolumePerSecond());
+        evaporationOnCycle(currentCycle);
+        aggregatesOnCycle(currentCycle);
+        archiveRecordCycle(currentCycle);
+
+        // Dryf serii: tylko sygnał ERR4 - algorytm nie przechodzi w STATE_ERROR.
+        // Nie nadpisuje sygnału prawdziwego błędu. Cykl wznowiony po restarcie
+        // ma czasy z przerwą zasilania - poza seriami detektora.
+        if (!cycleResumed && anomalyOnCycle(currentCycle) && !errorSignalActive) {
+            startErrorSignal(ERROR_ANOMALY);
+        }
+    }
+
+    metricsInc(currentCycle.error_code == ERROR_PUMP_FAILURE ? MC_CYCLES_PUMP_FAILURE : MC_CYCLES_OK);
+    metricsInc(MC_CYCLE_GAP1_FAIL, gap1_increment);
+    metricsInc(MC_CYCLE_GAP2_FAIL, gap2_increment);
+    metricsInc(MC_CYCLE_WATER_FAIL, water_increment);
+    metricsInc(MC_CYCLE_VOLUME_ML, actualVolumeML);
     
-    uint32_t unixTime = getUnixTimestamp();
+    uint32_t unixTime = getCachedUnixTimestamp();
     
     LOG_INFO("");
     LOG_INFO("====================================");
-    LOG_INFO("=== CYCLE COMPLETE ===");
+    LOG_INFO("=== CYCLE COMPLETE (CH%d) ===", channel);
     LOG_INFO("Actual volume: %dml (pump_duration: %ds)", actualVolumeML, currentCycle.pump_duration);
     LOG_INFO("TIME_GAP_1: %ds (fail=%d)", currentCycle.time_gap_1, gap1_increment);
     LOG_INFO("TIME_GAP_2: %ds (fail=%d)", currentCycle.time_gap_2, gap2_increment);
@@ -1124,7 +1610,7 @@ void WaterAlgorithm::logCycleComplete() {
     LOG_INFO("====================================");
 }
 
-bool WaterAlgorithm::requestManualPump(uint16_t duration_ms) {
+bool WaterAlgorithm::requestManualPump(uint32_t duration_ms) {
 
     // ============== BLOCK MANUAL PUMP WHEN SYSTEM DISABLED ==============
     if (isSystemDisabled()) {
@@ -1173,6 +1659,19 @@ void WaterAlgorithm::onManualPumpComplete() {
     }
 }
 
+// Arbiter oddał przekaźnik źródłu o wyższym priorytecie - przekaźnik już wyłączony.
+// Cykl nie może czekać na release po dawce, której nie dostał: zapis częściowy
+// jak przy resetSystem(), powrót do IDLE.
+void WaterAlgorithm::onPumpPreempted(PumpSource by) {
+    LOG_WARNING("");
+    LOG_WARNING("AUTO pump CH%d preempted by %s in state %s",
+                channel, getPumpSourceName(by), getStateString());
+
+    if (currentState == STATE_PUMPING_AND_VERIFY) {
+        resetSystem();
+    }
+}
+
 const char* WaterAlgorithm::getStateString() const {
     switch (currentState) {
         case STATE_IDLE: return "IDLE";
@@ -1202,21 +1701,61 @@ void WaterAlgorithm::startErrorSignal(ErrorCode error) {
     errorSignalStart = millis();
     errorPulseCount = 0;
     errorPulseState = false;
-    pinMode(ERROR_SIGNAL_PIN, OUTPUT);
-    digitalWrite(ERROR_SIGNAL_PIN, LOW);
+    if (claimSignalPin()) {
+        pinMode(ERROR_SIGNAL_PIN, OUTPUT);
+        digitalWrite(ERROR_SIGNAL_PIN, LOW);
+    }
     
     LOG_ERROR("");
-    LOG_ERROR("Starting error signal: %s", 
+    LOG_ERROR("CH%d starting error signal: %s", channel,
              error == ERROR_DAILY_LIMIT ? "ERR1" :
-             error == ERROR_PUMP_FAILURE ? "ERR2" : "ERR0");
+             error == ERROR_PUMP_FAILURE ? "ERR2" :
+             error == ERROR_ANOMALY ? "ERR4" : "ERR0");
+}
+
+// Pin ERROR_SIGNAL_PIN jest wspólny dla kanałów - prowadzi go jeden kanał
+// naraz (pierwszy z aktywnym sygnałem), kolejny przejmuje po jego wygaszeniu
+bool WaterAlgorithm::claimSignalPin() {
+    if (signalOwner != nullptr && signalOwner != this &&
+        (signalOwner->errorSignalActive || signalOwner->resetFeedbackStart != 0)) {
+        return false;
+    }
+    signalOwner = this;
+    return true;
+}
+
+void WaterAlgorithm::releaseSignalPin() {
+    if (claimSignalPin()) {
+        pinMode(ERROR_SIGNAL_PIN, OUTPUT);
+        digitalWrite(ERROR_SIGNAL_PIN, LOW);
+    }
 }
 
 void WaterAlgorithm::updateErrorSignal() {
+    if ((errorSignalActive || resetFeedbackStart != 0) && !claimSignalPin()) {
+        return;
+    }
+
+    // Potwierdzenie resetu: HIGH 100ms, LOW 100ms, HIGH 100ms, LOW
+    // (przed wznowionym ERR4 - wzorzec sygnału zaczyna się po mignięciu)
+    if (resetFeedbackStart != 0) {
+        uint32_t elapsed = millis() - resetFeedbackStart;
+        bool high = elapsed < 100 || (elapsed >= 200 && elapsed < 300);
+        digitalWrite(ERROR_SIGNAL_PIN, high ? HIGH : LOW);
+        if (elapsed >= 300) {
+            resetFeedbackStart = 0;
+            errorSignalStart = millis();
+            errorPulseState = false;
+        }
+        return;
+    }
+
     if (!errorSignalActive) return;
     
     uint32_t elapsed = millis() - errorSignalStart;
     uint8_t pulsesNeeded = (lastError == ERROR_DAILY_LIMIT) ? 1 :
-                           (lastError == ERROR_PUMP_FAILURE) ? 2 : 3;
+                           (lastError == ERROR_PUMP_FAILURE) ? 2 :
+                           (lastError == ERROR_ANOMALY) ? 4 : 3;
     
     // Calculate current position in signal pattern
     uint32_t cycleTime = 0;
@@ -1247,11 +1786,32 @@ void WaterAlgorithm::updateErrorSignal() {
     }
 }
 
+void WaterAlgorithm::acknowledgeAnomaly() {
+    if (channel == 0) {
+        acknowledgeAnomalies();
+    }
+    if (errorSignalActive && lastError == ERROR_ANOMALY) {
+        lastError = ERROR_NONE;
+        errorSignalActive = false;
+        releaseSignalPin();
+    }
+}
+
+// ERR4 wywłaszczony przez prawdziwy błąd (albo wykryty w jego trakcie) -
+// po wyczyszczeniu błędu niepotwierdzony alarm anomalii wraca na pin
+void WaterAlgorithm::resumeAnomalySignal() {
+    if (channel == 0 && ENABLE_ANOMALY_DETECTION && !errorSignalActive && isAnomalyActive()) {
+        LOG_WARNING("");
+        LOG_WARNING("Anomaly alarm still unacknowledged - resuming ERR4");
+        startErrorSignal(ERROR_ANOMALY);
+    }
+}
+
 void WaterAlgorithm::resetFromError() {
     lastError = ERROR_NONE;
     errorSignalActive = false;
-    pinMode(ERROR_SIGNAL_PIN, OUTPUT);
-    digitalWrite(ERROR_SIGNAL_PIN, LOW);
+    releaseSignalPin();
+    resumeAnomalySignal();
     currentState = STATE_IDLE;
     resetCycle();
     LOG_INFO("");
@@ -1282,29 +1842,13 @@ bool WaterAlgorithm::resetSystem() {
     LOG_WARNING("resetSystem() — interrupting active cycle in state: %s", getStateString());
 
     // Stop pump if running
-    if (isPumpActive()) {
+    if (pump().isActive()) {
         LOG_WARNING("Stopping active pump");
-        stopPump();
+        pump().stop();
     }
 
     // Calculate and save partial volume if pump ran during this cycle
-    if (pumpStartTime > 0 && currentCycle.pump_duration > 0) {
-        uint32_t pumpedSeconds = getCurrentTimeSeconds() - pumpStartTime;
-        if (pumpedSeconds > currentCycle.pump_duration) {
-            pumpedSeconds = currentCycle.pump_duration;
-        }
-        uint16_t actualVolumeML = (uint16_t)(pumpedSeconds * currentPumpSettings.volumePerSecond);
-        currentCycle.volume_dose = actualVolumeML;
-
-        framBusy = true;
-        if (actualVolumeML > 0) {
-            dailyVolumeML += actualVolumeML;
-            saveDailyVolumeToFRAM(dailyVolumeML, lastResetUTCDay);
-            LOG_INFO("Partial volume saved: %dml, daily total: %dml", actualVolumeML, dailyVolumeML);
-        }
-        saveCycleToStorage(currentCycle);
-        framBusy = false;
-    }
+    closePartialCycle();
 
     currentState = STATE_IDLE;
     resetCycle();
@@ -1318,7 +1862,7 @@ void WaterAlgorithm::loadCyclesFromStorage() {
 
     framBusy = true;
 
-    if (loadCyclesFromFRAM(framCycles, FRAM_MAX_CYCLES)) {
+    if (loadCyclesFromFRAM(framCycles, FRAM_MAX_CYCLES, channel)) {
         framDataLoaded = true;
         LOG_INFO("");
         LOG_INFO("====================================");
@@ -1348,35 +1892,35 @@ void WaterAlgorithm::loadCyclesFromStorage() {
 }
 
 void WaterAlgorithm::saveCycleToStorage(const PumpCycle& cycle) {
-    if (saveCycleToFRAM(cycle)) {
-        LOG_INFO("");
-        LOG_INFO("Cycle saved to FRAM successfully");
+    // Zapis do ringu FRAM wykonuje zadanie storage (błąd logowany tam).
+    // Do framCycles trafia dopiero po udanym zapisie - collectSavedCycles()
+    queueCycleSave(cycle, channel);
+}
 
-        // Add to framCycles for immediate access
+void WaterAlgorithm::collectSavedCycles() {
+    PumpCycle cycle;
+    while (takeSavedCycle(channel, cycle)) {
+        framBusy = true;
         framCycles.push_back(cycle);
 
         // Keep framCycles size matching FRAM ring buffer
         if (framCycles.size() > FRAM_MAX_CYCLES) {
             framCycles.erase(framCycles.begin());
         }
-    } else {
-        LOG_ERROR("");
-        LOG_ERROR("Failed to save cycle to FRAM");
+        framBusy = false;
     }
 }
 
-bool WaterAlgorithm::resetErrorStatistics() {
-    bool success = resetErrorStatsInFRAM();
-    if (success) {
-        LOG_INFO("");
-        LOG_INFO("Error statistics reset requested via web interface");
-    }
-    return success;
+void WaterAlgorithm::resetErrorStatistics(uint32_t resetTimestamp) {
+    // Po przyrostach z wcześniejszych cykli - ta sama kolejka storage
+    queueErrorStatsReset(resetTimestamp, channel);
+    LOG_INFO("");
+    LOG_INFO("Error statistics reset requested via web interface");
 }
 
 bool WaterAlgorithm::getErrorStatistics(uint16_t& gap1_sum, uint16_t& gap2_sum, uint16_t& water_sum, uint32_t& last_reset) {
     ErrorStats stats;
-    bool success = loadErrorStatsFromFRAM(stats);
+    bool success = loadErrorStatsFromFRAM(stats, channel);
     
     if (success) {
         gap1_sum = stats.gap1_fail_sum;
@@ -1402,10 +1946,10 @@ void WaterAlgorithm::addManualVolume(uint16_t volumeML) {
         availableVolumeCurrent = 0;
     }
     
-    // Save to FRAM
-    if (!saveAvailableVolumeToFRAM(availableVolumeMax, availableVolumeCurrent)) {
-        LOG_WARNING("");
-        LOG_WARNING("Failed to save available volume to FRAM after manual pump");
+    // Save to FRAM (storage task)
+    queueAvailableVolumeSave(availableVolumeMax, availableVolumeCurrent, channel);
+    if (channel == 0) {
+        archiveRecordManual(getCachedUnixTimestamp(), volumeML);
     }
     
     LOG_INFO("Manual volume: %dml | Available: %lu/%lu ml", 
@@ -1418,6 +1962,14 @@ void WaterAlgorithm::addManualVolume(uint16_t volumeML) {
     }
 }
 
+// Każdy przebieg poza cyklem AUTO dolewa do zbiornika - model dawki liczy
+// deficyt od niego (kanał 0, jedyny z modelem)
+void WaterAlgorithm::onOutOfCycleRefill(uint16_t volumeML) {
+    if (channel == 0) {
+        doseSizingOnManualRefill(getCachedUnixTimestamp(), volumeML);
+    }
+}
+
 
 // ============================================
 // 🆕 CHECK RESET BUTTON (Pin 8 - Active LOW)
@@ -1425,10 +1977,6 @@ void WaterAlgorithm::addManualVolume(uint16_t volumeML) {
 // ============================================
 
 void WaterAlgorithm::checkResetButton() {
-    static bool lastButtonState = HIGH;           // Poprzedni stan (HIGH = not pressed)
-    static uint32_t lastDebounceTime = 0;         // Czas ostatniej zmiany
-    static bool buttonPressed = false;            // Czy przycisk jest wciśnięty
-    
     const uint32_t DEBOUNCE_DELAY = 50;           // 50ms debouncing
     
     // Read current button state (INPUT_PULLUP, więc LOW = pressed)
@@ -1436,11 +1984,11 @@ void WaterAlgorithm::checkResetButton() {
     
     // Sprawdź czy stan się zmienił
     if (currentButtonState != lastButtonState) {
-        lastDebounceTime = millis();
+        lastButtonChange = millis();
     }
     
     // Debouncing - sprawdź czy stan jest stabilny przez DEBOUNCE_DELAY
-    if ((millis() - lastDebounceTime) > DEBOUNCE_DELAY) {
+    if ((millis() - lastButtonChange) > DEBOUNCE_DELAY) {
         
         // Przycisk został naciśnięty (HIGH → LOW)
         if (currentButtonState == LOW && !buttonPressed) {
@@ -1475,15 +2023,23 @@ void WaterAlgorithm::checkResetButton() {
                 LOG_INFO("Error signal: CLEARED");
                 LOG_INFO("====================================");
                 
-                // Visual feedback - krótkie mignięcie LED (potwierdzenie)
-                digitalWrite(ERROR_SIGNAL_PIN, HIGH);
-                delay(100);
-                digitalWrite(ERROR_SIGNAL_PIN, LOW);
-                delay(100);
-                digitalWrite(ERROR_SIGNAL_PIN, HIGH);
-                delay(100);
-                digitalWrite(ERROR_SIGNAL_PIN, LOW);
+                // Visual feedback - krótkie mignięcie LED (potwierdzenie),
+                // prowadzone bez blokowania przez updateErrorSignal()
+                resetFeedbackStart = millis();
+                if (resetFeedbackStart == 0) {
+                    resetFeedbackStart = 1;
+                }
                 
+            } else if (errorSignalActive && lastError == ERROR_ANOMALY) {
+                LOG_INFO("");
+                LOG_INFO("🔘 Anomaly alarm (ERR4) acknowledged by button");
+                acknowledgeAnomaly();
+
+                resetFeedbackStart = millis();
+                if (resetFeedbackStart == 0) {
+                    resetFeedbackStart = 1;
+                }
+
             } else {
                 LOG_INFO("");
                 LOG_INFO("====================================");
@@ -1512,19 +2068,17 @@ void WaterAlgorithm::setAvailableVolume(uint32_t maxMl) {
     availableVolumeMax = maxMl;
     availableVolumeCurrent = maxMl;
     
-    if (saveAvailableVolumeToFRAM(availableVolumeMax, availableVolumeCurrent)) {
-        LOG_INFO("");
-        LOG_INFO("Available volume set to %lu ml", maxMl);
-    }
+    queueAvailableVolumeSave(availableVolumeMax, availableVolumeCurrent, channel);
+    LOG_INFO("");
+    LOG_INFO("Available volume set to %lu ml", maxMl);
 }
 
 void WaterAlgorithm::refillAvailableVolume() {
     availableVolumeCurrent = availableVolumeMax;
     
-    if (saveAvailableVolumeToFRAM(availableVolumeMax, availableVolumeCurrent)) {
-        LOG_INFO("");
-        LOG_INFO("Available volume refilled to %lu ml", availableVolumeMax);
-    }
+    queueAvailableVolumeSave(availableVolumeMax, availableVolumeCurrent, channel);
+    LOG_INFO("");
+    LOG_INFO("Available volume refilled to %lu ml", availableVolumeMax);
 }
 
 uint32_t WaterAlgorithm::getAvailableVolumeMax() const {
@@ -1552,10 +2106,9 @@ void WaterAlgorithm::setFillWaterMax(uint16_t maxMl) {
     
     fillWaterMaxConfig = maxMl;
     
-    if (saveFillWaterMaxToFRAM(fillWaterMaxConfig)) {
-        LOG_INFO("");
-        LOG_INFO("Fill water max set to %d ml", maxMl);
-    }
+    queueFillWaterMaxSave(fillWaterMaxConfig, channel);
+    LOG_INFO("");
+    LOG_INFO("Fill water max set to %d ml", maxMl);
 }
 
 uint16_t WaterAlgorithm::getFillWaterMax() const {
@@ -1570,7 +2123,7 @@ bool WaterAlgorithm::resetDailyVolume() {
     LOG_INFO("Current UTC day: %lu", lastResetUTCDay);
     LOG_INFO("====================================");
     
-    if (isPumpActive()) {
+    if (pump().isActive()) {
         LOG_WARNING("");
         LOG_WARNING("❌ Reset blocked - pump is active");
         return false;
@@ -1579,11 +2132,7 @@ bool WaterAlgorithm::resetDailyVolume() {
     dailyVolumeML = 0;
     todayCycles.clear();
     
-    if (!saveDailyVolumeToFRAM(dailyVolumeML, lastResetUTCDay)) {
-        LOG_ERROR("");
-        LOG_ERROR("⚠️ Failed to save reset volume to FRAM");
-        return false;
-    }
+    queueDailyVolumeSave(dailyVolumeML, lastResetUTCDay, channel);
     LOG_INFO("");
     LOG_INFO("====================================");
     LOG_INFO("✅ Daily volume reset to 0ml");
@@ -1614,10 +2163,16 @@ String WaterAlgorithm::getStateDescription() const {
             return "Settling - water calming down";
 
         case STATE_DEBOUNCING:
+            if (pumpWaitSeconds != 0) {
+                return "Waiting for pump relay";
+            }
             return "Debouncing - verifying drain";
 
         case STATE_PUMPING_AND_VERIFY:
-            if (isPumpActive()) {
+            if (pumpWaitSeconds != 0) {
+                return "Retry waiting for pump relay";
+            }
+            if (pump().isActive()) {
                 return "Pump operating + monitoring sensors";
             } else {
                 return "Verifying sensor response";
@@ -1664,26 +2219,29 @@ uint32_t WaterAlgorithm::getRemainingSeconds() const {
         case STATE_PRE_QUALIFICATION:
             // Pre-qualification timeout
             elapsed = currentTime - stateStartTime;
-            if (elapsed >= PRE_QUAL_WINDOW) {
+            total = sensors().getActiveSchedule().preQualWindow;
+            if (elapsed >= total) {
                 return 0;
             }
-            return PRE_QUAL_WINDOW - elapsed;
+            return total - elapsed;
 
         case STATE_SETTLING:
             // Settling countdown
             elapsed = currentTime - stateStartTime;
-            if (elapsed >= SETTLING_TIME) {
+            total = sensors().getActiveSchedule().settlingTime;
+            if (elapsed >= total) {
                 return 0;
             }
-            return SETTLING_TIME - elapsed;
+            return total - elapsed;
 
         case STATE_DEBOUNCING:
             // Debouncing timeout
             elapsed = currentTime - stateStartTime;
-            if (elapsed >= TOTAL_DEBOUNCE_TIME) {
+            total = sensors().getActiveSchedule().totalDebounceTime;
+            if (elapsed >= total) {
                 return 0;
             }
-            return TOTAL_DEBOUNCE_TIME - elapsed;
+            return total - elapsed;
 
         case STATE_PUMPING_AND_VERIFY:
             // Pump + verify - return time until timeout (WATER_TRIGGER_MAX_TIME)
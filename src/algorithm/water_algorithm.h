@@ -4,19 +4,29 @@
 
 #include "algorithm_config.h"
 #include "../hardware/fram_controller.h"
+#include "../hardware/pump_controller.h"
+#include "../hardware/water_sensors.h"
 #include <vector>
 
+// Jedna instancja na kanał (zbiornik + pompa + para pływaków), każda z
+// własną partycją FRAM. waterAlgorithm = kanał 0 (dotychczasowe API).
 class WaterAlgorithm
 {
 private:
+    // ============== KANAŁ ==============
+    uint8_t channel;
+    float channelVolumePerSecond;           // Kanały 1+ (kanał 0: currentPumpSettings)
+    uint16_t plannedPumpSeconds;            // Dawka pierwszej próby (ponowienie)
+
+    PumpChannel& pump() const { return getPumpChannel(channel); }
+    SensorChannel& sensors() const { return getSensorChannel(channel); }
+
     AlgorithmState currentState;
     PumpCycle currentCycle;
 
     // Timing variables
     uint32_t stateStartTime;
     uint32_t triggerStartTime;
-    uint32_t sensor1TriggerTime;
-    uint32_t sensor2TriggerTime;
     uint32_t pumpStartTime;
     bool permission_log;
 
@@ -26,31 +36,51 @@ private:
     std::vector<PumpCycle> framCycles;
     bool framDataLoaded;
 
-    // Sensor states
-    bool lastSensor1State;
-    bool lastSensor2State;
     uint8_t pumpAttempts;
 
-    uint32_t sensor1DebounceCompleteTime;   // Czas zaliczenia debouncingu czujnika 1
-    uint32_t sensor2DebounceCompleteTime;   // Czas zaliczenia debouncingu czujnika 2
+    uint32_t debounceCompleteTime[WATER_SENSOR_COUNT];  // Czas zaliczenia debouncingu (0 = brak)
     bool debouncePhaseActive;               // Czy jesteśmy w fazie debouncingu
 
     // ============== KONTEKST Z FAZY 1 (które czujniki wyzwoliły cykl) ==============
-    bool sensor1TriggeredCycle;             // Czy S1 zaliczył debouncing fazy 1
-    bool sensor2TriggeredCycle;             // Czy S2 zaliczył debouncing fazy 1
+    SensorMask triggeredMask;               // Czujniki, które zaliczyły debouncing fazy 1
 
     // ============== RELEASE DEBOUNCE (faza 2 - podnoszenie wody) ==============
-    struct ReleaseDebounceState {
-        uint8_t counter;                    // Licznik kolejnych HIGH (0-3)
-        bool confirmed;                     // Czy osiągnięto 3×HIGH
-        uint32_t confirmTime;               // Czas potwierdzenia (sekundy)
-    } releaseDebounce[2];
-
-    uint32_t lastReleaseCheck;              // Czas ostatniego sprawdzenia czujników
+    uint8_t releaseCounter[WATER_SENSOR_COUNT];         // Kolejne HIGH (0 do RELEASE_DEBOUNCE_COUNT)
+    uint32_t releaseConfirmTime[WATER_SENSOR_COUNT];    // Czas potwierdzenia (sekundy)
+    uint32_t releaseEdgeUs[WATER_SENSOR_COUNT];         // Zbocze do HIGH potwierdzonego czujnika (µs, 0 = brak)
+    SensorMask releaseConfirmed;                        // Bit i = czujnik i potwierdził 3×HIGH
+    uint32_t pumpStartUs;                               // Start pompy AUTO (esp_timer µs)
+
+    // ============== PRZYDZIAŁ PRZEKAŹNIKA (arbiter) ==============
+    uint16_t pumpWaitSeconds;               // Dawka czekająca na przydział (0 = brak)
+    uint32_t pumpWaitStart;                 // Początek oczekiwania (s)
+    uint32_t pumpWaitLastTry;               // Ostatnie żądanie (s)
+    bool pumpWaitQueued;                    // Arbiter zakolejkował - start przyjdzie z kolejki
 
     // State control flags
     bool cycleLogged;
 
+    // Ostatni stan zgłoszony do /metrics i trace (wykrywanie przejść)
+    AlgorithmState metricsLastState;
+
+    // ============== CHECKPOINT CYKLU ==============
+    // Ostatni zapisany kontekst (wykrywanie zmian do zapisu w FRAM)
+    AlgorithmState checkpointState;
+    uint32_t checkpointStateStart;
+    SensorMask checkpointDebounced;
+    bool checkpointLogged;
+    bool cycleResumed;                      // Cykl przeżył restart - czasy obejmują przerwę
+    bool verifyResumed;                     // Weryfikacja wznowiona bez pomiaru od startu pompy
+    bool cyclePreviousDay;                  // Cykl sprzed zmiany doby UTC - poza dzienną objętością
+
+    // Dławienie logów update() i stan przycisku reset (per kanał)
+    uint32_t lastRtcWarning;
+    uint32_t lastInvalidDayWarning;
+    uint32_t lastRegressionWarning;
+    bool lastButtonState;
+    uint32_t lastButtonChange;
+    bool buttonPressed;
+
     // ============== SYSTEM DISABLE FLAG ==============
     // Tracks if system was disabled - used for sensor re-check on re-enable
     bool systemWasDisabled;
@@ -61,6 +91,7 @@ private:
     uint32_t errorSignalStart;
     uint8_t errorPulseCount;
     bool errorPulseState;
+    uint32_t resetFeedbackStart;            // Mignięcie potwierdzenia resetu (0 = brak)
 
     // Daily volume tracking
     std::vector<PumpCycle> todayCycles;
@@ -80,7 +111,9 @@ private:
     void resetCycle();
     void calculateTimeGap2();
     void calculateWaterTrigger();
+    uint32_t releaseReactionMs() const;     // Średni czas pompa -> zbocze HIGH (ms, 0 = brak)
     void logCycleComplete();
+    void publishTelemetry();
 
     // ============== RELEASE VERIFICATION (faza 2) ==============
     void resetReleaseDebounce();
@@ -90,6 +123,10 @@ private:
 
     void startErrorSignal(ErrorCode error);
     void updateErrorSignal();
+    bool claimSignalPin();
+    void releaseSignalPin();
+    void resumeAnomalySignal();             // ERR4 po wyczyszczeniu wywłaszczającego błędu
+    static WaterAlgorithm* signalOwner;     // Kanał prowadzący wspólny ERROR_SIGNAL_PIN
     void checkResetButton();
 
     // ============== SYSTEM DISABLE HANDLER ==============
@@ -99,9 +136,29 @@ private:
     // FRAM integration methods
     void loadCyclesFromStorage();
     void saveCycleToStorage(const PumpCycle &cycle);
+    void collectSavedCycles();              // Cykle potwierdzone przez zadanie storage -> framCycles
+
+    // Dose sizing: plan + log, returns pump seconds
+    uint16_t planCycleDose();
+
+    // Objętość dawki z czasu pracy przekaźnika (µs) ostatniego przebiegu AUTO
+    uint16_t autoRunVolumeMl(uint32_t fallbackSeconds) const;
+
+    // Start pompy AUTO: faza 2 rusza dopiero po przydziale przekaźnika
+    bool requestAutoPump(uint16_t pumpWorkTime);    // true = przydział, pompa pracuje
+    void onAutoPumpGranted(uint16_t pumpWorkTime);
+    void servicePumpWait();
+    void closePartialCycle();               // Zapis przerwanego cyklu z objętością przebiegu AUTO
+
+    // Checkpoint cyklu: zapis przy zmianie kontekstu (update())
+    void checkpointCycle();
 
 public:
-    WaterAlgorithm();
+    explicit WaterAlgorithm(uint8_t channel);
+
+    uint8_t getChannel() const { return channel; }
+    float getVolumePerSecond() const;
+    void setVolumePerSecond(float volumePerSecond);   // Kanały 1+ (kanał 0: CMD_SET_VOLUME_PER_SECOND)
 
     // Initialize FRAM-backed data AFTER initFRAM()/initNVS()
     void initFromFRAM();
@@ -109,6 +166,9 @@ public:
     // 🆕 NEW: Initialize daily volume AFTER RTC is ready
     void initDailyVolume();
 
+    // Cykl przerwany restartem: wznowienie albo zamknięcie (po initDailyVolume())
+    void restoreCheckpoint();
+
     bool resetDailyVolume();
 
     uint32_t getCurrentTimeSeconds() const { return millis() / 1000; }
@@ -116,19 +176,25 @@ public:
     // Main algorithm update - call this from loop()
     void update();
 
+    // Wpisy harmonogramu sterowania (main.cpp), dawniej dławione w update()
+    void checkUtcDay();         // Zmiana doby UTC, archiveTick (co DATE_CHECK_PERIOD_MS)
+    void releaseCheckTick();    // Release debounce fazy 2 (co RELEASE_CHECK_INTERVAL)
+    void logStatus();           // Log postępu PUMPING_AND_VERIFY (co STATUS_LOG_PERIOD_MS)
+
     // ============== CALLBACKI FAZY 1 (Pre-qual + Settling + Debouncing) ==============
     void onPreQualificationStart();                         // Wykryto pierwszy LOW, start pre-qual
     void onPreQualificationSuccess();                       // Pre-qual zaliczone (3×LOW)
     void onPreQualificationFail();                          // Pre-qual timeout (cichy reset)
     void onSettlingComplete();                              // Settling zakończone, start debouncing
     void onSensorDebounceComplete(uint8_t sensorNum);       // Czujnik zaliczył debouncing
-    void onDebounceBothComplete();                          // Oba czujniki zaliczone
-    void onDebounceTimeout(bool sensor1OK, bool sensor2OK); // Timeout TOTAL_DEBOUNCE_TIME
+    void onDebounceAllComplete();                           // Wszystkie czujniki zaliczone
+    void onDebounceTimeout(SensorMask passed);              // Timeout TOTAL_DEBOUNCE_TIME
 
     // Status and data access
     AlgorithmState getState() const { return currentState; }
     const char *getStateString() const;
     bool isInCycle() const;
+    bool isWaitingForPump() const { return pumpWaitSeconds != 0; }
     uint16_t getDailyVolume() const { return dailyVolumeML; }
     ErrorCode getLastError() const { return lastError; }
 
@@ -157,20 +223,26 @@ public:
     // Reset after error
     void resetFromError();
 
+    // Anomaly alarm (ERR4): acknowledge drift, stop the signal
+    void acknowledgeAnomaly();
+    bool isErrorSignalActive() const { return errorSignalActive; }
+
     // Remote system reset (works from any state except LOGGING)
     bool resetSystem();
 
     // Reset statistics and get current stats for display
-    bool resetErrorStatistics();
+    void resetErrorStatistics(uint32_t resetTimestamp);    // Zapis przez kolejkę storage
     bool getErrorStatistics(uint16_t &gap1_sum, uint16_t &gap2_sum, uint16_t &water_sum, uint32_t &last_reset);
 
-    // Manual pump interface
-    bool requestManualPump(uint16_t duration_ms);
+    // Manual pump interface (wywołania z arbitra pompy)
+    bool requestManualPump(uint32_t duration_ms);
     void onManualPumpComplete();
+    void onPumpPreempted(PumpSource by);
 
     uint32_t getLastResetUTCDay() const { return lastResetUTCDay; }
 
     void addManualVolume(uint16_t volumeML);
+    void onOutOfCycleRefill(uint16_t volumeML);    // MANUAL / CALIBRATION / DIRECT -> model dawki
 
     // ============== SYSTEM DISABLE STATUS ==============
     // Returns true if system was recently re-enabled (for UI feedback)
@@ -178,6 +250,7 @@ public:
     void clearSystemWasDisabled() { systemWasDisabled = false; }
 };
 
-extern WaterAlgorithm waterAlgorithm;
+extern WaterAlgorithm& waterAlgorithm;
+WaterAlgorithm& getWaterChannel(uint8_t channel);
 
 #endif
\ No newline at end of file
@@ -10,6 +10,30 @@
 #define ENABLE_FULL_LOGGING true
 #define ENABLE_SERIAL_DEBUG true
 
+// Profiler pętli głównej (timery na liczniku cykli CPU) - false = zero kosztu
+#define ENABLE_LOOP_PROFILER true
+#define LOOP_TICK_BUDGET_US 20000   // Budżet czasu jednego przebiegu planera (bez uśpienia)
+
+// Rejestrator spanów (Chrome trace-event JSON, /api/debug/trace)
+#define ENABLE_TRACE true
+#define TRACE_RING_SIZE 256         // Zdarzeń w buforze kołowym (16 B każde)
+
+// Zadania FreeRTOS (stos w bajtach - ESP-IDF). async_tcp ma priorytet 3.
+#define CONTROL_TASK_PRIORITY 5         // Czujniki, algorytm, pompa - wywłaszcza HTTP
+#define STORAGE_TASK_PRIORITY 4         // FRAM/RTC
+#define HOUSEKEEPING_TASK_PRIORITY 1    // Sesje, rate limiter, WiFi (jak loopTask)
+#define CONTROL_TASK_STACK 6144
+#define STORAGE_TASK_STACK 4096
+#define HOUSEKEEPING_TASK_STACK 6144    // Reconnect WiFi + NTP
+#define TASK_MAX_IDLE_MS 1000           // Górna granica uśpienia między terminami
+#define TASK_STACK_WARN_BYTES 512       // Ostrzeżenie przy mniejszym zapasie stosu
+#define CONTROL_COMMAND_TIMEOUT_MS 50   // Handler HTTP śpi na wyniku polecenia (semafor, bez odpytywania)
+
+// Oszczędzanie w spoczynku (praca z UPS/baterii) - dłuższy okres, budzenie poziomem GPIO.
+// Bez light sleep: build Arduino-ESP32 nie ma esp_pm (CONFIG_PM_ENABLE)
+#define ENABLE_IDLE_POWER_SAVE false
+#define POWER_IDLE_PERIOD_MS 1000       // Okres zadań control w spoczynku (IDLE, pompa off)
+
 // TYLKO DEKLARACJE (extern) - NIE DEFINICJE!
 extern const char* WIFI_SSID;
 extern const char* WIFI_PASSWORD;
@@ -43,6 +67,7 @@ extern const unsigned long PUMP_AUTO_ENABLE_MS;
 const unsigned long SESSION_TIMEOUT_MS = 1800000; 
 const unsigned long RATE_LIMIT_WINDOW_MS = 1000;
 const int MAX_REQUESTS_PER_SECOND = 5;
+const int RATE_LIMIT_BURST = 12;        // Pierwsze wczytanie dashboardu: strona + 5 fetchy, z zapasem
 const int MAX_FAILED_ATTEMPTS = 10;
 const unsigned long BLOCK_DURATION_MS = 60000;
 
@@ -0,0 +1,345 @@
+#include "control_commands.h"
+#include "logging.h"
+#include "metrics.h"
+#include "task_manager.h"
+#include "../config/config.h"
+#include "../hardware/hardware_pins.h"
+#include "../hardware/pump_controller.h"
+#include "../hardware/pump_usage.h"
+#include "../algorithm/water_algorithm.h"
+#include "../algorithm/debounce_profile.h"
+#include "../algorithm/flow_calibration.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+static_assert((CONTROL_COMMAND_QUEUE_SIZE & (CONTROL_COMMAND_QUEUE_SIZE - 1)) == 0,
+    "CONTROL_COMMAND_QUEUE_SIZE must be a power of two");
+
+// ============== BOUNDED MPSC RING ==============
+// Producentów (handlery HTTP, inne zadania) szereguje krótka sekcja
+// krytyczna - zapis komórki i publikacja enqueuePos. Konsument (control)
+// jest jeden i jako jedyny pisze dequeuePos, więc czyta bez blokady.
+// Bez std::atomic: CAS/RMW na ESP32-C3 idą przez emulację libatomic.
+
+struct CommandCell {
+    ControlCommand command;
+    int8_t resultSlot;
+};
+
+static portMUX_TYPE mailboxMux = portMUX_INITIALIZER_UNLOCKED;
+static CommandCell cells[CONTROL_COMMAND_QUEUE_SIZE];
+static volatile uint32_t enqueuePos = 0;    // Pisze producent (pod mailboxMux)
+static volatile uint32_t dequeuePos = 0;    // Pisze tylko control
+
+// ============== RESULT SLOTS ==============
+// FREE -> PENDING (producent) -> RUNNING (control) -> DONE (control) -> FREE (producent odczytał)
+// Handler po timeoucie oznacza slot ABANDONED tylko ze stanu PENDING - control
+// nie wykonuje wtedy polecenia (klient dostał 503, ponowienie nie zdubluje
+// dozowania) i sam zwalnia slot. Slotu RUNNING handler już nie porzuca.
+// Przejścia z więcej niż jednym możliwym stanem wyjściowym - pod mailboxMux.
+// Handler śpi na semaforze slotu (bez odpytywania) - control daje go po DONE.
+
+enum ResultSlotState : uint8_t {
+    SLOT_FREE = 0,
+    SLOT_PENDING,
+    SLOT_RUNNING,
+    SLOT_DONE,
+    SLOT_ABANDONED
+};
+
+struct ResultSlot {
+    volatile uint8_t state;
+    ControlCommandResult result;
+    SemaphoreHandle_t done;
+};
+
+static ResultSlot resultSlots[CONTROL_COMMAND_RESULT_SLOTS];
+static uint32_t commandsApplied = 0;
+
+void initControlCommands() {
+    for (int i = 0; i < CONTROL_COMMAND_RESULT_SLOTS; i++) {
+        resultSlots[i].state = SLOT_FREE;
+        if (resultSlots[i].done == nullptr) {
+            resultSlots[i].done = xSemaphoreCreateBinary();
+        }
+    }
+    enqueuePos = 0;
+    dequeuePos = 0;
+    commandsApplied = 0;
+}
+
+// Zmiana stanu slotu tylko z oczekiwanego stanu (odpowiednik CAS)
+static bool transitionSlot(ResultSlot& slot, uint8_t from, uint8_t to) {
+    bool changed = false;
+    portENTER_CRITICAL(&mailboxMux);
+    if (slot.state == from) {
+        slot.state = to;
+        changed = true;
+    }
+    portEXIT_CRITICAL(&mailboxMux);
+    return changed;
+}
+
+static int8_t acquireResultSlot() {
+    for (int8_t i = 0; i < CONTROL_COMMAND_RESULT_SLOTS; i++) {
+        if (resultSlots[i].done != nullptr && transitionSlot(resultSlots[i], SLOT_FREE, SLOT_PENDING)) {
+            xSemaphoreTake(resultSlots[i].done, 0);     // Sygnał po porzuconym poleceniu
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool enqueue(const ControlCommand& command, int8_t resultSlot) {
+    bool queued = false;
+    portENTER_CRITICAL(&mailboxMux);
+    uint32_t pos = enqueuePos;
+    if (pos - dequeuePos < CONTROL_COMMAND_QUEUE_SIZE) {
+        CommandCell& cell = cells[pos & (CONTROL_COMMAND_QUEUE_SIZE - 1)];
+        cell.command = command;
+        cell.resultSlot = resultSlot;
+        enqueuePos = pos + 1;   // Publikacja po zapisie komórki (sekcja krytyczna = bariera)
+        queued = true;
+    }
+    portEXIT_CRITICAL(&mailboxMux);
+    return queued;
+}
+
+static bool dequeue(ControlCommand& command, int8_t& resultSlot) {
+    uint32_t pos = dequeuePos;
+    if (pos == enqueuePos) {
+        return false;       // Pusta
+    }
+    __asm__ __volatile__("" ::: "memory");     // Komórka czytana po indeksie producenta
+
+    const CommandCell& cell = cells[pos & (CONTROL_COMMAND_QUEUE_SIZE - 1)];
+    command = cell.command;
+    resultSlot = cell.resultSlot;
+    __asm__ __volatile__("" ::: "memory");     // Komórka odczytana przed zwolnieniem
+    dequeuePos = pos + 1;
+    return true;
+}
+
+ControlCommandStatus postControlCommand(const ControlCommand& command, ControlCommandFuture* future) {
+    int8_t slot = -1;
+    if (future != nullptr) {
+        slot = acquireResultSlot();
+        if (slot < 0) {
+            metricsInc(MC_CONTROL_COMMANDS_REJECTED);
+            return CMD_STATUS_QUEUE_FULL;
+        }
+    }
+
+    if (!enqueue(command, slot)) {
+        if (slot >= 0) {
+            resultSlots[slot].state = SLOT_FREE;
+        }
+        metricsInc(MC_CONTROL_COMMANDS_REJECTED);
+        return CMD_STATUS_QUEUE_FULL;
+    }
+
+    if (future != nullptr) {
+        future->slot = slot;
+    }
+    notifySystemTask(TASK_CONTROL);
+    return CMD_STATUS_DONE;
+}
+
+ControlCommandStatus waitControlCommand(ControlCommandFuture& future, uint32_t timeoutMs, ControlCommandResult* result) {
+    if (future.slot < 0) {
+        return CMD_STATUS_DONE;
+    }
+    ResultSlot& slot = resultSlots[future.slot];
+
+    // Control ma wyższy priorytet i budzi się na powiadomienie - zwykle semafor
+    // jest już dany. Handler (async_tcp) śpi najwyżej timeoutMs, bez odpytywania.
+    if (slot.state != SLOT_DONE &&
+        xSemaphoreTake(slot.done, pdMS_TO_TICKS(timeoutMs)) != pdTRUE) {
+        if (transitionSlot(slot, SLOT_PENDING, SLOT_ABANDONED)) {
+            future.slot = -1;
+            metricsInc(MC_CONTROL_COMMAND_TIMEOUTS);
+            return CMD_STATUS_TIMEOUT;
+        }
+        // Control już wykonuje polecenie (RUNNING) albo skończył - wynik
+        // przyjdzie za chwilę, porzucenie skłamałoby klientowi
+        xSemaphoreTake(slot.done, portMAX_DELAY);
+    }
+
+    __asm__ __volatile__("" ::: "memory");     // Wynik czytany po stanie DONE
+    if (result != nullptr) {
+        *result = slot.result;
+    }
+    slot.state = SLOT_FREE;
+    future.slot = -1;
+    return CMD_STATUS_DONE;
+}
+
+static ControlCommandStatus submitAndWait(const ControlCommand& command, ControlCommandResult* result) {
+    ControlCommandFuture future;
+    ControlCommandStatus status = postControlCommand(command, &future);
+    if (status != CMD_STATUS_DONE) {
+        return status;
+    }
+    return waitControlCommand(future, CONTROL_COMMAND_TIMEOUT_MS, result);
+}
+
+ControlCommandStatus runControlCommand(ControlCommandType type, uint32_t arg, ControlCommandResult* result,
+                                       uint8_t channel) {
+    ControlCommand command;
+    command.type = type;
+    command.channel = channel;
+    command.u32 = arg;
+    return submitAndWait(command, result);
+}
+
+ControlCommandStatus runControlCommandFloat(ControlCommandType type, float arg, ControlCommandResult* result,
+                                            uint8_t channel) {
+    ControlCommand command;
+    command.type = type;
+    command.channel = channel;
+    command.f32 = arg;
+    return submitAndWait(command, result);
+}
+
+// ============== EXECUTION (control task) ==============
+
+static ControlCommandResult execute(const ControlCommand& command) {
+    ControlCommandResult result = { true, 0 };
+
+    // Handlery walidują kanał, ale mailbox nie ufa producentom
+    if (command.channel >= WATER_CHANNEL_COUNT) {
+        result.success = false;
+        return result;
+    }
+    WaterAlgorithm& algorithm = getWaterChannel(command.channel);
+    PumpChannel& pump = getPumpChannel(command.channel);
+
+    switch (command.type) {
+        case CMD_DIRECT_PUMP_ON:
+            result.success = pump.directOn((uint16_t)command.u32);
+            break;
+
+        case CMD_DIRECT_PUMP_OFF:
+            pump.directOff();
+            break;
+
+        case CMD_PUMP_STOP:
+            pump.stop();
+            break;
+
+        case CMD_PUMP_MANUAL:
+        case CMD_PUMP_CALIBRATION: {
+            PumpSource source = command.type == CMD_PUMP_MANUAL ? PUMP_SOURCE_MANUAL
+                                                                : PUMP_SOURCE_CALIBRATION;
+            PumpRequestResult granted = pump.request(source, (uint16_t)command.u32);
+            result.success = granted != PUMP_REJECTED;
+            result.value = granted;
+            break;
+        }
+
+        case CMD_SET_VOLUME_PER_SECOND:
+            algorithm.setVolumePerSecond(command.f32);      // Zapis FRAM przez kolejkę storage
+            if (command.channel == 0) {
+                flowCalibrationOnManualRate(command.f32);
+            }
+            break;
+
+        case CMD_TOGGLE_SYSTEM: {
+            bool enable = isSystemDisabled();
+            setSystemState(enable);
+            result.value = enable ? 1 : 0;
+            break;
+        }
+
+        case CMD_TOGGLE_PUMP_GLOBAL:
+            setPumpGlobalState(!pumpGlobalEnabled);
+            result.value = pumpGlobalEnabled ? 1 : 0;
+            break;
+
+        case CMD_SYSTEM_RESET:
+            result.success = algorithm.resetSystem();
+            break;
+
+        case CMD_RESET_DAILY_VOLUME:
+            result.success = algorithm.resetDailyVolume();
+            break;
+
+        case CMD_SET_AVAILABLE_VOLUME:
+            algorithm.setAvailableVolume(command.u32);
+            break;
+
+        case CMD_REFILL_AVAILABLE_VOLUME:
+            algorithm.refillAvailableVolume();
+            break;
+
+        case CMD_SET_FILL_WATER_MAX:
+            algorithm.setFillWaterMax((uint16_t)command.u32);
+            break;
+
+        case CMD_RESET_DEBOUNCE_PROFILE:
+            resetDebounceProfile();
+            break;
+
+        case CMD_APPLY_FLOW_ESTIMATE:
+            result.success = applyFlowEstimate();
+            break;
+
+        case CMD_ACK_ANOMALY:
+            algorithm.acknowledgeAnomaly();
+            break;
+
+        case CMD_RESET_PUMP_USAGE:
+            resetPumpUsage(command.channel);
+            break;
+
+        case CMD_RESET_ERROR_STATS:
+            algorithm.resetErrorStatistics(command.u32);
+            break;
+
+        default:
+            result.success = false;
+            break;
+    }
+    return result;
+}
+
+void applyControlCommands() {
+    ControlCommand command;
+    int8_t slotIndex;
+
+    while (dequeue(command, slotIndex)) {
+        if (slotIndex >= 0 && !transitionSlot(resultSlots[slotIndex], SLOT_PENDING, SLOT_RUNNING)) {
+            // Handler zgłosił już timeout (ABANDONED) - polecenie nie może się
+            // wykonać po fakcie, np. start pompy po odpowiedzi 503
+            resultSlots[slotIndex].state = SLOT_FREE;
+            metricsInc(MC_CONTROL_COMMANDS_CANCELLED);
+            LOG_WARNING("");
+            LOG_WARNING("Control command %d cancelled - caller timed out", command.type);
+            continue;
+        }
+
+        ControlCommandResult result = execute(command);
+        commandsApplied++;
+        metricsInc(MC_CONTROL_COMMANDS_APPLIED);
+
+        if (slotIndex < 0) {
+            continue;
+        }
+        ResultSlot& slot = resultSlots[slotIndex];
+        slot.result = result;
+        __asm__ __volatile__("" ::: "memory");     // Wynik zapisany przed DONE
+        slot.state = SLOT_DONE;                     // Ze stanu RUNNING wychodzi tylko control
+        xSemaphoreGive(slot.done);
+    }
+}
+
+void waitForControlWork(uint32_t waitMs) {
+    if (waitMs > 0) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+    }
+}
+
+uint32_t getControlCommandsApplied() {
+    return commandsApplied;
+}
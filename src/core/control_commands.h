@@ -0,0 +1,82 @@
+#ifndef CONTROL_COMMANDS_H
+#define CONTROL_COMMANDS_H
+
+#include <Arduino.h>
+
+// ============== CONTROL COMMAND MAILBOX ==============
+// Handlery HTTP (async_tcp) nie dotykają stanu pompy ani algorytmu -
+// wrzucają typowane polecenie do ograniczonej kolejki (krótka sekcja
+// krytyczna, bez mutexa i bez std::atomic), a
+// zadanie control wykonuje je na początku ticka, przed planerem.
+// Wynik wraca przez slot "future" (submit + wait) albo w ogóle
+// (fire-and-forget, future == nullptr).
+
+#define CONTROL_COMMAND_QUEUE_SIZE      8   // Potęga dwójki
+#define CONTROL_COMMAND_RESULT_SLOTS    4   // Równocześnie oczekujących handlerów
+
+enum ControlCommandType : uint8_t {
+    CMD_DIRECT_PUMP_ON = 0,         // u32 = czas [s]
+    CMD_DIRECT_PUMP_OFF,
+    CMD_PUMP_STOP,
+    CMD_PUMP_MANUAL,                // u32 = czas [s], value = PumpRequestResult
+    CMD_PUMP_CALIBRATION,           // u32 = czas [s], value = PumpRequestResult
+    CMD_SET_VOLUME_PER_SECOND,      // f32 = ml/s
+    CMD_TOGGLE_SYSTEM,              // value = 1 gdy po przełączeniu włączony
+    CMD_TOGGLE_PUMP_GLOBAL,         // value = 1 gdy po przełączeniu włączona
+    CMD_SYSTEM_RESET,
+    CMD_RESET_DAILY_VOLUME,
+    CMD_SET_AVAILABLE_VOLUME,       // u32 = ml
+    CMD_REFILL_AVAILABLE_VOLUME,
+    CMD_SET_FILL_WATER_MAX,         // u32 = ml
+    CMD_RESET_DEBOUNCE_PROFILE,
+    CMD_APPLY_FLOW_ESTIMATE,        // success = false gdy brak estymaty
+    CMD_ACK_ANOMALY,
+    CMD_RESET_PUMP_USAGE,
+    CMD_RESET_ERROR_STATS,          // u32 = znacznik czasu resetu (unix)
+
+    CONTROL_COMMAND_TYPE_COUNT
+};
+
+struct ControlCommand {
+    ControlCommandType type;
+    uint8_t channel;                // Kanał wodny (WATER_CHANNEL_COUNT), 0 = domyślny
+    union {
+        uint32_t u32;
+        float f32;
+    };
+};
+
+struct ControlCommandResult {
+    bool success;
+    int32_t value;
+};
+
+enum ControlCommandStatus {
+    CMD_STATUS_DONE = 0,
+    CMD_STATUS_QUEUE_FULL,          // Kolejka lub sloty wyników zajęte
+    CMD_STATUS_TIMEOUT              // Control nie wykonał polecenia w czasie
+};
+
+struct ControlCommandFuture {
+    int8_t slot;                    // -1 = bez oczekiwania na wynik
+};
+
+void initControlCommands();
+
+// Producent (dowolne zadanie poza control)
+ControlCommandStatus postControlCommand(const ControlCommand& command, ControlCommandFuture* future);
+ControlCommandStatus waitControlCommand(ControlCommandFuture& future, uint32_t timeoutMs, ControlCommandResult* result);
+
+// submit + wait w jednym wywołaniu - typowe użycie w handlerze
+ControlCommandStatus runControlCommand(ControlCommandType type, uint32_t arg, ControlCommandResult* result,
+                                       uint8_t channel = 0);
+ControlCommandStatus runControlCommandFloat(ControlCommandType type, float arg, ControlCommandResult* result,
+                                            uint8_t channel = 0);
+
+// Konsument (tylko zadanie control)
+void applyControlCommands();
+void waitForControlWork(uint32_t waitMs);   // TaskWaitFn - budzi się na polecenie
+
+uint32_t getControlCommandsApplied();
+
+#endif
@@ -0,0 +1,233 @@
+#include "metrics.h"
+#include "logging.h"
+#include <WiFi.h>
+
+// ============== DESKRYPTORY ==============
+// Wpisy tej samej rodziny muszą sąsiadować - HELP/TYPE emitowane raz na rodzinę
+
+struct MetricDesc {
+    const char* name;
+    const char* labels;     // "" albo "key=\"value\""
+    const char* help;
+};
+
+static const MetricDesc COUNTER_DESC[METRIC_COUNTER_COUNT] = {
+    { "water_pump_starts_total", "source=\"auto\"", "Pump relay activations by request source" },
+    { "water_pump_starts_total", "source=\"manual\"", "" },
+    { "water_pump_starts_total", "source=\"direct\"", "" },
+    { "water_pump_starts_total", "source=\"calibration\"", "" },
+    { "water_pump_runtime_ms_total", "", "Accumulated pump relay on-time" },
+    { "water_pump_arbiter_events_total", "event=\"queued\"", "Pump arbiter decisions other than a plain grant" },
+    { "water_pump_arbiter_events_total", "event=\"rejected\"", "" },
+    { "water_pump_arbiter_events_total", "event=\"preempted\"", "" },
+    { "water_pump_arbiter_events_total", "event=\"dropped\"", "" },
+
+    { "water_cycles_total", "result=\"ok\"", "Completed algorithm cycles by outcome" },
+    { "water_cycles_total", "result=\"pump_failure\"", "" },
+    { "water_cycle_failures_total", "check=\"gap1\"", "Cycle verification failures by check" },
+    { "water_cycle_failures_total", "check=\"gap2\"", "" },
+    { "water_cycle_failures_total", "check=\"water\"", "" },
+    { "water_cycle_volume_ml_total", "", "Water volume delivered by algorithm cycles" },
+    { "water_cycle_checkpoint_restores_total", "outcome=\"resumed\"", "Cycle checkpoints found at boot by outcome" },
+    { "water_cycle_checkpoint_restores_total", "outcome=\"closed\"", "" },
+    { "water_cycle_checkpoint_restores_total", "outcome=\"discarded\"", "" },
+
+    { "water_algorithm_state_entries_total", "state=\"idle\"", "Algorithm state entries" },
+    { "water_algorithm_state_entries_total", "state=\"pre_qualification\"", "" },
+    { "water_algorithm_state_entries_total", "state=\"settling\"", "" },
+    { "water_algorithm_state_entries_total", "state=\"debouncing\"", "" },
+    { "water_algorithm_state_entries_total", "state=\"pumping_and_verify\"", "" },
+    { "water_algorithm_state_entries_total", "state=\"logging\"", "" },
+    { "water_algorithm_state_entries_total", "state=\"error\"", "" },
+    { "water_algorithm_state_entries_total", "state=\"manual_override\"", "" },
+
+    { "water_fram_ops_total", "op=\"read\"", "FRAM I2C transactions" },
+    { "water_fram_ops_total", "op=\"write\"", "" },
+    { "water_fram_bytes_total", "op=\"read\"", "FRAM bytes transferred" },
+    { "water_fram_bytes_total", "op=\"write\"", "" },
+    { "water_fram_errors_total", "", "FRAM transactions reported as failed by the driver" },
+    { "water_rtc_reads_total", "", "DS3231 time reads" },
+    { "water_rtc_read_failures_total", "", "RTC reads that failed validation after retries" },
+    { "water_i2c_lock_contended_total", "", "I2C bus acquisitions that had to wait for another task" },
+    { "water_storage_jobs_total", "event=\"done\"", "Deferred FRAM writes executed, waits for a full queue and drops" },
+    { "water_storage_jobs_total", "event=\"overflow\"", "" },
+    { "water_storage_jobs_total", "event=\"dropped\"", "" },
+
+    { "water_http_requests_total", "", "HTTP requests handled" },
+    { "water_http_auth_denied_total", "", "HTTP requests rejected by authentication" },
+    { "water_sessions_total", "event=\"created\"", "Session lifecycle events" },
+    { "water_sessions_total", "event=\"destroyed\"", "" },
+    { "water_sessions_total", "event=\"expired\"", "" },
+    { "water_sessions_total", "event=\"restored\"", "" },
+    { "water_rate_limiter_events_total", "event=\"limited\"", "Rate limiter events" },
+    { "water_rate_limiter_events_total", "event=\"blocked\"", "" },
+    { "water_rate_limiter_events_total", "event=\"evicted\"", "" },
+    { "water_control_commands_total", "event=\"applied\"", "Web commands passed to the control task" },
+    { "water_control_commands_total", "event=\"rejected\"", "" },
+    { "water_control_commands_total", "event=\"timeout\"", "" },
+    { "water_control_commands_total", "event=\"cancelled\"", "" },
+    { "water_power_wakes_total", "source=\"timer\"", "Control task wake-ups by cause" },
+    { "water_power_wakes_total", "source=\"gpio\"", "" },
+    { "water_power_wakes_total", "source=\"command\"", "" },
+    { "water_sensor_edges_total", "event=\"edge\"", "Float sensor edges captured by interrupt" },
+    { "water_sensor_edges_total", "event=\"bounce\"", "" },
+    { "water_sensor_edges_total", "event=\"dropped\"", "" },
+    { "water_flow_calibration_total", "event=\"sample\"", "Flow calibration samples accepted and rate corrections applied" },
+    { "water_flow_calibration_total", "event=\"applied\"", "" },
+    { "water_anomaly_alarms_total", "series=\"time_gap_1\"", "CUSUM drift alarms per monitored series" },
+    { "water_anomaly_alarms_total", "series=\"water_trigger_time\"", "" },
+    { "water_anomaly_alarms_total", "series=\"loss_rate\"", "" },
+
+    { "water_loop_budget_overruns_total", "", "Control ticks exceeding LOOP_TICK_BUDGET_US" },
+};
+
+static const MetricDesc GAUGE_DESC[METRIC_GAUGE_COUNT] = {
+    { "water_uptime_seconds", "", "Seconds since boot" },
+    { "water_free_heap_bytes", "", "Current free heap" },
+    { "water_min_free_heap_bytes", "", "Lowest free heap since boot" },
+    { "water_wifi_rssi_dbm", "", "WiFi signal strength" },
+    { "water_pump_running", "", "1 while the pump relay is on" },
+    { "water_algorithm_state", "", "Current AlgorithmState value" },
+    { "water_daily_volume_ml", "", "Volume counted against the daily limit" },
+    { "water_available_volume_ml", "", "Remaining reservoir volume" },
+    { "water_sessions_active", "", "Active web sessions" },
+    { "water_rate_limiter_clients", "", "Tracked rate limiter clients" },
+    { "water_task_stack_free_bytes", "task=\"control\"", "Lowest free stack seen per system task" },
+    { "water_task_stack_free_bytes", "task=\"storage\"", "" },
+    { "water_task_stack_free_bytes", "task=\"housekeeping\"", "" },
+    { "water_storage_queue_depth", "", "FRAM writes waiting for the storage task" },
+    { "water_power_task_busy_permille", "", "Share of uptime spent in system tasks and HTTP handlers (not sleep residency)" },
+    { "water_flow_drift_permille", "", "Estimated vs configured pump flow rate difference" },
+    { "water_anomaly_active", "", "Monitored series currently in anomaly alarm" },
+    { "water_pump_lifetime_on_seconds", "source=\"auto\"", "Persisted pump relay on-time by request source" },
+    { "water_pump_lifetime_on_seconds", "source=\"calibration\"", "" },
+    { "water_pump_lifetime_on_seconds", "source=\"manual\"", "" },
+    { "water_pump_lifetime_on_seconds", "source=\"direct\"", "" },
+    { "water_pump_lifetime_starts", "", "Persisted pump relay activations" },
+    { "water_pump_longest_run_ms", "", "Longest single pump run since the counters were reset" },
+    { "water_pump_on_today_seconds", "", "Pump on-time in the current UTC day" },
+    { "water_pump_duty_yesterday_permille", "", "Pump on-time share of the previous UTC day" },
+};
+
+struct HistogramDesc {
+    const char* name;
+    const char* help;
+    uint32_t bounds[METRICS_MAX_BUCKETS];   // Rosnąco, 0 = koniec listy
+};
+
+static const HistogramDesc HISTOGRAM_DESC[METRIC_HISTOGRAM_COUNT] = {
+    { "water_loop_duration_us", "Control task tick time excluding idle wait",
+      { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000 } },
+    { "water_http_handler_duration_us", "Web handler execution time",
+      { 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000 } },
+    { "water_fram_op_duration_us", "FRAM I2C transaction time",
+      { 50, 100, 200, 500, 1000, 2000, 5000, 10000 } },
+    { "water_rtc_read_duration_us", "DS3231 read time",
+      { 100, 200, 500, 1000, 2000, 5000, 10000, 50000 } },
+    { "water_pump_run_duration_ms", "Pump relay on-time per activation",
+      { 1000, 2000, 5000, 10000, 15000, 20000, 30000, 60000, 120000, 300000 } },
+};
+
+struct HistogramData {
+    uint32_t buckets[METRICS_MAX_BUCKETS + 1];  // Ostatni = +Inf
+    uint32_t count;
+    uint64_t sum;
+};
+
+static uint32_t counters[METRIC_COUNTER_COUNT];
+static int32_t gauges[METRIC_GAUGE_COUNT];
+static HistogramData histograms[METRIC_HISTOGRAM_COUNT];
+
+void initMetrics() {
+    memset(counters, 0, sizeof(counters));
+    memset(gauges, 0, sizeof(gauges));
+    memset(histograms, 0, sizeof(histograms));
+    LOG_INFO("");
+    LOG_INFO("Metrics registry initialized (%d counters, %d gauges, %d histograms)",
+             METRIC_COUNTER_COUNT, METRIC_GAUGE_COUNT, METRIC_HISTOGRAM_COUNT);
+}
+
+void metricsInc(MetricCounter id, uint32_t amount) {
+    counters[id] += amount;
+}
+
+void metricsSetGauge(MetricGauge id, int32_t value) {
+    gauges[id] = value;
+}
+
+void metricsObserve(MetricHistogram id, uint32_t value) {
+    const HistogramDesc& desc = HISTOGRAM_DESC[id];
+    HistogramData& data = histograms[id];
+
+    uint8_t bucket = 0;
+    while (bucket < METRICS_MAX_BUCKETS && desc.bounds[bucket] != 0 && value > desc.bounds[bucket]) {
+        bucket++;
+    }
+    if (bucket < METRICS_MAX_BUCKETS && desc.bounds[bucket] == 0) {
+        bucket = METRICS_MAX_BUCKETS;   // Powyżej ostatniej granicy -> +Inf
+    }
+
+    data.buckets[bucket]++;
+    data.count++;
+    data.sum += value;
+}
+
+uint32_t metricsGetCounter(MetricCounter id) {
+    return counters[id];
+}
+
+static void writeFamilyHeader(Print& out, const char* name, const char* help, const char* type) {
+    out.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void writeSample(Print& out, const MetricDesc& desc, long long value) {
+    if (desc.labels[0]) {
+        out.printf("%s{%s} %lld\n", desc.name, desc.labels, value);
+    } else {
+        out.printf("%s %lld\n", desc.name, value);
+    }
+}
+
+void writeMetricsPrometheus(Print& out) {
+    // Wartości systemowe odświeżane przy scrape
+    metricsSetGauge(MG_UPTIME_SECONDS, millis() / 1000);
+    metricsSetGauge(MG_FREE_HEAP_BYTES, ESP.getFreeHeap());
+    metricsSetGauge(MG_MIN_FREE_HEAP_BYTES, ESP.getMinFreeHeap());
+    metricsSetGauge(MG_WIFI_RSSI_DBM, WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0);
+
+    const char* lastFamily = nullptr;
+    for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+        const MetricDesc& desc = COUNTER_DESC[i];
+        if (!lastFamily || strcmp(lastFamily, desc.name) != 0) {
+            writeFamilyHeader(out, desc.name, desc.help, "counter");
+            lastFamily = desc.name;
+        }
+        writeSample(out, desc, counters[i]);
+    }
+
+    lastFamily = nullptr;
+    for (int i = 0; i < METRIC_GAUGE_COUNT; i++) {
+        const MetricDesc& desc = GAUGE_DESC[i];
+        if (!lastFamily || strcmp(lastFamily, desc.name) != 0) {
+            writeFamilyHeader(out, desc.name, desc.help, "gauge");
+            lastFamily = desc.name;
+        }
+        writeSample(out, desc, gauges[i]);
+    }
+
+    for (int i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+        const HistogramDesc& desc = HISTOGRAM_DESC[i];
+        const HistogramData& data = histograms[i];
+        writeFamilyHeader(out, desc.name, desc.help, "histogram");
+
+        uint32_t cumulative = 0;
+        for (uint8_t b = 0; b < METRICS_MAX_BUCKETS && desc.bounds[b] != 0; b++) {
+            cumulative += data.buckets[b];
+            out.printf("%s_bucket{le=\"%lu\"} %lu\n", desc.name,
+                       (unsigned long)desc.bounds[b], (unsigned long)cumulative);
+        }
+        out.printf("%s_bucket{le=\"+Inf\"} %lu\n", desc.name, (unsigned long)data.count);
+        out.printf("%s_sum %llu\n", desc.name, (unsigned long long)data.sum);
+        out.printf("%s_count %lu\n", desc.name, (unsigned long)data.count);
+    }
+}
@@ -0,0 +1,163 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+// ============== METRICS REGISTRY ==============
+// Statyczne liczniki / gauge / histogramy - bez alokacji, eksport w formacie
+// Prometheus text (GET /metrics). Inkrementacje są "best effort": zadania systemowe i
+// async_tcp mogą się przeplatać, pojedyncza zgubiona inkrementacja jest
+// akceptowalna dla monitoringu.
+
+enum MetricCounter {
+    // Pompa
+    MC_PUMP_STARTS_AUTO = 0,
+    MC_PUMP_STARTS_MANUAL,
+    MC_PUMP_STARTS_DIRECT,
+    MC_PUMP_STARTS_CALIBRATION,
+    MC_PUMP_RUNTIME_MS,
+    MC_PUMP_ARBITER_QUEUED,
+    MC_PUMP_ARBITER_REJECTED,
+    MC_PUMP_ARBITER_PREEMPTED,
+    MC_PUMP_ARBITER_DROPPED,
+
+    // Cykle algorytmu
+    MC_CYCLES_OK,
+    MC_CYCLES_PUMP_FAILURE,
+    MC_CYCLE_GAP1_FAIL,
+    MC_CYCLE_GAP2_FAIL,
+    MC_CYCLE_WATER_FAIL,
+    MC_CYCLE_VOLUME_ML,
+    MC_CHECKPOINT_RESUMED,
+    MC_CHECKPOINT_CLOSED,
+    MC_CHECKPOINT_DISCARDED,
+
+    // Wejścia w stany algorytmu (kolejność = AlgorithmState)
+    MC_STATE_ENTER_IDLE,
+    MC_STATE_ENTER_PRE_QUALIFICATION,
+    MC_STATE_ENTER_SETTLING,
+    MC_STATE_ENTER_DEBOUNCING,
+    MC_STATE_ENTER_PUMPING_AND_VERIFY,
+    MC_STATE_ENTER_LOGGING,
+    MC_STATE_ENTER_ERROR,
+    MC_STATE_ENTER_MANUAL_OVERRIDE,
+
+    // FRAM / RTC I/O
+    MC_FRAM_READS,
+    MC_FRAM_WRITES,
+    MC_FRAM_BYTES_READ,
+    MC_FRAM_BYTES_WRITTEN,
+    MC_FRAM_ERRORS,
+    MC_RTC_READS,
+    MC_RTC_READ_FAILURES,
+    MC_I2C_LOCK_CONTENDED,
+    MC_STORAGE_JOBS_DONE,
+    MC_STORAGE_QUEUE_OVERFLOWS,
+    MC_STORAGE_JOBS_DROPPED,
+
+    // Web / sesje / rate limiter
+    MC_HTTP_REQUESTS,
+    MC_HTTP_AUTH_DENIED,
+    MC_SESSIONS_CREATED,
+    MC_SESSIONS_DESTROYED,
+    MC_SESSIONS_EXPIRED,
+    MC_SESSIONS_RESTORED,
+    MC_RATE_LIMITED,
+    MC_RATE_IP_BLOCKS,
+    MC_RATE_EVICTIONS,
+    MC_CONTROL_COMMANDS_APPLIED,
+    MC_CONTROL_COMMANDS_REJECTED,
+    MC_CONTROL_COMMAND_TIMEOUTS,
+    MC_CONTROL_COMMANDS_CANCELLED,
+
+    // Zasilanie (kolejność = PowerWakeSource)
+    MC_POWER_WAKES_TIMER,
+    MC_POWER_WAKES_GPIO,
+    MC_POWER_WAKES_COMMAND,
+
+    // Czujniki (przerwania zboczy)
+    MC_SENSOR_EDGES,
+    MC_SENSOR_BOUNCES,
+    MC_SENSOR_EDGES_DROPPED,
+
+    // Kalibracja przepływu
+    MC_FLOW_CAL_SAMPLES,
+    MC_FLOW_CAL_APPLIED,
+
+    // Detekcja anomalii (kolejność = AnomalySeries)
+    MC_ANOMALY_TIME_GAP_1,
+    MC_ANOMALY_WATER_TRIGGER,
+    MC_ANOMALY_LOSS_RATE,
+
+    // Pętla główna
+    MC_LOOP_BUDGET_OVERRUNS,
+
+    METRIC_COUNTER_COUNT
+};
+
+enum MetricGauge {
+    MG_UPTIME_SECONDS = 0,
+    MG_FREE_HEAP_BYTES,
+    MG_MIN_FREE_HEAP_BYTES,
+    MG_WIFI_RSSI_DBM,
+    MG_PUMP_RUNNING,
+    MG_ALGORITHM_STATE,
+    MG_DAILY_VOLUME_ML,
+    MG_AVAILABLE_VOLUME_ML,
+    MG_SESSIONS_ACTIVE,
+    MG_RATE_LIMIT_CLIENTS,
+    MG_TASK_STACK_FREE_CONTROL,
+    MG_TASK_STACK_FREE_STORAGE,
+    MG_TASK_STACK_FREE_HOUSEKEEPING,
+    MG_STORAGE_QUEUE_DEPTH,
+    MG_POWER_TASK_BUSY_PERMILLE,
+    MG_FLOW_DRIFT_PERMILLE,
+    MG_ANOMALY_ACTIVE,
+
+    // Eksploatacja pompy kanału 0 (kolejność = PumpSource)
+    MG_PUMP_LIFETIME_ON_AUTO,
+    MG_PUMP_LIFETIME_ON_CALIBRATION,
+    MG_PUMP_LIFETIME_ON_MANUAL,
+    MG_PUMP_LIFETIME_ON_DIRECT,
+    MG_PUMP_LIFETIME_STARTS,
+    MG_PUMP_LONGEST_RUN_MS,
+    MG_PUMP_ON_TODAY_SECONDS,
+    MG_PUMP_DUTY_YESTERDAY_PERMILLE,
+
+    METRIC_GAUGE_COUNT
+};
+
+enum MetricHistogram {
+    MH_LOOP_DURATION_US = 0,
+    MH_HTTP_HANDLER_US,
+    MH_FRAM_OP_US,
+    MH_RTC_READ_US,
+    MH_PUMP_RUN_MS,
+
+    METRIC_HISTOGRAM_COUNT
+};
+
+#define METRICS_MAX_BUCKETS     10
+
+void initMetrics();
+
+void metricsInc(MetricCounter id, uint32_t amount = 1);
+void metricsSetGauge(MetricGauge id, int32_t value);
+void metricsObserve(MetricHistogram id, uint32_t value);
+
+uint32_t metricsGetCounter(MetricCounter id);
+
+// Prometheus text exposition format 0.0.4
+void writeMetricsPrometheus(Print& out);
+
+// Mierzy czas życia obiektu (µs) do wskazanego histogramu
+class MetricTimer {
+public:
+    explicit MetricTimer(MetricHistogram id) : histogram(id), start(micros()) {}
+    ~MetricTimer() { metricsObserve(histogram, micros() - start); }
+private:
+    MetricHistogram histogram;
+    uint32_t start;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "power_manager.h"
+#include "logging.h"
+#include "metrics.h"
+#include "task_manager.h"
+#include "../hardware/hardware_pins.h"
+#include "../hardware/sensor_edges.h"
+#include <WiFi.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+
+static const char* WAKE_SOURCE_NAMES[POWER_WAKE_SOURCE_COUNT] = {
+    "timer",
+    "gpio",
+    "command",
+};
+
+static portMUX_TYPE powerMux = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t taskBusyUs = 0;
+static uint32_t idleTicks = 0;
+static uint32_t wakes[POWER_WAKE_SOURCE_COUNT];
+static bool gpioWakeArmed = false;
+static volatile bool gpioWakePending = false;
+
+void IRAM_ATTR powerSignalGpioWakeFromISR() {
+    gpioWakePending = true;
+    notifySystemTaskFromISR(TASK_CONTROL);
+}
+
+// Przycisk: przerwanie poziomem LOW (ten sam typ co GPIO wakeup) - wyłącza się
+// samo, inaczej trzymany przycisk generowałby burzę przerwań. Piny pływaków
+// obsługuje ISR zboczy (sensor_edges), przełączany tu w tryb poziomu.
+static void IRAM_ATTR onWakePin() {
+    gpio_intr_disable((gpio_num_t)RESET_PIN);
+    powerSignalGpioWakeFromISR();
+}
+
+void initPowerManager() {
+    memset(wakes, 0, sizeof(wakes));
+
+    if (!ENABLE_IDLE_POWER_SAVE) {
+        LOG_INFO("");
+        LOG_INFO("Power manager: idle power save disabled (ENABLE_IDLE_POWER_SAVE=false)");
+        return;
+    }
+
+    // Modem sleep: WiFi pozostaje połączone, radio budzi się na DTIM
+    WiFi.setSleep(true);
+
+    attachInterrupt(RESET_PIN, onWakePin, ONLOW);
+    gpio_intr_disable((gpio_num_t)RESET_PIN);
+
+    LOG_INFO("");
+    LOG_INFO("Power manager: idle power save enabled (%d ms idle period, no light sleep)",
+             POWER_IDLE_PERIOD_MS);
+}
+
+bool isIdlePowerSaveEnabled() {
+    return ENABLE_IDLE_POWER_SAVE;
+}
+
+static void armGpioWake() {
+    gpio_intr_enable((gpio_num_t)RESET_PIN);
+    setSensorLevelWake(true);
+    gpioWakeArmed = true;
+}
+
+static void disarmGpioWake() {
+    gpio_intr_disable((gpio_num_t)RESET_PIN);
+    setSensorLevelWake(false);
+    gpioWakeArmed = false;
+}
+
+void powerSetControlIdle(bool idle) {
+    if (!ENABLE_IDLE_POWER_SAVE) {
+        return;
+    }
+    if (idle) {
+        idleTicks++;
+        if (!gpioWakeArmed) {
+            armGpioWake();
+        }
+    } else if (gpioWakeArmed) {
+        disarmGpioWake();
+    }
+}
+
+bool takeGpioWake() {
+    if (!gpioWakePending) {
+        return false;
+    }
+    gpioWakePending = false;
+    if (gpioWakeArmed) {
+        disarmGpioWake();
+    }
+    return true;
+}
+
+void powerRecordWake(PowerWakeSource source) {
+    wakes[source]++;
+    metricsInc((MetricCounter)(MC_POWER_WAKES_TIMER + source));
+}
+
+void powerAccountActive(uint32_t us) {
+    portENTER_CRITICAL(&powerMux);
+    taskBusyUs += us;
+    portEXIT_CRITICAL(&powerMux);
+}
+
+PowerStats getPowerStats() {
+    PowerStats stats;
+    stats.idleModeEnabled = ENABLE_IDLE_POWER_SAVE;
+    stats.gpioWakeArmed = gpioWakeArmed;
+    stats.uptimeUs = esp_timer_get_time();
+    portENTER_CRITICAL(&powerMux);
+    stats.taskBusyUs = taskBusyUs;
+    portEXIT_CRITICAL(&powerMux);
+    stats.idleTicks = idleTicks;
+    memcpy(stats.wakes, wakes, sizeof(wakes));
+    return stats;
+}
+
+const char* getPowerWakeSourceName(PowerWakeSource source) {
+    return WAKE_SOURCE_NAMES[source];
+}
@@ -0,0 +1,49 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+
+// ============== POWER MANAGEMENT ==============
+// Oszczędzanie w spoczynku (ENABLE_IDLE_POWER_SAVE): gdy algorytm czeka
+// w IDLE, zadanie control wydłuża okresy do POWER_IDLE_PERIOD_MS, próbkowanie
+// 1 kHz stoi, a poziom LOW pływaka / przycisku budzi je od razu (przerwanie
+// poziomem). WiFi zostaje w modem sleep - asocjacja utrzymana.
+// Light sleep (esp_pm) nie jest dostępny: build Arduino-ESP32 nie ma
+// CONFIG_PM_ENABLE, więc CPU nie usypia - skraca się tylko czas pracy zadań.
+// Pomiar "busy" to czas w zadaniach systemowych i handlerach HTTP - reszta
+// uptime to "poza zadaniami" (idle task, WiFi, lwIP), nie czas w uśpieniu.
+
+enum PowerWakeSource {
+    WAKE_TIMER = 0,         // Termin planera
+    WAKE_GPIO,              // Pływak / przycisk
+    WAKE_COMMAND,           // Polecenie z HTTP (ruch sieciowy)
+
+    POWER_WAKE_SOURCE_COUNT
+};
+
+struct PowerStats {
+    bool idleModeEnabled;       // ENABLE_IDLE_POWER_SAVE
+    bool gpioWakeArmed;
+    uint64_t uptimeUs;
+    uint64_t taskBusyUs;        // Czas pracy zadań systemowych + handlerów HTTP (nie rezydencja uśpienia)
+    uint32_t idleTicks;         // Ticki control z wydłużonym okresem
+    uint32_t wakes[POWER_WAKE_SOURCE_COUNT];
+};
+
+void initPowerManager();        // Po initWiFi() i initWaterSensors()
+
+bool isIdlePowerSaveEnabled();
+
+// Kontekst control: uzbrojenie/rozbrojenie wybudzania GPIO wg stanu spoczynku
+void powerSetControlIdle(bool idle);
+bool takeGpioWake();            // Zbocze od ostatniego sprawdzenia (rozbraja GPIO)
+void powerSignalGpioWakeFromISR();  // ISR pływaków / przycisku (IRAM)
+
+void powerRecordWake(PowerWakeSource source);
+void powerAccountActive(uint32_t us);
+
+PowerStats getPowerStats();
+const char* getPowerWakeSourceName(PowerWakeSource source);
+
+#endif
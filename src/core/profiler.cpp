@@ -0,0 +1,152 @@
+#include "profiler.h"
+#include "logging.h"
+#include "metrics.h"
+
+static const char* SECTION_NAMES[PROFILE_SECTION_COUNT] = {
+    "sensors",
+    "algorithm",
+    "pump",
+    "sessions",
+    "rate_limiter",
+    "wifi",
+    "tick",
+    "lateness",
+};
+
+static ProfileStats stats[PROFILE_SECTION_COUNT];
+static ProfileWorstTick worstTick;
+static uint32_t currentTick[PROFILE_SECTION_COUNT];
+static int64_t tickStartUs = 0;
+static uint32_t budgetOverruns = 0;
+
+static uint8_t bucketFor(uint32_t us) {
+    uint8_t bucket = 0;
+    while (us > 1 && bucket < PROFILE_HISTOGRAM_BUCKETS - 1) {
+        us = (us + 1) >> 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static uint32_t elapsedUs(int64_t startUs) {
+    return (uint32_t)(esp_timer_get_time() - startUs);
+}
+
+void initProfiler() {
+    resetProfiler();
+
+    LOG_INFO("");
+    LOG_INFO("Loop profiler %s (budget %d us/tick)",
+             isProfilerEnabled() ? "enabled" : "compiled out", LOOP_TICK_BUDGET_US);
+}
+
+void resetProfiler() {
+    memset(stats, 0, sizeof(stats));
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+        stats[i].minUs = UINT32_MAX;
+    }
+    memset(&worstTick, 0, sizeof(worstTick));
+    memset(currentTick, 0, sizeof(currentTick));
+    budgetOverruns = 0;
+}
+
+void profilerRecord(ProfileSection section, uint32_t us) {
+    ProfileStats& s = stats[section];
+    s.count++;
+    s.sumUs += us;
+    if (us < s.minUs) {
+        s.minUs = us;
+    }
+    if (us > s.maxUs) {
+        s.maxUs = us;
+        s.maxAtMs = millis();
+    }
+    s.histogram[bucketFor(us)]++;
+
+    // Rozkład ticka tylko z sekcji zadania control (housekeeping działa osobno)
+    if (section <= PROF_PUMP) {
+        currentTick[section] += us;
+    }
+}
+
+void profilerBeginTick() {
+    memset(currentTick, 0, sizeof(currentTick));
+    tickStartUs = esp_timer_get_time();
+}
+
+void profilerEndTick() {
+    uint32_t tickUs = elapsedUs(tickStartUs);
+    profilerRecord(PROF_TICK, tickUs);
+
+    if (tickUs > worstTick.totalUs) {
+        worstTick.totalUs = tickUs;
+        worstTick.atMs = millis();
+        memcpy(worstTick.sectionUs, currentTick, sizeof(currentTick));
+    }
+
+    if (tickUs > LOOP_TICK_BUDGET_US) {
+        budgetOverruns++;
+        metricsInc(MC_LOOP_BUDGET_OVERRUNS);
+
+        // Największy pojedynczy składnik ticka
+        int worst = PROF_SENSORS;
+        for (int i = PROF_SENSORS; i < PROF_TICK; i++) {
+            if (currentTick[i] > currentTick[worst]) {
+                worst = i;
+            }
+        }
+
+        static uint32_t lastOverrunLog = 0;
+        if (millis() - lastOverrunLog > 10000) {
+            LOG_WARNING("");
+            LOG_WARNING("Loop tick over budget: %lu us > %d us (largest: %s %lu us)",
+                        tickUs, LOOP_TICK_BUDGET_US, SECTION_NAMES[worst], currentTick[worst]);
+            lastOverrunLog = millis();
+        }
+    }
+}
+
+#if ENABLE_LOOP_PROFILER
+ProfileScope::~ProfileScope() {
+    profilerRecord(section, elapsedUs(startUs));
+}
+#endif
+
+const char* getProfileSectionName(ProfileSection section) {
+    return SECTION_NAMES[section];
+}
+
+const ProfileStats& getProfileStats(ProfileSection section) {
+    return stats[section];
+}
+
+const ProfileWorstTick& getProfileWorstTick() {
+    return worstTick;
+}
+
+// Górna granica bucketu, w którym leży percentyl (dokładność 2x - log2 buckety)
+uint32_t getProfilePercentile(ProfileSection section, uint8_t percent) {
+    const ProfileStats& s = stats[section];
+    if (s.count == 0) {
+        return 0;
+    }
+
+    uint32_t target = ((uint64_t)s.count * percent + 99) / 100;
+    uint32_t cumulative = 0;
+    for (uint8_t b = 0; b < PROFILE_HISTOGRAM_BUCKETS; b++) {
+        cumulative += s.histogram[b];
+        if (cumulative >= target) {
+            uint32_t upper = 1UL << b;
+            return upper < s.maxUs ? upper : s.maxUs;
+        }
+    }
+    return s.maxUs;
+}
+
+uint32_t getProfileBudgetOverruns() {
+    return budgetOverruns;
+}
+
+bool isProfilerEnabled() {
+    return ENABLE_LOOP_PROFILER;
+}
@@ -0,0 +1,84 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "../config/config.h"
+
+// ============== LOOP PROFILER ==============
+// Scoped timery na esp_timer (µs) wokół każdego podsystemu loop(). Nie
+// licznik cykli CPU - przy DFS (power manager) częstotliwość się zmienia.
+// Przy ENABLE_LOOP_PROFILER == false makra znikają, a API zwraca enabled=false.
+
+enum ProfileSection {
+    PROF_SENSORS = 0,
+    PROF_ALGORITHM,
+    PROF_PUMP,
+    PROF_SESSIONS,
+    PROF_RATE_LIMITER,
+    PROF_WIFI,
+    PROF_TICK,              // Cały przebieg planera zadania control (bez uśpienia)
+    PROF_LATENESS,          // Opóźnienie startu zadania względem jego terminu
+
+    PROFILE_SECTION_COUNT
+};
+
+// Log2 buckety w µs: [0-1], (1-2], (2-4] ... ostatni = wszystko powyżej
+#define PROFILE_HISTOGRAM_BUCKETS 20
+
+struct ProfileStats {
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t sumUs;
+    uint32_t maxAtMs;               // millis() wystąpienia maksimum
+    uint32_t histogram[PROFILE_HISTOGRAM_BUCKETS];
+};
+
+// Rozkład najgorszego ticka - które podsystemy go spowodowały
+struct ProfileWorstTick {
+    uint32_t totalUs;
+    uint32_t atMs;
+    uint32_t sectionUs[PROFILE_SECTION_COUNT];
+};
+
+void initProfiler();
+void resetProfiler();
+
+void profilerBeginTick();
+void profilerEndTick();
+void profilerRecord(ProfileSection section, uint32_t us);
+
+const char* getProfileSectionName(ProfileSection section);
+const ProfileStats& getProfileStats(ProfileSection section);
+const ProfileWorstTick& getProfileWorstTick();
+uint32_t getProfilePercentile(ProfileSection section, uint8_t percent);
+uint32_t getProfileBudgetOverruns();
+bool isProfilerEnabled();
+
+#if ENABLE_LOOP_PROFILER
+
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileSection s) : section(s), startUs(esp_timer_get_time()) {}
+    ~ProfileScope();
+private:
+    ProfileSection section;
+    int64_t startUs;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(section) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(section)
+#define PROFILE_TICK_BEGIN() profilerBeginTick()
+#define PROFILE_TICK_END() profilerEndTick()
+
+#else
+
+#define PROFILE_SCOPE(section) do {} while(0)
+#define PROFILE_TICK_BEGIN() do {} while(0)
+#define PROFILE_TICK_END() do {} while(0)
+
+#endif
+
+#endif
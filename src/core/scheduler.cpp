@@ -0,0 +1,106 @@
+#include "scheduler.h"
+#include "logging.h"
+#include "profiler.h"
+
+// Porównania terminów odporne na zawinięcie millis() (różnice < 24 dni)
+static bool isDue(uint32_t deadline, uint32_t now) {
+    return (int32_t)(now - deadline) >= 0;
+}
+
+Scheduler::Scheduler() : taskCount(0) {
+    for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        tasks[i].active = false;
+    }
+}
+
+Scheduler::TaskId Scheduler::add(uint32_t periodMs, uint32_t delayMs, SchedulerCallback callback,
+                                 void* ctx, const char* name) {
+    for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        if (!tasks[i].active) {
+            tasks[i].callback = callback;
+            tasks[i].ctx = ctx;
+            tasks[i].name = name;
+            tasks[i].periodMs = periodMs;
+            tasks[i].deadline = millis() + delayMs;
+            tasks[i].active = true;
+            taskCount++;
+            return i;
+        }
+    }
+
+    LOG_ERROR("");
+    LOG_ERROR("Scheduler full - cannot register task '%s'", name);
+    return -1;
+}
+
+Scheduler::TaskId Scheduler::every(uint32_t periodMs, SchedulerCallback callback, void* ctx, const char* name) {
+    return add(periodMs, 0, callback, ctx, name);
+}
+
+Scheduler::TaskId Scheduler::after(uint32_t delayMs, SchedulerCallback callback, void* ctx, const char* name) {
+    return add(0, delayMs, callback, ctx, name);
+}
+
+void Scheduler::wakeIn(TaskId id, uint32_t delayMs) {
+    if (id >= 0 && id < SCHEDULER_MAX_TASKS && tasks[id].active) {
+        tasks[id].deadline = millis() + delayMs;
+    }
+}
+
+void Scheduler::cancel(TaskId id) {
+    if (id >= 0 && id < SCHEDULER_MAX_TASKS && tasks[id].active) {
+        tasks[id].active = false;
+        taskCount--;
+    }
+}
+
+uint32_t Scheduler::runDue() {
+    for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        Task& task = tasks[i];
+        uint32_t now = millis();
+        if (!task.active || !isDue(task.deadline, now)) {
+            continue;
+        }
+
+#if ENABLE_LOOP_PROFILER
+        profilerRecord(PROF_LATENESS, (now - task.deadline) * 1000UL);
+#endif
+
+        uint32_t next = task.callback(task.ctx);
+        if (!task.active) {
+            continue;   // Zadanie anulowało się samo
+        }
+
+        if (next == SCHEDULER_DONE || (next == 0 && task.periodMs == 0)) {
+            cancel(i);
+        } else if (next > 0) {
+            task.deadline = millis() + next;
+        } else {
+            // Bez dryfu: kolejny termin liczony od poprzedniego; po dużym
+            // opóźnieniu (> okres) nie nadrabiamy serii, tylko startujemy od teraz
+            task.deadline += task.periodMs;
+            if (isDue(task.deadline, millis())) {
+                task.deadline = millis() + task.periodMs;
+            }
+        }
+    }
+    return msUntilNext();
+}
+
+uint32_t Scheduler::msUntilNext() const {
+    uint32_t now = millis();
+    uint32_t best = SCHEDULER_DONE;
+    for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        if (!tasks[i].active) {
+            continue;
+        }
+        if (isDue(tasks[i].deadline, now)) {
+            return 0;
+        }
+        uint32_t wait = tasks[i].deadline - now;
+        if (wait < best) {
+            best = wait;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,58 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// ============== DEADLINE SCHEDULER ==============
+// Kooperacyjny planer: każdy podsystem rejestruje zadanie okresowe albo
+// jednorazowe, a pętla śpi do najbliższego terminu. Przy kilkunastu
+// zadaniach liniowe szukanie minimum jest tańsze niż koło czasowe.
+//
+// Callback zwraca:
+//   0                 - kolejny termin wg zarejestrowanego okresu
+//                       (zadanie jednorazowe zostaje usunięte)
+//   N > 0             - kolejny termin za N ms (nadpisuje okres)
+//   SCHEDULER_DONE    - usuń zadanie
+
+#define SCHEDULER_MAX_TASKS     12
+#define SCHEDULER_DONE          0xFFFFFFFFUL
+
+typedef uint32_t (*SchedulerCallback)(void* ctx);
+
+class Scheduler {
+public:
+    typedef int8_t TaskId;
+
+    Scheduler();
+
+    TaskId every(uint32_t periodMs, SchedulerCallback callback, void* ctx, const char* name);
+    TaskId after(uint32_t delayMs, SchedulerCallback callback, void* ctx, const char* name);
+
+    // Przesuń termin zadania (np. wybudzenie wcześniej niż okres)
+    void wakeIn(TaskId id, uint32_t delayMs);
+    void cancel(TaskId id);
+
+    // Uruchamia wszystkie zadania, których termin minął.
+    // Zwraca ms do najbliższego terminu (0 = coś już czeka).
+    uint32_t runDue();
+    uint32_t msUntilNext() const;
+
+    uint8_t getTaskCount() const { return taskCount; }
+
+private:
+    struct Task {
+        SchedulerCallback callback;
+        void* ctx;
+        const char* name;
+        uint32_t periodMs;      // 0 = jednorazowe
+        uint32_t deadline;      // millis()
+        bool active;
+    };
+
+    Task tasks[SCHEDULER_MAX_TASKS];
+    uint8_t taskCount;
+
+    TaskId add(uint32_t periodMs, uint32_t delayMs, SchedulerCallback callback, void* ctx, const char* name);
+};
+
+#endif
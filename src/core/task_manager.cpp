@@ -0,0 +1,145 @@
+#include "task_manager.h"
+#include "logging.h"
+#include "metrics.h"
+#include "profiler.h"
+#include "control_commands.h"
+#include "power_manager.h"
+#include <esp_attr.h>
+#include "../config/config.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct SystemTask {
+    const char* name;
+    uint32_t stackBytes;
+    UBaseType_t priority;
+    MetricGauge stackGauge;
+
+    Scheduler* scheduler;
+    TaskWaitFn wait;
+    TaskHandle_t handle;
+    volatile uint32_t iterations;
+};
+
+static SystemTask systemTasks[SYSTEM_TASK_COUNT] = {
+    { "control", CONTROL_TASK_STACK, CONTROL_TASK_PRIORITY, MG_TASK_STACK_FREE_CONTROL, nullptr, nullptr, nullptr, 0 },
+    { "storage", STORAGE_TASK_STACK, STORAGE_TASK_PRIORITY, MG_TASK_STACK_FREE_STORAGE, nullptr, nullptr, nullptr, 0 },
+    { "housekeeping", HOUSEKEEPING_TASK_STACK, HOUSEKEEPING_TASK_PRIORITY, MG_TASK_STACK_FREE_HOUSEKEEPING, nullptr, nullptr, nullptr, 0 },
+};
+
+static uint32_t runControlTick(Scheduler& scheduler) {
+    uint32_t passStartUs = micros();
+    PROFILE_TICK_BEGIN();
+
+    // Polecenia z HTTP wykonywane w jednym, stałym miejscu ticka - przed planerem
+    applyControlCommands();
+    uint32_t sleepMs = scheduler.runDue();
+
+    PROFILE_TICK_END();
+    metricsObserve(MH_LOOP_DURATION_US, micros() - passStartUs);
+    return sleepMs;
+}
+
+static void systemTaskMain(void* arg) {
+    SystemTask& task = *(SystemTask*)arg;
+    bool isControl = (&task == &systemTasks[TASK_CONTROL]);
+
+    for (;;) {
+        uint32_t activeStartUs = micros();
+        uint32_t sleepMs = isControl ? runControlTick(*task.scheduler) : task.scheduler->runDue();
+        task.iterations++;
+        powerAccountActive(micros() - activeStartUs);
+
+        if (sleepMs > TASK_MAX_IDLE_MS) {
+            sleepMs = TASK_MAX_IDLE_MS;
+        }
+        if (task.wait != nullptr) {
+            task.wait(sleepMs);
+        } else if (sleepMs > 0) {
+            vTaskDelay(pdMS_TO_TICKS(sleepMs));
+        }
+    }
+}
+
+bool startSystemTask(SystemTaskId id, Scheduler& scheduler, TaskWaitFn wait) {
+    SystemTask& task = systemTasks[id];
+    task.scheduler = &scheduler;
+    task.wait = wait;
+
+    // ESP-IDF: głębokość stosu w bajtach
+    if (xTaskCreate(systemTaskMain, task.name, task.stackBytes, &task, task.priority, &task.handle) != pdPASS) {
+        task.handle = nullptr;
+        LOG_ERROR("");
+        LOG_ERROR("Failed to start %s task (stack %lu B)", task.name, task.stackBytes);
+        return false;
+    }
+
+    LOG_INFO("");
+    LOG_INFO("Task %s started: priority %d, stack %lu B, %d scheduled jobs",
+             task.name, task.priority, task.stackBytes, scheduler.getTaskCount());
+    return true;
+}
+
+const char* getSystemTaskName(SystemTaskId id) {
+    return systemTasks[id].name;
+}
+
+bool isSystemTaskRunning(SystemTaskId id) {
+    return systemTasks[id].handle != nullptr;
+}
+
+uint32_t getSystemTaskPriority(SystemTaskId id) {
+    return systemTasks[id].priority;
+}
+
+uint32_t getSystemTaskStackSize(SystemTaskId id) {
+    return systemTasks[id].stackBytes;
+}
+
+uint32_t getSystemTaskStackFree(SystemTaskId id) {
+    if (systemTasks[id].handle == nullptr) {
+        return 0;
+    }
+    return uxTaskGetStackHighWaterMark(systemTasks[id].handle);
+}
+
+uint32_t getSystemTaskIterations(SystemTaskId id) {
+    return systemTasks[id].iterations;
+}
+
+void notifySystemTask(SystemTaskId id) {
+    if (systemTasks[id].handle != nullptr) {
+        xTaskNotifyGive(systemTasks[id].handle);
+    }
+}
+
+void IRAM_ATTR notifySystemTaskFromISR(SystemTaskId id) {
+    if (systemTasks[id].handle == nullptr) {
+        return;
+    }
+    BaseType_t higherPriorityWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(systemTasks[id].handle, &higherPriorityWoken);
+    portYIELD_FROM_ISR(higherPriorityWoken);
+}
+
+void updateTaskStackMetrics() {
+    for (int i = 0; i < SYSTEM_TASK_COUNT; i++) {
+        SystemTaskId id = (SystemTaskId)i;
+        if (!isSystemTaskRunning(id)) {
+            continue;
+        }
+
+        uint32_t freeBytes = getSystemTaskStackFree(id);
+        metricsSetGauge(systemTasks[i].stackGauge, freeBytes);
+
+        if (freeBytes < TASK_STACK_WARN_BYTES) {
+            static uint32_t lastWarning[SYSTEM_TASK_COUNT] = {0};
+            if (lastWarning[i] == 0 || millis() - lastWarning[i] > 60000) {
+                LOG_WARNING("");
+                LOG_WARNING("Task %s stack low: %lu B free of %lu B",
+                            systemTasks[i].name, freeBytes, systemTasks[i].stackBytes);
+                lastWarning[i] = millis();
+            }
+        }
+    }
+}
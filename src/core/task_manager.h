@@ -0,0 +1,42 @@
+#ifndef TASK_MANAGER_H
+#define TASK_MANAGER_H
+
+#include <Arduino.h>
+#include "scheduler.h"
+
+// ============== SYSTEM TASKS ==============
+// Trzy zadania FreeRTOS, każde z własnym planerem terminów:
+//   control      - czujniki, algorytm, pompa (najwyższy priorytet, nad async_tcp)
+//   storage      - właściciel FRAM/RTC: kolejka zapisów + odświeżanie czasu
+//   housekeeping - sesje, rate limiter, WiFi, restart dobowy (najniższy)
+// Priorytety i stosy w config.h.
+
+enum SystemTaskId {
+    TASK_CONTROL = 0,
+    TASK_STORAGE,
+    TASK_HOUSEKEEPING,
+
+    SYSTEM_TASK_COUNT
+};
+
+// Czekanie do najbliższego terminu; nullptr = vTaskDelay.
+// Storage czeka na kolejce zapisów, żeby zlecenie budziło je od razu.
+typedef void (*TaskWaitFn)(uint32_t waitMs);
+
+bool startSystemTask(SystemTaskId id, Scheduler& scheduler, TaskWaitFn wait = nullptr);
+
+const char* getSystemTaskName(SystemTaskId id);
+bool isSystemTaskRunning(SystemTaskId id);
+uint32_t getSystemTaskPriority(SystemTaskId id);
+uint32_t getSystemTaskStackSize(SystemTaskId id);
+uint32_t getSystemTaskStackFree(SystemTaskId id);   // Najniższy zapas stosu (high-water), bajty
+uint32_t getSystemTaskIterations(SystemTaskId id);
+
+// Wybudza zadanie czekające w ulTaskNotifyTake (np. control po nowym poleceniu)
+void notifySystemTask(SystemTaskId id);
+void notifySystemTaskFromISR(SystemTaskId id);
+
+// Zapas stosów -> gauge /metrics, ostrzeżenie przy małym zapasie
+void updateTaskStackMetrics();
+
+#endif
@@ -0,0 +1,164 @@
+#include "trace.h"
+#include "logging.h"
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+struct TraceEvent {
+    uint32_t tsUs;          // Młodsze 32 bity esp_timer_get_time()
+    uint32_t durUs;         // Tylko dla 'X'
+    const char* name;
+    char phase;             // 'B', 'E', 'X', 'i'
+    uint8_t track;
+    uint16_t reserved;
+};
+
+static TraceEvent ring[TRACE_RING_SIZE];
+static uint16_t ringHead = 0;       // Następny zapis
+static uint16_t ringCount = 0;
+static uint8_t activeExports = 0;   // Rejestracja wstrzymana, gdy > 0
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* TRACK_NAMES[TRACE_TRACK_END] = {
+    "",
+    "algorithm",
+    "pump",
+    "i2c",
+    "http",
+};
+
+static void record(char phase, TraceTrack track, const char* name, uint32_t tsUs, uint32_t durUs) {
+#if ENABLE_TRACE
+    portENTER_CRITICAL(&traceMux);
+    if (activeExports > 0) {
+        portEXIT_CRITICAL(&traceMux);
+        return;
+    }
+    TraceEvent& ev = ring[ringHead];
+    ev.tsUs = tsUs;
+    ev.durUs = durUs;
+    ev.name = name;
+    ev.phase = phase;
+    ev.track = track;
+    ringHead = (ringHead + 1) % TRACE_RING_SIZE;
+    if (ringCount < TRACE_RING_SIZE) {
+        ringCount++;
+    }
+    portEXIT_CRITICAL(&traceMux);
+#endif
+}
+
+void initTrace() {
+    clearTrace();
+    LOG_INFO("");
+    LOG_INFO("Trace recorder %s (%d events)", ENABLE_TRACE ? "enabled" : "compiled out", TRACE_RING_SIZE);
+}
+
+void clearTrace() {
+    portENTER_CRITICAL(&traceMux);
+    ringHead = 0;
+    ringCount = 0;
+    portEXIT_CRITICAL(&traceMux);
+}
+
+uint32_t traceNowUs() {
+    return (uint32_t)esp_timer_get_time();
+}
+
+void traceBegin(TraceTrack track, const char* name) {
+    record('B', track, name, traceNowUs(), 0);
+}
+
+void traceEnd(TraceTrack track) {
+    record('E', track, nullptr, traceNowUs(), 0);
+}
+
+void traceComplete(TraceTrack track, const char* name, uint32_t startUs, uint32_t durationUs) {
+    record('X', track, name, startUs, durationUs);
+}
+
+void traceInstant(TraceTrack track, const char* name) {
+    record('i', track, name, traceNowUs(), 0);
+}
+
+uint16_t getTraceEventCount() {
+    portENTER_CRITICAL(&traceMux);
+    uint16_t count = ringCount;
+    portEXIT_CRITICAL(&traceMux);
+    return count;
+}
+
+TraceExport::TraceExport() : next(0), pendingLen(0), pendingPos(0) {
+    portENTER_CRITICAL(&traceMux);
+    activeExports++;
+    start = (ringHead + TRACE_RING_SIZE - ringCount) % TRACE_RING_SIZE;
+    count = ringCount;
+    portEXIT_CRITICAL(&traceMux);
+
+    // Pełny 64-bitowy czas odtwarzany względem "teraz" - odporne na zawinięcie
+    // 32-bitowych znaczników (bufor obejmuje dużo mniej niż 71 minut)
+    now64 = esp_timer_get_time();
+    nowLow = (uint32_t)now64;
+}
+
+TraceExport::~TraceExport() {
+    portENTER_CRITICAL(&traceMux);
+    activeExports--;
+    portEXIT_CRITICAL(&traceMux);
+}
+
+// Kolejny element JSON do pending; false = koniec eksportu
+bool TraceExport::formatNext() {
+    const uint16_t eventsFrom = TRACE_TRACK_END;
+    int len;
+
+    if (next == 0) {
+        len = snprintf(pending, sizeof(pending), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    } else if (next < eventsFrom) {
+        len = snprintf(pending, sizeof(pending),
+                       "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                       next == TRACE_TRACK_ALGORITHM ? "" : ",", next, TRACK_NAMES[next]);
+    } else if (next < eventsFrom + count) {
+        const TraceEvent& ev = ring[(start + next - eventsFrom) % TRACE_RING_SIZE];
+        long long ts = now64 - (uint32_t)(nowLow - ev.tsUs);
+
+        len = snprintf(pending, sizeof(pending), ",{\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%lld",
+                       ev.phase, ev.track, ts);
+        if (ev.name && len < (int)sizeof(pending)) {
+            len += snprintf(pending + len, sizeof(pending) - len, ",\"name\":\"%s\"", ev.name);
+        }
+        if (ev.phase == 'X' && len < (int)sizeof(pending)) {
+            len += snprintf(pending + len, sizeof(pending) - len, ",\"dur\":%lu", (unsigned long)ev.durUs);
+        } else if (ev.phase == 'i' && len < (int)sizeof(pending)) {
+            len += snprintf(pending + len, sizeof(pending) - len, ",\"s\":\"t\"");
+        }
+        if (len < (int)sizeof(pending)) {
+            len += snprintf(pending + len, sizeof(pending) - len, "}");
+        }
+    } else if (next == eventsFrom + count) {
+        len = snprintf(pending, sizeof(pending), "]}");
+    } else {
+        return false;
+    }
+
+    next++;
+    pendingLen = len < (int)sizeof(pending) ? (size_t)len : sizeof(pending) - 1;
+    pendingPos = 0;
+    return true;
+}
+
+size_t TraceExport::fill(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+        if (pendingPos == pendingLen && !formatNext()) {
+            break;
+        }
+        size_t chunk = pendingLen - pendingPos;
+        if (chunk > maxLen - written) {
+            chunk = maxLen - written;
+        }
+        memcpy(buffer + written, pending + pendingPos, chunk);
+        pendingPos += chunk;
+        written += chunk;
+    }
+    return written;
+}
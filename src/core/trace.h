@@ -0,0 +1,77 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+
+// ============== SPAN RECORDER ==============
+// Bufor kołowy zdarzeń begin/end/complete z czasem w µs (esp_timer).
+// Eksport jako Chrome/Perfetto trace-event JSON - jedna oś czasu dla
+// faz cyklu, pompy, I2C i żądań HTTP. Nazwy MUSZĄ być stałymi literałami.
+
+enum TraceTrack {
+    TRACE_TRACK_ALGORITHM = 1,
+    TRACE_TRACK_PUMP,
+    TRACE_TRACK_I2C,
+    TRACE_TRACK_HTTP,
+
+    TRACE_TRACK_END
+};
+
+void initTrace();
+void clearTrace();
+
+void traceBegin(TraceTrack track, const char* name);
+void traceEnd(TraceTrack track);
+void traceComplete(TraceTrack track, const char* name, uint32_t startUs, uint32_t durationUs);
+void traceInstant(TraceTrack track, const char* name);
+
+uint32_t traceNowUs();
+uint16_t getTraceEventCount();
+
+// Eksport {"traceEvents":[...]} porcjami do odpowiedzi chunked - bez bufora
+// całego JSON na stercie. Rejestracja wstrzymana od konstrukcji (migawka
+// indeksów pod blokadą) do zniszczenia obiektu, także przy zerwanym połączeniu.
+class TraceExport {
+public:
+    TraceExport();
+    ~TraceExport();
+    size_t fill(uint8_t* buffer, size_t maxLen);    // 0 = koniec
+
+private:
+    bool formatNext();
+
+    int64_t now64;
+    uint32_t nowLow;
+    uint16_t start;
+    uint16_t count;
+    uint16_t next;                  // 0 = nagłówek, potem tory, zdarzenia, stopka
+    char pending[160];
+    size_t pendingLen;
+    size_t pendingPos;
+};
+
+#if ENABLE_TRACE
+
+// Span typu "X" (complete) - bezpieczny przy przeplataniu zadań na tym samym torze
+class TraceScope {
+public:
+    TraceScope(TraceTrack t, const char* n) : track(t), name(n), start(traceNowUs()) {}
+    ~TraceScope() { traceComplete(track, name, start, traceNowUs() - start); }
+private:
+    TraceTrack track;
+    const char* name;
+    uint32_t start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(track, name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(track, name)
+
+#else
+
+#define TRACE_SCOPE(track, name) do {} while(0)
+
+#endif
+
+#endif
@@ -7,15 +7,52 @@
 #include "rtc_controller.h"
 
 #include "../crypto/fram_encryption.h"
+#include "../core/metrics.h"
+#include "../core/trace.h"
+#include "i2c_bus.h"
 
 static_assert(sizeof(PumpCycle) == FRAM_CYCLE_SIZE,
     "FRAM_CYCLE_SIZE must match sizeof(PumpCycle)! Update FRAM_CYCLE_SIZE in fram_controller.h");
+static_assert(FRAM_ADDR_CYCLE_DATA + FRAM_MAX_CYCLES * FRAM_CYCLE_SIZE - FRAM_ESP32_BASE <= FRAM_CHANNEL_PARTITION_SIZE,
+    "Channel data does not fit in FRAM_CHANNEL_PARTITION_SIZE");
+static_assert(FRAM_CHANNEL_PARTITION_BASE + (WATER_CHANNEL_MAX - 1) * FRAM_CHANNEL_PARTITION_SIZE <= 0x8000,
+    "Channel partitions exceed 32KB FRAM");
 
 
 Adafruit_FRAM_I2C fram = Adafruit_FRAM_I2C();
 bool framInitialized = false;
 volatile bool framBusy = false;
 
+// ============== INSTRUMENTED I2C ACCESS ==============
+// Wszystkie transakcje FRAM przechodzą tędy - liczniki + czas do /metrics i trace.
+// Funkcje z sekwencją odczyt-modyfikacja-zapis (ring cykli, checksumy) trzymają
+// dodatkowo I2CBusLock przez całą sekwencję - mutex jest rekurencyjny.
+static bool framWrite(uint16_t addr, uint8_t* data, uint16_t len) {
+    I2CBusLock busLock;
+    MetricTimer timer(MH_FRAM_OP_US);
+    TRACE_SCOPE(TRACE_TRACK_I2C, "fram_write");
+    bool ok = fram.write(addr, data, len);
+    metricsInc(MC_FRAM_WRITES);
+    metricsInc(MC_FRAM_BYTES_WRITTEN, len);
+    if (!ok) {
+        metricsInc(MC_FRAM_ERRORS);
+    }
+    return ok;
+}
+
+static bool framRead(uint16_t addr, uint8_t* data, uint16_t len) {
+    I2CBusLock busLock;
+    MetricTimer timer(MH_FRAM_OP_US);
+    TRACE_SCOPE(TRACE_TRACK_I2C, "fram_read");
+    bool ok = fram.read(addr, data, len);
+    metricsInc(MC_FRAM_READS);
+    metricsInc(MC_FRAM_BYTES_READ, len);
+    if (!ok) {
+        metricsInc(MC_FRAM_ERRORS);
+    }
+    return ok;
+}
+
 // Calculate simple checksum
 uint16_t calculateChecksum(uint8_t* data, size_t len) {
     uint16_t sum = 0;
@@ -25,6 +62,39 @@ uint16_t calculateChecksum(uint8_t* data, size_t len) {
     return sum;
 }
 
+// Partycja kanału 1+ bez znacznika (nowy kanał): domyślny przepływ, pusty
+// ring cykli i unieważnione sumy kontrolne - loadery wracają do wartości
+// domyślnych zamiast czytać zera jako "zbiornik 0 ml".
+static void initChannelPartition(uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    uint32_t magic = 0;
+    framRead(off + FRAM_ADDR_CHANNEL_MAGIC, (uint8_t*)&magic, 4);
+    if (magic == FRAM_CHANNEL_MAGIC) {
+        return;
+    }
+
+    LOG_WARNING("");
+    LOG_WARNING("CH%d FRAM partition not initialized (0x%04X), writing defaults",
+                channel, off + FRAM_ESP32_BASE);
+
+    float defaultVolume = 1.0;
+    uint16_t checksum = calculateChecksum((uint8_t*)&defaultVolume, 4);
+    framWrite(off + FRAM_ADDR_VOLUME_ML, (uint8_t*)&defaultVolume, 4);
+    framWrite(off + FRAM_ADDR_CHECKSUM, (uint8_t*)&checksum, 2);
+
+    uint16_t zero = 0;
+    uint16_t invalid = 0xFFFF;
+    framWrite(off + FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&zero, 2);
+    framWrite(off + FRAM_ADDR_CYCLE_INDEX, (uint8_t*)&zero, 2);
+    framWrite(off + FRAM_ADDR_STATS_CHKSUM, (uint8_t*)&invalid, 2);
+    framWrite(off + FRAM_ADDR_DAILY_CHECKSUM, (uint8_t*)&invalid, 2);
+    framWrite(off + FRAM_ADDR_AVAIL_VOL_CHKSUM, (uint8_t*)&invalid, 2);
+    framWrite(off + FRAM_ADDR_FILL_MAX_CHKSUM, (uint8_t*)&invalid, 2);
+
+    magic = FRAM_CHANNEL_MAGIC;
+    framWrite(off + FRAM_ADDR_CHANNEL_MAGIC, (uint8_t*)&magic, 4);
+}
+
 bool initFRAM() {
     LOG_INFO("");
     LOG_INFO("Initializing FRAM at address 0x50...");
@@ -49,39 +119,46 @@ bool initFRAM() {
         
         // Write magic number
         uint32_t magic = FRAM_MAGIC_NUMBER;
-        fram.write(FRAM_ADDR_MAGIC, (uint8_t*)&magic, 4);
+        framWrite(FRAM_ADDR_MAGIC, (uint8_t*)&magic, 4);
         
         // Write version
         uint16_t version = FRAM_DATA_VERSION;
-        fram.write(FRAM_ADDR_VERSION, (uint8_t*)&version, 2);
+        framWrite(FRAM_ADDR_VERSION, (uint8_t*)&version, 2);
         
         // Write default volume
         float defaultVolume = 1.0;
-        fram.write(FRAM_ADDR_VOLUME_ML, (uint8_t*)&defaultVolume, 4);
+        framWrite(FRAM_ADDR_VOLUME_ML, (uint8_t*)&defaultVolume, 4);
         
         // Calculate and write checksum
         uint8_t buffer[4];
-        fram.read(FRAM_ADDR_VOLUME_ML, buffer, 4);
+        framRead(FRAM_ADDR_VOLUME_ML, buffer, 4);
         uint16_t checksum = calculateChecksum(buffer, 4);
-        fram.write(FRAM_ADDR_CHECKSUM, (uint8_t*)&checksum, 2);
+        framWrite(FRAM_ADDR_CHECKSUM, (uint8_t*)&checksum, 2);
         
         LOG_INFO("");
         LOG_INFO("FRAM initialized with defaults");
     }
 
+    for (uint8_t ch = 1; ch < WATER_CHANNEL_COUNT; ch++) {
+        initChannelPartition(ch);
+    }
+
     // Validate cycle metadata against FRAM_MAX_CYCLES (handles 200→30 transition)
-    uint16_t bootCycleCount = 0;
-    uint16_t bootWriteIndex = 0;
-    fram.read(FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&bootCycleCount, 2);
-    fram.read(FRAM_ADDR_CYCLE_INDEX, (uint8_t*)&bootWriteIndex, 2);
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        const uint16_t off = FRAM_CHANNEL_OFFSET(ch);
+        uint16_t bootCycleCount = 0;
+        uint16_t bootWriteIndex = 0;
+        framRead(off + FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&bootCycleCount, 2);
+        framRead(off + FRAM_ADDR_CYCLE_INDEX, (uint8_t*)&bootWriteIndex, 2);
 
-    if (bootCycleCount > FRAM_MAX_CYCLES || bootWriteIndex >= FRAM_MAX_CYCLES) {
-        LOG_WARNING("Cycle metadata out of range (count=%d, index=%d, max=%d), resetting",
-                    bootCycleCount, bootWriteIndex, FRAM_MAX_CYCLES);
-        uint16_t zero = 0;
-        fram.write(FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&zero, 2);
-        fram.write(FRAM_ADDR_CYCLE_INDEX, (uint8_t*)&zero, 2);
-        LOG_INFO("Cycle ring buffer reset");
+        if (bootCycleCount > FRAM_MAX_CYCLES || bootWriteIndex >= FRAM_MAX_CYCLES) {
+            LOG_WARNING("CH%d cycle metadata out of range (count=%d, index=%d, max=%d), resetting",
+                        ch, bootCycleCount, bootWriteIndex, FRAM_MAX_CYCLES);
+            uint16_t zero = 0;
+            framWrite(off + FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&zero, 2);
+            framWrite(off + FRAM_ADDR_CYCLE_INDEX, (uint8_t*)&zero, 2);
+            LOG_INFO("Cycle ring buffer reset");
+        }
     }
 
     return true;
@@ -91,7 +168,7 @@ bool verifyFRAM() {
     
     // Check magic number
     uint32_t magic = 0;
-    fram.read(FRAM_ADDR_MAGIC, (uint8_t*)&magic, 4);
+    framRead(FRAM_ADDR_MAGIC, (uint8_t*)&magic, 4);
     
     if (magic != FRAM_MAGIC_NUMBER) {
         LOG_WARNING("");
@@ -101,7 +178,7 @@ bool verifyFRAM() {
     
     // Check version
     uint16_t version = 0;
-    fram.read(FRAM_ADDR_VERSION, (uint8_t*)&version, 2);
+    framRead(FRAM_ADDR_VERSION, (uint8_t*)&version, 2);
     
     if (version != FRAM_DATA_VERSION) {
         // Auto-upgrade from version 1 to 2
@@ -119,7 +196,7 @@ bool verifyFRAM() {
                 
             // Update version
             uint16_t newVersion = FRAM_DATA_VERSION;
-            fram.write(FRAM_ADDR_VERSION, (uint8_t*)&newVersion, 2);
+            framWrite(FRAM_ADDR_VERSION, (uint8_t*)&newVersion, 2);
             
             LOG_INFO("");
             LOG_INFO("FRAM upgraded to version %d", FRAM_DATA_VERSION);
@@ -131,11 +208,11 @@ bool verifyFRAM() {
     
     // Verify ESP32 data checksum
     uint8_t buffer[4];
-    fram.read(FRAM_ADDR_VOLUME_ML, buffer, 4);
+    framRead(FRAM_ADDR_VOLUME_ML, buffer, 4);
     uint16_t calculatedChecksum = calculateChecksum(buffer, 4);
     
     uint16_t storedChecksum = 0;
-    fram.read(FRAM_ADDR_CHECKSUM, (uint8_t*)&storedChecksum, 2);
+    framRead(FRAM_ADDR_CHECKSUM, (uint8_t*)&storedChecksum, 2);
     
     if (calculatedChecksum != storedChecksum) {
         LOG_WARNING("");
@@ -148,7 +225,9 @@ bool verifyFRAM() {
     return true;
 }
 
-bool loadVolumeFromFRAM(float& volume) {
+bool loadVolumeFromFRAM(float& volume, uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized, cannot load volume");
@@ -156,7 +235,7 @@ bool loadVolumeFromFRAM(float& volume) {
     }
     
     // Read volume value
-    fram.read(FRAM_ADDR_VOLUME_ML, (uint8_t*)&volume, 4);
+    framRead(off + FRAM_ADDR_VOLUME_ML, (uint8_t*)&volume, 4);
     
     // Verify checksum
     uint8_t buffer[4];
@@ -164,7 +243,7 @@ bool loadVolumeFromFRAM(float& volume) {
     uint16_t calculatedChecksum = calculateChecksum(buffer, 4);
     
     uint16_t storedChecksum = 0;
-    fram.read(FRAM_ADDR_CHECKSUM, (uint8_t*)&storedChecksum, 2);
+    framRead(off + FRAM_ADDR_CHECKSUM, (uint8_t*)&storedChecksum, 2);
     
     if (calculatedChecksum != storedChecksum) {
         LOG_ERROR("");
@@ -184,7 +263,9 @@ bool loadVolumeFromFRAM(float& volume) {
     return true;
 }
 
-bool saveVolumeToFRAM(float volume) {
+bool saveVolumeToFRAM(float volume, uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized, cannot save volume");
@@ -199,17 +280,17 @@ bool saveVolumeToFRAM(float volume) {
     }
     
     // Write volume
-    fram.write(FRAM_ADDR_VOLUME_ML, (uint8_t*)&volume, 4);
+    framWrite(off + FRAM_ADDR_VOLUME_ML, (uint8_t*)&volume, 4);
     
     // Calculate and write checksum
     uint8_t buffer[4];
     memcpy(buffer, &volume, 4);
     uint16_t checksum = calculateChecksum(buffer, 4);
-    fram.write(FRAM_ADDR_CHECKSUM, (uint8_t*)&checksum, 2);
+    framWrite(off + FRAM_ADDR_CHECKSUM, (uint8_t*)&checksum, 2);
     
     // Verify write by reading back
     float readBack = 0;
-    fram.read(FRAM_ADDR_VOLUME_ML, (uint8_t*)&readBack, 4);
+    framRead(off + FRAM_ADDR_VOLUME_ML, (uint8_t*)&readBack, 4);
     
     if (abs(readBack - volume) > 0.01) {
         LOG_ERROR("");
@@ -236,8 +317,8 @@ void testFRAM() {
                             0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
     uint8_t readData[16];
     
-    fram.write(0x1000, testData, 16);  // Test address at 4KB offset
-    fram.read(0x1000, readData, 16);
+    framWrite(0x1000, testData, 16);  // Test address at 4KB offset
+    framRead(0x1000, readData, 16);
     
     bool testPassed = true;
     for (int i = 0; i < 16; i++) {
@@ -276,7 +357,9 @@ void testFRAM() {
     LOG_INFO("=== FRAM Test Complete ===");
 }
 
-bool saveCycleToFRAM(const PumpCycle& cycle) {
+bool saveCycleToFRAM(const PumpCycle& cycle, uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for cycle save");
@@ -287,23 +370,23 @@ bool saveCycleToFRAM(const PumpCycle& cycle) {
     uint16_t cycleCount = 0;
     uint16_t writeIndex = 0;
     
-    fram.read(FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&cycleCount, 2);
-    fram.read(FRAM_ADDR_CYCLE_INDEX, (uint8_t*)&writeIndex, 2);
+    framRead(off + FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&cycleCount, 2);
+    framRead(off + FRAM_ADDR_CYCLE_INDEX, (uint8_t*)&writeIndex, 2);
     
     // Calculate write address
-    uint16_t writeAddr = FRAM_ADDR_CYCLE_DATA + (writeIndex * FRAM_CYCLE_SIZE);
+    uint16_t writeAddr = off + FRAM_ADDR_CYCLE_DATA + (writeIndex * FRAM_CYCLE_SIZE);
     
     // Write cycle data
-    fram.write(writeAddr, (uint8_t*)&cycle, sizeof(PumpCycle));
+    framWrite(writeAddr, (uint8_t*)&cycle, sizeof(PumpCycle));
     
     // Update circular buffer index
     writeIndex = (writeIndex + 1) % FRAM_MAX_CYCLES;
-    fram.write(FRAM_ADDR_CYCLE_INDEX, (uint8_t*)&writeIndex, 2);
+    framWrite(off + FRAM_ADDR_CYCLE_INDEX, (uint8_t*)&writeIndex, 2);
     
     // Update count (max FRAM_MAX_CYCLES)
     if (cycleCount < FRAM_MAX_CYCLES) {
         cycleCount++;
-        fram.write(FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&cycleCount, 2);
+        framWrite(off + FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&cycleCount, 2);
     }
     LOG_INFO("");
     LOG_INFO("Cycle saved to FRAM at index %d (total: %d)", 
@@ -312,7 +395,9 @@ bool saveCycleToFRAM(const PumpCycle& cycle) {
     return true;
 }
 
-bool loadCyclesFromFRAM(std::vector<PumpCycle>& cycles, uint16_t maxCount) {
+bool loadCyclesFromFRAM(std::vector<PumpCycle>& cycles, uint16_t maxCount, uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for cycle load");
@@ -325,8 +410,8 @@ bool loadCyclesFromFRAM(std::vector<PumpCycle>& cycles, uint16_t maxCount) {
     uint16_t cycleCount = 0;
     uint16_t writeIndex = 0;
     
-    fram.read(FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&cycleCount, 2);
-    fram.read(FRAM_ADDR_CYCLE_INDEX, (uint8_t*)&writeIndex, 2);
+    framRead(off + FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&cycleCount, 2);
+    framRead(off + FRAM_ADDR_CYCLE_INDEX, (uint8_t*)&writeIndex, 2);
     
     if (cycleCount == 0) {
         LOG_INFO("");
@@ -350,10 +435,10 @@ bool loadCyclesFromFRAM(std::vector<PumpCycle>& cycles, uint16_t maxCount) {
     // Load cycles
     for (uint16_t i = 0; i < loadCount; i++) {
         uint16_t readIndex = (startIndex + i) % FRAM_MAX_CYCLES;
-        uint16_t readAddr = FRAM_ADDR_CYCLE_DATA + (readIndex * FRAM_CYCLE_SIZE);
+        uint16_t readAddr = off + FRAM_ADDR_CYCLE_DATA + (readIndex * FRAM_CYCLE_SIZE);
         
         PumpCycle cycle;
-        fram.read(readAddr, (uint8_t*)&cycle, sizeof(PumpCycle));
+        framRead(readAddr, (uint8_t*)&cycle, sizeof(PumpCycle));
         
         // Basic validation
         if (cycle.timestamp > 0 && cycle.timestamp < 0xFFFFFFFF) {
@@ -367,11 +452,12 @@ bool loadCyclesFromFRAM(std::vector<PumpCycle>& cycles, uint16_t maxCount) {
     return true;
 }
 
-uint16_t getCycleCountFromFRAM() {
+uint16_t getCycleCountFromFRAM(uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
     if (!framInitialized) return 0;
     
     uint16_t cycleCount = 0;
-    fram.read(FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&cycleCount, 2);
+    framRead(off + FRAM_ADDR_CYCLE_COUNT, (uint8_t*)&cycleCount, 2);
     return cycleCount;
 }
 
@@ -389,7 +475,9 @@ uint16_t calculateStatsChecksum(const ErrorStats& stats) {
     return sum;
 }
 
-bool loadErrorStatsFromFRAM(ErrorStats& stats) {
+bool loadErrorStatsFromFRAM(ErrorStats& stats, uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for stats load");
@@ -397,15 +485,15 @@ bool loadErrorStatsFromFRAM(ErrorStats& stats) {
     }
     
     // Read stats data
-    fram.read(FRAM_ADDR_GAP1_SUM, (uint8_t*)&stats.gap1_fail_sum, 2);
-    fram.read(FRAM_ADDR_GAP2_SUM, (uint8_t*)&stats.gap2_fail_sum, 2);
-    fram.read(FRAM_ADDR_WATER_SUM, (uint8_t*)&stats.water_fail_sum, 2);
-    fram.read(FRAM_ADDR_LAST_RESET, (uint8_t*)&stats.last_reset_timestamp, 4);
+    framRead(off + FRAM_ADDR_GAP1_SUM, (uint8_t*)&stats.gap1_fail_sum, 2);
+    framRead(off + FRAM_ADDR_GAP2_SUM, (uint8_t*)&stats.gap2_fail_sum, 2);
+    framRead(off + FRAM_ADDR_WATER_SUM, (uint8_t*)&stats.water_fail_sum, 2);
+    framRead(off + FRAM_ADDR_LAST_RESET, (uint8_t*)&stats.last_reset_timestamp, 4);
     
     // Verify checksum
     uint16_t calculatedChecksum = calculateStatsChecksum(stats);
     uint16_t storedChecksum = 0;
-    fram.read(FRAM_ADDR_STATS_CHKSUM, (uint8_t*)&storedChecksum, 2);
+    framRead(off + FRAM_ADDR_STATS_CHKSUM, (uint8_t*)&storedChecksum, 2);
     
     if (calculatedChecksum != storedChecksum) {
         LOG_WARNING("");
@@ -418,7 +506,7 @@ bool loadErrorStatsFromFRAM(ErrorStats& stats) {
         stats.water_fail_sum = 0;
         stats.last_reset_timestamp = getUnixTimestamp(); // Current time as reset time
         
-        saveErrorStatsToFRAM(stats); // Save defaults
+        saveErrorStatsToFRAM(stats, channel); // Save defaults
         return false;
     }
     LOG_INFO("");
@@ -428,7 +516,9 @@ bool loadErrorStatsFromFRAM(ErrorStats& stats) {
     return true;
 }
 
-bool saveErrorStatsToFRAM(const ErrorStats& stats) {
+bool saveErrorStatsToFRAM(const ErrorStats& stats, uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for stats save");
@@ -436,20 +526,20 @@ bool saveErrorStatsToFRAM(const ErrorStats& stats) {
     }
     
     // Write stats data
-    fram.write(FRAM_ADDR_GAP1_SUM, (uint8_t*)&stats.gap1_fail_sum, 2);
-    fram.write(FRAM_ADDR_GAP2_SUM, (uint8_t*)&stats.gap2_fail_sum, 2);
-    fram.write(FRAM_ADDR_WATER_SUM, (uint8_t*)&stats.water_fail_sum, 2);
-    fram.write(FRAM_ADDR_LAST_RESET, (uint8_t*)&stats.last_reset_timestamp, 4);
+    framWrite(off + FRAM_ADDR_GAP1_SUM, (uint8_t*)&stats.gap1_fail_sum, 2);
+    framWrite(off + FRAM_ADDR_GAP2_SUM, (uint8_t*)&stats.gap2_fail_sum, 2);
+    framWrite(off + FRAM_ADDR_WATER_SUM, (uint8_t*)&stats.water_fail_sum, 2);
+    framWrite(off + FRAM_ADDR_LAST_RESET, (uint8_t*)&stats.last_reset_timestamp, 4);
     
     // Calculate and write checksum
     uint16_t checksum = calculateStatsChecksum(stats);
-    fram.write(FRAM_ADDR_STATS_CHKSUM, (uint8_t*)&checksum, 2);
+    framWrite(off + FRAM_ADDR_STATS_CHKSUM, (uint8_t*)&checksum, 2);
     
     // Verify write by reading back
     ErrorStats readBack;
-    fram.read(FRAM_ADDR_GAP1_SUM, (uint8_t*)&readBack.gap1_fail_sum, 2);
-    fram.read(FRAM_ADDR_GAP2_SUM, (uint8_t*)&readBack.gap2_fail_sum, 2);
-    fram.read(FRAM_ADDR_WATER_SUM, (uint8_t*)&readBack.water_fail_sum, 2);
+    framRead(off + FRAM_ADDR_GAP1_SUM, (uint8_t*)&readBack.gap1_fail_sum, 2);
+    framRead(off + FRAM_ADDR_GAP2_SUM, (uint8_t*)&readBack.gap2_fail_sum, 2);
+    framRead(off + FRAM_ADDR_WATER_SUM, (uint8_t*)&readBack.water_fail_sum, 2);
     
     if (readBack.gap1_fail_sum != stats.gap1_fail_sum ||
         readBack.gap2_fail_sum != stats.gap2_fail_sum ||
@@ -466,7 +556,7 @@ bool saveErrorStatsToFRAM(const ErrorStats& stats) {
     return true;
 }
 
-bool resetErrorStatsInFRAM() {
+bool resetErrorStatsInFRAM(uint8_t channel, uint32_t resetTimestamp) {
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for stats reset");
@@ -477,9 +567,9 @@ bool resetErrorStatsInFRAM() {
     stats.gap1_fail_sum = 0;
     stats.gap2_fail_sum = 0;
     stats.water_fail_sum = 0;
-    stats.last_reset_timestamp = getUnixTimestamp(); // Current time
+    stats.last_reset_timestamp = resetTimestamp;
     
-    bool success = saveErrorStatsToFRAM(stats);
+    bool success = saveErrorStatsToFRAM(stats, channel);
     if (success) {
         LOG_INFO("");
         LOG_INFO("Error statistics reset to zero");
@@ -488,7 +578,8 @@ bool resetErrorStatsInFRAM() {
     return success;
 }
 
-bool incrementErrorStats(uint8_t gap1_increment, uint8_t gap2_increment, uint8_t water_increment) {
+bool incrementErrorStats(uint8_t gap1_increment, uint8_t gap2_increment, uint8_t water_increment, uint8_t channel) {
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for stats increment");
@@ -497,7 +588,7 @@ bool incrementErrorStats(uint8_t gap1_increment, uint8_t gap2_increment, uint8_t
     
     // Load current stats
     ErrorStats stats;
-    if (!loadErrorStatsFromFRAM(stats)) {
+    if (!loadErrorStatsFromFRAM(stats, channel)) {
         // If load fails, start with defaults
         stats.gap1_fail_sum = 0;
         stats.gap2_fail_sum = 0;
@@ -531,7 +622,7 @@ bool incrementErrorStats(uint8_t gap1_increment, uint8_t gap2_increment, uint8_t
     }
     
     // Save updated stats
-    bool success = saveErrorStatsToFRAM(stats);
+    bool success = saveErrorStatsToFRAM(stats, channel);
     
     if (success && (gap1_increment || gap2_increment || water_increment)) {
         LOG_INFO("");
@@ -556,13 +647,14 @@ bool readCredentialsFromFRAM(FRAMCredentials& creds) {
     }
     
     // Read credentials structure from FRAM
-    fram.read(FRAM_CREDENTIALS_ADDR, (uint8_t*)&creds, sizeof(FRAMCredentials));
+    framRead(FRAM_CREDENTIALS_ADDR, (uint8_t*)&creds, sizeof(FRAMCredentials));
     LOG_INFO("");
     LOG_INFO("Read credentials from FRAM at address 0x%04X", FRAM_CREDENTIALS_ADDR);
     return true;
 }
 
 bool writeCredentialsToFRAM(const FRAMCredentials& creds) {
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for credentials write");
@@ -570,11 +662,11 @@ bool writeCredentialsToFRAM(const FRAMCredentials& creds) {
     }
     
     // Write credentials structure to FRAM
-    fram.write(FRAM_CREDENTIALS_ADDR, (uint8_t*)&creds, sizeof(FRAMCredentials));
+    framWrite(FRAM_CREDENTIALS_ADDR, (uint8_t*)&creds, sizeof(FRAMCredentials));
     
     // Verify write by reading back
     FRAMCredentials verify_creds;
-    fram.read(FRAM_CREDENTIALS_ADDR, (uint8_t*)&verify_creds, sizeof(FRAMCredentials));
+    framRead(FRAM_CREDENTIALS_ADDR, (uint8_t*)&verify_creds, sizeof(FRAMCredentials));
     
     // Compare written data
     if (memcmp(&creds, &verify_creds, sizeof(FRAMCredentials)) != 0) {
@@ -641,7 +733,9 @@ uint16_t calculateDailyVolumeChecksum(const DailyVolumeData& data) {
     return sum;
 }
 
-bool saveDailyVolumeToFRAM(uint16_t dailyVolume, uint32_t utcDay) {
+bool saveDailyVolumeToFRAM(uint16_t dailyVolume, uint32_t utcDay, uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for daily volume save");
@@ -659,19 +753,19 @@ bool saveDailyVolumeToFRAM(uint16_t dailyVolume, uint32_t utcDay) {
     data.last_reset_utc_day = utcDay;
     
     // Write volume
-    fram.write(FRAM_ADDR_DAILY_VOLUME, (uint8_t*)&data.volume_ml, 2);
+    framWrite(off + FRAM_ADDR_DAILY_VOLUME, (uint8_t*)&data.volume_ml, 2);
     
     // Write UTC day
-    fram.write(FRAM_ADDR_LAST_RESET_UTC, (uint8_t*)&data.last_reset_utc_day, 4);
+    framWrite(off + FRAM_ADDR_LAST_RESET_UTC, (uint8_t*)&data.last_reset_utc_day, 4);
     
     // Calculate and write checksum
     uint16_t checksum = calculateDailyVolumeChecksum(data);
-    fram.write(FRAM_ADDR_DAILY_CHECKSUM, (uint8_t*)&checksum, 2);
+    framWrite(off + FRAM_ADDR_DAILY_CHECKSUM, (uint8_t*)&checksum, 2);
     
     // Verify write
     DailyVolumeData verify;
-    fram.read(FRAM_ADDR_DAILY_VOLUME, (uint8_t*)&verify.volume_ml, 2);
-    fram.read(FRAM_ADDR_LAST_RESET_UTC, (uint8_t*)&verify.last_reset_utc_day, 4);
+    framRead(off + FRAM_ADDR_DAILY_VOLUME, (uint8_t*)&verify.volume_ml, 2);
+    framRead(off + FRAM_ADDR_LAST_RESET_UTC, (uint8_t*)&verify.last_reset_utc_day, 4);
     
     if (verify.volume_ml != dailyVolume || verify.last_reset_utc_day != utcDay) {
         LOG_ERROR("");
@@ -683,7 +777,9 @@ bool saveDailyVolumeToFRAM(uint16_t dailyVolume, uint32_t utcDay) {
     return true;
 }
 
-bool loadDailyVolumeFromFRAM(uint16_t& dailyVolume, uint32_t& utcDay) {
+bool loadDailyVolumeFromFRAM(uint16_t& dailyVolume, uint32_t& utcDay, uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for daily volume load");
@@ -691,13 +787,13 @@ bool loadDailyVolumeFromFRAM(uint16_t& dailyVolume, uint32_t& utcDay) {
     }
     
     DailyVolumeData data;
-    fram.read(FRAM_ADDR_DAILY_VOLUME, (uint8_t*)&data.volume_ml, 2);
-    fram.read(FRAM_ADDR_LAST_RESET_UTC, (uint8_t*)&data.last_reset_utc_day, 4);
+    framRead(off + FRAM_ADDR_DAILY_VOLUME, (uint8_t*)&data.volume_ml, 2);
+    framRead(off + FRAM_ADDR_LAST_RESET_UTC, (uint8_t*)&data.last_reset_utc_day, 4);
     
     // Verify checksum
     uint16_t calculatedChecksum = calculateDailyVolumeChecksum(data);
     uint16_t storedChecksum = 0;
-    fram.read(FRAM_ADDR_DAILY_CHECKSUM, (uint8_t*)&storedChecksum, 2);
+    framRead(off + FRAM_ADDR_DAILY_CHECKSUM, (uint8_t*)&storedChecksum, 2);
     
     if (calculatedChecksum != storedChecksum) {
         LOG_WARNING("");
@@ -735,7 +831,9 @@ uint16_t calculateAvailableVolumeChecksum(uint32_t maxMl, uint32_t currentMl) {
     return sum;
 }
 
-bool saveAvailableVolumeToFRAM(uint32_t maxMl, uint32_t currentMl) {
+bool saveAvailableVolumeToFRAM(uint32_t maxMl, uint32_t currentMl, uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for available volume save");
@@ -749,16 +847,16 @@ bool saveAvailableVolumeToFRAM(uint32_t maxMl, uint32_t currentMl) {
         return false;
     }
     
-    fram.write(FRAM_ADDR_AVAIL_VOL_MAX, (uint8_t*)&maxMl, 4);
-    fram.write(FRAM_ADDR_AVAIL_VOL_CURRENT, (uint8_t*)&currentMl, 4);
+    framWrite(off + FRAM_ADDR_AVAIL_VOL_MAX, (uint8_t*)&maxMl, 4);
+    framWrite(off + FRAM_ADDR_AVAIL_VOL_CURRENT, (uint8_t*)&currentMl, 4);
     
     uint16_t checksum = calculateAvailableVolumeChecksum(maxMl, currentMl);
-    fram.write(FRAM_ADDR_AVAIL_VOL_CHKSUM, (uint8_t*)&checksum, 2);
+    framWrite(off + FRAM_ADDR_AVAIL_VOL_CHKSUM, (uint8_t*)&checksum, 2);
     
     // Verify write
     uint32_t verifyMax = 0, verifyCurrent = 0;
-    fram.read(FRAM_ADDR_AVAIL_VOL_MAX, (uint8_t*)&verifyMax, 4);
-    fram.read(FRAM_ADDR_AVAIL_VOL_CURRENT, (uint8_t*)&verifyCurrent, 4);
+    framRead(off + FRAM_ADDR_AVAIL_VOL_MAX, (uint8_t*)&verifyMax, 4);
+    framRead(off + FRAM_ADDR_AVAIL_VOL_CURRENT, (uint8_t*)&verifyCurrent, 4);
     
     if (verifyMax != maxMl || verifyCurrent != currentMl) {
         LOG_ERROR("");
@@ -771,19 +869,21 @@ bool saveAvailableVolumeToFRAM(uint32_t maxMl, uint32_t currentMl) {
     return true;
 }
 
-bool loadAvailableVolumeFromFRAM(uint32_t& maxMl, uint32_t& currentMl) {
+bool loadAvailableVolumeFromFRAM(uint32_t& maxMl, uint32_t& currentMl, uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for available volume load");
         return false;
     }
     
-    fram.read(FRAM_ADDR_AVAIL_VOL_MAX, (uint8_t*)&maxMl, 4);
-    fram.read(FRAM_ADDR_AVAIL_VOL_CURRENT, (uint8_t*)&currentMl, 4);
+    framRead(off + FRAM_ADDR_AVAIL_VOL_MAX, (uint8_t*)&maxMl, 4);
+    framRead(off + FRAM_ADDR_AVAIL_VOL_CURRENT, (uint8_t*)&currentMl, 4);
     
     uint16_t calculatedChecksum = calculateAvailableVolumeChecksum(maxMl, currentMl);
     uint16_t storedChecksum = 0;
-    fram.read(FRAM_ADDR_AVAIL_VOL_CHKSUM, (uint8_t*)&storedChecksum, 2);
+    framRead(off + FRAM_ADDR_AVAIL_VOL_CHKSUM, (uint8_t*)&storedChecksum, 2);
     
     if (calculatedChecksum != storedChecksum) {
         LOG_WARNING("");
@@ -813,7 +913,9 @@ uint16_t calculateFillMaxChecksum(uint16_t fillWaterMax) {
     return fillWaterMax ^ 0x5A5A;
 }
 
-bool saveFillWaterMaxToFRAM(uint16_t fillWaterMax) {
+bool saveFillWaterMaxToFRAM(uint16_t fillWaterMax, uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for fill water max save");
@@ -827,14 +929,14 @@ bool saveFillWaterMaxToFRAM(uint16_t fillWaterMax) {
         return false;
     }
     
-    fram.write(FRAM_ADDR_FILL_WATER_MAX, (uint8_t*)&fillWaterMax, 2);
+    framWrite(off + FRAM_ADDR_FILL_WATER_MAX, (uint8_t*)&fillWaterMax, 2);
     
     uint16_t checksum = calculateFillMaxChecksum(fillWaterMax);
-    fram.write(FRAM_ADDR_FILL_MAX_CHKSUM, (uint8_t*)&checksum, 2);
+    framWrite(off + FRAM_ADDR_FILL_MAX_CHKSUM, (uint8_t*)&checksum, 2);
     
     // Verify write
     uint16_t verifyValue = 0;
-    fram.read(FRAM_ADDR_FILL_WATER_MAX, (uint8_t*)&verifyValue, 2);
+    framRead(off + FRAM_ADDR_FILL_WATER_MAX, (uint8_t*)&verifyValue, 2);
     
     if (verifyValue != fillWaterMax) {
         LOG_ERROR("");
@@ -847,18 +949,20 @@ bool saveFillWaterMaxToFRAM(uint16_t fillWaterMax) {
     return true;
 }
 
-bool loadFillWaterMaxFromFRAM(uint16_t& fillWaterMax) {
+bool loadFillWaterMaxFromFRAM(uint16_t& fillWaterMax, uint8_t channel) {
+    const uint16_t off = FRAM_CHANNEL_OFFSET(channel);
+    I2CBusLock busLock;
     if (!framInitialized) {
         LOG_ERROR("");
         LOG_ERROR("FRAM not initialized for fill water max load");
         return false;
     }
     
-    fram.read(FRAM_ADDR_FILL_WATER_MAX, (uint8_t*)&fillWaterMax, 2);
+    framRead(off + FRAM_ADDR_FILL_WATER_MAX, (uint8_t*)&fillWaterMax, 2);
     
     uint16_t calculatedChecksum = calculateFillMaxChecksum(fillWaterMax);
     uint16_t storedChecksum = 0;
-    fram.read(FRAM_ADDR_FILL_MAX_CHKSUM, (uint8_t*)&storedChecksum, 2);
+    framRead(off + FRAM_ADDR_FILL_MAX_CHKSUM, (uint8_t*)&storedChecksum, 2);
     
     if (calculatedChecksum != storedChecksum) {
         LOG_WARNING("");
@@ -877,4 +981,48 @@ bool loadFillWaterMaxFromFRAM(uint16_t& fillWaterMax) {
     LOG_INFO("");
     LOG_INFO("Fill water max loaded from FRAM: %d ml", fillWaterMax);
     return true;
-}
\ No newline at end of file
+}
+
+// ===============================
+// GENERIC CHECKSUMMED RECORDS
+// ===============================
+
+static uint16_t calculateRecordChecksum(const void* data, uint16_t len) {
+    return calculateChecksum((uint8_t*)data, len) + len;
+}
+
+bool saveRecordToFRAM(uint16_t addr, const void* data, uint16_t len) {
+    I2CBusLock busLock;
+    if (!framInitialized || len > FRAM_RECORD_MAX_DATA) {
+        return false;
+    }
+
+    uint16_t magic = FRAM_RECORD_MAGIC;
+    uint16_t checksum = calculateRecordChecksum(data, len);
+    bool ok = framWrite(addr, (uint8_t*)&magic, 2);
+    ok = ok && framWrite(addr + 2, (uint8_t*)data, len);
+    ok = ok && framWrite(addr + 2 + len, (uint8_t*)&checksum, 2);
+    return ok;
+}
+
+bool loadRecordFromFRAM(uint16_t addr, void* data, uint16_t len) {
+    I2CBusLock busLock;
+    if (!framInitialized || len > FRAM_RECORD_MAX_DATA) {
+        return false;
+    }
+
+    uint16_t magic = 0;
+    uint16_t storedChecksum = 0;
+    uint8_t buffer[FRAM_RECORD_MAX_DATA];
+    if (!framRead(addr, (uint8_t*)&magic, 2) ||
+        !framRead(addr + 2, buffer, len) ||
+        !framRead(addr + 2 + len, (uint8_t*)&storedChecksum, 2)) {
+        return false;
+    }
+
+    if (magic != FRAM_RECORD_MAGIC || storedChecksum != calculateRecordChecksum(buffer, len)) {
+        return false;
+    }
+    memcpy(data, buffer, len);
+    return true;
+}
@@ -61,14 +61,52 @@ struct PumpCycle;
 #define FRAM_MAX_CYCLES        30      // Maksymalnie 30 cykli (~5 dni)
 #define FRAM_CYCLE_SIZE        28      // musi == sizeof(PumpCycle), weryfikacja w fram_controller.cpp
 
+// 0x0A00+: Learned profiles (generic records, see saveRecordToFRAM)
+#define FRAM_ADDR_DEBOUNCE_PROFILE   (FRAM_ESP32_BASE + 0x500)  // 0x0A00, 32 + 4 bytes
+#define FRAM_ADDR_FLOW_CALIBRATION   (FRAM_ESP32_BASE + 0x540)  // 0x0A40, <= 44 + 4 bytes
+#define FRAM_ADDR_EVAPORATION_PROFILE (FRAM_ESP32_BASE + 0x580) // 0x0A80, 48 + 4 bytes
+#define FRAM_ADDR_ANOMALY_STATE      (FRAM_ESP32_BASE + 0x600)  // 0x0B00, 3 x 0x20 (24 + 4 bytes each)
+#define FRAM_ANOMALY_SLOT_SIZE       0x20
+
+// 0x1100+: Cycle aggregates (0x1000-0x100F = testFRAM scratch)
+#define FRAM_ADDR_AGGREGATES         0x1100     // 43 x 0x34 (48 + 4 bytes each) -> 0x19BC
+#define FRAM_AGGREGATE_SLOT_SIZE     0x34
+#define FRAM_AGGREGATE_BUCKETS       43         // 12 x 5 min + 24 x 1 h + 7 x 1 doba
+
+// 0x1A00+: Consumption archive (RRD)
+#define FRAM_ADDR_CONSUMPTION_ARCHIVE 0x1A00    // 242 x 0x10 (12 + 4 bytes each) -> 0x2920
+#define FRAM_ARCHIVE_SLOT_SIZE       0x10
+#define FRAM_ARCHIVE_BUCKETS         242        // 48 x 30 min + 90 x 1 doba + 104 x 1 tydzień
+
+// 0x2940+: Pump usage (lifetime counters + 7-day duty ring), slot per channel
+#define FRAM_ADDR_PUMP_USAGE         0x2940     // 2 x 0x60 -> 0x2A00
+#define FRAM_PUMP_USAGE_SLOT_SIZE    0x60       // Sumy 44 + 4 bytes, ring dni 32 + 4 bytes
+#define FRAM_PUMP_DUTY_OFFSET        0x30
+#define FRAM_PUMP_USAGE_CHANNELS     2
+
+// 0x2A00+: Cycle checkpoint (kontekst cyklu w toku), slot per channel
+#define FRAM_ADDR_CYCLE_CHECKPOINT   0x2A00     // 2 x 0x40 (<= 48 + 4 bytes each) -> 0x2A80
+#define FRAM_CYCLE_CHECKPOINT_SLOT_SIZE 0x40
+#define FRAM_CYCLE_CHECKPOINT_CHANNELS 2
+
+// 0x3000+: Partycje kanałów 1..WATER_CHANNEL_MAX-1 (kanał 0 = FRAM_ESP32_BASE)
+// Każda powtarza układ FRAM_ESP32_BASE + 0x00..0x447 (przepływ, statystyki,
+// wolumeny, ring cykli); funkcje poniżej przyjmują numer kanału.
+#define FRAM_CHANNEL_PARTITION_BASE  0x3000
+#define FRAM_CHANNEL_PARTITION_SIZE  0x0500
+#define FRAM_CHANNEL_OFFSET(ch)      ((ch) == 0 ? 0 : \
+    (FRAM_CHANNEL_PARTITION_BASE + ((ch) - 1) * FRAM_CHANNEL_PARTITION_SIZE - FRAM_ESP32_BASE))
+#define FRAM_ADDR_CHANNEL_MAGIC      (FRAM_ESP32_BASE + 0x00)  // 4 bytes - tylko partycje kanałów 1+
+#define FRAM_CHANNEL_MAGIC           0x4E414843  // "CHAN"
+
 // Common constants
 // #define FRAM_MAGIC_NUMBER      0x57415452  // "WATR" in hex
 // #define FRAM_DATA_VERSION      0x0002      // Version 2 (updated for dual-mode)
 
 // Basic FRAM functions
 bool initFRAM();
-bool loadVolumeFromFRAM(float& volume);
-bool saveVolumeToFRAM(float volume);
+bool loadVolumeFromFRAM(float& volume, uint8_t channel = 0);
+bool saveVolumeToFRAM(float volume, uint8_t channel = 0);
 bool verifyFRAM();
 void testFRAM();
 
@@ -77,14 +115,15 @@ struct DailyVolumeData {
     uint32_t last_reset_utc_day;
 };
 
-bool saveDailyVolumeToFRAM(uint16_t dailyVolume, uint32_t utcDay);
-bool loadDailyVolumeFromFRAM(uint16_t& dailyVolume, uint32_t& utcDay);
+bool saveDailyVolumeToFRAM(uint16_t dailyVolume, uint32_t utcDay, uint8_t channel = 0);
+bool loadDailyVolumeFromFRAM(uint16_t& dailyVolume, uint32_t& utcDay, uint8_t channel = 0);
 
 // Cycle management functions (implemented in fram_controller.cpp)
-bool saveCycleToFRAM(const PumpCycle& cycle);
-bool loadCyclesFromFRAM(std::vector<PumpCycle>& cycles, uint16_t maxCount = FRAM_MAX_CYCLES);
-uint16_t getCycleCountFromFRAM();
-// FRAM busy flag - prevents concurrent I2C access during writes
+bool saveCycleToFRAM(const PumpCycle& cycle, uint8_t channel = 0);
+bool loadCyclesFromFRAM(std::vector<PumpCycle>& cycles, uint16_t maxCount = FRAM_MAX_CYCLES, uint8_t channel = 0);
+uint16_t getCycleCountFromFRAM(uint8_t channel = 0);
+// FRAM busy flag - HTTP skips cycle history while the algorithm updates it
+// (I2C itself is serialized by I2CBusLock, see i2c_bus.h)
 extern volatile bool framBusy;
 
 // Struktura statystyk błędów
@@ -96,10 +135,10 @@ struct ErrorStats {
 };
 
 // Funkcje obsługi statystyk błędów
-bool loadErrorStatsFromFRAM(ErrorStats& stats);
-bool saveErrorStatsToFRAM(const ErrorStats& stats);
-bool resetErrorStatsInFRAM();
-bool incrementErrorStats(uint8_t gap1_increment, uint8_t gap2_increment, uint8_t water_increment);
+bool loadErrorStatsFromFRAM(ErrorStats& stats, uint8_t channel = 0);
+bool saveErrorStatsToFRAM(const ErrorStats& stats, uint8_t channel = 0);
+bool resetErrorStatsInFRAM(uint8_t channel, uint32_t resetTimestamp);
+bool incrementErrorStats(uint8_t gap1_increment, uint8_t gap2_increment, uint8_t water_increment, uint8_t channel = 0);
 
 // ===============================
 // 🆕 NEW: AVAILABLE VOLUME FUNCTIONS
@@ -109,14 +148,26 @@ struct AvailableVolumeData {
     uint32_t current_ml;  // Aktualna ilość
 };
 
-bool saveAvailableVolumeToFRAM(uint32_t maxMl, uint32_t currentMl);
-bool loadAvailableVolumeFromFRAM(uint32_t& maxMl, uint32_t& currentMl);
+bool saveAvailableVolumeToFRAM(uint32_t maxMl, uint32_t currentMl, uint8_t channel = 0);
+bool loadAvailableVolumeFromFRAM(uint32_t& maxMl, uint32_t& currentMl, uint8_t channel = 0);
 
 // ===============================
 // 🆕 NEW: CONFIGURABLE FILL_WATER_MAX
 // ===============================
-bool saveFillWaterMaxToFRAM(uint16_t fillWaterMax);
-bool loadFillWaterMaxFromFRAM(uint16_t& fillWaterMax);
+bool saveFillWaterMaxToFRAM(uint16_t fillWaterMax, uint8_t channel = 0);
+bool loadFillWaterMaxFromFRAM(uint16_t& fillWaterMax, uint8_t channel = 0);
+
+// ===============================
+// GENERIC CHECKSUMMED RECORDS
+// ===============================
+// Layout: [magic 2B][data len B][checksum 2B]. Pusty / wyzerowany FRAM nie
+// przechodzi walidacji (magic), zmiana rozmiaru struktury też (len w sumie).
+#define FRAM_RECORD_MAGIC      0x5243  // "RC"
+#define FRAM_RECORD_OVERHEAD   4
+#define FRAM_RECORD_MAX_DATA   48      // Limit zlecenia w kolejce storage
+
+bool saveRecordToFRAM(uint16_t addr, const void* data, uint16_t len);
+bool loadRecordFromFRAM(uint16_t addr, void* data, uint16_t len);
 
 // ===============================
 // FRAM CREDENTIALS SECTION
@@ -6,6 +6,7 @@
 // #define STATUS_LED_PIN      2            // ERROR signal
 #define WATER_SENSOR_1_PIN   3            // Float sensor 1 (pull-up, active LOW)
 #define WATER_SENSOR_2_PIN   4            // Float sensor 2 (pull-up, active LOW)
+#define WATER_SENSOR_COUNT   2            // Pływaki na kanał (1..3) - głosowanie: algorithm_config.h
 #define RTC_SDA_PIN         6            // DS3231M I2C SDA
 #define RTC_SCL_PIN         7            // DS3231M I2C SCL
 
@@ -13,4 +14,43 @@
 #define ERROR_SIGNAL_PIN    2   // 2 Pin sygnalizacji błędów ERR0/1/2
 #define RESET_PIN          8  // Pin fizycznego resetu
 
-#endif
\ No newline at end of file
+// ============== KANAŁY (zbiornik + pompa + pływaki) ==============
+// Kanał 0 = piny powyżej. Wolne piny C3 (5, 0, 1) wystarczają na jeden
+// dodatkowy kanał; sygnalizacja błędów i przycisk są wspólne. GPIO20/21 to
+// UART0 (log bootloadera ROM na TX) - nie na pływaki. GPIO0/1 (XTAL_32K)
+// są wolne bez kwarcu 32 kHz (RTC = DS3231).
+#define WATER_CHANNEL_COUNT  1            // Aktywne kanały (1..WATER_CHANNEL_MAX)
+#define WATER_CHANNEL_MAX    2
+
+#define CH1_PUMP_RELAY_PIN   5
+#define CH1_SENSOR_1_PIN     0            // XTAL_32K_P
+#define CH1_SENSOR_2_PIN     1            // XTAL_32K_N
+
+#define CHANNEL_PUMP_PINS    { PUMP_RELAY_PIN, CH1_PUMP_RELAY_PIN }
+
+// Piny pływaków kolejnych kanałów, WATER_SENSOR_COUNT na kanał. Trzeci
+// pływak (redundancja) zajmuje pin CH1_SENSOR_1 - tylko przy jednym kanale.
+#if WATER_SENSOR_COUNT == 1
+#define CHANNEL_SENSOR_PINS  { WATER_SENSOR_1_PIN, CH1_SENSOR_1_PIN }
+#elif WATER_SENSOR_COUNT == 2
+#define CHANNEL_SENSOR_PINS  { WATER_SENSOR_1_PIN, WATER_SENSOR_2_PIN, \
+                               CH1_SENSOR_1_PIN, CH1_SENSOR_2_PIN }
+#elif WATER_SENSOR_COUNT == 3
+#define WATER_SENSOR_3_PIN   CH1_SENSOR_1_PIN
+#define CHANNEL_SENSOR_PINS  { WATER_SENSOR_1_PIN, WATER_SENSOR_2_PIN, WATER_SENSOR_3_PIN }
+#else
+#error "WATER_SENSOR_COUNT must be 1..3 (no free pins for more on Xiao C3)"
+#endif
+
+// Czujniki wszystkich kanałów: indeks = kanał * WATER_SENSOR_COUNT + czujnik
+#define WATER_SENSOR_TOTAL   (WATER_CHANNEL_COUNT * WATER_SENSOR_COUNT)
+
+#if WATER_CHANNEL_COUNT < 1 || WATER_CHANNEL_COUNT > WATER_CHANNEL_MAX
+#error "WATER_CHANNEL_COUNT must be in 1..WATER_CHANNEL_MAX"
+#endif
+
+#if WATER_SENSOR_COUNT == 3 && WATER_CHANNEL_COUNT > 1
+#error "Third float sensor uses channel 1 pins - set WATER_CHANNEL_COUNT to 1"
+#endif
+
+#endif
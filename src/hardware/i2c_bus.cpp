@@ -0,0 +1,33 @@
+#include "i2c_bus.h"
+#include "../core/logging.h"
+#include "../core/metrics.h"
+
+static SemaphoreHandle_t i2cMutex = nullptr;
+
+void initI2CBus() {
+    if (i2cMutex != nullptr) {
+        return;
+    }
+    i2cMutex = xSemaphoreCreateRecursiveMutex();
+    if (i2cMutex == nullptr) {
+        LOG_ERROR("");
+        LOG_ERROR("I2C bus mutex allocation failed - bus access unguarded");
+    }
+}
+
+// Przed initI2CBus() (wczesny setup) działa jak no-op
+I2CBusLock::I2CBusLock() {
+    if (i2cMutex == nullptr) {
+        return;
+    }
+    if (xSemaphoreTakeRecursive(i2cMutex, 0) != pdTRUE) {
+        metricsInc(MC_I2C_LOCK_CONTENDED);
+        xSemaphoreTakeRecursive(i2cMutex, portMAX_DELAY);
+    }
+}
+
+I2CBusLock::~I2CBusLock() {
+    if (i2cMutex != nullptr) {
+        xSemaphoreGiveRecursive(i2cMutex);
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// ============== I2C BUS LOCK ==============
+// FRAM i DS3231 dzielą jedną magistralę. Zadanie storage, handlery
+// async_tcp i setup() mogą sięgać po nią równolegle - rekurencyjny mutex
+// pozwala zablokować całą sekwencję (np. zapis + checksum + weryfikacja)
+// i jednocześnie brać go ponownie w pojedynczych transakcjach.
+// Mutex ma dziedziczenie priorytetu, więc krótka transakcja webowa nie
+// zatrzyma na długo zadania storage.
+
+void initI2CBus();
+
+class I2CBusLock {
+public:
+    I2CBusLock();
+    ~I2CBusLock();
+    I2CBusLock(const I2CBusLock&) = delete;
+    I2CBusLock& operator=(const I2CBusLock&) = delete;
+};
+
+#endif
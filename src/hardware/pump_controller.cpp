@@ -4,197 +4,536 @@
 #include "../network/vps_logger.h"
 #include "../hardware/rtc_controller.h"
 #include "../core/logging.h"
+#include "../core/metrics.h"
+#include "../core/trace.h"
+#include "../core/task_manager.h"
+#include "pump_usage.h"
 #include <math.h>
+#include <freertos/FreeRTOS.h>
 
 #include "../algorithm/water_algorithm.h"  // <-- DODAJ
 
 
+static const uint8_t PUMP_PINS[WATER_CHANNEL_MAX] = CHANNEL_PUMP_PINS;
+
+static PumpChannel pumpChannels[WATER_CHANNEL_COUNT] = {
+    PumpChannel(0),
+#if WATER_CHANNEL_COUNT > 1
+    PumpChannel(1),
+#endif
+};
+
+// Indeks = PumpSource (bez SAFETY - stop nie włącza przekaźnika)
+static const MetricCounter START_COUNTERS[PUMP_SOURCE_SAFETY] = {
+    MC_PUMP_STARTS_AUTO,
+    MC_PUMP_STARTS_CALIBRATION,
+    MC_PUMP_STARTS_MANUAL,
+    MC_PUMP_STARTS_DIRECT,
+};
+
+static const char* const TRACE_NAMES[PUMP_SOURCE_SAFETY] = {
+    "pump_auto",
+    "pump_calibration",
+    "pump_manual",
+    "pump_direct",
+};
+
+// ============== AUDIT LOG ==============
+// Pisze tylko control, czyta async_tcp - krótka sekcja krytyczna przy kopiowaniu
+static portMUX_TYPE auditMux = portMUX_INITIALIZER_UNLOCKED;
+static PumpAuditEntry auditLog[PUMP_AUDIT_SIZE];
+static uint8_t auditHead = 0;
+static uint8_t auditCount = 0;
+static uint32_t auditTotal = 0;
+
+PumpChannel& getPumpChannel(uint8_t channel) {
+    return pumpChannels[channel < WATER_CHANNEL_COUNT ? channel : 0];
+}
 
+bool isAnyPumpActive() {
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        if (pumpChannels[ch].isActive()) {
+            return true;
+        }
+    }
+    return false;
+}
 
-bool pumpRunning = false;
-unsigned long pumpStartTime = 0;
-unsigned long pumpDuration = 0;
-String currentActionType = "";
+static bool isManualSource(PumpSource source) {
+    return source == PUMP_SOURCE_MANUAL || source == PUMP_SOURCE_CALIBRATION;
+}
 
-static bool pumpActive = false;
-static bool manualPumpActive = false;
-static bool directPumpMode = false;
+PumpChannel::PumpChannel(uint8_t channel)
+    : channel(channel), relayPin(PUMP_PINS[channel]), owner(PUMP_SOURCE_NONE),
+      startTime(0), duration(0), startUs(0), cutoffTimer(nullptr),
+      cutoffArmed(false), cutoffFired(false), cutoffUs(0), timerCutoff(false), cutoffArmFailures(0),
+      lastRunSource(PUMP_SOURCE_NONE), lastRunUs(0), manualSession(false), queueCount(0) {
+}
 
-void initPumpController() {
+// Zadanie esp_timer: przekaźnik off dokładnie w terminie, rozliczenie w control
+void PumpChannel::onCutoffTimer(void* arg) {
+    PumpChannel* self = static_cast<PumpChannel*>(arg);
+    if (!self->cutoffArmed) {
+        return;
+    }
+    digitalWrite(self->relayPin, HIGH);
+    self->cutoffUs = esp_timer_get_time();
+    self->cutoffArmed = false;
+    self->cutoffFired = true;
+    notifySystemTask(TASK_CONTROL);
+}
+
+void PumpChannel::relayOff() {
+    // Rozbrojenie przed stop - callback, który już wystartował, nic nie zrobi
+    cutoffArmed = false;
+    if (cutoffTimer != nullptr) {
+        esp_timer_stop(cutoffTimer);
+    }
+    digitalWrite(relayPin, HIGH);
+
+    int64_t endUs = cutoffFired ? cutoffUs : esp_timer_get_time();
+    cutoffFired = false;
+    lastRunUs = (uint32_t)(endUs - startUs);
+    lastRunSource = owner;
+    owner = PUMP_SOURCE_NONE;
+    recordRunMetrics();
+    pumpUsageOnStop(channel, lastRunSource, lastRunUs);
+}
+
+// Relay właśnie wyłączony - czas pracy do /metrics, koniec spanu pompy
+// (ścieżka trace pompy jest jedna - span tylko dla kanału 0)
+void PumpChannel::recordRunMetrics() {
+    if (channel == 0) {
+        traceEnd(TRACE_TRACK_PUMP);
+    }
+    uint32_t runMs = lastRunUs / 1000;
+    metricsInc(MC_PUMP_RUNTIME_MS, runMs);
+    metricsObserve(MH_PUMP_RUN_MS, runMs);
+    metricsSetGauge(MG_PUMP_RUNNING, isAnyPumpActive() ? 1 : 0);
+}
+
+uint16_t PumpChannel::volumeForUs(uint32_t onTimeUs) const {
+    return (uint16_t)round(onTimeUs / 1000000.0 * getWaterChannel(channel).getVolumePerSecond());
+}
+
+void PumpChannel::audit(PumpAuditAction action, PumpSource source, PumpSource other,
+                        PumpAuditReason reason, uint16_t durationSeconds) {
+    PumpAuditEntry entry;
+    entry.ms = millis();
+    entry.durationSeconds = durationSeconds;
+    entry.channel = channel;
+    entry.source = source;
+    entry.other = other;
+    entry.action = action;
+    entry.reason = reason;
+
+    portENTER_CRITICAL(&auditMux);
+    auditLog[auditHead] = entry;
+    auditHead = (auditHead + 1) % PUMP_AUDIT_SIZE;
+    if (auditCount < PUMP_AUDIT_SIZE) {
+        auditCount++;
+    }
+    auditTotal++;
+    portEXIT_CRITICAL(&auditMux);
+}
+
+void PumpChannel::init() {
+    pinMode(relayPin, OUTPUT);
+    digitalWrite(relayPin, HIGH);
+
+    owner = PUMP_SOURCE_NONE;
+    queueCount = 0;
+
+    esp_timer_create_args_t args = {};
+    args.callback = onCutoffTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "pump_cutoff";
+    if (esp_timer_create(&args, &cutoffTimer) != 0) {
+        cutoffTimer = nullptr;
+        LOG_ERROR("Pump CH%d: cutoff timer create failed - tick-based stop only", channel);
+    }
+    timerCutoff = cutoffTimer != nullptr;
 
-    pinMode(PUMP_RELAY_PIN, OUTPUT);
-    digitalWrite(PUMP_RELAY_PIN, HIGH);
-    
-    pumpRunning = false;
     LOG_INFO("");
-    LOG_INFO("Pump controller initialized");
+    LOG_INFO("Pump controller CH%d initialized (relay pin %d, %s cutoff)", channel, relayPin,
+             cutoffTimer != nullptr ? "timer" : "tick");
 }
 
-void updatePumpController() {
+// Timer wyłączył przekaźnik, ale właściciel zostaje do rozliczenia w control.
+// Każda decyzja arbitra najpierw zamyka taki przebieg jako COMPLETE - inaczej
+// direct-on widziałby zajęty przekaźnik (wywłaszczenie zakończonego AUTO,
+// zignorowane ponowne DIRECT), a release/stop zapisałyby złą akcję.
+void PumpChannel::settleCutoff() {
+    if (isActive() && cutoffFired) {
+        finish(PUMP_AUDIT_COMPLETE, PUMP_SOURCE_NONE, PUMP_REASON_NONE);
+    }
+}
+
+void PumpChannel::update() {
+
+    // Timer już wyłączył przekaźnik; bez timera (lub gdy nie zadziałał) - termin z ticka
+    settleCutoff();
+    unsigned long deadline = timerCutoff ? duration + PUMP_CUTOFF_GRACE_MS : duration;
+    if (isActive() && millis() - startTime >= deadline) {
+        finish(PUMP_AUDIT_COMPLETE, PUMP_SOURCE_NONE, PUMP_REASON_NONE);
+    }
 
         // Check global pump state - stop if disabled (but not in direct mode)
-    if (!pumpGlobalEnabled && pumpRunning && !directPumpMode) {
-        digitalWrite(PUMP_RELAY_PIN, HIGH);
-        pumpRunning = false;
+    if (!pumpGlobalEnabled && isActive() && owner != PUMP_SOURCE_DIRECT) {
         LOG_INFO("");
-        LOG_INFO("Pump stopped - globally disabled");
-        return;
+        LOG_INFO("Pump CH%d stopped - globally disabled", channel);
+        stop(PUMP_REASON_GLOBAL_DISABLED);
     }
 
-    if (pumpRunning && (millis() - pumpStartTime >= pumpDuration)) {
-        // Stop pump and log event
-        digitalWrite(PUMP_RELAY_PIN, HIGH);
-        pumpRunning = false;
+    serviceQueue();
 
-        uint16_t actualDuration = (millis() - pumpStartTime) / 1000;
-        uint16_t volumeML = (uint16_t)round(actualDuration * currentPumpSettings.volumePerSecond);
+    // Algorytm wraca z MANUAL_OVERRIDE dopiero gdy cała seria ręcznych przebiegów minęła
+    if (manualSession && !isActive() && queueCount == 0) {
+        manualSession = false;
+        getWaterChannel(channel).onManualPumpComplete();
+    }
+}
 
-        LOG_INFO("");
-        LOG_INFO("Pump stopped after %d seconds, estimated volume: %d ml",
-                 actualDuration, volumeML);
+// ============== ARBITRAŻ ==============
 
-        if (directPumpMode) {
-            directPumpMode = false;
-            LOG_INFO("");
-            LOG_INFO("Direct pump safety timeout reached - pump stopped");
-        } else if (currentActionType == "MANUAL_NORMAL") {
-            // Access water algorithm to update daily volume
-            waterAlgorithm.addManualVolume(volumeML);
-            LOG_INFO("");
-            LOG_INFO("✅ MANUAL_NORMAL volume added to daily total: %dml", volumeML);
-        } else if (currentActionType == "MANUAL_EXTENDED") {
-            LOG_INFO("");
-            LOG_INFO("ℹ️ MANUAL_EXTENDED (calibration) - NOT added to daily volume");
-        }
+PumpRequestResult PumpChannel::request(PumpSource source, uint16_t durationSeconds) {
+    settleCutoff();
 
-        currentActionType = "";
+    if (source >= PUMP_SOURCE_SAFETY) {
+        stop();
+        return PUMP_GRANTED;
     }
 
-      static bool wasManualActive = false;
-    if (wasManualActive && !manualPumpActive && !pumpRunning && !directPumpMode) {
-        waterAlgorithm.onManualPumpComplete();
-        wasManualActive = false;
+    if (source == PUMP_SOURCE_DIRECT && owner == PUMP_SOURCE_DIRECT) {
+        // Already running in direct mode — ignore
+        return PUMP_GRANTED;
     }
-    if (manualPumpActive) {
-        wasManualActive = true;
+
+    if (!pumpGlobalEnabled && source != PUMP_SOURCE_DIRECT) {
+        return reject(source, PUMP_REASON_GLOBAL_DISABLED, durationSeconds);
     }
-}
 
-bool triggerPump(uint16_t durationSeconds, const String& actionType) {
-    LOG_INFO("");
-    LOG_INFO("triggerPump called: %s for %ds", actionType.c_str(), durationSeconds);
-    
-    if (pumpRunning) {
+    if (isActive() && source <= owner) {
+        if (isManualSource(source)) {
+            return enqueue(source, durationSeconds);
+        }
+        return reject(source, PUMP_REASON_BUSY, durationSeconds);
+    }
+
+    // Weto algorytmu przed wywłaszczeniem - odrzucone żądanie nie przerywa pracy
+    if (isManualSource(source) &&
+        !getWaterChannel(channel).requestManualPump(durationSeconds * 1000)) {
+        return reject(source, PUMP_REASON_ALGORITHM_VETO, durationSeconds);
+    }
+
+    if (isActive()) {
         LOG_WARNING("");
-        LOG_WARNING("Pump already running, ignoring trigger");
-        return false;
+        LOG_WARNING("Pump CH%d: %s preempts %s", channel,
+                    getPumpSourceName(source), getPumpSourceName(owner));
+        metricsInc(MC_PUMP_ARBITER_PREEMPTED);
+        finish(PUMP_AUDIT_PREEMPT, source, PUMP_REASON_NONE);
     }
 
-    if (!pumpGlobalEnabled) {
-        LOG_INFO("");
-        LOG_INFO("Pump trigger blocked - globally disabled");
-        return false;
+    start(source, durationSeconds);
+    return PUMP_GRANTED;
+}
+
+PumpRequestResult PumpChannel::reject(PumpSource source, PumpAuditReason reason,
+                                      uint16_t durationSeconds) {
+    metricsInc(MC_PUMP_ARBITER_REJECTED);
+    audit(PUMP_AUDIT_REJECT, source, owner, reason, durationSeconds);
+
+    LOG_WARNING("");
+    LOG_WARNING("Pump CH%d: %s request rejected (%s, owner %s)", channel,
+                getPumpSourceName(source), getPumpAuditReasonName(reason),
+                getPumpSourceName(owner));
+    return PUMP_REJECTED;
+}
+
+PumpRequestResult PumpChannel::enqueue(PumpSource source, uint16_t durationSeconds) {
+    if (queueCount >= PUMP_ARBITER_QUEUE_SIZE) {
+        return reject(source, PUMP_REASON_QUEUE_FULL, durationSeconds);
     }
-    
-    // TYLKO dla manual pump notify algorithm
-    if (actionType.startsWith("MANUAL")) {
-        if (!waterAlgorithm.requestManualPump(durationSeconds * 1000)) {
-            LOG_WARNING("");
-            LOG_WARNING("Algorithm rejected manual pump request");
-            return false;
-        }
+
+    // Za wszystkimi o priorytecie >= source - FIFO w obrębie priorytetu
+    uint8_t pos = queueCount;
+    while (pos > 0 && queue[pos - 1].source < source) {
+        queue[pos] = queue[pos - 1];
+        pos--;
     }
-    // Dla AUTO_PUMP nie wywołuj requestManualPump!
-    
-    digitalWrite(PUMP_RELAY_PIN, LOW);
-    pumpRunning = true;
-    pumpStartTime = millis();
-    pumpDuration = durationSeconds * 1000UL;
-    currentActionType = actionType;
-    
+    queue[pos].source = source;
+    queue[pos].durationSeconds = durationSeconds;
+    queue[pos].queuedAt = millis();
+    queueCount++;
+
+    metricsInc(MC_PUMP_ARBITER_QUEUED);
+    audit(PUMP_AUDIT_QUEUE, source, owner, PUMP_REASON_BUSY, durationSeconds);
+
     LOG_INFO("");
-    LOG_INFO("Pump started: %s for %d seconds", actionType.c_str(), durationSeconds);
-    return true;
+    LOG_INFO("Pump CH%d: %s for %ds queued behind %s (position %d/%d)", channel,
+             getPumpSourceName(source), durationSeconds, getPumpSourceName(owner),
+             pos + 1, queueCount);
+    return PUMP_QUEUED;
 }
 
-bool isPumpActive() {
-    return pumpRunning;
+void PumpChannel::removeQueued(uint8_t index) {
+    for (uint8_t i = index; i + 1 < queueCount; i++) {
+        queue[i] = queue[i + 1];
+    }
+    queueCount--;
 }
 
-uint32_t getPumpRemainingTime() {
-    if (!pumpRunning) return 0;
-    
-    unsigned long elapsed = millis() - pumpStartTime;
-    if (elapsed >= pumpDuration) return 0;
-    
-    return (pumpDuration - elapsed) / 1000;
+void PumpChannel::serviceQueue() {
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < queueCount; ) {
+        if (now - queue[i].queuedAt >= PUMP_ARBITER_QUEUE_TTL_MS) {
+            metricsInc(MC_PUMP_ARBITER_DROPPED);
+            audit(PUMP_AUDIT_DROP, queue[i].source, owner, PUMP_REASON_QUEUE_TTL,
+                  queue[i].durationSeconds);
+            LOG_WARNING("");
+            LOG_WARNING("Pump CH%d: queued %s request expired", channel,
+                        getPumpSourceName(queue[i].source));
+            removeQueued(i);
+        } else {
+            i++;
+        }
+    }
+
+    // Przekaźnik wolny - najwyższy priorytet z kolejki przechodzi pełny arbitraż
+    while (!isActive() && queueCount > 0) {
+        QueuedRequest next = queue[0];
+        removeQueued(0);
+        request(next.source, next.durationSeconds);
+    }
 }
 
-void stopPump() {
-    if (pumpRunning) {
-        digitalWrite(PUMP_RELAY_PIN, HIGH);
-        pumpRunning = false;
+void PumpChannel::start(PumpSource source, uint16_t durationSeconds) {
+    digitalWrite(relayPin, LOW);
+    startUs = esp_timer_get_time();
+    owner = source;
+    startTime = millis();
+    duration = durationSeconds * 1000UL;
+    cutoffFired = false;
+    timerCutoff = false;
+    if (cutoffTimer != nullptr) {
+        cutoffArmed = true;
+        esp_err_t err = esp_timer_start_once(cutoffTimer, (uint64_t)durationSeconds * 1000000ULL);
+        if (err == ESP_OK) {
+            timerCutoff = true;
+        } else {
+            cutoffArmed = false;
+            cutoffArmFailures++;
+            LOG_ERROR("");
+            LOG_ERROR("Pump CH%d: cutoff timer start failed (err %d) - tick-based stop for this run",
+                      channel, (int)err);
+        }
+    }
+    if (isManualSource(source)) {
+        manualSession = true;
+    }
 
-        // Calculate actual duration and volume
-        uint16_t actualDuration = (millis() - pumpStartTime) / 1000;
-        uint16_t volumeML = (uint16_t)round(actualDuration * currentPumpSettings.volumePerSecond);
+    metricsInc(START_COUNTERS[source]);
+    pumpUsageOnStart(channel, source);
+    if (channel == 0) {
+        traceBegin(TRACE_TRACK_PUMP, TRACE_NAMES[source]);
+    }
+    metricsSetGauge(MG_PUMP_RUNNING, 1);
+    audit(PUMP_AUDIT_GRANT, source, PUMP_SOURCE_NONE, PUMP_REASON_NONE, durationSeconds);
 
-        LOG_INFO("");
-        LOG_INFO("Pump manually stopped after %d seconds, estimated volume: %d ml",
-                 actualDuration, volumeML);
-
-        if (directPumpMode) {
-            directPumpMode = false;
-            LOG_INFO("Direct pump stopped via stopPump()");
-        } else if (currentActionType == "MANUAL_NORMAL") {
-            waterAlgorithm.addManualVolume(volumeML);
+    LOG_INFO("");
+    LOG_INFO("Pump CH%d started: %s for %d seconds", channel,
+             getPumpSourceName(source), durationSeconds);
+}
+
+// Wyłącza przekaźnik właściciela i rozlicza przebieg według źródła
+void PumpChannel::finish(PumpAuditAction action, PumpSource other, PumpAuditReason reason) {
+    PumpSource source = owner;
+    relayOff();
+    uint16_t actualDuration = (uint16_t)((lastRunUs + 500000UL) / 1000000UL);
+    uint16_t volumeML = getLastRunVolumeMl();
+    audit(action, source, other, reason, actualDuration);
+
+    LOG_INFO("");
+    LOG_INFO("Pump CH%d %s stopped (%s) after %lu.%03lu s, estimated volume: %d ml",
+             channel, getPumpSourceName(source), getPumpAuditActionName(action),
+             (unsigned long)(lastRunUs / 1000000UL), (unsigned long)((lastRunUs / 1000UL) % 1000UL),
+             volumeML);
+
+    if (source != PUMP_SOURCE_AUTO) {
+        getWaterChannel(channel).onOutOfCycleRefill(volumeML);
+    }
+
+    switch (source) {
+        case PUMP_SOURCE_MANUAL:
+            getWaterChannel(channel).addManualVolume(volumeML);
             LOG_INFO("");
-            LOG_INFO("MANUAL_NORMAL stopped early: %dml (available volume updated)", volumeML);
-        } else if (currentActionType == "MANUAL_EXTENDED") {
+            LOG_INFO("✅ MANUAL volume added to daily total: %dml", volumeML);
+            break;
+
+        case PUMP_SOURCE_CALIBRATION:
             LOG_INFO("");
-            LOG_INFO("MANUAL_EXTENDED (calibration) stopped - NOT added to volume");
-        }
+            LOG_INFO("ℹ️ CALIBRATION run - NOT added to daily volume");
+            break;
+
+        case PUMP_SOURCE_DIRECT:
+            if (action == PUMP_AUDIT_COMPLETE) {
+                LOG_INFO("");
+                LOG_INFO("Direct pump safety timeout reached - pump stopped");
+            }
+            break;
+
+        case PUMP_SOURCE_AUTO:
+            // Stop bezpieczeństwa zleca sam algorytm - powiadamiamy tylko o wywłaszczeniu
+            if (action == PUMP_AUDIT_PREEMPT) {
+                getWaterChannel(channel).onPumpPreempted(other);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
 
-        currentActionType = "";
+void PumpChannel::release(PumpSource source) {
+    settleCutoff();
+    if (owner != source) {
+        return;
     }
+
+    finish(PUMP_AUDIT_RELEASE, PUMP_SOURCE_NONE, PUMP_REASON_NONE);
 }
 
-bool directPumpOn(uint16_t durationSeconds) {
-    if (pumpRunning && !directPumpMode) {
-        LOG_WARNING("directPumpOn blocked — algorithm pump is running");
-        return false;
+void PumpChannel::stop(PumpAuditReason reason) {
+    settleCutoff();
+    while (queueCount > 0) {
+        metricsInc(MC_PUMP_ARBITER_DROPPED);
+        audit(PUMP_AUDIT_DROP, queue[0].source, PUMP_SOURCE_SAFETY, reason,
+              queue[0].durationSeconds);
+        removeQueued(0);
     }
-    if (pumpRunning && directPumpMode) {
-        // Already running in direct mode — ignore
-        return true;
+
+    if (isActive()) {
+        finish(PUMP_AUDIT_STOP, PUMP_SOURCE_SAFETY, reason);
     }
+}
 
-    directPumpMode = true;
-    digitalWrite(PUMP_RELAY_PIN, LOW);
-    pumpRunning = true;
-    pumpStartTime = millis();
-    pumpDuration = durationSeconds * 1000UL;
-    currentActionType = "DIRECT_MANUAL";
+uint32_t PumpChannel::getRemainingTime() const {
+    return getRemainingMs() / 1000;
+}
 
-    LOG_INFO("");
-    LOG_INFO("Direct pump ON for %d seconds", durationSeconds);
-    return true;
+uint32_t PumpChannel::getRemainingMs() const {
+    if (!isActive()) return 0;
+
+    unsigned long elapsed = millis() - startTime;
+    if (elapsed >= duration) return 0;
+
+    return duration - elapsed;
 }
 
-void directPumpOff() {
-    if (!pumpRunning || !directPumpMode) {
-        return;
+// ============== NAZWY / AUDYT (API) ==============
+
+const char* getPumpSourceName(PumpSource source) {
+    switch (source) {
+        case PUMP_SOURCE_AUTO: return "AUTO";
+        case PUMP_SOURCE_CALIBRATION: return "CALIBRATION";
+        case PUMP_SOURCE_MANUAL: return "MANUAL";
+        case PUMP_SOURCE_DIRECT: return "DIRECT";
+        case PUMP_SOURCE_SAFETY: return "SAFETY";
+        case PUMP_SOURCE_NONE: return "NONE";
+        default: return "UNKNOWN";
     }
+}
 
-    digitalWrite(PUMP_RELAY_PIN, HIGH);
-    pumpRunning = false;
-    directPumpMode = false;
-    currentActionType = "";
+const char* getPumpAuditActionName(PumpAuditAction action) {
+    switch (action) {
+        case PUMP_AUDIT_GRANT: return "GRANT";
+        case PUMP_AUDIT_QUEUE: return "QUEUE";
+        case PUMP_AUDIT_REJECT: return "REJECT";
+        case PUMP_AUDIT_PREEMPT: return "PREEMPT";
+        case PUMP_AUDIT_COMPLETE: return "COMPLETE";
+        case PUMP_AUDIT_RELEASE: return "RELEASE";
+        case PUMP_AUDIT_STOP: return "STOP";
+        case PUMP_AUDIT_DROP: return "DROP";
+        default: return "UNKNOWN";
+    }
+}
 
-    LOG_INFO("");
-    LOG_INFO("Direct pump stopped");
+const char* getPumpAuditReasonName(PumpAuditReason reason) {
+    switch (reason) {
+        case PUMP_REASON_NONE: return "NONE";
+        case PUMP_REASON_BUSY: return "BUSY";
+        case PUMP_REASON_GLOBAL_DISABLED: return "GLOBAL_DISABLED";
+        case PUMP_REASON_ALGORITHM_VETO: return "ALGORITHM_VETO";
+        case PUMP_REASON_QUEUE_FULL: return "QUEUE_FULL";
+        case PUMP_REASON_QUEUE_TTL: return "QUEUE_TTL";
+        case PUMP_REASON_STOP_REQUEST: return "STOP_REQUEST";
+        default: return "UNKNOWN";
+    }
+}
+
+const char* getPumpRequestResultName(PumpRequestResult result) {
+    switch (result) {
+        case PUMP_GRANTED: return "GRANTED";
+        case PUMP_QUEUED: return "QUEUED";
+        case PUMP_REJECTED: return "REJECTED";
+        default: return "UNKNOWN";
+    }
+}
+
+uint8_t copyPumpAudit(PumpAuditEntry* out, uint8_t maxCount) {
+    portENTER_CRITICAL(&auditMux);
+    uint8_t count = auditCount < maxCount ? auditCount : maxCount;
+    for (uint8_t n = 0; n < count; n++) {
+        out[n] = auditLog[(auditHead + PUMP_AUDIT_SIZE - 1 - n) % PUMP_AUDIT_SIZE];
+    }
+    portEXIT_CRITICAL(&auditMux);
+    return count;
+}
+
+uint32_t getPumpAuditTotal() {
+    return auditTotal;
+}
+
+// ============== API KANAŁU 0 / WSZYSTKICH KANAŁÓW ==============
+
+void initPumpController() {
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        pumpChannels[ch].init();
+    }
+}
+
+void updatePumpController() {
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        pumpChannels[ch].update();
+    }
+    pumpUsageTick(getCachedUnixTimestamp());
+}
+
+bool isPumpActive() {
+    return pumpChannels[0].isActive();
+}
+
+uint32_t getPumpRemainingTime() {
+    return pumpChannels[0].getRemainingTime();
+}
+
+uint32_t getPumpRemainingMs() {
+    return pumpChannels[0].getRemainingMs();
+}
+
+void stopPump() {
+    pumpChannels[0].stop();
+}
+
+bool directPumpOn(uint16_t durationSeconds) {
+    return pumpChannels[0].directOn(durationSeconds);
+}
+
+void directPumpOff() {
+    pumpChannels[0].directOff();
 }
 
 bool isDirectPumpMode() {
-    return directPumpMode;
-}
\ No newline at end of file
+    return pumpChannels[0].isDirectMode();
+}
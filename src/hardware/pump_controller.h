@@ -1,12 +1,166 @@
 #ifndef PUMP_CONTROLLER_H
 #define PUMP_CONTROLLER_H
 #include <Arduino.h>
+#include <esp_timer.h>
+
+// ============== PUMP ARBITER ==============
+// Przekaźnik ma jednego właściciela. Źródła zgłaszają typowane żądania,
+// wartość enuma = priorytet: wyższy wywłaszcza niższy, równy lub niższy
+// czeka w kolejce (tylko MANUAL/CALIBRATION) albo jest odrzucany.
+// Każda decyzja trafia do wspólnego dziennika audytu.
+
+#define PUMP_ARBITER_QUEUE_SIZE     2       // Oczekujące żądania na kanał
+#define PUMP_ARBITER_QUEUE_TTL_MS   60000   // Po tym czasie żądanie z kolejki przepada
+#define PUMP_AUDIT_SIZE             32      // Ostatnie decyzje arbitra dla API
+
+// Wyłączenie przekaźnika: jednorazowy esp_timer na dokładny termin, tick
+// control tylko rozlicza przebieg. Sprawdzanie millis() zostaje jako zabezpieczenie
+// (po terminie + margines) i jako jedyna ścieżka, gdy timer się nie utworzył
+// albo esp_timer_start_once() zawiódł dla danego przebiegu.
+#define PUMP_CUTOFF_GRACE_MS        50
+
+enum PumpSource : uint8_t {
+    PUMP_SOURCE_AUTO = 0,           // Cykl algorytmu
+    PUMP_SOURCE_CALIBRATION,        // Ręczny przebieg kalibracyjny - poza dzienną objętością
+    PUMP_SOURCE_MANUAL,             // Ręczna dawka - wlicza się do dziennej objętości
+    PUMP_SOURCE_DIRECT,             // Przycisk bezpośredni - omija algorytm i limity
+    PUMP_SOURCE_SAFETY,             // Stop - tylko wyłącza, zawsze wygrywa
+    PUMP_SOURCE_COUNT,
+
+    PUMP_SOURCE_NONE = 0xFF         // Przekaźnik wolny
+};
+
+enum PumpRequestResult : uint8_t {
+    PUMP_GRANTED = 0,
+    PUMP_QUEUED,
+    PUMP_REJECTED
+};
+
+enum PumpAuditAction : uint8_t {
+    PUMP_AUDIT_GRANT = 0,
+    PUMP_AUDIT_QUEUE,
+    PUMP_AUDIT_REJECT,
+    PUMP_AUDIT_PREEMPT,             // source = wywłaszczony, other = nowy właściciel
+    PUMP_AUDIT_COMPLETE,            // Czas pracy upłynął
+    PUMP_AUDIT_RELEASE,             // Właściciel zwolnił przed czasem (direct-off)
+    PUMP_AUDIT_STOP,                // Stop bezpieczeństwa
+    PUMP_AUDIT_DROP                 // Żądanie usunięte z kolejki
+};
+
+enum PumpAuditReason : uint8_t {
+    PUMP_REASON_NONE = 0,
+    PUMP_REASON_BUSY,               // Zajęty przez źródło o priorytecie >= żądania
+    PUMP_REASON_GLOBAL_DISABLED,
+    PUMP_REASON_ALGORITHM_VETO,     // requestManualPump() odmówił
+    PUMP_REASON_QUEUE_FULL,
+    PUMP_REASON_QUEUE_TTL,
+    PUMP_REASON_STOP_REQUEST
+};
+
+struct PumpAuditEntry {
+    uint32_t ms;
+    uint16_t durationSeconds;       // Żądany (GRANT/QUEUE) albo faktyczny czas pracy
+    uint8_t channel;
+    PumpSource source;
+    PumpSource other;               // Blokujący / wywłaszczający właściciel, NONE gdy brak
+    PumpAuditAction action;
+    PumpAuditReason reason;
+};
+
+// ============== PUMP CHANNEL ==============
+// Przekaźnik pompy jednego kanału (hardware_pins.h: CHANNEL_PUMP_PINS).
+// Funkcje globalne poniżej działają na kanale 0 - dotychczasowe API.
+class PumpChannel {
+public:
+    explicit PumpChannel(uint8_t channel);
+
+    void init();
+    void update();
+
+    // Jedyna droga do włączenia przekaźnika (wywołania tylko z zadania control)
+    PumpRequestResult request(PumpSource source, uint16_t durationSeconds);
+    void release(PumpSource source);
+    void stop(PumpAuditReason reason = PUMP_REASON_STOP_REQUEST);
+
+    bool isActive() const { return owner != PUMP_SOURCE_NONE; }
+    PumpSource getOwner() const { return owner; }
+    uint8_t getQueuedCount() const { return queueCount; }
+    uint32_t getRemainingTime() const;
+    uint32_t getRemainingMs() const;
+    bool hasCutoffTimer() const { return timerCutoff; }     // Bieżący/ostatni przebieg wyłączany timerem
+    uint32_t getCutoffArmFailures() const { return cutoffArmFailures; }
+
+    // Ostatni zakończony przebieg - czas pracy przekaźnika zmierzony w µs
+    PumpSource getLastRunSource() const { return lastRunSource; }
+    uint32_t getLastRunUs() const { return lastRunUs; }
+    uint16_t getLastRunVolumeMl() const { return volumeForUs(lastRunUs); }
+
+    bool directOn(uint16_t durationSeconds) { return request(PUMP_SOURCE_DIRECT, durationSeconds) == PUMP_GRANTED; }
+    void directOff() { release(PUMP_SOURCE_DIRECT); }
+    bool isDirectMode() const { return owner == PUMP_SOURCE_DIRECT; }
+
+    uint8_t getChannel() const { return channel; }
+
+private:
+    struct QueuedRequest {
+        PumpSource source;
+        uint16_t durationSeconds;
+        unsigned long queuedAt;
+    };
+
+    PumpRequestResult reject(PumpSource source, PumpAuditReason reason, uint16_t durationSeconds);
+    void start(PumpSource source, uint16_t durationSeconds);
+    void finish(PumpAuditAction action, PumpSource other, PumpAuditReason reason);
+    PumpRequestResult enqueue(PumpSource source, uint16_t durationSeconds);
+    void removeQueued(uint8_t index);
+    void serviceQueue();
+    void audit(PumpAuditAction action, PumpSource source, PumpSource other,
+               PumpAuditReason reason, uint16_t durationSeconds);
+    static void onCutoffTimer(void* arg);
+    void relayOff();
+    void settleCutoff();
+    void recordRunMetrics();
+    uint16_t volumeForUs(uint32_t onTimeUs) const;
+
+    uint8_t channel;
+    uint8_t relayPin;
+    PumpSource owner;
+    unsigned long startTime;
+    unsigned long duration;
+    int64_t startUs;
+
+    // Pisane z zadania esp_timer (wyższy priorytet niż control)
+    esp_timer_handle_t cutoffTimer;
+    volatile bool cutoffArmed;
+    volatile bool cutoffFired;
+    volatile int64_t cutoffUs;
+    bool timerCutoff;               // false = termin z ticka (brak timera / start nieudany)
+    uint32_t cutoffArmFailures;
+
+    PumpSource lastRunSource;
+    uint32_t lastRunUs;
+    bool manualSession;             // MANUAL/CALIBRATION - onManualPumpComplete() po opróżnieniu kolejki
+    QueuedRequest queue[PUMP_ARBITER_QUEUE_SIZE];   // Malejący priorytet, FIFO w obrębie
+    uint8_t queueCount;
+};
+
+PumpChannel& getPumpChannel(uint8_t channel);
+bool isAnyPumpActive();
+
+const char* getPumpSourceName(PumpSource source);
+const char* getPumpAuditActionName(PumpAuditAction action);
+const char* getPumpAuditReasonName(PumpAuditReason reason);
+const char* getPumpRequestResultName(PumpRequestResult result);
+
+// Dziennik audytu wszystkich kanałów (czytany z async_tcp)
+uint8_t copyPumpAudit(PumpAuditEntry* out, uint8_t maxCount);   // Od najnowszego
+uint32_t getPumpAuditTotal();
 
 void initPumpController();
 void updatePumpController();
-bool triggerPump(uint16_t durationSeconds, const String& actionType);
 bool isPumpActive();
 uint32_t getPumpRemainingTime();
+uint32_t getPumpRemainingMs();      // Do planowania dokładnego wyłączenia
 void stopPump();
 
 // Direct pump control — bypasses algorithm, system disable and daily limit
@@ -14,4 +168,4 @@ bool directPumpOn(uint16_t durationSeconds);
 void directPumpOff();
 bool isDirectPumpMode();
 
-#endif
\ No newline at end of file
+#endif
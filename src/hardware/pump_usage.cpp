@@ -0,0 +1,241 @@
+#include "pump_usage.h"
+#include "hardware_pins.h"
+#include "fram_controller.h"
+#include "storage_queue.h"
+#include "rtc_controller.h"
+#include "../core/logging.h"
+#include "../core/metrics.h"
+#include <freertos/FreeRTOS.h>
+
+// Zapisywany w FRAM (FRAM_ADDR_PUMP_USAGE + kanał * FRAM_PUMP_USAGE_SLOT_SIZE)
+struct PumpUsageRecord {
+    uint32_t onMs[PUMP_USAGE_SOURCES];
+    uint32_t starts[PUMP_USAGE_SOURCES];
+    uint32_t longestRunMs;
+    uint32_t sinceUnix;
+    uint8_t longestRunSource;
+    uint8_t reserved[3];
+};
+
+// Zapisywany w FRAM (slot kanału + FRAM_PUMP_DUTY_OFFSET)
+struct PumpDutyRecord {
+    uint32_t day;                   // Dzień UTC onMs[0], 0 = pusty
+    uint32_t onMs[PUMP_DUTY_DAYS];
+};
+
+static_assert(sizeof(PumpUsageRecord) + FRAM_RECORD_OVERHEAD <= FRAM_PUMP_DUTY_OFFSET,
+              "PumpUsageRecord does not fit its FRAM slot");
+static_assert(FRAM_PUMP_DUTY_OFFSET + sizeof(PumpDutyRecord) + FRAM_RECORD_OVERHEAD <= FRAM_PUMP_USAGE_SLOT_SIZE,
+              "PumpDutyRecord does not fit its FRAM slot");
+static_assert(WATER_CHANNEL_MAX <= FRAM_PUMP_USAGE_CHANNELS, "FRAM_ADDR_PUMP_USAGE has no slot for every channel");
+
+static PumpUsageRecord usage[WATER_CHANNEL_COUNT];
+static PumpDutyRecord duty[WATER_CHANNEL_COUNT];
+static portMUX_TYPE usageMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t lastTickDay = 0;
+
+static uint16_t usageAddr(uint8_t channel) {
+    return FRAM_ADDR_PUMP_USAGE + channel * FRAM_PUMP_USAGE_SLOT_SIZE;
+}
+
+static uint16_t dutyAddr(uint8_t channel) {
+    return usageAddr(channel) + FRAM_PUMP_DUTY_OFFSET;
+}
+
+// Ring tak, by onMs[0] = day; dni bez pracy = 0. Czas cofnięty - bez zmian.
+static bool rollDuty(PumpDutyRecord& d, uint32_t day) {
+    if (d.day == day) {
+        return true;
+    }
+    if (d.day > day) {
+        return false;               // Korekta RTC wstecz
+    }
+
+    uint32_t shift = day - d.day;
+    for (int8_t i = PUMP_DUTY_DAYS - 1; i >= 0; i--) {
+        d.onMs[i] = (uint32_t)i >= shift ? d.onMs[i - shift] : 0;
+    }
+    d.day = day;
+    return true;
+}
+
+// Gauge /metrics - kanał 0, jak pozostałe modele
+static void publishGauges() {
+    const PumpUsageRecord& u = usage[0];
+    uint32_t starts = 0;
+    for (uint8_t s = 0; s < PUMP_USAGE_SOURCES; s++) {
+        metricsSetGauge((MetricGauge)(MG_PUMP_LIFETIME_ON_AUTO + s), u.onMs[s] / 1000);
+        starts += u.starts[s];
+    }
+    metricsSetGauge(MG_PUMP_LIFETIME_STARTS, starts);
+    metricsSetGauge(MG_PUMP_LONGEST_RUN_MS, u.longestRunMs);
+    metricsSetGauge(MG_PUMP_ON_TODAY_SECONDS, duty[0].onMs[0] / 1000);
+    metricsSetGauge(MG_PUMP_DUTY_YESTERDAY_PERMILLE, duty[0].onMs[1] / 86400);
+}
+
+static void saveUsage(uint8_t channel) {
+    queueRecordSave(usageAddr(channel), &usage[channel], sizeof(PumpUsageRecord));
+}
+
+static void saveDuty(uint8_t channel) {
+    queueRecordSave(dutyAddr(channel), &duty[channel], sizeof(PumpDutyRecord));
+}
+
+void initPumpUsage() {
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        if (!loadRecordFromFRAM(usageAddr(ch), &usage[ch], sizeof(PumpUsageRecord))) {
+            memset(&usage[ch], 0, sizeof(PumpUsageRecord));
+            usage[ch].longestRunSource = PUMP_SOURCE_NONE;
+        }
+        if (!loadRecordFromFRAM(dutyAddr(ch), &duty[ch], sizeof(PumpDutyRecord))) {
+            memset(&duty[ch], 0, sizeof(PumpDutyRecord));
+        }
+
+        uint64_t totalMs = 0;
+        uint32_t starts = 0;
+        for (uint8_t s = 0; s < PUMP_USAGE_SOURCES; s++) {
+            totalMs += usage[ch].onMs[s];
+            starts += usage[ch].starts[s];
+        }
+        LOG_INFO("");
+        LOG_INFO("Pump usage CH%d: %lu starts, %lu s on-time, longest run %lu ms",
+                 ch, (unsigned long)starts, (unsigned long)(totalMs / 1000),
+                 (unsigned long)usage[ch].longestRunMs);
+    }
+    publishGauges();
+}
+
+void pumpUsageOnStart(uint8_t channel, PumpSource source) {
+    if (channel >= WATER_CHANNEL_COUNT || source >= PUMP_USAGE_SOURCES) {
+        return;
+    }
+
+    portENTER_CRITICAL(&usageMux);
+    usage[channel].starts[source]++;
+    portEXIT_CRITICAL(&usageMux);
+}
+
+void pumpUsageOnStop(uint8_t channel, PumpSource source, uint32_t onTimeUs) {
+    if (channel >= WATER_CHANNEL_COUNT || source >= PUMP_USAGE_SOURCES) {
+        return;
+    }
+
+    uint32_t runMs = onTimeUs / 1000;
+    uint32_t nowUnix = getCachedUnixTimestamp();
+    bool timeValid = isUnixTimeValid(nowUnix);
+    PumpUsageRecord& u = usage[channel];
+    PumpDutyRecord& d = duty[channel];
+
+    portENTER_CRITICAL(&usageMux);
+    u.onMs[source] += runMs;
+    if (runMs > u.longestRunMs) {
+        u.longestRunMs = runMs;
+        u.longestRunSource = source;
+    }
+    if (u.sinceUnix == 0 && timeValid) {
+        u.sinceUnix = nowUnix;
+    }
+
+    // Przebieg przez północ dzielony między dni (przebiegi < doby)
+    bool dutyChanged = timeValid && rollDuty(d, nowUnix / 86400);
+    if (dutyChanged) {
+        uint32_t msToday = (nowUnix % 86400) * 1000UL;
+        if (runMs <= msToday) {
+            d.onMs[0] += runMs;
+        } else {
+            d.onMs[0] += msToday;
+            d.onMs[1] += runMs - msToday;
+        }
+    }
+    portEXIT_CRITICAL(&usageMux);
+
+    saveUsage(channel);
+    if (dutyChanged) {
+        saveDuty(channel);
+    }
+    if (channel == 0) {
+        publishGauges();
+    }
+}
+
+// Zadanie control: przejście doby bez pracy pompy zeruje "dziś" w gauge
+void pumpUsageTick(uint32_t nowUnix) {
+    if (!isUnixTimeValid(nowUnix) || nowUnix / 86400 == lastTickDay) {
+        return;
+    }
+    lastTickDay = nowUnix / 86400;
+
+    portENTER_CRITICAL(&usageMux);
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        rollDuty(duty[ch], lastTickDay);
+    }
+    portEXIT_CRITICAL(&usageMux);
+    publishGauges();
+}
+
+void resetPumpUsage(uint8_t channel) {
+    if (channel >= WATER_CHANNEL_COUNT) {
+        return;
+    }
+
+    uint32_t nowUnix = getCachedUnixTimestamp();
+    portENTER_CRITICAL(&usageMux);
+    memset(&usage[channel], 0, sizeof(PumpUsageRecord));
+    usage[channel].longestRunSource = PUMP_SOURCE_NONE;
+    usage[channel].sinceUnix = isUnixTimeValid(nowUnix) ? nowUnix : 0;
+    memset(&duty[channel], 0, sizeof(PumpDutyRecord));
+    portEXIT_CRITICAL(&usageMux);
+
+    saveUsage(channel);
+    saveDuty(channel);
+    if (channel == 0) {
+        publishGauges();
+    }
+
+    LOG_INFO("");
+    LOG_INFO("Pump usage CH%d reset (pump replaced)", channel);
+}
+
+PumpUsageStats getPumpUsage(uint8_t channel) {
+    PumpUsageStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.longestRunSource = PUMP_SOURCE_NONE;
+    if (channel >= WATER_CHANNEL_COUNT) {
+        return stats;
+    }
+
+    uint32_t nowUnix = getCachedUnixTimestamp();
+    portENTER_CRITICAL(&usageMux);
+    PumpUsageRecord u = usage[channel];
+    PumpDutyRecord d = duty[channel];
+    portEXIT_CRITICAL(&usageMux);
+
+    for (uint8_t s = 0; s < PUMP_USAGE_SOURCES; s++) {
+        stats.onMs[s] = u.onMs[s];
+        stats.starts[s] = u.starts[s];
+        stats.totalOnMs += u.onMs[s];
+        stats.totalStarts += u.starts[s];
+    }
+    stats.longestRunMs = u.longestRunMs;
+    stats.longestRunSource = (PumpSource)u.longestRunSource;
+    stats.sinceUnix = u.sinceUnix;
+
+    // Kopia przesunięta na dziś - dni bez pracy od ostatniego przebiegu = 0
+    stats.dutyValid = isUnixTimeValid(nowUnix) && rollDuty(d, nowUnix / 86400);
+    stats.dutyDay = d.day;
+    memcpy(stats.dutyOnMs, d.onMs, sizeof(stats.dutyOnMs));
+    return stats;
+}
+
+// Dziś - udział w dotychczasowej części doby, dni wcześniejsze - w pełnej dobie
+uint16_t getPumpDutyPermille(const PumpUsageStats& stats, uint8_t dayIndex, uint32_t nowUnix) {
+    if (!stats.dutyValid || dayIndex >= PUMP_DUTY_DAYS) {
+        return 0;
+    }
+    uint32_t spanMs = dayIndex == 0 ? (nowUnix % 86400) * 1000UL : 86400000UL;
+    if (spanMs == 0) {
+        return 0;
+    }
+    uint32_t permille = (uint32_t)((uint64_t)stats.dutyOnMs[dayIndex] * 1000 / spanMs);
+    return permille > 1000 ? 1000 : permille;
+}
@@ -0,0 +1,43 @@
+#ifndef PUMP_USAGE_H
+#define PUMP_USAGE_H
+
+#include <Arduino.h>
+#include "pump_controller.h"
+
+// ============== PUMP USAGE ==============
+// Licznik eksploatacji pompy każdego kanału - wymiana wg faktycznej pracy
+// zamiast kalendarza. Aktualizowany przy przejściach przekaźnika: start
+// liczy uruchomienie, koniec dodaje zmierzony czas pracy (per źródło),
+// najdłuższy przebieg i czas pracy dnia UTC. Do FRAM raz na zakończony
+// przebieg: rekord sum i ring dni (FRAM_ADDR_PUMP_USAGE) przez kolejkę
+// storage. Przebieg przerwany restartem nie jest liczony.
+
+#define PUMP_DUTY_DAYS              7       // Dni UTC w ringu, [0] = dziś
+#define PUMP_USAGE_SOURCES          PUMP_SOURCE_SAFETY  // AUTO..DIRECT - SAFETY nie włącza przekaźnika
+
+struct PumpUsageStats {
+    uint32_t onMs[PUMP_USAGE_SOURCES];      // uint32 ms = 49 dni czystej pracy na źródło
+    uint32_t starts[PUMP_USAGE_SOURCES];
+    uint64_t totalOnMs;
+    uint32_t totalStarts;
+    uint32_t longestRunMs;
+    PumpSource longestRunSource;
+    uint32_t sinceUnix;                     // Pierwszy start / reset z ważnym czasem, 0 = nieznany
+    bool dutyValid;                         // Czas RTC ważny - ring dni aktualny
+    uint32_t dutyDay;                       // Dzień UTC dutyOnMs[0]
+    uint32_t dutyOnMs[PUMP_DUTY_DAYS];
+};
+
+void initPumpUsage();                       // Po initFRAM(), przed pierwszym startem pompy
+
+// Zadanie control (PumpChannel)
+void pumpUsageOnStart(uint8_t channel, PumpSource source);
+void pumpUsageOnStop(uint8_t channel, PumpSource source, uint32_t onTimeUs);
+void pumpUsageTick(uint32_t nowUnix);       // Przejście doby UTC bez pracy pompy
+void resetPumpUsage(uint8_t channel);       // Po wymianie pompy
+
+// Dowolne zadanie: kopia z ringiem dni przesuniętym na bieżący dzień
+PumpUsageStats getPumpUsage(uint8_t channel);
+uint16_t getPumpDutyPermille(const PumpUsageStats& stats, uint8_t dayIndex, uint32_t nowUnix);
+
+#endif
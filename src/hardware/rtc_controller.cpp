@@ -6,6 +6,10 @@
 #include <WiFi.h>
 #include <time.h>
 #include "../network/wifi_manager.h"
+#include "../core/metrics.h"
+#include "../core/trace.h"
+#include "i2c_bus.h"
+#include <freertos/FreeRTOS.h>
 
 
 // ===============================
@@ -41,6 +45,15 @@ struct {
     unsigned long lastUpdate = 0;
 } internalTime;
 
+// Odczyt DS3231 z pomiarem czasu (I2C) do /metrics
+static DateTime rtcNow() {
+    I2CBusLock busLock;
+    MetricTimer timer(MH_RTC_READ_US);
+    TRACE_SCOPE(TRACE_TRACK_I2C, "rtc_read");
+    metricsInc(MC_RTC_READS);
+    return rtc.now();
+}
+
 // NTP sync tracking
 unsigned long lastNTPSync = 0;
 const unsigned long NTP_SYNC_INTERVAL = 3600000;  // 1 hour
@@ -123,7 +136,7 @@ bool syncTimeFromNTP() {
     
     while (attempts < 40) {  // 40 * 500ms = 20 seconds
         time(&now);
-        if (now > 1600000000) {  // Sprawdź czy timestamp jest sensowny (after 2020)
+        if (isUnixTimeValid((uint32_t)now)) {  // Sprawdź czy timestamp jest sensowny (after 2020)
             localtime_r(&now, &timeinfo);  // ✅ Automatyczna konwersja na lokalny czas
             
             char timeStr[64];
@@ -160,10 +173,13 @@ bool setRTCFromNTP() {
     LOG_INFO("NTP returned UTC timestamp: %lu", (unsigned long)ntp_time);
     
     // ✅ Zapisz UTC BEZPOŚREDNIO do RTC (bez żadnych offsetów)
-    rtc.adjust(DateTime(ntp_time));
+    {
+        I2CBusLock busLock;
+        rtc.adjust(DateTime(ntp_time));
+    }
     
     // Weryfikacja z konwersją na lokalny czas dla loga
-    DateTime rtc_utc = rtc.now();
+    DateTime rtc_utc = rtcNow();
     time_t rtc_timestamp = rtc_utc.unixtime();
     struct tm local_time;
     localtime_r(&rtc_timestamp, &local_time);
@@ -247,7 +263,7 @@ void initializeRTC() {
             }
             
             // Weryfikacja czasu RTC
-            DateTime now = rtc.now();
+            DateTime now = rtcNow();
             DateTime compileTime = DateTime(F(__DATE__), F(__TIME__));
             
             LOG_INFO("RTC current time (UTC): %04d-%02d-%02d %02d:%02d:%02d", 
@@ -355,7 +371,7 @@ String getCurrentTimestamp() {
     bool validRead = false;
     
     for (int retry = 0; retry < MAX_RETRIES; retry++) {
-        now = rtc.now();
+        now = rtcNow();
         
         if (now.year() >= 2024 && now.year() <= 2030) {
             validRead = true;
@@ -372,6 +388,7 @@ String getCurrentTimestamp() {
     }
     
     if (!validRead) {
+        metricsInc(MC_RTC_READ_FAILURES);
         static uint32_t lastError = 0;
         if (millis() - lastError > 10000) {
             LOG_ERROR("RTC read failed after %d retries", MAX_RETRIES);
@@ -424,7 +441,7 @@ unsigned long getUnixTimestamp() {
         bool validRead = false;
         
         for (int retry = 0; retry < MAX_RETRIES; retry++) {
-            now = rtc.now();
+            now = rtcNow();
             
             // ✅ Walidacja roku
             if (now.year() >= 2024 && now.year() <= 2035) {
@@ -438,6 +455,7 @@ unsigned long getUnixTimestamp() {
         }
         
         if (!validRead) {
+            metricsInc(MC_RTC_READ_FAILURES);
             static uint32_t lastError = 0;
             if (millis() - lastError > 10000) {
                 LOG_ERROR("RTC read failed in getUnixTimestamp(), year: %d", now.year());
@@ -459,11 +477,58 @@ bool isRTCWorking() {
     if (useInternalRTC) {
         return true;  // Internal RTC zawsze "działa"
     } else {
-        DateTime now = rtc.now();
+        DateTime now = rtcNow();
         return (now.year() >= 2020 && now.year() <= 2035);
     }
 }
 
+// ===============================
+// CACHED TIME (storage task)
+// ===============================
+// Zadanie storage odczytuje DS3231 raz na sekundę; ścieżka sterowania
+// korzysta z kopii i ekstrapoluje ją millis(), więc wolne I2C jej nie blokuje.
+
+static portMUX_TYPE rtcCacheMux = portMUX_INITIALIZER_UNLOCKED;
+static unsigned long cachedUnixTime = 0;
+static uint32_t cachedAtMs = 0;
+static bool cachedWorking = false;
+static bool cacheFilled = false;
+
+void refreshRTCCache() {
+    bool working = isRTCWorking();
+    unsigned long unixTime = working ? getUnixTimestamp() : 0;
+    uint32_t nowMs = millis();
+
+    portENTER_CRITICAL(&rtcCacheMux);
+    cachedWorking = working;
+    if (working) {
+        cachedUnixTime = unixTime;
+        cachedAtMs = nowMs;
+    }
+    cacheFilled = true;
+    portEXIT_CRITICAL(&rtcCacheMux);
+}
+
+bool isRTCWorkingCached() {
+    if (!cacheFilled) {
+        return isRTCWorking();      // Przed startem zadania storage (setup)
+    }
+    return cachedWorking;
+}
+
+unsigned long getCachedUnixTimestamp() {
+    if (!cacheFilled || cachedAtMs == 0) {
+        return getUnixTimestamp();
+    }
+
+    portENTER_CRITICAL(&rtcCacheMux);
+    unsigned long unixTime = cachedUnixTime;
+    uint32_t atMs = cachedAtMs;
+    portEXIT_CRITICAL(&rtcCacheMux);
+
+    return unixTime + (millis() - atMs) / 1000;
+}
+
 String getRTCInfo() {
 
     if (!rtcInitialized) {
@@ -3,12 +3,25 @@
 
 #include <Arduino.h>
 
+#define RTC_MIN_VALID_UNIX  1600000000UL    // 2020-09-13 - wcześniejszy znacznik = RTC nieustawiony
+
+// Znacznik sprzed ustawienia RTC = brak czasu (nie liczy się do historii, dób, przerw)
+inline bool isUnixTimeValid(uint32_t t) {
+    return t >= RTC_MIN_VALID_UNIX;
+}
+
 void initializeRTC();
+void configureTimezone();       // Idempotentne - przed pierwszym localtime_r()
 String getCurrentTimestamp();
 bool isRTCWorking();
 unsigned long getUnixTimestamp();
 String getRTCInfo();
 
+// Kopia czasu odświeżana przez zadanie storage (bez I2C w ścieżce sterowania)
+void refreshRTCCache();
+bool isRTCWorkingCached();
+unsigned long getCachedUnixTimestamp();
+
 String getTimeSourceInfo();
 bool isRTCHardware();
 
@@ -0,0 +1,255 @@
+#include "sensor_edges.h"
+#include "sensor_filter.h"
+#include "../core/logging.h"
+#include "../core/metrics.h"
+#include "../core/power_manager.h"
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+
+static_assert((SENSOR_EDGE_RING_SIZE & (SENSOR_EDGE_RING_SIZE - 1)) == 0,
+              "SENSOR_EDGE_RING_SIZE must be a power of two");
+
+static const uint8_t SENSOR_PINS[] = CHANNEL_SENSOR_PINS;
+
+// ============== RING (ISR -> control) ==============
+// Jeden producent (ISR), jeden konsument (control). Każdy indeks ma jednego
+// pisarza, więc wystarczą volatile i zwykłe 32-bitowe zapisy - bez
+// std::atomic (RMW na ESP32-C3 idą przez emulację libatomic). Slot i indeks
+// ISR publikuje w portENTER_CRITICAL_ISR: przerwania pinów mogą się zagnieżdżać.
+static SensorEdge ring[SENSOR_EDGE_RING_SIZE];
+static volatile uint32_t ringHead = 0;          // Pisze tylko ISR
+static volatile uint32_t ringTail = 0;          // Pisze tylko konsument
+static volatile uint32_t ringDropped = 0;       // Pisze tylko ISR
+static portMUX_TYPE ringMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool levelWakeMode = false;
+
+// ============== STAN KONSUMENTA ==============
+static SensorEdgeStats stats[WATER_SENSOR_TOTAL];
+static bool firstLowPending[WATER_SENSOR_TOTAL];
+static uint32_t firstLowUs[WATER_SENSOR_TOTAL];
+static uint32_t droppedSeen = 0;
+
+// Historia czytana z async_tcp - krótka sekcja krytyczna przy kopiowaniu
+static portMUX_TYPE historyMux = portMUX_INITIALIZER_UNLOCKED;
+static SensorEdge history[SENSOR_EDGE_HISTORY];
+static uint8_t historyHead = 0;
+static uint8_t historyCount = 0;
+
+static void IRAM_ATTR onSensorEdge(void* arg) {
+    uint8_t sensor = (uint8_t)(uintptr_t)arg;
+    uint8_t level = gpio_get_level((gpio_num_t)SENSOR_PINS[sensor]) == 0 ? 1 : 0;
+
+    uint32_t timestampUs = (uint32_t)esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&ringMux);
+    uint32_t head = ringHead;
+    if (head - ringTail >= SENSOR_EDGE_RING_SIZE) {
+        ringDropped = ringDropped + 1;
+    } else {
+        SensorEdge& slot = ring[head & (SENSOR_EDGE_RING_SIZE - 1)];
+        slot.timestampUs = timestampUs;
+        slot.sensor = sensor;
+        slot.level = level;
+        ringHead = head + 1;     // Publikacja po zapisie slotu (sekcja krytyczna = bariera)
+    }
+    portEXIT_CRITICAL_ISR(&ringMux);
+
+    if (levelWakeMode) {
+        // Przerwanie poziomem LOW - wyłącz, inaczej trzymany pływak zalałby CPU
+        for (uint8_t i = 0; i < WATER_SENSOR_TOTAL; i++) {
+            gpio_intr_disable((gpio_num_t)SENSOR_PINS[i]);
+        }
+        powerSignalGpioWakeFromISR();
+    } else if (level) {
+        // Zbocze HIGH->LOW: obudź control od razu zamiast czekać na tick
+        powerSignalGpioWakeFromISR();
+    }
+}
+
+static void recordEdge(const SensorEdge& edge) {
+    SensorEdgeStats& s = stats[edge.sensor];
+    bool wasLow = s.low;
+
+    if (s.edges > 0) {
+        uint32_t interval = edge.timestampUs - s.lastEdgeUs;
+        if (interval < s.minIntervalUs) {
+            s.minIntervalUs = interval;
+        }
+        if (interval < SENSOR_BOUNCE_WINDOW_US) {
+            s.bounces++;
+            metricsInc(MC_SENSOR_BOUNCES);
+        }
+    }
+    s.edges++;
+    s.lastEdgeUs = edge.timestampUs;
+    s.low = edge.level != 0;
+    metricsInc(MC_SENSOR_EDGES);
+
+    if (s.low && !wasLow && !firstLowPending[edge.sensor]) {
+        firstLowPending[edge.sensor] = true;
+        firstLowUs[edge.sensor] = edge.timestampUs;
+    }
+
+    portENTER_CRITICAL(&historyMux);
+    history[historyHead] = edge;
+    historyHead = (historyHead + 1) % SENSOR_EDGE_HISTORY;
+    if (historyCount < SENSOR_EDGE_HISTORY) {
+        historyCount++;
+    }
+    portEXIT_CRITICAL(&historyMux);
+}
+
+// Po zgubionych zboczach lub po trybie wybudzania poziomem stan z ringu
+// może być nieaktualny - dopisz syntetyczne zbocze z bieżącego odczytu pinu.
+static void resyncSensorLevels() {
+    for (uint8_t i = 0; i < WATER_SENSOR_TOTAL; i++) {
+        bool low = digitalRead(SENSOR_PINS[i]) == LOW;
+        if (low != stats[i].low) {
+            SensorEdge edge;
+            edge.timestampUs = (uint32_t)esp_timer_get_time();
+            edge.sensor = i;
+            edge.level = low ? 1 : 0;
+            recordEdge(edge);
+        }
+    }
+}
+
+void initSensorEdgeCapture() {
+    memset(stats, 0, sizeof(stats));
+    memset(firstLowPending, 0, sizeof(firstLowPending));
+    ringHead = 0;
+    ringTail = 0;
+    ringDropped = 0;
+    droppedSeen = 0;
+
+    for (uint8_t i = 0; i < WATER_SENSOR_TOTAL; i++) {
+        stats[i].low = digitalRead(SENSOR_PINS[i]) == LOW;
+        stats[i].minIntervalUs = UINT32_MAX;
+        attachInterruptArg(SENSOR_PINS[i], onSensorEdge, (void*)(uintptr_t)i, CHANGE);
+    }
+
+    LOG_INFO("");
+    LOG_INFO("Sensor edge capture: %d pins, ring %d, bounce window %dus",
+             WATER_SENSOR_TOTAL, SENSOR_EDGE_RING_SIZE, SENSOR_BOUNCE_WINDOW_US);
+}
+
+uint8_t drainSensorEdges() {
+    uint8_t processed = 0;
+    uint32_t tail = ringTail;
+    uint32_t head = ringHead;
+    __asm__ __volatile__("" ::: "memory");         // Sloty czytane po indeksie ISR
+
+    while (tail != head) {
+        SensorEdge edge = ring[tail & (SENSOR_EDGE_RING_SIZE - 1)];
+        tail++;
+        __asm__ __volatile__("" ::: "memory");     // Slot odczytany przed zwolnieniem
+        ringTail = tail;
+        recordEdge(edge);
+        processed++;
+    }
+
+    uint32_t dropped = ringDropped;
+    if (dropped != droppedSeen) {
+        metricsInc(MC_SENSOR_EDGES_DROPPED, dropped - droppedSeen);
+        LOG_WARNING("Sensor edge ring overflow: %lu edges dropped, resyncing levels",
+                    dropped - droppedSeen);
+        droppedSeen = dropped;
+        resyncSensorLevels();
+    }
+    return processed;
+}
+
+bool isSensorLow(uint8_t sensor) {
+    return sensor < WATER_SENSOR_TOTAL && stats[sensor].low;
+}
+
+bool takeSensorFirstLow(uint8_t sensor, uint32_t* timestampUs) {
+    if (sensor >= WATER_SENSOR_TOTAL || !firstLowPending[sensor]) {
+        return false;
+    }
+    firstLowPending[sensor] = false;
+    if (timestampUs) {
+        *timestampUs = firstLowUs[sensor];
+    }
+    return true;
+}
+
+uint32_t getSensorBouncesSince(uint8_t sensor, uint32_t sinceUs) {
+    uint32_t count = 0;
+    uint32_t prevUs = 0;
+    bool havePrev = false;
+
+    // Historia od najstarszego
+    portENTER_CRITICAL(&historyMux);
+    uint8_t start = (historyHead + SENSOR_EDGE_HISTORY - historyCount) % SENSOR_EDGE_HISTORY;
+    for (uint8_t n = 0; n < historyCount; n++) {
+        const SensorEdge& e = history[(start + n) % SENSOR_EDGE_HISTORY];
+        if (e.sensor != sensor || (int32_t)(e.timestampUs - sinceUs) < 0) {
+            continue;
+        }
+        if (havePrev && e.timestampUs - prevUs < SENSOR_BOUNCE_WINDOW_US) {
+            count++;
+        }
+        prevUs = e.timestampUs;
+        havePrev = true;
+    }
+    portEXIT_CRITICAL(&historyMux);
+    return count;
+}
+
+SensorEdgeStats getSensorEdgeStats(uint8_t sensor) {
+    SensorEdgeStats s;
+    memset(&s, 0, sizeof(s));
+    if (sensor < WATER_SENSOR_TOTAL) {
+        s = stats[sensor];
+    }
+    return s;
+}
+
+uint8_t copySensorEdgeHistory(SensorEdge* out, uint8_t maxCount) {
+    portENTER_CRITICAL(&historyMux);
+    uint8_t count = historyCount < maxCount ? historyCount : maxCount;
+    for (uint8_t n = 0; n < count; n++) {
+        out[n] = history[(historyHead + SENSOR_EDGE_HISTORY - 1 - n) % SENSOR_EDGE_HISTORY];
+    }
+    portEXIT_CRITICAL(&historyMux);
+    return count;
+}
+
+uint32_t getSensorEdgesDropped() {
+    return ringDropped;
+}
+
+void setSensorLevelWake(bool enabled) {
+    if (enabled == levelWakeMode) {
+        return;
+    }
+
+    if (enabled) {
+        // W spoczynku bez timera 1 kHz - control budzi dopiero poziom LOW
+        setSensorSampling(false);
+        levelWakeMode = true;
+        for (uint8_t i = 0; i < WATER_SENSOR_TOTAL; i++) {
+            gpio_set_intr_type((gpio_num_t)SENSOR_PINS[i], GPIO_INTR_LOW_LEVEL);
+            gpio_intr_enable((gpio_num_t)SENSOR_PINS[i]);
+        }
+        return;
+    }
+
+    for (uint8_t i = 0; i < WATER_SENSOR_TOTAL; i++) {
+        gpio_intr_disable((gpio_num_t)SENSOR_PINS[i]);
+        gpio_set_intr_type((gpio_num_t)SENSOR_PINS[i], GPIO_INTR_ANYEDGE);
+    }
+    levelWakeMode = false;
+    for (uint8_t i = 0; i < WATER_SENSOR_TOTAL; i++) {
+        gpio_intr_enable((gpio_num_t)SENSOR_PINS[i]);
+    }
+
+    // W trybie poziomu przerwanie wyłącza się po pierwszym LOW - dalsze zbocza
+    // mogły przepaść
+    drainSensorEdges();
+    resyncSensorLevels();
+    setSensorSampling(true);
+}
@@ -0,0 +1,49 @@
+#ifndef SENSOR_EDGES_H
+#define SENSOR_EDGES_H
+
+#include <Arduino.h>
+#include "hardware_pins.h"
+
+// ============== SENSOR EDGE CAPTURE ==============
+// Przerwanie CHANGE na pinach pływaków zapisuje każde zbocze ze znacznikiem
+// µs do bufora kołowego SPSC (producent = ISR, konsument = zadanie control)
+// i budzi control - wykrycie pierwszego LOW nie czeka na kolejny tick.
+// Konsument utrzymuje bieżący poziom, statystyki drgań i krótką historię
+// do diagnostyki (/api/sensor-edges).
+
+#define SENSOR_EDGE_RING_SIZE       64      // Potęga dwójki
+#define SENSOR_EDGE_HISTORY         32      // Ostatnie zbocza dla API
+#define SENSOR_BOUNCE_WINDOW_US     50000   // Zbocze < 50 ms po poprzednim = drganie
+
+struct SensorEdge {
+    uint32_t timestampUs;       // esp_timer (zawija się co ~71 min)
+    uint8_t sensor;             // 0 .. WATER_SENSOR_TOTAL-1 (kanał * WATER_SENSOR_COUNT + czujnik)
+    uint8_t level;              // 1 = LOW (woda poniżej progu), 0 = HIGH
+};
+
+struct SensorEdgeStats {
+    uint32_t edges;
+    uint32_t bounces;               // Zbocza w oknie SENSOR_BOUNCE_WINDOW_US
+    uint32_t lastEdgeUs;
+    uint32_t minIntervalUs;         // Najkrótszy odstęp między zboczami
+    bool low;                       // Bieżący poziom wg zboczy
+};
+
+void initSensorEdgeCapture();
+
+// Konsument (control): przenosi zbocza z ringu do stanu/historii.
+// Zwraca liczbę przetworzonych zboczy.
+uint8_t drainSensorEdges();
+
+bool isSensorLow(uint8_t sensor);                   // Poziom wg ostatniego zbocza
+bool takeSensorFirstLow(uint8_t sensor, uint32_t* timestampUs);  // Zbocze HIGH->LOW od ostatniego pytania
+uint32_t getSensorBouncesSince(uint8_t sensor, uint32_t sinceUs);
+
+SensorEdgeStats getSensorEdgeStats(uint8_t sensor);
+uint8_t copySensorEdgeHistory(SensorEdge* out, uint8_t maxCount);   // Od najnowszego
+uint32_t getSensorEdgesDropped();
+
+// Spoczynek: przełączenie pinów na przerwanie poziomem LOW i z powrotem
+void setSensorLevelWake(bool enabled);
+
+#endif
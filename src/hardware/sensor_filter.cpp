@@ -0,0 +1,165 @@
+#include "sensor_filter.h"
+#include "sensor_edges.h"
+#include "../core/logging.h"
+#include "../algorithm/algorithm_config.h"
+#include <esp_timer.h>
+#include <driver/gpio.h>
+
+#define FILTER_WORDS            (SENSOR_FILTER_WINDOW / 32)
+#define FILTER_LOW_THRESHOLD    ((SENSOR_FILTER_WINDOW * SENSOR_FILTER_LOW_PERCENT) / 100)
+#define FILTER_HIGH_THRESHOLD   ((SENSOR_FILTER_WINDOW * SENSOR_FILTER_HIGH_PERCENT) / 100)
+
+static const uint8_t SENSOR_PINS[] = CHANNEL_SENSOR_PINS;
+
+// Pisane tylko z callbacku timera; control / async_tcp czytają pojedyncze
+// pola (odczyt wyrównanego słowa jest atomowy)
+static struct {
+    uint32_t bits[FILTER_WORDS];    // 1 = próbka LOW
+    volatile uint16_t lowSamples;
+    volatile bool low;
+    volatile bool rawLow;
+    volatile uint32_t flips;
+    volatile uint32_t rawChanges;
+} filters[WATER_SENSOR_TOTAL];
+
+// Stan przefiltrowany wszystkich czujników: bit i = czujnik i LOW
+static volatile uint32_t filteredLowMask = 0;
+
+static_assert(WATER_SENSOR_TOTAL <= 32, "filteredLowMask holds up to 32 sensors");
+
+static uint16_t bitIndex = 0;
+static esp_timer_handle_t samplerTimer = nullptr;
+static volatile bool samplerRunning = false;
+
+static void sampleSensors(void*) {
+    uint16_t word = bitIndex >> 5;
+    uint32_t mask = 1UL << (bitIndex & 31);
+
+    for (uint8_t i = 0; i < WATER_SENSOR_TOTAL; i++) {
+        bool raw = gpio_get_level((gpio_num_t)SENSOR_PINS[i]) == 0;
+        bool outgoing = (filters[i].bits[word] & mask) != 0;
+
+        if (raw != outgoing) {
+            if (raw) {
+                filters[i].bits[word] |= mask;
+                filters[i].lowSamples++;
+            } else {
+                filters[i].bits[word] &= ~mask;
+                filters[i].lowSamples--;
+            }
+        }
+        if (raw != filters[i].rawLow) {
+            filters[i].rawLow = raw;
+            filters[i].rawChanges++;
+        }
+
+        // Histereza: między progami stan się nie zmienia
+        if (!filters[i].low && filters[i].lowSamples >= FILTER_LOW_THRESHOLD) {
+            filters[i].low = true;
+            filters[i].flips++;
+            filteredLowMask |= (1UL << i);
+        } else if (filters[i].low && filters[i].lowSamples <= FILTER_HIGH_THRESHOLD) {
+            filters[i].low = false;
+            filters[i].flips++;
+            filteredLowMask &= ~(1UL << i);
+        }
+    }
+
+    bitIndex = (bitIndex + 1) % SENSOR_FILTER_WINDOW;
+}
+
+// Okno wypełnione bieżącym poziomem - stan ważny od pierwszego odczytu
+static void seedFilters() {
+    uint32_t mask = 0;
+    for (uint8_t i = 0; i < WATER_SENSOR_TOTAL; i++) {
+        bool low = digitalRead(SENSOR_PINS[i]) == LOW;
+        memset(filters[i].bits, low ? 0xFF : 0x00, sizeof(filters[i].bits));
+        filters[i].lowSamples = low ? SENSOR_FILTER_WINDOW : 0;
+        filters[i].low = low;
+        filters[i].rawLow = low;
+        if (low) {
+            mask |= (1UL << i);
+        }
+    }
+    filteredLowMask = mask;
+    bitIndex = 0;
+}
+
+void initSensorFilter() {
+    memset(filters, 0, sizeof(filters));
+
+    esp_timer_create_args_t args = {};
+    args.callback = sampleSensors;
+    args.arg = nullptr;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "sensor_filter";
+    args.skip_unhandled_events = true;
+
+    if (esp_timer_create(&args, &samplerTimer) != 0) {
+        samplerTimer = nullptr;
+        LOG_ERROR("Sensor filter: timer create failed - using edge state only");
+        return;
+    }
+
+    setSensorSampling(true);
+
+    LOG_INFO("");
+    LOG_INFO("Sensor filter: %dus sampling, window %d, LOW>=%d HIGH<=%d samples",
+             SENSOR_SAMPLE_PERIOD_US, SENSOR_FILTER_WINDOW,
+             FILTER_LOW_THRESHOLD, FILTER_HIGH_THRESHOLD);
+}
+
+bool isSensorFilteredLow(uint8_t sensor) {
+    if (sensor >= WATER_SENSOR_TOTAL) {
+        return false;
+    }
+    if (!samplerRunning) {
+        return isSensorLow(sensor);
+    }
+    return filters[sensor].low;
+}
+
+uint32_t getSensorFilteredLowMask() {
+    if (samplerRunning) {
+        return filteredLowMask;
+    }
+    uint32_t mask = 0;
+    for (uint8_t i = 0; i < WATER_SENSOR_TOTAL; i++) {
+        if (isSensorLow(i)) {
+            mask |= (1UL << i);
+        }
+    }
+    return mask;
+}
+
+bool isSensorSamplingActive() {
+    return samplerRunning;
+}
+
+void setSensorSampling(bool enabled) {
+    if (samplerTimer == nullptr || enabled == samplerRunning) {
+        return;
+    }
+
+    if (enabled) {
+        seedFilters();
+        esp_timer_start_periodic(samplerTimer, SENSOR_SAMPLE_PERIOD_US);
+        samplerRunning = true;
+    } else {
+        esp_timer_stop(samplerTimer);
+        samplerRunning = false;
+    }
+}
+
+SensorFilterStats getSensorFilterStats(uint8_t sensor) {
+    SensorFilterStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (sensor < WATER_SENSOR_TOTAL) {
+        stats.low = filters[sensor].low;
+        stats.rawLow = filters[sensor].rawLow;
+        stats.lowSamples = filters[sensor].lowSamples;
+        stats.flips = filters[sensor].flips;
+        stats.rawChanges = filters[sensor].rawChanges;
+    }
+    return stats;
+}
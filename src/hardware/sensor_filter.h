@@ -0,0 +1,33 @@
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <Arduino.h>
+#include "hardware_pins.h"
+
+// ============== SENSOR FILTER ==============
+// Timer (esp_timer, SENSOR_SAMPLE_PERIOD_US) próbkuje piny pływaków do
+// historii bitowej per czujnik. Licznik LOW w oknie aktualizowany w O(1)
+// (bit wychodzący / wchodzący), stan przefiltrowany zmienia się dopiero po
+// przekroczeniu progów histerezy. Pojedyncza próbka na fali nie resetuje
+// liczników faz. Parametry: algorithm_config.h.
+// W trybie wybudzania poziomem (spoczynek) próbkowanie jest zatrzymane -
+// odczyty wracają wtedy do stanu ze zboczy (sensor_edges).
+
+struct SensorFilterStats {
+    bool low;                   // Stan przefiltrowany
+    bool rawLow;                // Ostatnia próbka
+    uint16_t lowSamples;        // Próbki LOW w oknie
+    uint32_t flips;             // Zmiany stanu przefiltrowanego
+    uint32_t rawChanges;        // Zmiany surowej próbki (w tym odrzucone)
+};
+
+void initSensorFilter();        // Po initSensorEdgeCapture()
+
+bool isSensorFilteredLow(uint8_t sensor);
+uint32_t getSensorFilteredLowMask();    // Bit i = czujnik i LOW (wszystkie kanały)
+bool isSensorSamplingActive();
+void setSensorSampling(bool enabled);
+
+SensorFilterStats getSensorFilterStats(uint8_t sensor);
+
+#endif
@@ -0,0 +1,240 @@
+#include "storage_queue.h"
+#include "fram_controller.h"
+#include "hardware_pins.h"
+#include "../core/logging.h"
+#include "../core/metrics.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+static QueueHandle_t storageQueue = nullptr;
+
+// ============== SAVED CYCLES (storage -> algorytm) ==============
+static portMUX_TYPE savedCyclesMux = portMUX_INITIALIZER_UNLOCKED;
+static PumpCycle savedCycles[WATER_CHANNEL_COUNT][STORAGE_SAVED_CYCLES_DEPTH];
+static uint8_t savedCyclesHead[WATER_CHANNEL_COUNT];
+static uint8_t savedCyclesCount[WATER_CHANNEL_COUNT];
+
+static void pushSavedCycle(uint8_t channel, const PumpCycle& cycle) {
+    if (channel >= WATER_CHANNEL_COUNT) {
+        return;
+    }
+    bool overwritten = false;
+    portENTER_CRITICAL(&savedCyclesMux);
+    uint8_t tail = (savedCyclesHead[channel] + savedCyclesCount[channel]) % STORAGE_SAVED_CYCLES_DEPTH;
+    savedCycles[channel][tail] = cycle;
+    if (savedCyclesCount[channel] < STORAGE_SAVED_CYCLES_DEPTH) {
+        savedCyclesCount[channel]++;
+    } else {
+        savedCyclesHead[channel] = (savedCyclesHead[channel] + 1) % STORAGE_SAVED_CYCLES_DEPTH;
+        overwritten = true;
+    }
+    portEXIT_CRITICAL(&savedCyclesMux);
+
+    if (overwritten) {
+        LOG_WARNING("");
+        LOG_WARNING("CH%d saved cycle not collected - history cache skips one entry", channel);
+    }
+}
+
+bool takeSavedCycle(uint8_t channel, PumpCycle& cycle) {
+    if (channel >= WATER_CHANNEL_COUNT) {
+        return false;
+    }
+    bool taken = false;
+    portENTER_CRITICAL(&savedCyclesMux);
+    if (savedCyclesCount[channel] > 0) {
+        cycle = savedCycles[channel][savedCyclesHead[channel]];
+        savedCyclesHead[channel] = (savedCyclesHead[channel] + 1) % STORAGE_SAVED_CYCLES_DEPTH;
+        savedCyclesCount[channel]--;
+        taken = true;
+    }
+    portEXIT_CRITICAL(&savedCyclesMux);
+    return taken;
+}
+
+void initStorageQueue() {
+    storageQueue = xQueueCreate(STORAGE_QUEUE_DEPTH, sizeof(StorageJob));
+    if (storageQueue == nullptr) {
+        LOG_ERROR("");
+        LOG_ERROR("Storage queue allocation failed - FRAM writes stay synchronous");
+    }
+}
+
+static void executeJob(const StorageJob& job) {
+    switch (job.type) {
+        case STORAGE_JOB_DAILY_VOLUME:
+            if (!saveDailyVolumeToFRAM(job.daily.volumeMl, job.daily.utcDay, job.channel)) {
+                LOG_WARNING("");
+                LOG_WARNING("Failed to save daily volume to FRAM");
+            }
+            break;
+
+        case STORAGE_JOB_AVAILABLE_VOLUME:
+            if (!saveAvailableVolumeToFRAM(job.available.maxMl, job.available.currentMl, job.channel)) {
+                LOG_WARNING("");
+                LOG_WARNING("Failed to save available volume to FRAM");
+            }
+            break;
+
+        case STORAGE_JOB_CYCLE:
+            if (saveCycleToFRAM(job.cycle, job.channel)) {
+                pushSavedCycle(job.channel, job.cycle);
+            } else {
+                LOG_ERROR("");
+                LOG_ERROR("Failed to save cycle to FRAM");
+            }
+            break;
+
+        case STORAGE_JOB_ERROR_STATS:
+            if (!incrementErrorStats(job.errors.gap1, job.errors.gap2, job.errors.water, job.channel)) {
+                LOG_WARNING("");
+                LOG_WARNING("Failed to update error stats in FRAM");
+            }
+            break;
+
+        case STORAGE_JOB_FILL_WATER_MAX:
+            if (!saveFillWaterMaxToFRAM(job.fillWaterMax, job.channel)) {
+                LOG_WARNING("");
+                LOG_WARNING("Failed to save fill water max to FRAM");
+            }
+            break;
+
+        case STORAGE_JOB_VOLUME_PER_SECOND:
+            if (!saveVolumeToFRAM(job.volumePerSecond, job.channel)) {
+                LOG_WARNING("");
+                LOG_WARNING("Failed to save volume per second to FRAM");
+            }
+            break;
+
+        case STORAGE_JOB_ERROR_STATS_RESET:
+            if (!resetErrorStatsInFRAM(job.channel, job.resetTimestamp)) {
+                LOG_WARNING("");
+                LOG_WARNING("Failed to reset error stats in FRAM");
+            }
+            break;
+
+        case STORAGE_JOB_RECORD:
+            if (!saveRecordToFRAM(job.record.addr, job.record.data, job.record.len)) {
+                LOG_WARNING("");
+                LOG_WARNING("Failed to save FRAM record at 0x%04X", job.record.addr);
+            }
+            break;
+    }
+    metricsInc(MC_STORAGE_JOBS_DONE);
+}
+
+static void submit(const StorageJob& job) {
+    if (storageQueue == nullptr) {
+        executeJob(job);    // Przed uruchomieniem zadań - kolejność zachowana
+        return;
+    }
+
+    if (xQueueSend(storageQueue, &job, 0) == pdTRUE) {
+        return;
+    }
+
+    // Pełna kolejka: zadanie storage opróżnia ją w czasie czekania. Zapis
+    // synchroniczny wyprzedziłby zlecenia w kolejce (np. starszy dzienny wolumen)
+    metricsInc(MC_STORAGE_QUEUE_OVERFLOWS);
+    if (xQueueSend(storageQueue, &job, pdMS_TO_TICKS(STORAGE_QUEUE_SEND_WAIT_MS)) == pdTRUE) {
+        return;
+    }
+
+    metricsInc(MC_STORAGE_JOBS_DROPPED);
+    LOG_ERROR("");
+    LOG_ERROR("Storage queue full for %dms - FRAM write dropped (job %d, CH%d)",
+              STORAGE_QUEUE_SEND_WAIT_MS, job.type, job.channel);
+}
+
+void queueDailyVolumeSave(uint16_t dailyVolume, uint32_t utcDay, uint8_t channel) {
+    StorageJob job;
+    job.type = STORAGE_JOB_DAILY_VOLUME;
+    job.channel = channel;
+    job.daily.volumeMl = dailyVolume;
+    job.daily.utcDay = utcDay;
+    submit(job);
+}
+
+void queueAvailableVolumeSave(uint32_t maxMl, uint32_t currentMl, uint8_t channel) {
+    StorageJob job;
+    job.type = STORAGE_JOB_AVAILABLE_VOLUME;
+    job.channel = channel;
+    job.available.maxMl = maxMl;
+    job.available.currentMl = currentMl;
+    submit(job);
+}
+
+void queueCycleSave(const PumpCycle& cycle, uint8_t channel) {
+    StorageJob job;
+    job.type = STORAGE_JOB_CYCLE;
+    job.channel = channel;
+    job.cycle = cycle;
+    submit(job);
+}
+
+void queueErrorStatsIncrement(uint8_t gap1, uint8_t gap2, uint8_t water, uint8_t channel) {
+    StorageJob job;
+    job.type = STORAGE_JOB_ERROR_STATS;
+    job.channel = channel;
+    job.errors.gap1 = gap1;
+    job.errors.gap2 = gap2;
+    job.errors.water = water;
+    submit(job);
+}
+
+void queueFillWaterMaxSave(uint16_t fillWaterMax, uint8_t channel) {
+    StorageJob job;
+    job.type = STORAGE_JOB_FILL_WATER_MAX;
+    job.channel = channel;
+    job.fillWaterMax = fillWaterMax;
+    submit(job);
+}
+
+void queueVolumeSave(float volumePerSecond, uint8_t channel) {
+    StorageJob job;
+    job.type = STORAGE_JOB_VOLUME_PER_SECOND;
+    job.channel = channel;
+    job.volumePerSecond = volumePerSecond;
+    submit(job);
+}
+
+void queueErrorStatsReset(uint32_t resetTimestamp, uint8_t channel) {
+    StorageJob job;
+    job.type = STORAGE_JOB_ERROR_STATS_RESET;
+    job.channel = channel;
+    job.resetTimestamp = resetTimestamp;
+    submit(job);
+}
+
+void queueRecordSave(uint16_t addr, const void* data, uint8_t len) {
+    if (len > FRAM_RECORD_MAX_DATA) {
+        LOG_ERROR("");
+        LOG_ERROR("FRAM record at 0x%04X too large (%d bytes)", addr, len);
+        return;
+    }
+    StorageJob job;
+    job.type = STORAGE_JOB_RECORD;
+    job.channel = 0;
+    job.record.addr = addr;
+    job.record.len = len;
+    memcpy(job.record.data, data, len);
+    submit(job);
+}
+
+void processStorageJobs(uint32_t waitMs) {
+    if (storageQueue == nullptr) {
+        delay(waitMs);
+        return;
+    }
+
+    StorageJob job;
+    TickType_t wait = pdMS_TO_TICKS(waitMs);
+    while (xQueueReceive(storageQueue, &job, wait) == pdTRUE) {
+        executeJob(job);
+        wait = 0;   // Opróżnij resztę bez czekania
+    }
+}
+
+uint8_t getStorageQueueDepth() {
+    return storageQueue != nullptr ? uxQueueMessagesWaiting(storageQueue) : 0;
+}
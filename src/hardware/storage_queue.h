@@ -0,0 +1,64 @@
+#ifndef STORAGE_QUEUE_H
+#define STORAGE_QUEUE_H
+
+#include <Arduino.h>
+#include "../algorithm/algorithm_config.h"
+#include "fram_controller.h"
+
+// ============== STORAGE QUEUE ==============
+// Zapisy FRAM z zadania sterowania trafiają do kolejki i wykonuje je
+// zadanie storage - pompa i czujniki nie czekają na I2C. Przed
+// uruchomieniem zadań (setup) zapis wykonuje się synchronicznie w wywołującym.
+// Pełna kolejka: wywołujący czeka chwilę na zadanie storage, potem zlecenie
+// przepada z błędem - zapis poza kolejką mógłby wyprzedzić starsze zlecenia.
+
+#define STORAGE_QUEUE_DEPTH     32     // Koniec cyklu na wszystkich kanałach (static_assert w water_algorithm.cpp)
+#define STORAGE_QUEUE_SEND_WAIT_MS  20  // Maks. czekanie na miejsce w kolejce
+#define STORAGE_SAVED_CYCLES_DEPTH  4   // Cykle zapisane w FRAM, czekające na odbiór przez algorytm
+
+enum StorageJobType : uint8_t {
+    STORAGE_JOB_DAILY_VOLUME = 0,
+    STORAGE_JOB_AVAILABLE_VOLUME,
+    STORAGE_JOB_CYCLE,
+    STORAGE_JOB_ERROR_STATS,
+    STORAGE_JOB_FILL_WATER_MAX,
+    STORAGE_JOB_RECORD,             // saveRecordToFRAM (profile modułów)
+    STORAGE_JOB_VOLUME_PER_SECOND,
+    STORAGE_JOB_ERROR_STATS_RESET
+};
+
+struct StorageJob {
+    StorageJobType type;
+    uint8_t channel;                // Partycja FRAM kanału (poza STORAGE_JOB_RECORD)
+    union {
+        struct { uint16_t volumeMl; uint32_t utcDay; } daily;
+        struct { uint32_t maxMl; uint32_t currentMl; } available;
+        struct { uint8_t gap1; uint8_t gap2; uint8_t water; } errors;
+        uint16_t fillWaterMax;
+        float volumePerSecond;
+        uint32_t resetTimestamp;
+        PumpCycle cycle;
+        struct { uint16_t addr; uint8_t len; uint8_t data[FRAM_RECORD_MAX_DATA]; } record;
+    };
+};
+
+void initStorageQueue();
+
+void queueDailyVolumeSave(uint16_t dailyVolume, uint32_t utcDay, uint8_t channel = 0);
+void queueAvailableVolumeSave(uint32_t maxMl, uint32_t currentMl, uint8_t channel = 0);
+void queueCycleSave(const PumpCycle& cycle, uint8_t channel = 0);
+void queueErrorStatsIncrement(uint8_t gap1, uint8_t gap2, uint8_t water, uint8_t channel = 0);
+void queueFillWaterMaxSave(uint16_t fillWaterMax, uint8_t channel = 0);
+void queueVolumeSave(float volumePerSecond, uint8_t channel = 0);
+void queueErrorStatsReset(uint32_t resetTimestamp, uint8_t channel = 0);
+void queueRecordSave(uint16_t addr, const void* data, uint8_t len);   // len <= FRAM_RECORD_MAX_DATA
+
+// Cykl, którego zapis do ringu FRAM się udał (FIFO per kanał). Algorytm
+// dopisuje go do swojej historii dopiero po potwierdzeniu zapisu.
+bool takeSavedCycle(uint8_t channel, PumpCycle& cycle);
+
+// Ciało zadania storage: czeka do waitMs na pierwsze zlecenie, potem opróżnia kolejkę
+void processStorageJobs(uint32_t waitMs);
+uint8_t getStorageQueueDepth();
+
+#endif
@@ -1,44 +1,67 @@
 #include "water_sensors.h"
 #include "../hardware/hardware_pins.h"
+#include "../hardware/sensor_edges.h"
+#include "../hardware/sensor_filter.h"
 #include "../core/logging.h"
 #include "../algorithm/water_algorithm.h"
 #include "../algorithm/algorithm_config.h"
+#include "../algorithm/debounce_profile.h"
+#include <esp_timer.h>
 
-// ============== STAN PROCESU DETEKCJI ==============
-static SensorPhase currentPhase = PHASE_IDLE;
-static uint32_t phaseStartTime = 0;
-static uint32_t lastCheckTime = 0;
+static const uint8_t SENSOR_PINS[] = CHANNEL_SENSOR_PINS;
 
-// ============== STAN PRE-QUALIFICATION ==============
-static struct {
-    uint8_t counter;           // Licznik kolejnych LOW (0 do PRE_QUAL_CONFIRM_COUNT)
-    bool anyLowDetected;       // Czy wykryto jakikolwiek LOW
-} preQualState = {0, false};
+static_assert(sizeof(SENSOR_PINS) >= WATER_SENSOR_TOTAL,
+              "CHANNEL_SENSOR_PINS must list WATER_SENSOR_COUNT pins per active channel");
 
-// ============== STAN DEBOUNCING ==============
-static struct {
-    uint8_t counter;           // Licznik kolejnych LOW (0 do DEBOUNCE_COUNTER)
-    bool complete;             // Czy zaliczony
-    uint32_t completeTime;     // Czas zaliczenia (sekundy od boot)
-} debounceState[2] = {{0, false, 0}, {0, false, 0}};
+static SensorChannel sensorChannels[WATER_CHANNEL_COUNT] = {
+    SensorChannel(0),
+#if WATER_CHANNEL_COUNT > 1
+    SensorChannel(1),
+#endif
+};
+
+static const uint32_t SETTLING_LOG_INTERVAL = 15;   // sekundy między logami SETTLING
+
+SensorChannel& getSensorChannel(uint8_t channel) {
+    return sensorChannels[channel < WATER_CHANNEL_COUNT ? channel : 0];
+}
+
+SensorChannel::SensorChannel(uint8_t channel) : channel(channel) {
+    reset();
+}
+
+void SensorChannel::reset() {
+    currentPhase = PHASE_IDLE;
+    phaseStartTime = 0;
+    lastCheckTime = 0;
+    lastSettlingLog = 0;
+    activeSchedule = getDefaultDebounceSchedule();
+    resetPreQualState();
+    resetDebounceState();
+}
 
 // ============== FUNKCJE POMOCNICZE ==============
-static void resetPreQualState() {
+void SensorChannel::resetPreQualState() {
     preQualState.counter = 0;
     preQualState.anyLowDetected = false;
 }
 
-static void resetDebounceState() {
-    for (int i = 0; i < 2; i++) {
-        debounceState[i].counter = 0;
-        debounceState[i].complete = false;
-        debounceState[i].completeTime = 0;
+// Zbocza zebrane poza IDLE nie mogą od razu wystartować kolejnego procesu
+void SensorChannel::clearFirstLowEdges() {
+    for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+        takeSensorFirstLow(sensorIndex(i), nullptr);
     }
 }
 
-static void transitionToPhase(SensorPhase newPhase) {
+void SensorChannel::resetDebounceState() {
+    memset(debounceCounter, 0, sizeof(debounceCounter));
+    memset(debounceCompleteTime, 0, sizeof(debounceCompleteTime));
+    debounceComplete = 0;
+}
+
+void SensorChannel::transitionToPhase(SensorPhase newPhase) {
     LOG_INFO("");
-    LOG_INFO("Phase transition: %s -> %s", getPhaseString(),
+    LOG_INFO("CH%d phase transition: %s -> %s", channel, getPhaseString(),
     newPhase == PHASE_IDLE ? "IDLE" :
     newPhase == PHASE_PRE_QUALIFICATION ? "PRE_QUAL" :
     newPhase == PHASE_SETTLING ? "SETTLING" : "DEBOUNCING");
@@ -48,22 +71,55 @@ static void transitionToPhase(SensorPhase newPhase) {
     lastCheckTime = phaseStartTime;
 }
 
+// Profil adaptacyjny uczy się na kanale 0 (statystyki zboczy jego czujników)
+DebounceSchedule SensorChannel::nextSchedule() const {
+    return channel == 0 ? getDebounceSchedule() : getDefaultDebounceSchedule();
+}
+
+void SensorChannel::profileCounterReset() {
+    if (channel == 0) {
+        debounceProfileCounterReset();
+    }
+}
+
+void SensorChannel::profileEndProcess(DebounceOutcome outcome) {
+    if (channel == 0) {
+        debounceProfileEndProcess(outcome);
+    }
+}
+
 // ============== INICJALIZACJA ==============
 void initWaterSensors() {
-    pinMode(WATER_SENSOR_1_PIN, INPUT_PULLUP);
-    pinMode(WATER_SENSOR_2_PIN, INPUT_PULLUP);
+    for (uint8_t i = 0; i < WATER_SENSOR_TOTAL; i++) {
+        pinMode(SENSOR_PINS[i], INPUT_PULLUP);
+    }
+    initSensorEdgeCapture();
+    initSensorFilter();
 
-    currentPhase = PHASE_IDLE;
-    phaseStartTime = 0;
-    lastCheckTime = 0;
-    resetPreQualState();
-    resetDebounceState();
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        sensorChannels[ch].reset();
+    }
 
     
     LOG_INFO("");             
     LOG_INFO("====================================");
-    LOG_INFO("Water sensors initialized on pins %d and %d",
-             WATER_SENSOR_1_PIN, WATER_SENSOR_2_PIN);
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        char pins[32];
+        size_t pos = 0;
+        for (uint8_t i = 0; i < WATER_SENSOR_COUNT && pos < sizeof(pins); i++) {
+            pos += snprintf(pins + pos, sizeof(pins) - pos, "%s%d", i > 0 ? ", " : "",
+                            SENSOR_PINS[ch * WATER_SENSOR_COUNT + i]);
+        }
+        LOG_INFO("Water sensors CH%d initialized on pins %s", ch, pins);
+    }
+    LOG_INFO("Sensor vote: trigger=%s, debounce=%s, release=%s (K=%d of %d)",
+             getSensorVotePolicyName(SENSOR_TRIGGER_VOTE),
+             getSensorVotePolicyName(SENSOR_DEBOUNCE_VOTE),
+             getSensorVotePolicyName(SENSOR_RELEASE_VOTE),
+             SENSOR_VOTE_K, WATER_SENSOR_COUNT);
+    LOG_INFO("Filter: %dus sampling, %d-sample window, hysteresis %d%%/%d%%",
+             SENSOR_SAMPLE_PERIOD_US, SENSOR_FILTER_WINDOW,
+             SENSOR_FILTER_LOW_PERCENT, SENSOR_FILTER_HIGH_PERCENT);
     LOG_INFO("Phase 1 config: PRE_QUAL=%ds/%d×%ds, SETTLING=%ds, DEBOUNCE=%ds/%d×%ds",
              PRE_QUAL_WINDOW, PRE_QUAL_CONFIRM_COUNT, PRE_QUAL_INTERVAL,
              SETTLING_TIME,
@@ -71,43 +127,98 @@ void initWaterSensors() {
     LOG_INFO("====================================");
 }
 
-// ============== ODCZYT SUROWY ==============
+// ============== ODCZYT (stan przefiltrowany) ==============
+bool SensorChannel::readSensor(uint8_t index) const {
+    return index < WATER_SENSOR_COUNT && isSensorFilteredLow(sensorIndex(index));
+}
+
+SensorMask SensorChannel::readLowMask() const {
+    return (SensorMask)(getSensorFilteredLowMask() >> sensorIndex(0)) & SENSOR_MASK_ALL;
+}
+
 bool readWaterSensor1() {
-    return digitalRead(WATER_SENSOR_1_PIN) == LOW;
+    return sensorChannels[0].readSensor(0);
 }
 
 bool readWaterSensor2() {
-    return digitalRead(WATER_SENSOR_2_PIN) == LOW;
+    return sensorChannels[0].readSensor(1);
 }
 
 // ============== RESET PROCESU ==============
-void resetSensorProcess() {
+void SensorChannel::resetProcess() {
     currentPhase = PHASE_IDLE;
     phaseStartTime = 0;
     lastCheckTime = 0;
     resetPreQualState();
     resetDebounceState();
+    clearFirstLowEdges();
+    LOG_INFO("");
+    LOG_INFO("CH%d sensor process reset to IDLE", channel);
+}
+
+// Faza odtworzona z checkpointu cyklu: czas fazy obejmuje przerwę zasilania,
+// liczniki niezaliczonych czujników liczą od zera. Debouncing zostawia co
+// najmniej jeden pomiar przed timeoutem - wynik nie zapada na danych sprzed restartu.
+void SensorChannel::resumeProcess(SensorPhase phase, uint32_t elapsed, SensorMask complete) {
+    activeSchedule = nextSchedule();
+    if (channel == 0) {
+        debounceProfileBeginProcess();
+    }
+
+    if (phase == PHASE_DEBOUNCING) {
+        uint32_t latest = activeSchedule.totalDebounceTime - activeSchedule.debounceInterval;
+        if (elapsed > latest) {
+            elapsed = latest;
+        }
+    }
+
+    currentPhase = phase;
+    phaseStartTime = millis() / 1000 - elapsed;
+    lastCheckTime = millis() / 1000;
+    lastSettlingLog = 0;
+    resetPreQualState();
+    resetDebounceState();
+    debounceComplete = complete & SENSOR_MASK_ALL;
+    clearFirstLowEdges();
+
     LOG_INFO("");
-    LOG_INFO("Sensor process reset to IDLE");
+    LOG_INFO("CH%d sensor process resumed in %s at %lus", channel, getPhaseString(), elapsed);
+}
+
+void resetSensorProcess() {
+    sensorChannels[0].resetProcess();
 }
 
 // ============== GŁÓWNA LOGIKA ==============
 void checkWaterSensors() {
+    // Zbocza z przerwań - zawsze, żeby ring nie przepełnił się podczas pompowania
+    drainSensorEdges();
+
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        sensorChannels[ch].check();
+    }
+}
+
+void SensorChannel::check() {
+    WaterAlgorithm& algorithm = getWaterChannel(channel);
+
     // ============== SKIP SENSOR PROCESSING IN CERTAIN ALGORITHM STATES ==============
     // - STATE_PUMPING_AND_VERIFY: Algorithm handles release debounce internally
     // - STATE_LOGGING: Avoid false triggers right after cycle
     // - STATE_ERROR: Don't start new cycles while in error state
-    AlgorithmState algState = waterAlgorithm.getState();
+    // - Debouncing zaliczony, cykl czeka na przekaźnik pompy (arbiter)
+    AlgorithmState algState = algorithm.getState();
     if (algState == STATE_PUMPING_AND_VERIFY ||
         algState == STATE_LOGGING ||
-        algState == STATE_ERROR) {
+        algState == STATE_ERROR ||
+        algorithm.isWaitingForPump()) {
+        clearFirstLowEdges();
         return;  // Don't process sensors in these states
     }
 
     uint32_t currentTime = millis() / 1000;
-    bool sensor1Low = readWaterSensor1();
-    bool sensor2Low = readWaterSensor2();
-    bool anyLow = sensor1Low || sensor2Low;
+    SensorMask lowMask = readLowMask();
+    bool triggerVote = sensorVotePasses(lowMask, SENSOR_TRIGGER_VOTE);
 
     switch (currentPhase) {
 
@@ -115,21 +226,46 @@ void checkWaterSensors() {
         // PHASE_IDLE: Czekanie na pierwszy LOW
         // ===============================================
         case PHASE_IDLE: {
-            if (anyLow) {
+            // Krótki spadek między tickami też startuje PRE_QUAL - trwałość
+            // sprawdzają kolejne pomiary
+            uint32_t edgeUs = 0;
+            SensorMask edgeMask = 0;
+            for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+                uint32_t ts;
+                if (takeSensorFirstLow(sensorIndex(i), &ts)) {
+                    if (edgeMask == 0 || (int32_t)(ts - edgeUs) < 0) {
+                        edgeUs = ts;
+                    }
+                    edgeMask |= (1U << i);
+                }
+            }
+
+            if (triggerVote || (edgeMask != 0 && sensorVotePasses(lowMask | edgeMask, SENSOR_TRIGGER_VOTE))) {
+                char states[48];
+                formatSensorMask(lowMask, "LOW", "HIGH", states, sizeof(states));
                 LOG_INFO("");
                 LOG_INFO("====================================");
-                LOG_INFO("FIRST LOW DETECTED - Starting PRE_QUAL");
-                LOG_INFO("S1=%s, S2=%s", sensor1Low ? "LOW" : "HIGH", sensor2Low ? "LOW" : "HIGH");
+                LOG_INFO("FIRST LOW DETECTED (CH%d) - Starting PRE_QUAL", channel);
+                LOG_INFO("%s", states);
+                if (edgeMask != 0) {
+                    LOG_INFO("Edge latency: %luus", (uint32_t)esp_timer_get_time() - edgeUs);
+                }
                 LOG_INFO("====================================");
 
 
+                // Harmonogram stały do końca procesu
+                activeSchedule = nextSchedule();
+                if (channel == 0) {
+                    debounceProfileBeginProcess();
+                }
+
                 transitionToPhase(PHASE_PRE_QUALIFICATION);
                 resetPreQualState();
                 preQualState.anyLowDetected = true;
                 preQualState.counter = 1;  // Pierwszy LOW już wykryty
 
                 // Powiadom algorytm o starcie procesu
-                waterAlgorithm.onPreQualificationStart();
+                algorithm.onPreQualificationStart();
             }
             break;
         }
@@ -141,44 +277,45 @@ void checkWaterSensors() {
             uint32_t elapsed = currentTime - phaseStartTime;
 
             // Sprawdź timeout (> nie >= żeby pomiar na granicy timeout mógł się wykonać)
-            if (elapsed > PRE_QUAL_WINDOW) {
+            if (elapsed > activeSchedule.preQualWindow) {
                 LOG_INFO("");
                 LOG_INFO("====================================");
                 LOG_INFO("PRE_QUAL TIMEOUT - returning to IDLE");
                 LOG_INFO("Counter was: %d/%d (needed %d consecutive)",
-                    preQualState.counter, PRE_QUAL_CONFIRM_COUNT, PRE_QUAL_CONFIRM_COUNT);
+                    preQualState.counter, activeSchedule.preQualConfirmCount, activeSchedule.preQualConfirmCount);
                 LOG_INFO("====================================");
 
 
                 // Cichy powrót do IDLE (bez błędu)
-                waterAlgorithm.onPreQualificationFail();
-                resetSensorProcess();
+                profileEndProcess(DEBOUNCE_OUTCOME_PREQUAL_FAIL);
+                algorithm.onPreQualificationFail();
+                resetProcess();
                 break;
             }
 
             // Sprawdź czy czas na kolejny pomiar
-            if (currentTime - lastCheckTime < PRE_QUAL_INTERVAL) {
+            if (currentTime - lastCheckTime < activeSchedule.preQualInterval) {
                 break;
             }
             lastCheckTime = currentTime;
 
-            // Pomiar - wymagamy LOW na którymkolwiek czujniku
-            if (anyLow) {
+            // Pomiar - wymagamy LOW wg SENSOR_TRIGGER_VOTE
+            if (triggerVote) {
                 preQualState.counter++;
                 LOG_INFO("");                         
                 LOG_INFO("PRE_QUAL: LOW confirmed, counter=%d/%d (elapsed %lus)",
-                         preQualState.counter, PRE_QUAL_CONFIRM_COUNT, elapsed);
+                         preQualState.counter, activeSchedule.preQualConfirmCount, elapsed);
 
                 // Sprawdź czy osiągnięto wymaganą liczbę
-                if (preQualState.counter >= PRE_QUAL_CONFIRM_COUNT) {
+                if (preQualState.counter >= activeSchedule.preQualConfirmCount) {
                     LOG_INFO("");
                     LOG_INFO("====================================");
-                    LOG_INFO("PRE_QUAL SUCCESS - %d consecutive LOWs", PRE_QUAL_CONFIRM_COUNT);
-                    LOG_INFO("Starting SETTLING phase (%ds)", SETTLING_TIME);
+                    LOG_INFO("PRE_QUAL SUCCESS - %d consecutive LOWs", activeSchedule.preQualConfirmCount);
+                    LOG_INFO("Starting SETTLING phase (%ds)", activeSchedule.settlingTime);
                     LOG_INFO("====================================");
 
 
-                    waterAlgorithm.onPreQualificationSuccess();
+                    algorithm.onPreQualificationSuccess();
                     transitionToPhase(PHASE_SETTLING);
                 }
             } else {
@@ -186,6 +323,7 @@ void checkWaterSensors() {
                 if (preQualState.counter > 0) {
                     LOG_INFO("");
                     LOG_INFO("PRE_QUAL: HIGH detected, counter reset (was %d)", preQualState.counter);
+                    profileCounterReset();
                 }
                 preQualState.counter = 0;
             }
@@ -199,24 +337,23 @@ void checkWaterSensors() {
             uint32_t elapsed = currentTime - phaseStartTime;
 
             // Status log co 15s
-            static uint32_t lastSettlingLog = 0;
-            if (currentTime - lastSettlingLog >= 15) {
+            if (currentTime - lastSettlingLog >= SETTLING_LOG_INTERVAL) {
                 LOG_INFO("");
-                LOG_INFO("SETTLING: %lu/%ds", elapsed, SETTLING_TIME);
+                LOG_INFO("CH%d SETTLING: %lu/%ds", channel, elapsed, activeSchedule.settlingTime);
                 lastSettlingLog = currentTime;
             }
 
-            // Sprawdź czy minęło SETTLING_TIME
-            if (elapsed >= SETTLING_TIME) {
+            // Sprawdź czy minął czas settling
+            if (elapsed >= activeSchedule.settlingTime) {
                 LOG_INFO("");
                 LOG_INFO("====================================");
                 LOG_INFO("SETTLING COMPLETE - Starting DEBOUNCING");
                 LOG_INFO("Debounce config: %ds timeout, %ds interval, %d×LOW needed",
-                    TOTAL_DEBOUNCE_TIME, DEBOUNCE_INTERVAL, DEBOUNCE_COUNTER);
+                    activeSchedule.totalDebounceTime, activeSchedule.debounceInterval, activeSchedule.debounceCounter);
                 LOG_INFO("====================================");
 
 
-                waterAlgorithm.onSettlingComplete();
+                algorithm.onSettlingComplete();
                 transitionToPhase(PHASE_DEBOUNCING);
                 resetDebounceState();
             }
@@ -230,70 +367,76 @@ void checkWaterSensors() {
             uint32_t elapsed = currentTime - phaseStartTime;
 
             // Sprawdź timeout (> nie >= żeby pomiar na granicy timeout mógł się wykonać)
-            if (elapsed > TOTAL_DEBOUNCE_TIME) {
-                bool s1OK = debounceState[0].complete;
-                bool s2OK = debounceState[1].complete;
+            if (elapsed > activeSchedule.totalDebounceTime) {
+                SensorMask passed = debounceComplete;
 
                 LOG_INFO("");
                 LOG_INFO("====================================");
-                LOG_INFO("DEBOUNCE TIMEOUT (%ds)", TOTAL_DEBOUNCE_TIME);
-                LOG_INFO("S1: %s (counter=%d)", s1OK ? "COMPLETE" : "FAILED", debounceState[0].counter);
-                LOG_INFO("S2: %s (counter=%d)", s2OK ? "COMPLETE" : "FAILED", debounceState[1].counter);
+                LOG_INFO("DEBOUNCE TIMEOUT (%ds)", activeSchedule.totalDebounceTime);
+                for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+                    LOG_INFO("S%d: %s (counter=%d)", i + 1,
+                             (passed & (1U << i)) ? "COMPLETE" : "FAILED", debounceCounter[i]);
+                }
                 LOG_INFO("====================================");
 
-                waterAlgorithm.onDebounceTimeout(s1OK, s2OK);
-                resetSensorProcess();
+                profileEndProcess(sensorVotePasses(passed, SENSOR_DEBOUNCE_VOTE) ? DEBOUNCE_OUTCOME_PARTIAL
+                                                                                 : DEBOUNCE_OUTCOME_FALSE_TRIGGER);
+                algorithm.onDebounceTimeout(passed);
+                resetProcess();
                 break;
             }
 
-            // Sprawdź czy oba czujniki zaliczone (wczesne zakończenie)
-            if (debounceState[0].complete && debounceState[1].complete) {
+            // Sprawdź czy wszystkie czujniki zaliczone (wczesne zakończenie)
+            if (debounceComplete == SENSOR_MASK_ALL) {
                 LOG_INFO("");
                 LOG_INFO("====================================");
-                LOG_INFO("DEBOUNCE SUCCESS - BOTH SENSORS OK");
+                LOG_INFO("DEBOUNCE SUCCESS - ALL %d SENSORS OK", WATER_SENSOR_COUNT);
                 LOG_INFO("Elapsed: %lus (early completion)", elapsed);
                 LOG_INFO("====================================");
 
 
-                waterAlgorithm.onDebounceBothComplete();
-                resetSensorProcess();
+                profileEndProcess(DEBOUNCE_OUTCOME_PASS);
+                algorithm.onDebounceAllComplete();
+                resetProcess();
                 break;
             }
 
             // Sprawdź czy czas na kolejny pomiar
-            if (currentTime - lastCheckTime < DEBOUNCE_INTERVAL) {
+            if (currentTime - lastCheckTime < activeSchedule.debounceInterval) {
                 break;
             }
             lastCheckTime = currentTime;
 
-            // Pomiar dla każdego czujnika niezależnie
-            bool sensors[2] = {sensor1Low, sensor2Low};
+            // Pomiar dla każdego niezaliczonego czujnika niezależnie
+            SensorMask pending = SENSOR_MASK_ALL & ~debounceComplete;
 
-            for (int i = 0; i < 2; i++) {
-                if (debounceState[i].complete) {
+            for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+                SensorMask bit = (SensorMask)(1U << i);
+                if (!(pending & bit)) {
                     continue;  // Już zaliczony
                 }
 
-                if (sensors[i]) {
+                if (lowMask & bit) {
                     // LOW - zwiększ licznik
-                    debounceState[i].counter++;
-                    LOG_INFO("S%d: LOW, counter=%d/%d", i + 1, debounceState[i].counter, DEBOUNCE_COUNTER);
+                    debounceCounter[i]++;
+                    LOG_INFO("S%d: LOW, counter=%d/%d", i + 1, debounceCounter[i], activeSchedule.debounceCounter);
 
-                    if (debounceState[i].counter >= DEBOUNCE_COUNTER) {
-                        debounceState[i].complete = true;
-                        debounceState[i].completeTime = currentTime;
+                    if (debounceCounter[i] >= activeSchedule.debounceCounter) {
+                        debounceComplete |= bit;
+                        debounceCompleteTime[i] = currentTime;
                         LOG_INFO("");
                         LOG_INFO("S%d: DEBOUNCE COMPLETE at %lus!", i + 1, currentTime);
 
-                        waterAlgorithm.onSensorDebounceComplete(i + 1);
+                        algorithm.onSensorDebounceComplete(i + 1);
                     }
                 } else {
                     // HIGH - reset licznika
-                    if (debounceState[i].counter > 0) {
+                    if (debounceCounter[i] > 0) {
                         LOG_INFO("");
-                        LOG_INFO("S%d: HIGH, counter reset (was %d)", i + 1, debounceState[i].counter);
+                        LOG_INFO("S%d: HIGH, counter reset (was %d)", i + 1, debounceCounter[i]);
+                        profileCounterReset();
                     }
-                    debounceState[i].counter = 0;
+                    debounceCounter[i] = 0;
                 }
             }
             break;
@@ -306,32 +449,23 @@ void updateWaterSensors() {
     checkWaterSensors();
 }
 
-String getWaterStatus() {
-    bool sensor1 = readWaterSensor1();
-    bool sensor2 = readWaterSensor2();
+String getWaterStatus(uint8_t channel) {
+    SensorMask low = getSensorChannel(channel).readLowMask();
 
-    if (sensor1 && sensor2) {
-        return "BOTH_LOW";
-    } else if (sensor1) {
-        return "SENSOR1_LOW";
-    } else if (sensor2) {
-        return "SENSOR2_LOW";
-    } else {
+    if (low == 0) {
         return "NORMAL";
+    } else if (low == SENSOR_MASK_ALL) {
+        return WATER_SENSOR_COUNT == 2 ? "BOTH_LOW" : "ALL_LOW";
+    } else if (sensorMaskCount(low) == 1) {
+        return "SENSOR" + String(__builtin_ctz(low) + 1) + "_LOW";
+    } else {
+        return "PARTIAL_LOW";
     }
 }
 
-bool shouldActivatePump() {
-    return false;  // Handled by water algorithm
-}
-
 // ============== GETTERY STANU ==============
 
-SensorPhase getCurrentPhase() {
-    return currentPhase;
-}
-
-const char* getPhaseString() {
+const char* SensorChannel::getPhaseString() const {
     switch (currentPhase) {
         case PHASE_IDLE: return "IDLE";
         case PHASE_PRE_QUALIFICATION: return "PRE_QUAL";
@@ -341,30 +475,33 @@ const char* getPhaseString() {
     }
 }
 
-uint8_t getPreQualCounter() {
-    return preQualState.counter;
-}
-
-uint8_t getDebounceCounter(uint8_t sensorNum) {
-    if (sensorNum >= 1 && sensorNum <= 2) {
-        return debounceState[sensorNum - 1].counter;
+uint8_t SensorChannel::getDebounceCounter(uint8_t sensorNum) const {
+    if (sensorNum >= 1 && sensorNum <= WATER_SENSOR_COUNT) {
+        return debounceCounter[sensorNum - 1];
     }
     return 0;
 }
 
-bool isDebounceComplete(uint8_t sensorNum) {
-    if (sensorNum >= 1 && sensorNum <= 2) {
-        return debounceState[sensorNum - 1].complete;
+bool SensorChannel::isDebounceComplete(uint8_t sensorNum) const {
+    if (sensorNum >= 1 && sensorNum <= WATER_SENSOR_COUNT) {
+        return (debounceComplete & (1U << (sensorNum - 1))) != 0;
     }
     return false;
 }
 
-uint32_t getPhaseElapsedTime() {
+uint32_t SensorChannel::getPhaseElapsedTime() const {
     if (currentPhase == PHASE_IDLE) return 0;
     return (millis() / 1000) - phaseStartTime;
 }
 
-uint32_t getPhaseRemainingTime() {
+const DebounceSchedule& SensorChannel::getActiveSchedule() const {
+    if (currentPhase == PHASE_IDLE && channel == 0) {
+        return getDebounceSchedule();
+    }
+    return activeSchedule;
+}
+
+uint32_t SensorChannel::getPhaseRemainingTime() const {
     if (currentPhase == PHASE_IDLE) return 0;
 
     uint32_t elapsed = getPhaseElapsedTime();
@@ -372,13 +509,13 @@ uint32_t getPhaseRemainingTime() {
 
     switch (currentPhase) {
         case PHASE_PRE_QUALIFICATION:
-            timeout = PRE_QUAL_WINDOW;
+            timeout = activeSchedule.preQualWindow;
             break;
         case PHASE_SETTLING:
-            timeout = SETTLING_TIME;
+            timeout = activeSchedule.settlingTime;
             break;
         case PHASE_DEBOUNCING:
-            timeout = TOTAL_DEBOUNCE_TIME;
+            timeout = activeSchedule.totalDebounceTime;
             break;
         default:
             return 0;
@@ -387,6 +524,87 @@ uint32_t getPhaseRemainingTime() {
     return (elapsed < timeout) ? (timeout - elapsed) : 0;
 }
 
+bool SensorChannel::getReleaseEdgeUs(uint8_t index, uint32_t& edgeUs) const {
+    if (index >= WATER_SENSOR_COUNT) {
+        return false;
+    }
+    SensorEdgeStats stats = getSensorEdgeStats(sensorIndex(index));
+    if (stats.low || stats.edges == 0) {
+        return false;
+    }
+    edgeUs = stats.lastEdgeUs;
+    return true;
+}
+
+// Sekunda (millis()/1000), od której check() ma coś do zrobienia - wcześniejsza z dwóch
+static uint32_t earlierSecond(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0 ? a : b;
+}
+
+uint32_t SensorChannel::msUntilDue() const {
+    uint32_t dueSecond;
+
+    switch (currentPhase) {
+        case PHASE_PRE_QUALIFICATION:
+            // Timeout porównuje "elapsed > window" - pierwsza sekunda po oknie
+            dueSecond = earlierSecond(lastCheckTime + activeSchedule.preQualInterval,
+                                      phaseStartTime + activeSchedule.preQualWindow + 1);
+            break;
+        case PHASE_SETTLING:
+            dueSecond = earlierSecond(lastSettlingLog + SETTLING_LOG_INTERVAL,
+                                      phaseStartTime + activeSchedule.settlingTime);
+            break;
+        case PHASE_DEBOUNCING:
+            if (debounceComplete == SENSOR_MASK_ALL) {
+                return 0;
+            }
+            dueSecond = earlierSecond(lastCheckTime + activeSchedule.debounceInterval,
+                                      phaseStartTime + activeSchedule.totalDebounceTime + 1);
+            break;
+        default:
+            return UINT32_MAX;      // IDLE: pierwszy LOW (próbkowanie lub zbocze GPIO)
+    }
+
+    uint32_t nowMs = millis();
+    int32_t aheadSeconds = (int32_t)(dueSecond - nowMs / 1000);
+    if (aheadSeconds <= 0) {
+        return 0;
+    }
+    return (uint32_t)aheadSeconds * 1000 - nowMs % 1000;
+}
+
+SensorPhase getCurrentPhase() {
+    return sensorChannels[0].getPhase();
+}
+
+const char* getPhaseString() {
+    return sensorChannels[0].getPhaseString();
+}
+
+uint8_t getPreQualCounter() {
+    return sensorChannels[0].getPreQualCounter();
+}
+
+uint8_t getDebounceCounter(uint8_t sensorNum) {
+    return sensorChannels[0].getDebounceCounter(sensorNum);
+}
+
+bool isDebounceComplete(uint8_t sensorNum) {
+    return sensorChannels[0].isDebounceComplete(sensorNum);
+}
+
+uint32_t getPhaseElapsedTime() {
+    return sensorChannels[0].getPhaseElapsedTime();
+}
+
+const DebounceSchedule& getActiveDebounceSchedule() {
+    return sensorChannels[0].getActiveSchedule();
+}
+
+uint32_t getPhaseRemainingTime() {
+    return sensorChannels[0].getPhaseRemainingTime();
+}
+
 // ============== LEGACY FUNCTIONS ==============
 
 void resetDebounceProcess() {
@@ -394,7 +612,7 @@ void resetDebounceProcess() {
 }
 
 bool isDebounceProcessActive() {
-    return currentPhase != PHASE_IDLE;
+    return sensorChannels[0].getPhase() != PHASE_IDLE;
 }
 
 uint32_t getDebounceElapsedTime() {
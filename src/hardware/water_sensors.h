@@ -2,6 +2,9 @@
 #define WATER_SENSORS_H
 
 #include <Arduino.h>
+#include "../algorithm/debounce_profile.h"
+#include "../algorithm/sensor_vote.h"
+#include "hardware_pins.h"
 
 // ============== FAZY PROCESU DETEKCJI ==============
 enum SensorPhase {
@@ -11,16 +14,82 @@ enum SensorPhase {
     PHASE_DEBOUNCING          // Pełna weryfikacja (1200s, 4×LOW)
 };
 
+// ============== SENSOR CHANNEL ==============
+// Silnik faz (PRE_QUAL -> SETTLING -> DEBOUNCING) dla WATER_SENSOR_COUNT
+// pływaków jednego kanału; powiadamia WaterAlgorithm tego samego kanału.
+// Stany czujników i zaliczenia to maski bitowe, start procesu rozstrzyga
+// SENSOR_TRIGGER_VOTE. Profil adaptacyjny debouncingu uczy się tylko na
+// kanale 0 - pozostałe używają harmonogramu domyślnego. Funkcje globalne
+// poniżej działają na kanale 0.
+class SensorChannel {
+public:
+    explicit SensorChannel(uint8_t channel);
+
+    void reset();                   // Stan początkowy (bez logu)
+    void check();                   // Zbocza opróżnia checkWaterSensors()
+    void resetProcess();
+    void resumeProcess(SensorPhase phase, uint32_t elapsed, SensorMask complete);  // Checkpoint cyklu po restarcie
+
+    bool readSensor(uint8_t index) const;   // index: 0 .. WATER_SENSOR_COUNT-1
+    SensorMask readLowMask() const;         // Bit i = czujnik i LOW
+    SensorPhase getPhase() const { return currentPhase; }
+    const char* getPhaseString() const;
+    uint8_t getPreQualCounter() const { return preQualState.counter; }
+    uint8_t getDebounceCounter(uint8_t sensorNum) const;    // sensorNum: 1 .. WATER_SENSOR_COUNT
+    bool isDebounceComplete(uint8_t sensorNum) const;
+    SensorMask getDebounceCompleteMask() const { return debounceComplete; }
+    uint32_t getPhaseElapsedTime() const;
+    uint32_t getPhaseRemainingTime() const;
+    uint32_t msUntilDue() const;            // ms do następnego pomiaru/timeoutu fazy (UINT32_MAX = IDLE)
+    const DebounceSchedule& getActiveSchedule() const;
+
+    uint8_t getChannel() const { return channel; }
+
+    // Ostatnie zbocze czujnika do HIGH (esp_timer µs) - false gdy wg zboczy jest LOW
+    bool getReleaseEdgeUs(uint8_t index, uint32_t& edgeUs) const;
+
+private:
+    uint8_t sensorIndex(uint8_t index) const { return channel * WATER_SENSOR_COUNT + index; }
+    DebounceSchedule nextSchedule() const;
+    void resetPreQualState();
+    void clearFirstLowEdges();
+    void resetDebounceState();
+    void transitionToPhase(SensorPhase newPhase);
+    void profileCounterReset();
+    void profileEndProcess(DebounceOutcome outcome);
+
+    uint8_t channel;
+
+    // ============== STAN PROCESU DETEKCJI ==============
+    SensorPhase currentPhase;
+    uint32_t phaseStartTime;
+    uint32_t lastCheckTime;
+    uint32_t lastSettlingLog;
+    DebounceSchedule activeSchedule;    // Kopia z profilu na czas procesu
+
+    // ============== STAN PRE-QUALIFICATION ==============
+    struct {
+        uint8_t counter;           // Licznik kolejnych LOW (0 do preQualConfirmCount)
+        bool anyLowDetected;       // Czy wykryto jakikolwiek LOW
+    } preQualState;
+
+    // ============== STAN DEBOUNCING ==============
+    uint8_t debounceCounter[WATER_SENSOR_COUNT];        // Kolejne LOW (0 do debounceCounter)
+    uint32_t debounceCompleteTime[WATER_SENSOR_COUNT];  // Czas zaliczenia (sekundy od boot)
+    SensorMask debounceComplete;                        // Bit i = czujnik i zaliczony
+};
+
+SensorChannel& getSensorChannel(uint8_t channel);
+
 // ============== PODSTAWOWE FUNKCJE ==============
 void initWaterSensors();
 void updateWaterSensors();
-void checkWaterSensors();
+void checkWaterSensors();           // Zbocza + wszystkie kanały
 
 // ============== ODCZYT STANU CZUJNIKÓW ==============
 bool readWaterSensor1();
 bool readWaterSensor2();
-String getWaterStatus();
-bool shouldActivatePump();
+String getWaterStatus(uint8_t channel = 0);
 
 // ============== ZARZĄDZANIE PROCESEM ==============
 void resetSensorProcess();
@@ -29,10 +98,11 @@ void resetSensorProcess();
 SensorPhase getCurrentPhase();
 const char* getPhaseString();
 uint8_t getPreQualCounter();
-uint8_t getDebounceCounter(uint8_t sensorNum);   // sensorNum: 1 lub 2
-bool isDebounceComplete(uint8_t sensorNum);      // sensorNum: 1 lub 2
+uint8_t getDebounceCounter(uint8_t sensorNum);   // sensorNum: 1 .. WATER_SENSOR_COUNT
+bool isDebounceComplete(uint8_t sensorNum);      // sensorNum: 1 .. WATER_SENSOR_COUNT
 uint32_t getPhaseElapsedTime();                  // sekundy od startu bieżącej fazy
 uint32_t getPhaseRemainingTime();                // sekundy do timeout bieżącej fazy
+const DebounceSchedule& getActiveDebounceSchedule();  // Harmonogram bieżącego procesu (IDLE: następnego)
 
 // ============== LEGACY (kompatybilność) ==============
 void resetDebounceProcess();
@@ -1,13 +1,23 @@
 
 #include <Arduino.h>
 #include "core/logging.h"
+#include "core/metrics.h"
+#include "core/profiler.h"
+#include "core/trace.h"
+#include "core/scheduler.h"
+#include "core/task_manager.h"
+#include "core/control_commands.h"
+#include "core/power_manager.h"
 #include "config/config.h"
 #include "config/credentials_manager.h"
 #include "hardware/rtc_controller.h"
 #include "hardware/fram_controller.h"
+#include "hardware/storage_queue.h"
+#include "hardware/i2c_bus.h"
 #include "hardware/hardware_pins.h"
 #include "hardware/water_sensors.h"
 #include "hardware/pump_controller.h"
+#include "hardware/pump_usage.h"
 #include "network/wifi_manager.h"
 #include "network/vps_logger.h"
 #include "security/auth_manager.h"
@@ -15,13 +25,244 @@
 #include "security/rate_limiter.h"
 #include "web/web_server.h"
 #include "algorithm/water_algorithm.h"
+#include "algorithm/debounce_profile.h"
+#include "algorithm/flow_calibration.h"
+#include "algorithm/evaporation_model.h"
 #include "provisioning/prov_detector.h"
 #include "provisioning/ap_core.h"
 #include "provisioning/ap_server.h"
 
+// ============== SYSTEM TASKS ==============
+// Każde zadanie FreeRTOS ma własny planer terminów i śpi do najbliższego
+static Scheduler controlScheduler;
+static Scheduler storageScheduler;
+static Scheduler housekeepingScheduler;
+
+static const uint32_t SENSOR_PERIOD_MS = 100;        // Wykrycie pierwszego LOW
+static const uint32_t ALGORITHM_PERIOD_MS = 100;     // Przycisk (50ms debounce) + impulsy błędu
+static const uint32_t PUMP_PERIOD_MS = 100;          // Nadzór pompy; wyłączenie planowane dokładnie
+static const uint32_t DATE_CHECK_PERIOD_MS = 1000;   // Zmiana doby UTC, przejście okresu archiwum
+static const uint32_t RELEASE_CHECK_PERIOD_MS = RELEASE_CHECK_INTERVAL * 1000UL;  // Release debounce fazy 2
+static const uint32_t STATUS_LOG_PERIOD_MS = 10000;  // Log postępu PUMPING_AND_VERIFY
+static const uint32_t RTC_REFRESH_PERIOD_MS = 1000;  // Kopia czasu dla ścieżki sterowania
+static const uint32_t HOUSEKEEPING_PERIOD_MS = 1000; // Sesje, rate limiter, WiFi
+static const uint32_t TASK_STATS_PERIOD_MS = 10000;  // Zapas stosów zadań -> /metrics
+static const uint32_t DAILY_RESTART_MS = 86400000UL; // 24h uptime
+
+// ---------- control ----------
+
+static Scheduler::TaskId sensorTaskId = -1;
+static Scheduler::TaskId algorithmTaskId = -1;
+
+// Spoczynek: algorytm czeka na pierwszy LOW, pompa stoi, przycisk puszczony.
+// Wtedy wystarczy rzadki okres - zbocze GPIO obudzi control wcześniej.
+// Przed prognozowaną dolewką czujniki zostają na pełnym próbkowaniu,
+// a sygnał ERR4 (anomalia w IDLE) potrzebuje okresu 100ms.
+static bool isChannelQuiescent(uint8_t ch) {
+    WaterAlgorithm& algorithm = getWaterChannel(ch);
+    SensorChannel& sensors = getSensorChannel(ch);
+    return !algorithm.isErrorSignalActive() &&
+           algorithm.getState() == STATE_IDLE &&
+           sensors.getPhase() == PHASE_IDLE &&
+           !getPumpChannel(ch).isActive() &&
+           sensors.readLowMask() == 0;
+}
+
+static bool isControlQuiescent() {
+    if (!isIdlePowerSaveEnabled() ||
+        isRefillExpectedSoon(getCachedUnixTimestamp()) ||
+        digitalRead(RESET_PIN) != HIGH) {
+        return false;
+    }
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        if (!isChannelQuiescent(ch)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t controlPeriodMs(uint32_t activeMs) {
+    return isControlQuiescent() ? POWER_IDLE_PERIOD_MS : activeMs;
+}
+
+// Poza IDLE czujniki mierzą co kilka-kilkadziesiąt sekund - śpij do najbliższego
+// pomiaru lub timeoutu fazy. W IDLE próbkowanie pierwszego LOW (albo zbocze GPIO).
+static uint32_t sensorTask(void*) {
+    {
+        PROFILE_SCOPE(PROF_SENSORS);
+        updateWaterSensors();
+    }
+
+    uint32_t dueMs = UINT32_MAX;
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        uint32_t chDueMs = getSensorChannel(ch).msUntilDue();
+        if (chDueMs < dueMs) {
+            dueMs = chDueMs;
+        }
+    }
+    if (dueMs == UINT32_MAX) {
+        return controlPeriodMs(SENSOR_PERIOD_MS);
+    }
+    return dueMs > SENSOR_PERIOD_MS ? dueMs : SENSOR_PERIOD_MS;
+}
+
+static uint32_t algorithmTask(void*) {
+    PROFILE_SCOPE(PROF_ALGORITHM);
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        getWaterChannel(ch).update();
+    }
+    return controlPeriodMs(ALGORITHM_PERIOD_MS);
+}
+
+static uint32_t dateCheckTask(void*) {
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        getWaterChannel(ch).checkUtcDay();
+    }
+    return 0;
+}
+
+static uint32_t releaseCheckTask(void*) {
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        getWaterChannel(ch).releaseCheckTick();
+    }
+    return 0;
+}
+
+static uint32_t statusLogTask(void*) {
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        getWaterChannel(ch).logStatus();
+    }
+    return 0;
+}
+
+static uint32_t pumpTask(void*) {
+    {
+        PROFILE_SCOPE(PROF_PUMP);
+        updatePumpController();
+    }
+
+    // AUTO zgłasza wyłącznie algorytm (PUMP_SOURCE_AUTO) - arbiter rozstrzyga kolizje
+
+    // Wyłączenie robi timer pompy (i budzi control na rozliczenie). Bez timera
+    // pompa kończy przed następnym okresem - obudź się dokładnie na wyłączenie
+    uint32_t wakeMs = PUMP_PERIOD_MS;
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        PumpChannel& pump = getPumpChannel(ch);
+        uint32_t remainingMs = pump.getRemainingMs();
+        if (pump.isActive() && !pump.hasCutoffTimer() && remainingMs < wakeMs) {
+            wakeMs = remainingMs > 0 ? remainingMs : 1;
+        }
+    }
+    if (wakeMs < PUMP_PERIOD_MS) {
+        return wakeMs;
+    }
+    return controlPeriodMs(PUMP_PERIOD_MS);
+}
+
+// Czekanie control: powiadomienie (polecenie HTTP / zbocze GPIO) albo termin.
+// W spoczynku uzbraja przerwania poziomem GPIO zamiast próbkowania czujników.
+static void controlWait(uint32_t waitMs) {
+    bool quiescent = isControlQuiescent();
+    powerSetControlIdle(quiescent);
+
+    uint32_t startMs = millis();
+    waitForControlWork(waitMs);
+
+    if (takeGpioWake()) {
+        powerRecordWake(WAKE_GPIO);
+        controlScheduler.wakeIn(sensorTaskId, 0);
+        controlScheduler.wakeIn(algorithmTaskId, 0);
+    } else if (millis() - startMs < waitMs) {
+        powerRecordWake(WAKE_COMMAND);
+        // Polecenie mogło zresetować proces czujników - przelicz ich termin
+        controlScheduler.wakeIn(sensorTaskId, 0);
+    } else {
+        powerRecordWake(WAKE_TIMER);
+    }
+}
+
+// ---------- storage ----------
+
+static uint32_t rtcRefreshTask(void*) {
+    refreshRTCCache();
+    return 0;
+}
+
+// ---------- housekeeping ----------
+
+static uint32_t housekeepingTask(void*) {
+    {
+        PROFILE_SCOPE(PROF_SESSIONS);
+        updateSessionManager();
+    }
+    {
+        PROFILE_SCOPE(PROF_RATE_LIMITER);
+        updateRateLimiter();
+    }
+    {
+        PROFILE_SCOPE(PROF_WIFI);
+        updateWiFi();
+    }
+    return 0;
+}
+
+static uint32_t taskStatsTask(void*) {
+    updateTaskStackMetrics();
+    metricsSetGauge(MG_STORAGE_QUEUE_DEPTH, getStorageQueueDepth());
+
+    PowerStats power = getPowerStats();
+    if (power.uptimeUs > 0) {
+        metricsSetGauge(MG_POWER_TASK_BUSY_PERMILLE, (int32_t)(power.taskBusyUs * 1000 / power.uptimeUs));
+    }
+    return 0;
+}
+
+static uint32_t dailyRestartTask(void*) {
+    // Pompa pracuje - spróbuj ponownie za chwilę zamiast przerywać dozowanie
+    if (isAnyPumpActive()) {
+        LOG_INFO("");
+        LOG_INFO("Daily restart postponed - pump active");
+        return 5000;
+    }
+
+    Serial.println("=== DAILY RESTART: 24h uptime reached ===");
+    Serial.println("System restarting in 3 seconds...");
+    delay(3000);
+    persistSessionsForRestart();
+    ESP.restart();
+    return SCHEDULER_DONE;
+}
+
+static void startSystemTasks() {
+    sensorTaskId = controlScheduler.every(SENSOR_PERIOD_MS, sensorTask, nullptr, "sensors");
+    algorithmTaskId = controlScheduler.every(ALGORITHM_PERIOD_MS, algorithmTask, nullptr, "algorithm");
+    controlScheduler.every(PUMP_PERIOD_MS, pumpTask, nullptr, "pump");
+    controlScheduler.every(DATE_CHECK_PERIOD_MS, dateCheckTask, nullptr, "date_check");
+    controlScheduler.every(RELEASE_CHECK_PERIOD_MS, releaseCheckTask, nullptr, "release_check");
+    controlScheduler.every(STATUS_LOG_PERIOD_MS, statusLogTask, nullptr, "status_log");
+
+    storageScheduler.every(RTC_REFRESH_PERIOD_MS, rtcRefreshTask, nullptr, "rtc_refresh");
+
+    housekeepingScheduler.every(HOUSEKEEPING_PERIOD_MS, housekeepingTask, nullptr, "housekeeping");
+    housekeepingScheduler.every(TASK_STATS_PERIOD_MS, taskStatsTask, nullptr, "task_stats");
+    housekeepingScheduler.after(DAILY_RESTART_MS - millis(), dailyRestartTask, nullptr, "daily_restart");
+
+    // Kopia czasu gotowa zanim ruszy sterowanie
+    refreshRTCCache();
+
+    startSystemTask(TASK_STORAGE, storageScheduler, processStorageJobs);
+    startSystemTask(TASK_CONTROL, controlScheduler, controlWait);
+    startSystemTask(TASK_HOUSEKEEPING, housekeepingScheduler);
+}
+
 void setup() {
     // Initialize core systems
     initLogging();
+    initMetrics();
+    initProfiler();
+    initTrace();
+    initI2CBus();
     delay(5000); // Wait for serial monitor
 
     LOG_INFO("");
@@ -96,7 +337,15 @@ void setup() {
 
     initNVS();
     loadVolumeFromNVS();
-    waterAlgorithm.initFromFRAM();
+    // Model parowania sortuje historię wg godzin lokalnych (localtime_r) -
+    // strefa musi być ustawiona przed initializeRTC()
+    configureTimezone();
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        getWaterChannel(ch).initFromFRAM();
+    }
+    initDebounceProfile();
+    initFlowCalibration();
+    initPumpUsage();
 
     bool credentials_loaded = initCredentialsManager();
     LOG_INFO("");
@@ -106,6 +355,7 @@ void setup() {
         LOG_INFO("FALLBACK_MODE");
     }
     initWiFi();
+    initPowerManager();
     initializeRTC();
     delay(2000);
 
@@ -123,7 +373,10 @@ void setup() {
         LOG_WARNING("");
     }
     LOG_INFO("Initializing daily volume tracking...");
-    waterAlgorithm.initDailyVolume();
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        getWaterChannel(ch).initDailyVolume();
+        getWaterChannel(ch).restoreCheckpoint();
+    }
 
     // Initialize security
     initAuthManager();
@@ -133,7 +386,8 @@ void setup() {
     // Initialize VPS logger
     // initVPSLogger();
     
-    // Initialize web server
+    // Initialize web server (state changes go through the control mailbox)
+    initControlCommands();
     initWebServer();
     
     // Post-init diagnostics
@@ -144,11 +398,14 @@ void setup() {
     LOG_INFO("RTC Working: %s", isRTCWorking() ? "YES" : "NO");
     LOG_INFO("RTC Info: %s", getRTCInfo().c_str());
     LOG_INFO("Current Time: %s", getCurrentTimestamp().c_str());
-    LOG_INFO("Water Algorithm:");
-    LOG_INFO("  State: %s", waterAlgorithm.getStateString());
-    LOG_INFO("  Daily Volume: %d / %d ml", 
-             waterAlgorithm.getDailyVolume(), FILL_WATER_MAX);
-    LOG_INFO("  UTC Day: %lu", waterAlgorithm.getLastResetUTCDay());
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        WaterAlgorithm& algorithm = getWaterChannel(ch);
+        LOG_INFO("Water Algorithm CH%d:", ch);
+        LOG_INFO("  State: %s", algorithm.getStateString());
+        LOG_INFO("  Daily Volume: %d / %d ml", 
+                 algorithm.getDailyVolume(), algorithm.getFillWaterMax());
+        LOG_INFO("  UTC Day: %lu", algorithm.getLastResetUTCDay());
+    }
     
     if (isWiFiConnected()) {
         LOG_INFO("Dashboard: http://");
@@ -157,56 +414,13 @@ void setup() {
     LOG_INFO("Current Time: %s", getCurrentTimestamp().c_str());
     LOG_INFO("=== System initialization complete ===");
     LOG_INFO("====================================");
+
+    initStorageQueue();
+    startSystemTasks();
 }
 
 void loop() {
-    // Production mode loop - full water system
-    static unsigned long lastUpdate = 0;
-    unsigned long now = millis();
-    
-    // DAILY RESTART CHECK - 24 godziny
-    if (now > 86400000UL) { // 24h w ms
-        Serial.println("=== DAILY RESTART: 24h uptime reached ===");
-        
-        if (isPumpActive()) {
-            stopPump();
-            Serial.println("Pump stopped before restart");
-            delay(1000);
-        }
-        
-        Serial.println("System restarting in 3 seconds...");
-        delay(3000);
-        ESP.restart();
-    }
-    
-    // Update water sensors every loop
-    updateWaterSensors();
-    waterAlgorithm.update();
-    
-    // Update other systems every 100ms
-    if (now - lastUpdate >= 100) {
-        updatePumpController();
-        updateSessionManager();
-        updateRateLimiter();
-        updateWiFi();
-        
-        // ============== AUTO PUMP TRIGGER (with system disable check) ==============
-        // Only trigger auto pump if:
-        // - System is NOT disabled
-        // - Auto mode is enabled
-        // - Water level is low (shouldActivatePump)
-        // - Pump is not already running
-        if (!isSystemDisabled() && 
-            currentPumpSettings.autoModeEnabled && 
-            shouldActivatePump() && 
-            !isPumpActive()) {
-            LOG_INFO("");
-            LOG_INFO("Auto pump triggered - water level low");    
-            triggerPump(currentPumpSettings.manualCycleSeconds, "AUTO_PUMP");
-        }
-        
-        lastUpdate = now;
-    }
-
-    delay(100);
-}
\ No newline at end of file
+    // Production mode: praca przeniesiona do zadań control/storage/housekeeping,
+    // loopTask nie jest już potrzebny - zwolnij jego stos
+    vTaskDelete(NULL);
+}
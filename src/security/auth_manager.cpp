@@ -4,9 +4,38 @@
 #include <mbedtls/md.h>
 #include "../config/credentials_manager.h"
 
+// ============== WHITELIST IP ==============
+// ALLOWED_IPS posortowane raz przy starcie (uint32, kolejność bajtów bez
+// znaczenia) - isIPAllowed() to wyszukiwanie binarne bez alokacji.
+#define AUTH_ALLOWED_IPS_MAX    16
+
+static uint32_t allowedSorted[AUTH_ALLOWED_IPS_MAX];
+static uint8_t allowedCount = 0;
+
+static void buildAllowedTable() {
+    allowedCount = 0;
+    for (int i = 0; i < ALLOWED_IPS_COUNT; i++) {
+        if (allowedCount >= AUTH_ALLOWED_IPS_MAX) {
+            LOG_ERROR("");
+            LOG_ERROR("ALLOWED_IPS has %d entries, only %d used", ALLOWED_IPS_COUNT, AUTH_ALLOWED_IPS_MAX);
+            break;
+        }
+        uint32_t ip = (uint32_t)ALLOWED_IPS[i];
+        uint8_t pos = allowedCount;
+        while (pos > 0 && allowedSorted[pos - 1] > ip) {
+            allowedSorted[pos] = allowedSorted[pos - 1];
+            pos--;
+        }
+        allowedSorted[pos] = ip;
+        allowedCount++;
+    }
+}
+
 void initAuthManager() {
+    buildAllowedTable();
+
     LOG_INFO("");
-    LOG_INFO("Authentication manager initialized");
+    LOG_INFO("Authentication manager initialized (%d whitelisted IPs)", allowedCount);
 
     LOG_INFO("Using %s admin credentials", areCredentialsLoaded() ? "FRAM" : "fallback");
     if (areCredentialsLoaded()) {
@@ -22,12 +51,18 @@ void initAuthManager() {
 }
 
 bool isIPAllowed(IPAddress ip) {
-    for (int i = 0; i < ALLOWED_IPS_COUNT; i++) {
-        if (ALLOWED_IPS[i] == ip) {
-            return true;
+    uint32_t key = (uint32_t)ip;
+    uint8_t lo = 0;
+    uint8_t hi = allowedCount;
+    while (lo < hi) {
+        uint8_t mid = (lo + hi) / 2;
+        if (allowedSorted[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
-    return false;
+    return lo < allowedCount && allowedSorted[lo] == key;
 }
 
 String hashPassword(const String& password) {
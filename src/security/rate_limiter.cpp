@@ -2,23 +2,145 @@
 #include "../config/config.h"
 #include "../security/auth_manager.h"
 #include "../core/logging.h"
-#include <map>
-#include <vector>
+#include "../core/metrics.h"
 
-static std::map<uint32_t, String> ipStringCache;
+// ============== TABLICA KLIENTÓW (open addressing, klucz = IPv4) ==============
+// Stały rozmiar - flood z wielu adresów nie powiększa pamięci, tylko
+// wypycha najdawniej widzianych klientów (LRU).
+static const uint8_t RATE_LIMIT_BUCKETS = 32;      // Potęga 2
+static const uint8_t RATE_LIMIT_MAX_CLIENTS = 24;  // ~75% zapełnienia - krótkie sondowanie
+static const unsigned long RATE_LIMIT_IDLE_MS = 300000;
 
-struct RateLimitData {
-    std::vector<unsigned long> requestTimes;
-    int failedAttempts;
+// Token bucket w mili-tokenach: pojemność RATE_LIMIT_BURST,
+// uzupełnianie MAX_REQUESTS_PER_SECOND na RATE_LIMIT_WINDOW_MS
+static const uint32_t TOKEN_SCALE = 1000;
+static const uint32_t BUCKET_CAPACITY = RATE_LIMIT_BURST * TOKEN_SCALE;
+static const uint32_t REFILL_PER_WINDOW = MAX_REQUESTS_PER_SECOND * TOKEN_SCALE;
+static const unsigned long FULL_REFILL_MS = RATE_LIMIT_WINDOW_MS * RATE_LIMIT_BURST / MAX_REQUESTS_PER_SECOND;
+
+struct RateLimitEntry {
+    uint32_t ip;
+    uint32_t tokens;                // mili-tokeny
+    unsigned long lastRefill;
+    unsigned long lastSeen;         // LRU
     unsigned long blockUntil;
-    unsigned long lastRequest;
+    uint8_t failedAttempts;
+    bool inUse;
 };
 
-std::map<String, RateLimitData> rateLimitData;
+static RateLimitEntry clients[RATE_LIMIT_BUCKETS];
+static uint8_t clientCount = 0;
+
+static uint8_t homeBucket(uint32_t ip) {
+    // Knuth multiplicative hash - ostatni oktet zmienia się najczęściej
+    return (uint32_t)(ip * 2654435761UL) >> 27;
+}
+
+static int8_t findEntry(uint32_t ip) {
+    uint8_t bucket = homeBucket(ip);
+    for (uint8_t probe = 0; probe < RATE_LIMIT_BUCKETS; probe++) {
+        if (!clients[bucket].inUse) {
+            return -1;
+        }
+        if (clients[bucket].ip == ip) {
+            return bucket;
+        }
+        bucket = (bucket + 1) & (RATE_LIMIT_BUCKETS - 1);
+    }
+    return -1;
+}
+
+// Backward-shift deletion - bez tombstone'ów, łańcuchy zostają spójne
+static void removeEntry(uint8_t bucket) {
+    clients[bucket].inUse = false;
+    clientCount--;
+
+    uint8_t hole = bucket;
+    uint8_t next = (hole + 1) & (RATE_LIMIT_BUCKETS - 1);
+    while (clients[next].inUse) {
+        uint8_t home = homeBucket(clients[next].ip);
+        // Przesuń, jeśli dziura leży między home a bieżącą pozycją (cyklicznie)
+        if (((next - home) & (RATE_LIMIT_BUCKETS - 1)) >= ((next - hole) & (RATE_LIMIT_BUCKETS - 1))) {
+            clients[hole] = clients[next];
+            clients[next].inUse = false;
+            hole = next;
+        }
+        next = (next + 1) & (RATE_LIMIT_BUCKETS - 1);
+    }
+}
+
+static bool isBlockActive(const RateLimitEntry& entry, unsigned long now) {
+    return entry.blockUntil != 0 && (long)(entry.blockUntil - now) > 0;
+}
+
+static void evictLeastRecentlyUsed(unsigned long now) {
+    int8_t victim = -1;
+    for (uint8_t i = 0; i < RATE_LIMIT_BUCKETS; i++) {
+        if (!clients[i].inUse) {
+            continue;
+        }
+        // Zablokowanych nie wypychamy, dopóki są inni kandydaci
+        if (victim < 0 ||
+            (isBlockActive(clients[victim], now) && !isBlockActive(clients[i], now)) ||
+            (isBlockActive(clients[victim], now) == isBlockActive(clients[i], now) &&
+             now - clients[i].lastSeen > now - clients[victim].lastSeen)) {
+            victim = i;
+        }
+    }
+    if (victim >= 0) {
+        removeEntry(victim);
+        metricsInc(MC_RATE_EVICTIONS);
+    }
+}
+
+static RateLimitEntry& getOrCreateEntry(uint32_t ip, unsigned long now) {
+    int8_t found = findEntry(ip);
+    if (found >= 0) {
+        return clients[found];
+    }
+
+    if (clientCount >= RATE_LIMIT_MAX_CLIENTS) {
+        evictLeastRecentlyUsed(now);
+    }
+
+    uint8_t bucket = homeBucket(ip);
+    while (clients[bucket].inUse) {
+        bucket = (bucket + 1) & (RATE_LIMIT_BUCKETS - 1);
+    }
+
+    RateLimitEntry& entry = clients[bucket];
+    entry.ip = ip;
+    entry.tokens = BUCKET_CAPACITY;
+    entry.lastRefill = now;
+    entry.lastSeen = now;
+    entry.blockUntil = 0;
+    entry.failedAttempts = 0;
+    entry.inUse = true;
+    clientCount++;
+    metricsSetGauge(MG_RATE_LIMIT_CLIENTS, clientCount);
+    return entry;
+}
+
+static void refillTokens(RateLimitEntry& entry, unsigned long now) {
+    unsigned long elapsed = now - entry.lastRefill;
+    if (elapsed >= FULL_REFILL_MS) {
+        entry.tokens = BUCKET_CAPACITY;
+    } else {
+        uint32_t added = elapsed * REFILL_PER_WINDOW / RATE_LIMIT_WINDOW_MS;
+        entry.tokens += added;
+        if (entry.tokens > BUCKET_CAPACITY) {
+            entry.tokens = BUCKET_CAPACITY;
+        }
+    }
+    entry.lastRefill = now;
+}
 
 void initRateLimiter() {
-    rateLimitData.clear();
-    LOG_INFO("Rate limiter initialized");
+    for (uint8_t i = 0; i < RATE_LIMIT_BUCKETS; i++) {
+        clients[i].inUse = false;
+    }
+    clientCount = 0;
+    LOG_INFO("Rate limiter initialized (%d client slots)", RATE_LIMIT_MAX_CLIENTS);
 }
 
 void updateRateLimiter() {
@@ -26,127 +148,95 @@ void updateRateLimiter() {
     
     // Clean old data every 5 minutes
     static unsigned long lastCleanup = 0;
-    if (now - lastCleanup > 300000) {
-        for (auto it = rateLimitData.begin(); it != rateLimitData.end();) {
-            if (now - it->second.lastRequest > 300000) {
-                it = rateLimitData.erase(it);
-            } else {
-                ++it;
+    if (now - lastCleanup > RATE_LIMIT_IDLE_MS) {
+        uint8_t i = 0;
+        while (i < RATE_LIMIT_BUCKETS) {
+            RateLimitEntry& entry = clients[i];
+            if (entry.inUse && now - entry.lastSeen > RATE_LIMIT_IDLE_MS && !isBlockActive(entry, now)) {
+                // Backward shift może wstawić inny wpis pod ten sam indeks
+                removeEntry(i);
+                continue;
             }
+            i++;
         }
         lastCleanup = now;
+        metricsSetGauge(MG_RATE_LIMIT_CLIENTS, clientCount);
     }
 }
 
 bool isRateLimited(IPAddress ip) {
-    if (isIPAllowed(ip)) {
-        return false; // No rate limiting for whitelisted IPs
+    if (isTrustedProxy(ip)) {
+        return false; // Tylko VPS/proxy bez limitu - whitelist to jedyni klienci z dostępem
     }
     
-    String ipStr = ip.toString();
-    if (rateLimitData.find(ipStr) == rateLimitData.end()) {
+    int8_t found = findEntry((uint32_t)ip);
+    if (found < 0) {
         return false;
     }
     
-    RateLimitData& data = rateLimitData[ipStr];
+    RateLimitEntry& entry = clients[found];
     unsigned long now = millis();
     
     // Check if blocked
-    if (data.blockUntil > now) {
+    if (isBlockActive(entry, now)) {
         return true;
     }
     
-    // Clean old requests
-    data.requestTimes.erase(
-        std::remove_if(data.requestTimes.begin(), data.requestTimes.end(),
-                      [now](unsigned long time) { return now - time > RATE_LIMIT_WINDOW_MS; }),
-        data.requestTimes.end());
-    
-    return data.requestTimes.size() >= MAX_REQUESTS_PER_SECOND;
+    refillTokens(entry, now);
+    if (entry.tokens < TOKEN_SCALE) {
+        metricsInc(MC_RATE_LIMITED);
+        return true;
+    }
+    return false;
 }
 
 void recordRequest(IPAddress ip) {
-        // ✅ CACHE dla IP string conversion
-    uint32_t ipUint = ip;
- 
-    String ipStr = ip.toString();
     unsigned long now = millis();
-    
-    auto cachedIP = ipStringCache.find(ipUint);
-    if (cachedIP != ipStringCache.end()) {
-        ipStr = cachedIP->second;
-    } else {
-        ipStr = ip.toString();
-        ipStringCache[ipUint] = ipStr;
-        
-        // Limit cache size (max 10 IPs)
-        if (ipStringCache.size() > 10) {
-            auto oldest = ipStringCache.begin();
-            ipStringCache.erase(oldest);
-        }
-    }
+    RateLimitEntry& entry = getOrCreateEntry((uint32_t)ip, now);
 
-    RateLimitData& data = rateLimitData[ipStr];
-    
-    // 🔍 DEBUGGING - rozmiar PRZED czyszczeniem
-    size_t sizeBefore = data.requestTimes.size();
-    size_t totalIPsBefore = rateLimitData.size();
-    
-    // ✅ CZYŚĆ STARE przed dodaniem nowego
-    data.requestTimes.erase(
-        std::remove_if(data.requestTimes.begin(), data.requestTimes.end(),
-                      [now](unsigned long time) { 
-                          return now - time > RATE_LIMIT_WINDOW_MS; 
-                      }),
-        data.requestTimes.end());
-    
-    size_t sizeAfterCleanup = data.requestTimes.size();
-    size_t cleaned = sizeBefore - sizeAfterCleanup;
-    
-    // ✅ HARD LIMIT - maksymalnie 20 timestampów
-    size_t hardLimitCleaned = 0;
-    if (data.requestTimes.size() >= 20) {
-        hardLimitCleaned = 10;
-        data.requestTimes.erase(data.requestTimes.begin(), 
-                               data.requestTimes.begin() + 10);
+    refillTokens(entry, now);
+    if (entry.tokens >= TOKEN_SCALE) {
+        entry.tokens -= TOKEN_SCALE;
     }
-    
-    data.requestTimes.push_back(now);
-    data.lastRequest = now;
-    
-    // 🔍 DEBUGGING - rozmiar PO wszystkich operacjach
-    size_t sizeFinal = data.requestTimes.size();
-    
-    // 🔍 LOG co 50 requestów LUB gdy było czyszczenie
-    static int requestCounter = 0;
-    requestCounter++;
+    entry.lastSeen = now;
 }
 
 void recordFailedAttempt(IPAddress ip) {
-    if (isIPAllowed(ip)) {
-        return; // No blocking for whitelisted IPs
+    if (isTrustedProxy(ip)) {
+        return; // No blocking for the trusted VPS/proxy
     }
     
-    String ipStr = ip.toString();
     unsigned long now = millis();
-    
-    RateLimitData& data = rateLimitData[ipStr];
-    data.failedAttempts++;
-    
-    if (data.failedAttempts >= MAX_FAILED_ATTEMPTS) {
-        data.blockUntil = now + BLOCK_DURATION_MS;
-        data.failedAttempts = 0;
-        LOG_WARNING("IP %s blocked for failed attempts", ipStr.c_str());
+    RateLimitEntry& entry = getOrCreateEntry((uint32_t)ip, now);
+    entry.lastSeen = now;
+    entry.failedAttempts++;
+    
+    if (entry.failedAttempts >= MAX_FAILED_ATTEMPTS) {
+        entry.blockUntil = now + BLOCK_DURATION_MS;
+        if (entry.blockUntil == 0) {
+            entry.blockUntil = 1;   // 0 = brak blokady
+        }
+        entry.failedAttempts = 0;
+        metricsInc(MC_RATE_IP_BLOCKS);
+        LOG_WARNING("IP %s blocked for failed attempts", ip.toString().c_str());
+    }
+}
+
+// Poprawne uwierzytelnienie zeruje licznik - blokada tylko za kolejne nieudane próby
+void recordSuccessfulAuth(IPAddress ip) {
+    int8_t found = findEntry((uint32_t)ip);
+    if (found >= 0) {
+        clients[found].failedAttempts = 0;
     }
 }
 
 bool isIPBlocked(IPAddress ip) {
-    if (isIPAllowed(ip)) {
+    if (isTrustedProxy(ip)) {
         return false;
     }
-    String ipStr = ip.toString();
-    if (rateLimitData.find(ipStr) == rateLimitData.end()) {
+    int8_t found = findEntry((uint32_t)ip);
+    if (found < 0) {
         return false;
     }
-    return rateLimitData[ipStr].blockUntil > millis();
-}
\ No newline at end of file
+    return isBlockActive(clients[found], millis());
+}
@@ -9,6 +9,7 @@ void updateRateLimiter();
 bool isRateLimited(IPAddress ip);
 void recordRequest(IPAddress ip);
 void recordFailedAttempt(IPAddress ip);
+void recordSuccessfulAuth(IPAddress ip);
 bool isIPBlocked(IPAddress ip);
 
 #endif
\ No newline at end of file
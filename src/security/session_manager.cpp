@@ -1,33 +1,232 @@
 #include "session_manager.h"
 #include "../config/config.h"
 #include "../core/logging.h"
+#include "../core/metrics.h"
+#include "../hardware/rtc_controller.h"
+#include <esp_random.h>
+#include <esp_system.h>
+#include <esp_attr.h>
 
 // ✅ FIX 3: Add session limits to prevent memory exhaustion
 static const size_t MAX_TOTAL_SESSIONS = 10;       // Maximum total sessions
 static const size_t MAX_SESSIONS_PER_IP = 3;       // Maximum sessions per IP
 
-std::vector<Session> activeSessions;
+// ============== TABLICA SESJI (stały rozmiar, bez alokacji) ==============
+// sessions[]  - sloty sesji
+// hashIndex[] - open addressing: bucket -> numer slotu (EMPTY / TOMBSTONE)
+static const uint8_t SESSION_HASH_BUCKETS = 16;    // Potęga 2, > MAX_TOTAL_SESSIONS
+static const int8_t HASH_EMPTY = -1;
+static const int8_t HASH_TOMBSTONE = -2;
+
+static Session sessions[MAX_TOTAL_SESSIONS];
+static int8_t hashIndex[SESSION_HASH_BUCKETS];
+static size_t sessionCount = 0;
+
+// Najwcześniejszy możliwy moment wygaśnięcia - sweep tylko gdy minął
+static unsigned long nextExpiryAt = 0;
+static bool expirySweepArmed = false;
+
+// ============== PERSYSTENCJA PRZEZ WARM RESTART ==============
+// RTC_NOINIT - pamięć nie jest zerowana przy ESP.restart(), ale po
+// power-on zawiera śmieci, więc magic + checksum są obowiązkowe.
+#define SESSION_PERSIST_MAGIC   0x53455353UL    // "SESS"
+
+struct PersistedSession {
+    uint8_t token[SESSION_TOKEN_BYTES];
+    uint32_t ip;
+    uint32_t ageMs;             // Czas od utworzenia
+    uint32_t idleMs;            // Czas od ostatniej aktywności
+};
+
+struct PersistedSessionStore {
+    uint32_t magic;
+    uint32_t savedUnix;         // Czas RTC zapisu - przerwa doliczana do bezczynności
+    uint8_t count;
+    PersistedSession entries[MAX_TOTAL_SESSIONS];
+    uint32_t checksum;
+};
+
+static RTC_NOINIT_ATTR PersistedSessionStore persistedSessions;
+
+// FNV-1a over the binary token
+static uint32_t hashToken(const uint8_t* token) {
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < SESSION_TOKEN_BYTES; i++) {
+        hash ^= token[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+// Constant-time comparison - czas nie zależy od pozycji pierwszej różnicy
+static bool tokenEquals(const uint8_t* a, const uint8_t* b) {
+    uint8_t diff = 0;
+    for (size_t i = 0; i < SESSION_TOKEN_BYTES; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+static void resetHashIndex() {
+    for (uint8_t i = 0; i < SESSION_HASH_BUCKETS; i++) {
+        hashIndex[i] = HASH_EMPTY;
+    }
+}
+
+static int8_t findSlot(const uint8_t* token, uint32_t hash) {
+    uint8_t bucket = hash & (SESSION_HASH_BUCKETS - 1);
+    for (uint8_t probe = 0; probe < SESSION_HASH_BUCKETS; probe++) {
+        int8_t slot = hashIndex[bucket];
+        if (slot == HASH_EMPTY) {
+            return -1;
+        }
+        if (slot >= 0 && sessions[slot].tokenHash == hash &&
+            tokenEquals(sessions[slot].token, token)) {
+            return slot;
+        }
+        bucket = (bucket + 1) & (SESSION_HASH_BUCKETS - 1);
+    }
+    return -1;
+}
+
+static void indexInsert(int8_t slot) {
+    uint8_t bucket = sessions[slot].tokenHash & (SESSION_HASH_BUCKETS - 1);
+    for (uint8_t probe = 0; probe < SESSION_HASH_BUCKETS; probe++) {
+        if (hashIndex[bucket] < 0) {
+            hashIndex[bucket] = slot;
+            return;
+        }
+        bucket = (bucket + 1) & (SESSION_HASH_BUCKETS - 1);
+    }
+}
+
+static void removeSlot(int8_t slot) {
+    for (uint8_t i = 0; i < SESSION_HASH_BUCKETS; i++) {
+        if (hashIndex[i] == slot) {
+            hashIndex[i] = HASH_TOMBSTONE;
+            break;
+        }
+    }
+    sessions[slot].isValid = false;
+    sessions[slot].generation++;
+    memset(sessions[slot].token, 0, SESSION_TOKEN_BYTES);
+    if (sessionCount > 0) {
+        sessionCount--;
+    }
+    metricsSetGauge(MG_SESSIONS_ACTIVE, sessionCount);
+
+    // Pusta tablica - wyczyść tombstone'y, żeby sondowanie zostało krótkie
+    if (sessionCount == 0) {
+        resetHashIndex();
+    }
+}
+
+static bool isExpired(const Session& session, unsigned long now) {
+    return now - session.lastActivity > SESSION_TIMEOUT_MS;
+}
+
+static void armExpiry(unsigned long lastActivity) {
+    unsigned long expiresAt = lastActivity + SESSION_TIMEOUT_MS;
+    if (!expirySweepArmed || (long)(expiresAt - nextExpiryAt) < 0) {
+        nextExpiryAt = expiresAt;
+        expirySweepArmed = true;
+    }
+}
+
+static uint32_t persistChecksum(const PersistedSessionStore& store) {
+    const uint8_t* data = (const uint8_t*)&store;
+    size_t len = offsetof(PersistedSessionStore, checksum);
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+static void restorePersistedSessions() {
+    bool warmRestart = esp_reset_reason() == ESP_RST_SW;
+    bool valid = persistedSessions.magic == SESSION_PERSIST_MAGIC &&
+                 persistedSessions.count <= MAX_TOTAL_SESSIONS &&
+                 persistedSessions.checksum == persistChecksum(persistedSessions);
+
+    // Bez ważnego czasu po obu stronach restartu przerwa jest nieznana -
+    // sesje nie są wskrzeszane (bezczynność mogła przekroczyć timeout)
+    uint32_t nowUnix = isRTCWorking() ? getUnixTimestamp() : 0;
+    bool timeValid = isUnixTimeValid(persistedSessions.savedUnix) &&
+                     nowUnix >= persistedSessions.savedUnix;
+    if (warmRestart && valid && !timeValid) {
+        LOG_WARNING("Persisted sessions dropped - downtime unknown (RTC not valid)");
+    }
+
+    if (warmRestart && valid && timeValid) {
+        unsigned long now = millis();
+        uint64_t downtimeMs = (uint64_t)(nowUnix - persistedSessions.savedUnix) * 1000ULL;
+        for (uint8_t i = 0; i < persistedSessions.count; i++) {
+            const PersistedSession& saved = persistedSessions.entries[i];
+            uint64_t idleMs = saved.idleMs + downtimeMs;
+            if (idleMs >= SESSION_TIMEOUT_MS) {
+                continue;
+            }
+
+            Session& session = sessions[sessionCount];
+            memcpy(session.token, saved.token, SESSION_TOKEN_BYTES);
+            session.tokenHash = hashToken(session.token);
+            session.ip = IPAddress(saved.ip);
+            // Znaczniki czasu względem nowego millis() - arytmetyka modulo 2^32
+            session.createdAt = now - (uint32_t)(saved.ageMs + downtimeMs);
+            session.lastActivity = now - (uint32_t)idleMs;
+            session.isValid = true;
+
+            indexInsert(sessionCount);
+            armExpiry(session.lastActivity);
+            sessionCount++;
+        }
+        metricsInc(MC_SESSIONS_RESTORED, sessionCount);
+        metricsSetGauge(MG_SESSIONS_ACTIVE, sessionCount);
+        LOG_INFO("Restored %zu session(s) after warm restart", sessionCount);
+    }
+
+    // Jednorazowe - kolejny restart (np. watchdog) nie może ich wskrzesić
+    persistedSessions.magic = 0;
+}
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
 
 void initSessionManager() {
-    activeSessions.clear();
-    activeSessions.reserve(MAX_TOTAL_SESSIONS); // Pre-allocate to avoid reallocations
+    for (size_t i = 0; i < MAX_TOTAL_SESSIONS; i++) {
+        sessions[i] = Session();
+    }
+    resetHashIndex();
+    sessionCount = 0;
+    expirySweepArmed = false;
+
+    restorePersistedSessions();
+
     LOG_INFO("Session manager initialized (max %zu sessions)", MAX_TOTAL_SESSIONS);
 }
+
 // ✅ Helper function to remove oldest session if needed
 void removeOldestSessionIfNeeded() {
-    if (activeSessions.size() >= MAX_TOTAL_SESSIONS) {
+    if (sessionCount >= MAX_TOTAL_SESSIONS) {
         // Find and remove the oldest session
-        auto oldestIt = activeSessions.begin();
-        for (auto it = activeSessions.begin(); it != activeSessions.end(); ++it) {
-            if (it->createdAt < oldestIt->createdAt) {
-                oldestIt = it;
+        int8_t oldest = -1;
+        for (size_t i = 0; i < MAX_TOTAL_SESSIONS; i++) {
+            if (sessions[i].isValid &&
+                (oldest < 0 || sessions[i].createdAt < sessions[oldest].createdAt)) {
+                oldest = i;
             }
         }
-        
-        if (oldestIt != activeSessions.end()) {
-            LOG_WARNING("Session limit reached, removing oldest session for IP: %s", 
-                       oldestIt->ip.toString().c_str());
-            activeSessions.erase(oldestIt);
+
+        if (oldest >= 0) {
+            LOG_WARNING("Session limit reached, removing oldest session for IP: %s",
+                       sessions[oldest].ip.toString().c_str());
+            removeSlot(oldest);
         }
     }
 }
@@ -35,8 +234,8 @@ void removeOldestSessionIfNeeded() {
 // ✅ Helper function to count sessions for specific IP
 size_t countSessionsForIP(IPAddress ip) {
     size_t count = 0;
-    for (const auto& session : activeSessions) {
-        if (session.ip == ip && session.isValid) {
+    for (size_t i = 0; i < MAX_TOTAL_SESSIONS; i++) {
+        if (sessions[i].isValid && sessions[i].ip == ip) {
             count++;
         }
     }
@@ -45,104 +244,213 @@ size_t countSessionsForIP(IPAddress ip) {
 
 void updateSessionManager() {
     unsigned long now = millis();
-    
-    for (auto it = activeSessions.begin(); it != activeSessions.end();) {
-        if (!it->isValid || (now - it->lastActivity > SESSION_TIMEOUT_MS)) {
-            LOG_INFO("Removing expired session for IP: %s", it->ip.toString().c_str());
-            it = activeSessions.erase(it);
+
+    // Nic nie mogło wygasnąć przed najwcześniejszym terminem
+    if (!expirySweepArmed || (long)(now - nextExpiryAt) < 0) {
+        return;
+    }
+
+    expirySweepArmed = false;
+    for (size_t i = 0; i < MAX_TOTAL_SESSIONS; i++) {
+        if (!sessions[i].isValid) {
+            continue;
+        }
+        if (isExpired(sessions[i], now)) {
+            LOG_INFO("Removing expired session for IP: %s", sessions[i].ip.toString().c_str());
+            removeSlot(i);
+            metricsInc(MC_SESSIONS_EXPIRED);
         } else {
-            ++it;
+            armExpiry(sessions[i].lastActivity);
         }
     }
 }
 
+void persistSessionsForRestart() {
+    unsigned long now = millis();
+    uint8_t count = 0;
+
+    for (size_t i = 0; i < MAX_TOTAL_SESSIONS; i++) {
+        const Session& session = sessions[i];
+        if (!session.isValid || isExpired(session, now)) {
+            continue;
+        }
+        PersistedSession& saved = persistedSessions.entries[count++];
+        memcpy(saved.token, session.token, SESSION_TOKEN_BYTES);
+        saved.ip = (uint32_t)session.ip;
+        saved.ageMs = now - session.createdAt;
+        saved.idleMs = now - session.lastActivity;
+    }
+
+    uint32_t nowUnix = getCachedUnixTimestamp();
+    persistedSessions.savedUnix = isUnixTimeValid(nowUnix) ? nowUnix : 0;
+    persistedSessions.count = count;
+    persistedSessions.magic = SESSION_PERSIST_MAGIC;
+    persistedSessions.checksum = persistChecksum(persistedSessions);
+
+    LOG_INFO("Persisted %d session(s) for warm restart", count);
+}
+
 String createSession(IPAddress ip) {
     // ✅ FIX 3: Check session limits before creating new session
     // Check per-IP limit
     size_t sessionsForIP = countSessionsForIP(ip);
     if (sessionsForIP >= MAX_SESSIONS_PER_IP) {
-        LOG_WARNING("Too many sessions for IP %s (%zu/%zu), removing oldest", 
+        LOG_WARNING("Too many sessions for IP %s (%zu/%zu), removing oldest",
                    ip.toString().c_str(), sessionsForIP, MAX_SESSIONS_PER_IP);
-        
+
         // Remove oldest session for this IP
-        auto oldestForIP = activeSessions.end();
-        for (auto it = activeSessions.begin(); it != activeSessions.end(); ++it) {
-            if (it->ip == ip && it->isValid) {
-                if (oldestForIP == activeSessions.end() || it->createdAt < oldestForIP->createdAt) {
-                    oldestForIP = it;
-                }
+        int8_t oldestForIP = -1;
+        for (size_t i = 0; i < MAX_TOTAL_SESSIONS; i++) {
+            if (sessions[i].isValid && sessions[i].ip == ip &&
+                (oldestForIP < 0 || sessions[i].createdAt < sessions[oldestForIP].createdAt)) {
+                oldestForIP = i;
             }
         }
-        
-        if (oldestForIP != activeSessions.end()) {
-            activeSessions.erase(oldestForIP);
+
+        if (oldestForIP >= 0) {
+            removeSlot(oldestForIP);
         }
     }
-    
+
     // Check total session limit
-    if (activeSessions.size() >= MAX_TOTAL_SESSIONS) {
-        removeOldestSessionIfNeeded();
-    }
-    
-    // Create new session
-    Session newSession;
-    newSession.token = "";
-    
-    // ✅ Improved token generation with better randomness
-    randomSeed(millis() ^ micros() ^ analogRead(A0));
-    for (int i = 0; i < 32; i++) {
-        newSession.token += String(random(0, 16), HEX);
-    }
-    
-    newSession.ip = ip;
-    newSession.createdAt = millis();
-    newSession.lastActivity = millis();
-    newSession.isValid = true;
-    
+    removeOldestSessionIfNeeded();
+
+    int8_t slot = -1;
+    for (size_t i = 0; i < MAX_TOTAL_SESSIONS; i++) {
+        if (!sessions[i].isValid) {
+            slot = i;
+            break;
+        }
+    }
+
     // ✅ Double-check we're not exceeding limits (paranoid check)
-    if (activeSessions.size() >= MAX_TOTAL_SESSIONS) {
+    if (slot < 0) {
         LOG_ERROR("Critical: Session creation would exceed limits!");
         return ""; // Return empty token to indicate failure
     }
-    
-    activeSessions.push_back(newSession);
-    
-    LOG_INFO("Session created for IP: %s (total sessions: %zu/%zu)", 
-             ip.toString().c_str(), activeSessions.size(), MAX_TOTAL_SESSIONS);
-    return newSession.token;
+
+    Session& session = sessions[slot];
+
+    // 128-bit token z hardware RNG (przy aktywnym WiFi/BT - prawdziwa entropia)
+    do {
+        esp_fill_random(session.token, SESSION_TOKEN_BYTES);
+        session.tokenHash = hashToken(session.token);
+    } while (findSlot(session.token, session.tokenHash) >= 0);
+
+    session.ip = ip;
+    session.createdAt = millis();
+    session.lastActivity = session.createdAt;
+    session.isValid = true;
+
+    indexInsert(slot);
+    armExpiry(session.lastActivity);
+    sessionCount++;
+    metricsInc(MC_SESSIONS_CREATED);
+    metricsSetGauge(MG_SESSIONS_ACTIVE, sessionCount);
+
+    char hex[SESSION_TOKEN_HEX_LEN + 1];
+    for (size_t i = 0; i < SESSION_TOKEN_BYTES; i++) {
+        sprintf(&hex[i * 2], "%02x", session.token[i]);
+    }
+
+    LOG_INFO("Session created for IP: %s (total sessions: %zu/%zu)",
+             ip.toString().c_str(), sessionCount, MAX_TOTAL_SESSIONS);
+    return String(hex);
 }
 
-bool validateSession(const String& token, IPAddress ip) {
-    if (token.length() == 0) {
+bool validateSessionToken(const uint8_t* token, IPAddress ip, SessionRef* ref) {
+    int8_t slot = findSlot(token, hashToken(token));
+    if (slot < 0) {
         return false;
     }
-    
-    for (auto& session : activeSessions) {
-        if (session.token == token && session.ip == ip && session.isValid) {
-            if (millis() - session.lastActivity > SESSION_TIMEOUT_MS) {
-                session.isValid = false;
-                LOG_INFO("Session expired for IP: %s", ip.toString().c_str());
-                return false;
-            }
-            session.lastActivity = millis();
-            return true;
-        }
+
+    Session& session = sessions[slot];
+    if (!session.isValid || session.ip != ip) {
+        return false;
+    }
+
+    unsigned long now = millis();
+    if (isExpired(session, now)) {
+        LOG_INFO("Session expired for IP: %s", ip.toString().c_str());
+        removeSlot(slot);
+        metricsInc(MC_SESSIONS_EXPIRED);
+        return false;
+    }
+
+    session.lastActivity = now;
+    if (ref) {
+        ref->slot = slot;
+        ref->generation = session.generation;
+    }
+    return true;
+}
+
+bool touchSession(const SessionRef& ref, IPAddress ip) {
+    if (ref.slot < 0 || ref.slot >= (int8_t)MAX_TOTAL_SESSIONS) {
+        return false;
+    }
+
+    Session& session = sessions[ref.slot];
+    if (!session.isValid || session.generation != ref.generation || session.ip != ip) {
+        return false;
+    }
+
+    unsigned long now = millis();
+    if (isExpired(session, now)) {
+        removeSlot(ref.slot);
+        metricsInc(MC_SESSIONS_EXPIRED);
+        return false;
+    }
+
+    session.lastActivity = now;
+    return true;
+}
+
+void destroySessionToken(const uint8_t* token) {
+    int8_t slot = findSlot(token, hashToken(token));
+    if (slot >= 0) {
+        LOG_INFO("Session destroyed for IP: %s", sessions[slot].ip.toString().c_str());
+        removeSlot(slot);
+        metricsInc(MC_SESSIONS_DESTROYED);
     }
-    return false;
 }
 
-void destroySession(const String& token) {
-    for (auto it = activeSessions.begin(); it != activeSessions.end(); ++it) {
-        if (it->token == token) {
-            LOG_INFO("Session destroyed for IP: %s", it->ip.toString().c_str());
-            activeSessions.erase(it);
+bool parseSessionCookie(const char* cookieHeader, uint8_t* tokenOut) {
+    static const char COOKIE_NAME[] = "session_token=";
+    static const size_t COOKIE_NAME_LEN = sizeof(COOKIE_NAME) - 1;
+
+    if (!cookieHeader) {
+        return false;
+    }
+
+    // Nazwa musi zaczynać cookie (początek nagłówka lub po "; ")
+    const char* p = cookieHeader;
+    while ((p = strstr(p, COOKIE_NAME)) != nullptr) {
+        if (p == cookieHeader || p[-1] == ' ' || p[-1] == ';') {
             break;
         }
+        p += COOKIE_NAME_LEN;
+    }
+    if (!p) {
+        return false;
     }
+    p += COOKIE_NAME_LEN;
+
+    // hexNibble('\0') == -1, więc krótsza wartość kończy się bez czytania poza bufor
+    for (size_t i = 0; i < SESSION_TOKEN_BYTES; i++) {
+        int hi = hexNibble(p[i * 2]);
+        if (hi < 0) return false;
+        int lo = hexNibble(p[i * 2 + 1]);
+        if (lo < 0) return false;
+        tokenOut[i] = (uint8_t)((hi << 4) | lo);
+    }
+
+    char end = p[SESSION_TOKEN_HEX_LEN];
+    return end == '\0' || end == ';' || end == ' ';
 }
 
 // ✅ New diagnostic function for monitoring
 void getSessionStats(size_t& totalSessions, size_t& maxSessions) {
-    totalSessions = activeSessions.size();
+    totalSessions = sessionCount;
     maxSessions = MAX_TOTAL_SESSIONS;
-}
\ No newline at end of file
+}
@@ -1,26 +1,45 @@
-
 #ifndef SESSION_MANAGER_H
 #define SESSION_MANAGER_H
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <vector>
+
+// Binary session token (128 bit) - hex-encoded only in the cookie
+#define SESSION_TOKEN_BYTES     16
+#define SESSION_TOKEN_HEX_LEN   (SESSION_TOKEN_BYTES * 2)
 
 struct Session {
-    String token;
+    uint8_t token[SESSION_TOKEN_BYTES];
+    uint32_t tokenHash;         // Klucz w tablicy hashującej
+    uint16_t generation;        // Zmienia się przy każdym zwolnieniu slotu
     IPAddress ip;
     unsigned long createdAt;
     unsigned long lastActivity;
     bool isValid;
 };
 
+// Handle to a validated session slot (used by per-connection auth cache)
+struct SessionRef {
+    int8_t slot;
+    uint16_t generation;
+};
+
 void initSessionManager();
 void updateSessionManager();
 String createSession(IPAddress ip);
-bool validateSession(const String& token, IPAddress ip);
-void destroySession(const String& token);
+
+// Hot path: binary token lookup (hashed, constant-time compare, no allocation)
+bool validateSessionToken(const uint8_t* token, IPAddress ip, SessionRef* ref = nullptr);
+bool touchSession(const SessionRef& ref, IPAddress ip);
+void destroySessionToken(const uint8_t* token);
+
+// Zero-copy "session_token=<hex>" extraction from a Cookie header
+bool parseSessionCookie(const char* cookieHeader, uint8_t* tokenOut);
+
+// Snapshot active sessions to RTC memory right before ESP.restart()
+void persistSessionsForRestart();
 
 // ✅ FIX 3: Add session statistics function
 void getSessionStats(size_t& totalSessions, size_t& maxSessions);
 
-#endif
\ No newline at end of file
+#endif
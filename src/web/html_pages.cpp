@@ -1308,17 +1308,22 @@ const char* DASHBOARD_HTML = R"rawliteral(
         }
 
         // ============================================
-        // EXTENDED PUMP (Calibration) — uses direct pump
+        // EXTENDED PUMP (Calibration) — arbiter, CALIBRATION source
         // ============================================
         function triggerExtendedPump() {
             const btn = document.getElementById("extendedBtn");
             btn.disabled = true;
             btn.textContent = "Starting...";
 
-            fetch("api/pump/direct-on", { method: "POST" })
+            fetch("api/pump/manual", {
+                method: "POST",
+                headers: {"Content-Type": "application/x-www-form-urlencoded"},
+                body: "mode=calibration"
+            })
                 .then((response) => response.json())
                 .then((data) => {
                     if (!data.success) console.error("Failed to start calibration pump");
+                    else if (data.result === "QUEUED") console.log("Calibration pump queued");
                 })
                 .catch((e) => console.error("Calibration pump error:", e))
                 .finally(() => {
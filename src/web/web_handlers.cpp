@@ -5,13 +5,33 @@
 #include "../security/auth_manager.h"
 #include "../security/session_manager.h"
 #include "../security/rate_limiter.h"
+#include "../hardware/hardware_pins.h"
 #include "../hardware/pump_controller.h"
+#include "../hardware/pump_usage.h"
 #include "../hardware/water_sensors.h"
 #include "../hardware/rtc_controller.h"
 #include "../network/wifi_manager.h"
 #include "../config/config.h"
 #include "../core/logging.h"
+#include "../core/metrics.h"
+#include "../core/profiler.h"
+#include "../core/trace.h"
+#include <memory>
+#include "../core/task_manager.h"
+#include "../core/control_commands.h"
+#include "../core/power_manager.h"
+#include "../hardware/storage_queue.h"
+#include "../hardware/sensor_edges.h"
+#include "../hardware/sensor_filter.h"
+#include "../algorithm/debounce_profile.h"
+#include "../algorithm/flow_calibration.h"
+#include "../algorithm/dose_sizing.h"
+#include "../algorithm/evaporation_model.h"
+#include "../algorithm/anomaly_detector.h"
+#include "../algorithm/cycle_aggregates.h"
+#include "../algorithm/consumption_archive.h"
 #include <ArduinoJson.h>
+#include <esp_timer.h>
 #include "../config/credentials_manager.h"
 #include "../algorithm/water_algorithm.h"
 
@@ -76,6 +96,7 @@ void handleLogin(AsyncWebServerRequest* request) {
     String password = request->getParam("password", true)->value();
     
     if (verifyPassword(password)) {
+        recordSuccessfulAuth(clientIP);
         String token = createSession(clientIP);
         String cookie = "session_token=" + token + "; Path=/; HttpOnly; Max-Age=" + String(SESSION_TIMEOUT_MS / 1000);
         
@@ -101,15 +122,9 @@ void handleLogin(AsyncWebServerRequest* request) {
 
 void handleLogout(AsyncWebServerRequest* request) {
     if (request->hasHeader("Cookie")) {
-        String cookie = request->getHeader("Cookie")->value();
-        int tokenStart = cookie.indexOf("session_token=");
-        if (tokenStart != -1) {
-            tokenStart += 14;
-            int tokenEnd = cookie.indexOf(";", tokenStart);
-            if (tokenEnd == -1) tokenEnd = cookie.length();
-            
-            String token = cookie.substring(tokenStart, tokenEnd);
-            destroySession(token);
+        uint8_t token[SESSION_TOKEN_BYTES];
+        if (parseSessionCookie(request->getHeader("Cookie")->value().c_str(), token)) {
+            destroySessionToken(token);
         }
     }
     
@@ -118,22 +133,58 @@ void handleLogout(AsyncWebServerRequest* request) {
     request->send(response);
 }
 
+// Opcjonalny parametr kanału (?channel=N w query lub body), domyślnie 0.
+// Dla kanału spoza WATER_CHANNEL_COUNT wysyła 400 i zwraca false.
+static bool parseChannelParam(AsyncWebServerRequest* request, uint8_t& channel) {
+    channel = 0;
+    String value;
+    if (request->hasParam("channel", true)) {
+        value = request->getParam("channel", true)->value();
+    } else if (request->hasParam("channel")) {
+        value = request->getParam("channel")->value();
+    } else {
+        return true;
+    }
+
+    bool valid = value.length() > 0 && value.length() <= 2;
+    for (size_t i = 0; valid && i < value.length(); i++) {
+        valid = value[i] >= '0' && value[i] <= '9';
+    }
+    if (!valid || value.toInt() >= WATER_CHANNEL_COUNT) {
+        request->send(400, "application/json", "{\"success\":false,\"error\":\"Invalid channel\"}");
+        return false;
+    }
+    channel = (uint8_t)value.toInt();
+    return true;
+}
+
 void handleStatus(AsyncWebServerRequest* request) {
     if (!checkAuthentication(request)) {
         request->send(401, "text/plain", "Unauthorized");
         return;
     }
+
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+    WaterAlgorithm& algorithm = getWaterChannel(channel);
+    PumpChannel& pump = getPumpChannel(channel);
+    SensorChannel& sensors = getSensorChannel(channel);
     
     JsonDocument json;
+    json["channel"] = channel;
     
     // ============================================
     // HARDWARE STATUS (for badges)
     // ============================================
-    json["sensor1_active"] = readWaterSensor1();
-    json["sensor2_active"] = readWaterSensor2();
-    json["pump_active"] = isPumpActive();
-    json["pump_attempt"] = waterAlgorithm.getPumpAttempts();
-    json["system_error"] = (waterAlgorithm.getState() == STATE_ERROR);
+    json["sensor1_active"] = sensors.readSensor(0);
+    json["sensor2_active"] = sensors.readSensor(1);
+    json["sensor_count"] = WATER_SENSOR_COUNT;
+    json["sensors_low_mask"] = sensors.readLowMask();
+    json["pump_active"] = pump.isActive();
+    json["pump_attempt"] = algorithm.getPumpAttempts();
+    json["system_error"] = (algorithm.getState() == STATE_ERROR);
     
     // ============================================
     // SYSTEM DISABLE STATUS (NEW)
@@ -144,15 +195,15 @@ void handleStatus(AsyncWebServerRequest* request) {
     // ============================================
     // PROCESS STATUS (for description + remaining time)
     // ============================================
-    json["state_description"] = waterAlgorithm.getStateDescription();
-    json["remaining_seconds"] = waterAlgorithm.getRemainingSeconds();
+    json["state_description"] = algorithm.getStateDescription();
+    json["remaining_seconds"] = algorithm.getRemainingSeconds();
     
     // ============================================
     // EXISTING STATUS FIELDS
     // ============================================
-    json["water_status"] = getWaterStatus();
-    json["pump_running"] = isPumpActive();  // kept for backwards compatibility
-    json["pump_remaining"] = getPumpRemainingTime();  // kept for backwards compatibility
+    json["water_status"] = getWaterStatus(channel);
+    json["pump_running"] = pump.isActive();  // kept for backwards compatibility
+    json["pump_remaining"] = pump.getRemainingTime();  // kept for backwards compatibility
     json["wifi_status"] = getWiFiStatus();
     json["wifi_connected"] = isWiFiConnected();
     json["rtc_time"] = getCurrentTimestamp();
@@ -182,12 +233,30 @@ void handleStatus(AsyncWebServerRequest* request) {
     request->send(200, "application/json", response);
 }
 
+// Polecenie nie zostało wykonane przez zadanie control (kolejka pełna / timeout).
+// Po timeoucie control odrzuca polecenie zamiast wykonać je później,
+// więc 503 znaczy "nie wykonano" i ponowienie jest bezpieczne.
+static bool rejectIfNotApplied(AsyncWebServerRequest* request, ControlCommandStatus status) {
+    if (status == CMD_STATUS_DONE) {
+        return false;
+    }
+    request->send(503, "application/json", status == CMD_STATUS_TIMEOUT
+        ? "{\"success\":false,\"error\":\"Control task timeout - not applied\"}"
+        : "{\"success\":false,\"error\":\"Control queue full\"}");
+    return true;
+}
+
 void handleDirectPumpOn(AsyncWebServerRequest* request) {
     if (!checkAuthentication(request)) {
         request->send(401, "text/plain", "Unauthorized");
         return;
     }
 
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+
     uint16_t duration = currentPumpSettings.manualCycleSeconds;
     String mode = "bistable";
     if (request->hasParam("mode", true) && request->getParam("mode", true)->value() == "monostable") {
@@ -195,10 +264,13 @@ void handleDirectPumpOn(AsyncWebServerRequest* request) {
         mode = "monostable";
     }
 
-    bool success = directPumpOn(duration);
+    ControlCommandResult result;
+    if (rejectIfNotApplied(request, runControlCommand(CMD_DIRECT_PUMP_ON, duration, &result, channel))) {
+        return;
+    }
 
     JsonDocument json;
-    json["success"] = success;
+    json["success"] = result.success;
     json["duration"] = duration;
     json["mode"] = mode;
 
@@ -213,7 +285,14 @@ void handleDirectPumpOff(AsyncWebServerRequest* request) {
         return;
     }
 
-    directPumpOff();
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+
+    if (rejectIfNotApplied(request, runControlCommand(CMD_DIRECT_PUMP_OFF, 0, nullptr, channel))) {
+        return;
+    }
 
     JsonDocument json;
     json["success"] = true;
@@ -228,8 +307,15 @@ void handlePumpStop(AsyncWebServerRequest* request) {
         request->send(401, "text/plain", "Unauthorized");
         return;
     }
+
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
     
-    stopPump();
+    if (rejectIfNotApplied(request, runControlCommand(CMD_PUMP_STOP, 0, nullptr, channel))) {
+        return;
+    }
     
     JsonDocument json;
     json["success"] = true;
@@ -239,7 +325,171 @@ void handlePumpStop(AsyncWebServerRequest* request) {
     serializeJson(json, response);
     request->send(200, "application/json", response);
     
-    LOG_INFO("Pump manually stopped via web");
+    LOG_INFO("Pump CH%d manually stopped via web", channel);
+}
+
+// Ręczna dawka (mode=normal, liczona do dziennej objętości) albo kalibracja
+// (mode=calibration) - przez arbiter, może trafić do kolejki
+void handlePumpManual(AsyncWebServerRequest* request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "text/plain", "Unauthorized");
+        return;
+    }
+
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+
+    ControlCommandType type = CMD_PUMP_MANUAL;
+    uint16_t duration = currentPumpSettings.manualCycleSeconds;
+    String mode = "normal";
+    if (request->hasParam("mode", true)) {
+        mode = request->getParam("mode", true)->value();
+        if (mode == "calibration") {
+            type = CMD_PUMP_CALIBRATION;
+            duration = currentPumpSettings.calibrationCycleSeconds;
+        } else if (mode != "normal") {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"mode must be normal or calibration\"}");
+            return;
+        }
+    }
+
+    ControlCommandResult result;
+    if (rejectIfNotApplied(request, runControlCommand(type, duration, &result, channel))) {
+        return;
+    }
+
+    JsonDocument json;
+    json["success"] = result.success;
+    json["result"] = getPumpRequestResultName((PumpRequestResult)result.value);
+    json["duration"] = duration;
+    json["mode"] = mode;
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+void handleGetPumpAudit(AsyncWebServerRequest* request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    PumpAuditEntry entries[PUMP_AUDIT_SIZE];
+    uint8_t count = copyPumpAudit(entries, PUMP_AUDIT_SIZE);
+    uint32_t now = millis();
+
+    JsonDocument json;
+    json["success"] = true;
+    json["total"] = getPumpAuditTotal();
+
+    JsonArray channels = json["channels"].to<JsonArray>();
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        PumpChannel& pump = getPumpChannel(ch);
+        JsonObject c = channels.add<JsonObject>();
+        c["channel"] = ch;
+        c["owner"] = getPumpSourceName(pump.getOwner());
+        c["remaining_ms"] = pump.getRemainingMs();
+        c["queued"] = pump.getQueuedCount();
+        c["cutoff"] = pump.hasCutoffTimer() ? "timer" : "tick";
+        c["cutoff_arm_failures"] = pump.getCutoffArmFailures();
+        c["last_run_source"] = getPumpSourceName(pump.getLastRunSource());
+        c["last_run_us"] = pump.getLastRunUs();
+        c["last_run_volume_ml"] = pump.getLastRunVolumeMl();
+    }
+
+    // Od najnowszego
+    JsonArray recent = json["recent"].to<JsonArray>();
+    for (uint8_t n = 0; n < count; n++) {
+        const PumpAuditEntry& e = entries[n];
+        JsonObject r = recent.add<JsonObject>();
+        r["age_ms"] = now - e.ms;
+        r["channel"] = e.channel;
+        r["action"] = getPumpAuditActionName(e.action);
+        r["source"] = getPumpSourceName(e.source);
+        r["other"] = getPumpSourceName(e.other);
+        r["reason"] = getPumpAuditReasonName(e.reason);
+        r["duration"] = e.durationSeconds;
+    }
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+void handleGetPumpUsage(AsyncWebServerRequest* request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+
+    PumpUsageStats usage = getPumpUsage(channel);
+    uint32_t nowUnix = getCachedUnixTimestamp();
+
+    JsonDocument json;
+    json["success"] = true;
+    json["channel"] = channel;
+    json["since"] = usage.sinceUnix;
+    json["starts"] = usage.totalStarts;
+    json["on_time_s"] = (uint32_t)(usage.totalOnMs / 1000);
+    json["longest_run_ms"] = usage.longestRunMs;
+    json["longest_run_source"] = getPumpSourceName(usage.longestRunSource);
+    json["mean_run_ms"] = usage.totalStarts ? (uint32_t)(usage.totalOnMs / usage.totalStarts) : 0;
+
+    JsonObject sources = json["sources"].to<JsonObject>();
+    for (uint8_t s = 0; s < PUMP_USAGE_SOURCES; s++) {
+        JsonObject item = sources[getPumpSourceName((PumpSource)s)].to<JsonObject>();
+        item["starts"] = usage.starts[s];
+        item["on_time_ms"] = usage.onMs[s];
+    }
+
+    // Od dziś wstecz; dziś = udział w dotychczasowej części doby
+    JsonArray days = json["duty"].to<JsonArray>();
+    if (usage.dutyValid) {
+        for (uint8_t d = 0; d < PUMP_DUTY_DAYS; d++) {
+            JsonObject item = days.add<JsonObject>();
+            item["day_start"] = (usage.dutyDay - d) * 86400UL;
+            item["on_time_ms"] = usage.dutyOnMs[d];
+            item["duty_permille"] = getPumpDutyPermille(usage, d, nowUnix);
+        }
+    }
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+void handleResetPumpUsage(AsyncWebServerRequest* request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    IPAddress clientIP = resolveClientIP(request);
+    if (isRateLimited(clientIP)) {
+        request->send(429, "application/json", "{\"success\":false,\"error\":\"Too many requests\"}");
+        return;
+    }
+
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+
+    if (rejectIfNotApplied(request, runControlCommand(CMD_RESET_PUMP_USAGE, 0, nullptr, channel))) {
+        return;
+    }
+
+    LOG_INFO("");
+    LOG_INFO("Pump usage CH%d reset from %s", channel, clientIP.toString().c_str());
+    request->send(200, "application/json", "{\"success\":true}");
 }
 
 void handlePumpSettings(AsyncWebServerRequest* request) {
@@ -247,12 +497,18 @@ void handlePumpSettings(AsyncWebServerRequest* request) {
         request->send(401, "text/plain", "Unauthorized");
         return;
     }
+
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
     
     if (request->method() == HTTP_GET) {
-        // Return current settings
+        // Return current settings (wydajność per kanał, cykle ręczne wspólne)
         JsonDocument json;
         json["success"] = true;
-        json["volume_per_second"] = currentPumpSettings.volumePerSecond;
+        json["channel"] = channel;
+        json["volume_per_second"] = getWaterChannel(channel).getVolumePerSecond();
         json["normal_cycle"] = currentPumpSettings.manualCycleSeconds;
         json["extended_cycle"] = currentPumpSettings.calibrationCycleSeconds;
         json["auto_mode"] = currentPumpSettings.autoModeEnabled;
@@ -275,16 +531,17 @@ void handlePumpSettings(AsyncWebServerRequest* request) {
             return;
         }
         
-        currentPumpSettings.volumePerSecond = newVolume;
-
-        // Save to NVS (non-volatile storage)
-        saveVolumeToNVS();
+        // Control zapisuje wartość przez kolejkę storage
+        if (rejectIfNotApplied(request, runControlCommandFloat(CMD_SET_VOLUME_PER_SECOND, newVolume, nullptr, channel))) {
+            return;
+        }
         
-        LOG_INFO("Volume per second updated to %.1f ml/s", newVolume);
+        LOG_INFO("Volume per second CH%d updated to %.1f ml/s", channel, newVolume);
         
         JsonDocument response;
         response["success"] = true;
-        response["volume_per_second"] = newVolume;
+        response["channel"] = channel;
+        response["volume_per_second"] = getWaterChannel(channel).getVolumePerSecond();
         response["message"] = "Volume per second updated successfully";
         
         String responseStr;
@@ -313,18 +570,21 @@ void handleSystemToggle(AsyncWebServerRequest* request) {
         request->send(200, "application/json", response);
 
     } else if (request->method() == HTTP_POST) {
-        bool currentlyDisabled = isSystemDisabled();
-        setSystemState(currentlyDisabled);  // toggle
+        ControlCommandResult result;
+        if (rejectIfNotApplied(request, runControlCommand(CMD_TOGGLE_SYSTEM, 0, &result))) {
+            return;
+        }
+        bool enabled = result.value != 0;
 
         JsonDocument json;
         json["success"] = true;
-        json["enabled"] = currentlyDisabled;  // was disabled → now enabled, and vice versa
+        json["enabled"] = enabled;
 
         String response;
         serializeJson(json, response);
         request->send(200, "application/json", response);
 
-        LOG_INFO("System %s via web interface", currentlyDisabled ? "ENABLED" : "DISABLED");
+        LOG_INFO("System %s via web interface", enabled ? "ENABLED" : "DISABLED");
     }
 }
 
@@ -357,14 +617,18 @@ void handlePumpToggle(AsyncWebServerRequest* request) {
         
     } else if (request->method() == HTTP_POST) {
         // Toggle pump state
-        setPumpGlobalState(!pumpGlobalEnabled);
+        ControlCommandResult result;
+        if (rejectIfNotApplied(request, runControlCommand(CMD_TOGGLE_PUMP_GLOBAL, 0, &result))) {
+            return;
+        }
+        bool enabled = result.value != 0;
         
         JsonDocument json;
         json["success"] = true;
-        json["enabled"] = pumpGlobalEnabled;
-        json["message"] = pumpGlobalEnabled ? "Pump enabled" : "Pump disabled for 30 minutes";
+        json["enabled"] = enabled;
+        json["message"] = enabled ? "Pump enabled" : "Pump disabled for 30 minutes";
         
-        if (!pumpGlobalEnabled) {
+        if (!enabled) {
             json["remaining_seconds"] = PUMP_AUTO_ENABLE_MS / 1000;
         } else {
             json["remaining_seconds"] = 0;
@@ -381,28 +645,28 @@ void handleResetStatistics(AsyncWebServerRequest* request) {
         request->send(401, "text/plain", "Unauthorized");
         return;
     }
-    
-    // Reset statistics
-    bool success = waterAlgorithm.resetErrorStatistics();
+
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+    // Reset przez control (kolejność z przyrostami kończącego się cyklu),
+    // zapis FRAM wykonuje zadanie storage
+    uint32_t resetTime = getCachedUnixTimestamp();
+    if (rejectIfNotApplied(request, runControlCommand(CMD_RESET_ERROR_STATS, resetTime, nullptr, channel))) {
+        return;
+    }
     
     JsonDocument json;
-    json["success"] = success;
-    json["message"] = success ? "Statistics reset successfully" : "Failed to reset statistics";
-    
-    if (success) {
-        // Get current timestamp for display
-        uint16_t gap1, gap2, water;
-        uint32_t resetTime;
-        if (waterAlgorithm.getErrorStatistics(gap1, gap2, water, resetTime)) {
-            json["reset_timestamp"] = resetTime;
-        }
-    }
+    json["success"] = true;
+    json["message"] = "Statistics reset successfully";
+    json["reset_timestamp"] = resetTime;
     
     String response;
     serializeJson(json, response);
-    request->send(success ? 200 : 500, "application/json", response);
+    request->send(200, "application/json", response);
     
-    LOG_INFO("Statistics reset requested via web interface - success: %s", success ? "true" : "false");
+    LOG_INFO("Statistics reset requested via web interface");
 }
 
 void handleGetStatistics(AsyncWebServerRequest* request) {
@@ -410,11 +674,17 @@ void handleGetStatistics(AsyncWebServerRequest* request) {
         request->send(401, "text/plain", "Unauthorized");
         return;
     }
+
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+    WaterAlgorithm& algorithm = getWaterChannel(channel);
     
     // Get current statistics
     uint16_t gap1_sum, gap2_sum, water_sum;
     uint32_t last_reset;
-    bool success = waterAlgorithm.getErrorStatistics(gap1_sum, gap2_sum, water_sum, last_reset);
+    bool success = algorithm.getErrorStatistics(gap1_sum, gap2_sum, water_sum, last_reset);
     
     JsonDocument json;
     json["success"] = success;
@@ -440,6 +710,117 @@ void handleGetStatistics(AsyncWebServerRequest* request) {
     request->send(success ? 200 : 500, "application/json", response);
 }
 
+void handleGetAggregates(AsyncWebServerRequest* request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    uint32_t now = getCachedUnixTimestamp();
+
+    JsonDocument json;
+    json["success"] = true;
+    json["timestamp"] = now;
+
+    for (uint8_t w = 0; w < AGG_WINDOW_COUNT; w++) {
+        AggregateSummary s = getAggregateSummary((AggregateWindow)w, now);
+        JsonObject win = json[getAggregateWindowName((AggregateWindow)w)].to<JsonObject>();
+
+        win["window_seconds"] = s.windowSeconds;
+        win["from"] = s.from;
+        win["cycles"] = s.cycles;
+        win["cycles_per_day"] = s.cycles * 86400.0f / s.windowSeconds;
+        win["clean"] = s.clean;
+        win["success_rate"] = s.cycles > 0 ? (float)s.clean / s.cycles : 0.0f;
+        win["retries"] = s.retries;
+
+        JsonObject fails = win["failures"].to<JsonObject>();
+        fails["pump"] = s.pumpFailures;
+        fails["gap1"] = s.gap1Fails;
+        fails["release"] = s.releaseFails;
+        fails["water"] = s.waterFails;
+        fails["false_trigger"] = s.falseTriggers;
+
+        for (uint8_t k = 0; k < AGG_SERIES_COUNT; k++) {
+            JsonObject stat = win[getAggregateSeriesName((AggregateSeries)k)].to<JsonObject>();
+            stat["count"] = s.count[k];
+            stat["sum"] = s.sum[k];
+            stat["min"] = s.min[k];
+            stat["max"] = s.max[k];
+            stat["mean"] = s.count[k] > 0 ? (float)s.sum[k] / s.count[k] : 0.0f;
+        }
+    }
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+// GET /api/archive?resolution=half_hour|day|week (domyślnie day)
+// Kolumny od najstarszego kubełka; null = brak danych (urządzenie nie działało)
+void handleGetArchive(AsyncWebServerRequest* request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    ArchiveResolution resolution = ARCHIVE_DAY;
+    if (request->hasParam("resolution")) {
+        String value = request->getParam("resolution")->value();
+        bool found = false;
+        for (uint8_t r = 0; r < ARCHIVE_RESOLUTION_COUNT; r++) {
+            if (value == getArchiveResolutionName((ArchiveResolution)r)) {
+                resolution = (ArchiveResolution)r;
+                found = true;
+            }
+        }
+        if (!found) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"Unknown resolution\"}");
+            return;
+        }
+    }
+
+    uint32_t now = getCachedUnixTimestamp();
+    static ArchiveBucket archive[FRAM_ARCHIVE_BUCKETS];     // async_tcp: jeden handler naraz
+    uint8_t count = getArchiveBuckets(resolution, now, archive, FRAM_ARCHIVE_BUCKETS);
+
+    JsonDocument json;
+    json["success"] = true;
+    json["resolution"] = getArchiveResolutionName(resolution);
+    json["bucket_seconds"] = getArchiveBucketSeconds(resolution);
+    json["count"] = count;
+
+    JsonArray start = json["start"].to<JsonArray>();
+    JsonArray autoMl = json["auto_ml"].to<JsonArray>();
+    JsonArray manualMl = json["manual_ml"].to<JsonArray>();
+    JsonArray cycles = json["cycles"].to<JsonArray>();
+    JsonArray errors = json["errors"].to<JsonArray>();
+
+    uint32_t totalMl = 0;
+    for (uint8_t n = 0; n < count; n++) {
+        const ArchiveBucket& b = archive[n];
+        if (b.period == 0) {
+            start.add(nullptr);
+            autoMl.add(nullptr);
+            manualMl.add(nullptr);
+            cycles.add(nullptr);
+            errors.add(nullptr);
+            continue;
+        }
+        start.add(getArchiveBucketStart(resolution, b.period));
+        autoMl.add(b.autoMl);
+        manualMl.add(b.manualMl);
+        cycles.add(b.cycles);
+        errors.add(b.errors);
+        totalMl += b.autoMl + b.manualMl;
+    }
+    json["total_ml"] = totalMl;
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
 // ========================================
 // DAILY VOLUME HANDLERS
 // ========================================
@@ -450,11 +831,17 @@ void handleGetDailyVolume(AsyncWebServerRequest* request) {
         return;
     }
 
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+    WaterAlgorithm& algorithm = getWaterChannel(channel);
+
     String response = "{";
     response += "\"success\":true,";
-    response += "\"daily_volume\":" + String(waterAlgorithm.getDailyVolume()) + ",";
-    response += "\"max_volume\":" + String(waterAlgorithm.getFillWaterMax()) + ",";
-    response += "\"last_reset_utc_day\":" + String(waterAlgorithm.getLastResetUTCDay());
+    response += "\"daily_volume\":" + String(algorithm.getDailyVolume()) + ",";
+    response += "\"max_volume\":" + String(algorithm.getFillWaterMax()) + ",";
+    response += "\"last_reset_utc_day\":" + String(algorithm.getLastResetUTCDay());
     response += "}";
 
     request->send(200, "application/json", response);
@@ -475,16 +862,25 @@ void handleResetDailyVolume(AsyncWebServerRequest* request) {
         return;
     }
 
-    LOG_INFO("Daily volume reset requested from %s", clientIP.toString().c_str());
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+    WaterAlgorithm& algorithm = getWaterChannel(channel);
+
+    LOG_INFO("Daily volume reset CH%d requested from %s", channel, clientIP.toString().c_str());
     
     // Perform reset
-    bool success = waterAlgorithm.resetDailyVolume();
+    ControlCommandResult result;
+    if (rejectIfNotApplied(request, runControlCommand(CMD_RESET_DAILY_VOLUME, 0, &result, channel))) {
+        return;
+    }
     
-    if (success) {
+    if (result.success) {
         String response = "{";
         response += "\"success\":true,";
-        response += "\"daily_volume\":" + String(waterAlgorithm.getDailyVolume()) + ",";
-        response += "\"last_reset_utc_day\":" + String(waterAlgorithm.getLastResetUTCDay());
+        response += "\"daily_volume\":" + String(algorithm.getDailyVolume()) + ",";
+        response += "\"last_reset_utc_day\":" + String(algorithm.getLastResetUTCDay());
         response += "}";
         
         request->send(200, "application/json", response);
@@ -506,11 +902,17 @@ void handleGetAvailableVolume(AsyncWebServerRequest* request) {
         return;
     }
 
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+    WaterAlgorithm& algorithm = getWaterChannel(channel);
+
     String response = "{";
     response += "\"success\":true,";
-    response += "\"max_ml\":" + String(waterAlgorithm.getAvailableVolumeMax()) + ",";
-    response += "\"current_ml\":" + String(waterAlgorithm.getAvailableVolumeCurrent()) + ",";
-    response += "\"is_empty\":" + String(waterAlgorithm.isAvailableVolumeEmpty() ? "true" : "false");
+    response += "\"max_ml\":" + String(algorithm.getAvailableVolumeMax()) + ",";
+    response += "\"current_ml\":" + String(algorithm.getAvailableVolumeCurrent()) + ",";
+    response += "\"is_empty\":" + String(algorithm.isAvailableVolumeEmpty() ? "true" : "false");
     response += "}";
 
     request->send(200, "application/json", response);
@@ -522,6 +924,12 @@ void handleSetAvailableVolume(AsyncWebServerRequest* request) {
         return;
     }
 
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+    WaterAlgorithm& algorithm = getWaterChannel(channel);
+
     if (!request->hasParam("value", true)) {
         request->send(400, "application/json", "{\"success\":false,\"error\":\"Missing value parameter\"}");
         return;
@@ -534,12 +942,14 @@ void handleSetAvailableVolume(AsyncWebServerRequest* request) {
         return;
     }
     
-    waterAlgorithm.setAvailableVolume(value);
+    if (rejectIfNotApplied(request, runControlCommand(CMD_SET_AVAILABLE_VOLUME, value, nullptr, channel))) {
+        return;
+    }
     
     String response = "{";
     response += "\"success\":true,";
-    response += "\"max_ml\":" + String(waterAlgorithm.getAvailableVolumeMax()) + ",";
-    response += "\"current_ml\":" + String(waterAlgorithm.getAvailableVolumeCurrent());
+    response += "\"max_ml\":" + String(algorithm.getAvailableVolumeMax()) + ",";
+    response += "\"current_ml\":" + String(algorithm.getAvailableVolumeCurrent());
     response += "}";
     
     request->send(200, "application/json", response);
@@ -551,12 +961,20 @@ void handleRefillAvailableVolume(AsyncWebServerRequest* request) {
         return;
     }
 
-    waterAlgorithm.refillAvailableVolume();
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+    WaterAlgorithm& algorithm = getWaterChannel(channel);
+
+    if (rejectIfNotApplied(request, runControlCommand(CMD_REFILL_AVAILABLE_VOLUME, 0, nullptr, channel))) {
+        return;
+    }
     
     String response = "{";
     response += "\"success\":true,";
-    response += "\"max_ml\":" + String(waterAlgorithm.getAvailableVolumeMax()) + ",";
-    response += "\"current_ml\":" + String(waterAlgorithm.getAvailableVolumeCurrent());
+    response += "\"max_ml\":" + String(algorithm.getAvailableVolumeMax()) + ",";
+    response += "\"current_ml\":" + String(algorithm.getAvailableVolumeCurrent());
     response += "}";
     
     request->send(200, "application/json", response);
@@ -572,9 +990,15 @@ void handleGetFillWaterMax(AsyncWebServerRequest* request) {
         return;
     }
 
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+    WaterAlgorithm& algorithm = getWaterChannel(channel);
+
     String response = "{";
     response += "\"success\":true,";
-    response += "\"fill_water_max\":" + String(waterAlgorithm.getFillWaterMax());
+    response += "\"fill_water_max\":" + String(algorithm.getFillWaterMax());
     response += "}";
 
     request->send(200, "application/json", response);
@@ -586,6 +1010,12 @@ void handleSetFillWaterMax(AsyncWebServerRequest* request) {
         return;
     }
 
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+    WaterAlgorithm& algorithm = getWaterChannel(channel);
+
     if (!request->hasParam("value", true)) {
         request->send(400, "application/json", "{\"success\":false,\"error\":\"Missing value parameter\"}");
         return;
@@ -598,11 +1028,13 @@ void handleSetFillWaterMax(AsyncWebServerRequest* request) {
         return;
     }
     
-    waterAlgorithm.setFillWaterMax(value);
+    if (rejectIfNotApplied(request, runControlCommand(CMD_SET_FILL_WATER_MAX, value, nullptr, channel))) {
+        return;
+    }
 
     String response = "{";
     response += "\"success\":true,";
-    response += "\"fill_water_max\":" + String(waterAlgorithm.getFillWaterMax());
+    response += "\"fill_water_max\":" + String(algorithm.getFillWaterMax());
     response += "}";
 
     request->send(200, "application/json", response);
@@ -620,12 +1052,18 @@ void handleGetCycleHistory(AsyncWebServerRequest* request) {
         return;
     }
 
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+    WaterAlgorithm& algorithm = getWaterChannel(channel);
+
     if (framBusy) {
         request->send(503, "application/json", "{\"success\":false,\"error\":\"System busy\"}");
         return;
     }
 
-    const std::vector<PumpCycle>& cycles = waterAlgorithm.getCycleHistory();
+    const std::vector<PumpCycle>& cycles = algorithm.getCycleHistory();
 
     JsonDocument doc;
     doc["success"] = true;
@@ -688,11 +1126,21 @@ void handleSystemReset(AsyncWebServerRequest* request) {
         return;
     }
 
-    bool success = waterAlgorithm.resetSystem();
+    uint8_t channel;
+    if (!parseChannelParam(request, channel)) {
+        return;
+    }
+    WaterAlgorithm& algorithm = getWaterChannel(channel);
+
+    ControlCommandResult result;
+    if (rejectIfNotApplied(request, runControlCommand(CMD_SYSTEM_RESET, 0, &result, channel))) {
+        return;
+    }
+    bool success = result.success;
 
     JsonDocument json;
     json["success"] = success;
-    json["state"] = waterAlgorithm.getStateString();
+    json["state"] = algorithm.getStateString();
     json["message"] = success ? "System reset to IDLE" : "Reset blocked - logging in progress";
 
     String response;
@@ -700,6 +1148,66 @@ void handleSystemReset(AsyncWebServerRequest* request) {
     request->send(200, "application/json", response);
 }
 
+// ===============================
+// CHANNELS HANDLER
+// ===============================
+
+void handleGetChannels(AsyncWebServerRequest* request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "text/plain", "Unauthorized");
+        return;
+    }
+
+    static const uint8_t pumpPins[WATER_CHANNEL_MAX] = CHANNEL_PUMP_PINS;
+    static const uint8_t sensorPins[] = CHANNEL_SENSOR_PINS;
+
+    JsonDocument json;
+    json["success"] = true;
+    json["count"] = WATER_CHANNEL_COUNT;
+    json["sensors_per_channel"] = WATER_SENSOR_COUNT;
+
+    JsonObject vote = json["vote"].to<JsonObject>();
+    vote["trigger"] = getSensorVotePolicyName(SENSOR_TRIGGER_VOTE);
+    vote["debounce"] = getSensorVotePolicyName(SENSOR_DEBOUNCE_VOTE);
+    vote["release"] = getSensorVotePolicyName(SENSOR_RELEASE_VOTE);
+    vote["k"] = SENSOR_VOTE_K;
+
+    JsonArray arr = json["channels"].to<JsonArray>();
+    for (uint8_t ch = 0; ch < WATER_CHANNEL_COUNT; ch++) {
+        WaterAlgorithm& algorithm = getWaterChannel(ch);
+        PumpChannel& pump = getPumpChannel(ch);
+        SensorChannel& sensors = getSensorChannel(ch);
+
+        JsonObject obj = arr.add<JsonObject>();
+        obj["channel"] = ch;
+        obj["state"] = algorithm.getStateString();
+        obj["phase"] = sensors.getPhaseString();
+        obj["system_error"] = (algorithm.getState() == STATE_ERROR);
+        obj["sensor1_active"] = sensors.readSensor(0);
+        obj["sensor2_active"] = sensors.readSensor(1);
+        obj["sensors_low_mask"] = sensors.readLowMask();
+        obj["pump_active"] = pump.isActive();
+        obj["pump_remaining"] = pump.getRemainingTime();
+        obj["daily_volume"] = algorithm.getDailyVolume();
+        obj["fill_water_max"] = algorithm.getFillWaterMax();
+        obj["available_ml"] = algorithm.getAvailableVolumeCurrent();
+        obj["volume_per_second"] = algorithm.getVolumePerSecond();
+        obj["pump_pin"] = pumpPins[ch];
+        obj["sensor1_pin"] = sensorPins[ch * WATER_SENSOR_COUNT];
+        if (WATER_SENSOR_COUNT > 1) {
+            obj["sensor2_pin"] = sensorPins[ch * WATER_SENSOR_COUNT + 1];
+        }
+        JsonArray pins = obj["sensor_pins"].to<JsonArray>();
+        for (uint8_t i = 0; i < WATER_SENSOR_COUNT; i++) {
+            pins.add(sensorPins[ch * WATER_SENSOR_COUNT + i]);
+        }
+    }
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
 // ===============================
 // HEALTH CHECK HANDLER
 // ===============================
@@ -718,4 +1226,453 @@ void handleHealth(AsyncWebServerRequest *request) {
     json += "}";
 
     request->send(200, "application/json", json);
-}
\ No newline at end of file
+}
+
+void handleMetrics(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "text/plain", "Unauthorized");
+        return;
+    }
+
+    AsyncResponseStream* response = request->beginResponseStream("text/plain; version=0.0.4");
+    writeMetricsPrometheus(*response);
+    request->send(response);
+}
+
+void handleGetProfiler(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    JsonDocument json;
+    json["success"] = true;
+    json["enabled"] = isProfilerEnabled();
+    json["budget_us"] = LOOP_TICK_BUDGET_US;
+    json["budget_overruns"] = getProfileBudgetOverruns();
+
+    JsonObject sections = json["sections"].to<JsonObject>();
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+        ProfileSection section = (ProfileSection)i;
+        const ProfileStats& stats = getProfileStats(section);
+        JsonObject entry = sections[getProfileSectionName(section)].to<JsonObject>();
+        entry["count"] = stats.count;
+        entry["min_us"] = stats.count ? stats.minUs : 0;
+        entry["avg_us"] = stats.count ? (uint32_t)(stats.sumUs / stats.count) : 0;
+        entry["max_us"] = stats.maxUs;
+        entry["max_at_ms"] = stats.maxAtMs;
+        entry["p50_us"] = getProfilePercentile(section, 50);
+        entry["p90_us"] = getProfilePercentile(section, 90);
+        entry["p99_us"] = getProfilePercentile(section, 99);
+    }
+
+    const ProfileWorstTick& worst = getProfileWorstTick();
+    JsonObject worstJson = json["worst_tick"].to<JsonObject>();
+    worstJson["total_us"] = worst.totalUs;
+    worstJson["at_ms"] = worst.atMs;
+    for (int i = PROF_SENSORS; i < PROF_TICK; i++) {
+        worstJson[getProfileSectionName((ProfileSection)i)] = worst.sectionUs[i];
+    }
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+void handleResetProfiler(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    resetProfiler();
+    request->send(200, "application/json", "{\"success\":true}");
+}
+
+void handleGetTrace(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    // Kursor żyje tyle co odpowiedź - zerwane połączenie też wznawia rejestrację
+    std::shared_ptr<TraceExport> cursor = std::make_shared<TraceExport>();
+    AsyncWebServerResponse* response = request->beginChunkedResponse("application/json",
+        [cursor](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            return cursor->fill(buffer, maxLen);
+        });
+    response->addHeader("Content-Disposition", "attachment; filename=\"trace.json\"");
+    request->send(response);
+}
+
+void handleClearTrace(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    clearTrace();
+    request->send(200, "application/json", "{\"success\":true}");
+}
+
+void handleGetTasks(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    JsonDocument json;
+    json["success"] = true;
+    json["storage_queue_depth"] = getStorageQueueDepth();
+    json["storage_queue_capacity"] = STORAGE_QUEUE_DEPTH;
+
+    JsonArray tasks = json["tasks"].to<JsonArray>();
+    for (int i = 0; i < SYSTEM_TASK_COUNT; i++) {
+        SystemTaskId id = (SystemTaskId)i;
+        JsonObject entry = tasks.add<JsonObject>();
+        entry["name"] = getSystemTaskName(id);
+        entry["running"] = isSystemTaskRunning(id);
+        entry["priority"] = getSystemTaskPriority(id);
+        entry["stack_bytes"] = getSystemTaskStackSize(id);
+        entry["stack_free_min_bytes"] = getSystemTaskStackFree(id);
+        entry["iterations"] = getSystemTaskIterations(id);
+    }
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+void handleGetPower(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    PowerStats power = getPowerStats();
+    // Poza zadaniami = idle task, WiFi, lwIP - nie jest to czas w uśpieniu
+    uint64_t outsideUs = power.uptimeUs > power.taskBusyUs ? power.uptimeUs - power.taskBusyUs : 0;
+
+    JsonDocument json;
+    json["success"] = true;
+    json["idle_mode_enabled"] = power.idleModeEnabled;
+    json["gpio_wake_armed"] = power.gpioWakeArmed;
+    json["uptime_ms"] = (uint32_t)(power.uptimeUs / 1000);
+    json["task_busy_ms"] = (uint32_t)(power.taskBusyUs / 1000);
+    json["outside_tasks_ms"] = (uint32_t)(outsideUs / 1000);
+    json["task_busy_permille"] = power.uptimeUs ? (uint32_t)(power.taskBusyUs * 1000 / power.uptimeUs) : 0;
+    json["idle_ticks"] = power.idleTicks;
+
+    JsonObject wakes = json["wakes"].to<JsonObject>();
+    for (int i = 0; i < POWER_WAKE_SOURCE_COUNT; i++) {
+        wakes[getPowerWakeSourceName((PowerWakeSource)i)] = power.wakes[i];
+    }
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+void handleGetSensorEdges(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    SensorEdge edges[SENSOR_EDGE_HISTORY];
+    uint8_t count = copySensorEdgeHistory(edges, SENSOR_EDGE_HISTORY);
+    uint32_t nowUs = (uint32_t)esp_timer_get_time();
+
+    JsonDocument json;
+    json["success"] = true;
+    json["dropped"] = getSensorEdgesDropped();
+    json["bounce_window_us"] = SENSOR_BOUNCE_WINDOW_US;
+    json["sampling_active"] = isSensorSamplingActive();
+    json["filter_window"] = SENSOR_FILTER_WINDOW;
+
+    JsonArray sensors = json["sensors"].to<JsonArray>();
+    for (uint8_t i = 0; i < WATER_SENSOR_TOTAL; i++) {
+        SensorEdgeStats stats = getSensorEdgeStats(i);
+        JsonObject s = sensors.add<JsonObject>();
+        s["channel"] = i / WATER_SENSOR_COUNT;
+        s["sensor"] = i % WATER_SENSOR_COUNT + 1;
+        s["low"] = stats.low;
+        s["edges"] = stats.edges;
+        s["bounces"] = stats.bounces;
+        s["min_interval_us"] = stats.edges > 1 ? stats.minIntervalUs : 0;
+        s["last_edge_age_ms"] = stats.edges ? (nowUs - stats.lastEdgeUs) / 1000 : 0;
+
+        SensorFilterStats filter = getSensorFilterStats(i);
+        s["filtered_low"] = filter.low;
+        s["raw_low"] = filter.rawLow;
+        s["low_samples"] = filter.lowSamples;
+        s["filter_flips"] = filter.flips;
+        s["raw_changes"] = filter.rawChanges;
+    }
+
+    // Od najnowszego
+    JsonArray recent = json["recent"].to<JsonArray>();
+    for (uint8_t n = 0; n < count; n++) {
+        JsonObject e = recent.add<JsonObject>();
+        e["channel"] = edges[n].sensor / WATER_SENSOR_COUNT;
+        e["sensor"] = edges[n].sensor % WATER_SENSOR_COUNT + 1;
+        e["level"] = edges[n].level ? "LOW" : "HIGH";
+        e["age_us"] = nowUs - edges[n].timestampUs;
+    }
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+void handleGetDebounceProfile(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    DebounceProfile profile = getDebounceProfile();
+    const DebounceSchedule& schedule = getDebounceSchedule();
+
+    JsonDocument json;
+    json["success"] = true;
+    json["adaptive"] = isAdaptiveDebounceActive();
+    json["noise_score"] = profile.noiseScore;
+    json["noise_score_max"] = NOISE_SCORE_MAX;
+
+    JsonObject sched = json["schedule"].to<JsonObject>();
+    sched["pre_qual_window"] = schedule.preQualWindow;
+    sched["pre_qual_interval"] = schedule.preQualInterval;
+    sched["pre_qual_confirm_count"] = schedule.preQualConfirmCount;
+    sched["settling_time"] = schedule.settlingTime;
+    sched["total_debounce_time"] = schedule.totalDebounceTime;
+    sched["debounce_interval"] = schedule.debounceInterval;
+    sched["debounce_counter"] = schedule.debounceCounter;
+
+    JsonObject stats = json["stats"].to<JsonObject>();
+    stats["processes"] = profile.processes;
+    stats["clean_passes"] = profile.cleanPasses;
+    stats["pre_qual_fails"] = profile.preQualFails;
+    stats["gap1_fails"] = profile.gap1Fails;
+    stats["false_triggers"] = profile.falseTriggers;
+    stats["counter_resets"] = profile.counterResets;
+    stats["bounces"] = profile.bounces;
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+void handleResetDebounceProfile(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    IPAddress clientIP = resolveClientIP(request);
+    if (isRateLimited(clientIP)) {
+        request->send(429, "application/json", "{\"success\":false,\"error\":\"Too many requests\"}");
+        return;
+    }
+
+    LOG_INFO("");
+    LOG_INFO("Debounce profile reset requested from %s", clientIP.toString().c_str());
+
+    if (rejectIfNotApplied(request, runControlCommand(CMD_RESET_DEBOUNCE_PROFILE, 0, nullptr))) {
+        return;
+    }
+    request->send(200, "application/json", "{\"success\":true}");
+}
+
+void handleGetFlowCalibration(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    FlowCalibrationStatus status = getFlowCalibrationStatus();
+
+    JsonDocument json;
+    json["success"] = true;
+    json["baseline_ready"] = status.baselineReady;
+    json["baseline_samples"] = status.baselineSamples;
+    json["baseline_required"] = FLOW_CAL_BASELINE_CYCLES;
+    json["samples"] = status.samples;
+    json["reference_volume_ml"] = status.referenceVolumeMl;
+    json["configured_rate"] = status.configuredRate;
+    json["estimated_rate"] = status.estimatedRate;
+    json["drift_percent"] = status.driftPercent;
+    json["drift_threshold_percent"] = FLOW_DRIFT_THRESHOLD_PERCENT;
+    json["drift_flag"] = status.driftFlag;
+    json["trend_percent_per_cycle"] = status.trendPercentPerCycle;
+    json["last_reaction_time"] = status.lastReactionTime;
+    json["auto_apply"] = status.autoApply;
+    json["applied"] = status.applied;
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+void handleGetDose(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    const DoseDecision& dose = getLastDoseDecision();
+
+    JsonDocument json;
+    json["success"] = true;
+    json["enabled"] = ENABLE_DOSE_SIZING;
+    json["consumption_ml_per_hour"] = getConsumptionRateMlPerHour();
+    json["min_dose_ml"] = SINGLE_DOSE_VOLUME;
+    json["max_dose_ml"] = DOSE_MAX_VOLUME;
+
+    JsonObject last = json["last"].to<JsonObject>();
+    last["volume_ml"] = dose.volumeMl;
+    last["pump_seconds"] = dose.pumpSeconds;
+    last["deficit_ml"] = dose.deficitMl;
+    last["release_floor_ml"] = dose.releaseFloorMl;
+    last["rate_ml_per_hour"] = dose.rateMlPerHour;
+    last["hours_since_refill"] = dose.hoursSinceRefill;
+    last["limited_by"] = dose.limitedBy;
+    last["rate_source"] = dose.rateSource;
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+void handleGetEvaporation(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    uint32_t now = getCachedUnixTimestamp();
+    uint32_t reservoir = waterAlgorithm.getAvailableVolumeCurrent();
+    EvaporationForecast forecast = getEvaporationForecast(now, reservoir);
+
+    JsonDocument json;
+    json["success"] = true;
+    json["ready"] = forecast.ready;
+    json["learned_hours"] = forecast.learnedHours;
+    json["required_hours"] = EVAP_MIN_LEARNED_HOURS;
+    json["daily_ml"] = forecast.dailyMl;
+    json["current_rate_ml_per_hour"] = forecast.currentRateMlPerHour;
+    json["typical_dose_ml"] = forecast.triggerDeficitMl;
+    json["last_refill"] = forecast.lastRefillUnix;
+    json["next_refill"] = forecast.nextRefillUnix;
+    json["next_refill_in_s"] = forecast.nextRefillUnix > now ? (int32_t)(forecast.nextRefillUnix - now) : 0;
+    json["prewarm"] = forecast.prewarm;
+    json["reservoir_ml"] = reservoir;
+    json["reservoir_empty"] = forecast.reservoirEmptyUnix;
+    json["reservoir_empty_in_h"] = forecast.reservoirEmptyUnix > now ?
+                                   (forecast.reservoirEmptyUnix - now) / 3600.0f : 0.0f;
+
+    JsonArray hourly = json["hourly_ml_per_hour"].to<JsonArray>();
+    for (uint8_t h = 0; h < 24; h++) {
+        float rate = getHourlyEvaporationRate(h);
+        if (rate < 0.0f) {
+            hourly.add(nullptr);
+        } else {
+            hourly.add(rate);
+        }
+    }
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+void handleGetAnomaly(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    JsonDocument json;
+    json["success"] = true;
+    json["enabled"] = ENABLE_ANOMALY_DETECTION;
+    json["active"] = isAnomalyActive();
+    json["signal"] = waterAlgorithm.isErrorSignalActive() && waterAlgorithm.getLastError() == ERROR_ANOMALY;
+    json["warmup_cycles"] = ANOMALY_WARMUP_CYCLES;
+    json["cusum_k"] = ANOMALY_CUSUM_K;
+    json["cusum_h"] = ANOMALY_CUSUM_H;
+
+    JsonArray list = json["series"].to<JsonArray>();
+    for (uint8_t s = 0; s < ANOMALY_SERIES_COUNT; s++) {
+        AnomalySeriesStatus status = getAnomalyStatus((AnomalySeries)s);
+        JsonObject item = list.add<JsonObject>();
+        item["name"] = status.name;
+        item["ready"] = status.ready;
+        item["samples"] = status.samples;
+        item["mean"] = status.mean;
+        item["sigma"] = status.sigma;
+        item["last"] = status.lastValue;
+        item["cusum_high"] = status.cusumHigh;
+        item["cusum_low"] = status.cusumLow;
+        item["alarm"] = status.alarm > 0 ? "up" : status.alarm < 0 ? "down" : "none";
+    }
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
+
+void handleAckAnomaly(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    IPAddress clientIP = resolveClientIP(request);
+    if (isRateLimited(clientIP)) {
+        request->send(429, "application/json", "{\"success\":false,\"error\":\"Too many requests\"}");
+        return;
+    }
+
+    if (rejectIfNotApplied(request, runControlCommand(CMD_ACK_ANOMALY, 0, nullptr))) {
+        return;
+    }
+
+    LOG_INFO("");
+    LOG_INFO("Anomaly alarms acknowledged from %s", clientIP.toString().c_str());
+    request->send(200, "application/json", "{\"success\":true}");
+}
+
+void handleApplyFlowCalibration(AsyncWebServerRequest *request) {
+    if (!checkAuthentication(request)) {
+        request->send(401, "application/json", "{\"success\":false,\"error\":\"Unauthorized\"}");
+        return;
+    }
+
+    IPAddress clientIP = resolveClientIP(request);
+    if (isRateLimited(clientIP)) {
+        request->send(429, "application/json", "{\"success\":false,\"error\":\"Too many requests\"}");
+        return;
+    }
+
+    ControlCommandResult result;
+    if (rejectIfNotApplied(request, runControlCommand(CMD_APPLY_FLOW_ESTIMATE, 0, &result))) {
+        return;
+    }
+
+    if (!result.success) {
+        request->send(400, "application/json", "{\"success\":false,\"error\":\"No flow estimate yet\"}");
+        return;
+    }
+
+    LOG_INFO("");
+    LOG_INFO("Flow estimate applied from %s: %.2f ml/s", clientIP.toString().c_str(),
+             currentPumpSettings.volumePerSecond);
+
+    JsonDocument json;
+    json["success"] = true;
+    json["volume_per_second"] = currentPumpSettings.volumePerSecond;
+
+    String response;
+    serializeJson(json, response);
+    request->send(200, "application/json", response);
+}
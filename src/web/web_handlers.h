@@ -22,6 +22,14 @@ void handlePumpStop(AsyncWebServerRequest *request);
 // Direct pump control (bypasses algorithm, system disable and daily limit)
 void handleDirectPumpOn(AsyncWebServerRequest *request);
 void handleDirectPumpOff(AsyncWebServerRequest *request);
+
+// Pump arbiter: manual/calibration request, decision audit trail
+void handlePumpManual(AsyncWebServerRequest *request);
+void handleGetPumpAudit(AsyncWebServerRequest *request);
+
+// Pump usage: lifetime on-time / starts / duty, reset after pump replacement
+void handleGetPumpUsage(AsyncWebServerRequest *request);
+void handleResetPumpUsage(AsyncWebServerRequest *request);
 void handlePumpSettings(AsyncWebServerRequest *request);
 
 // ============== SYSTEM TOGGLE ==============
@@ -34,6 +42,8 @@ void handlePumpToggle(AsyncWebServerRequest *request);
 // Statistics handlers
 void handleResetStatistics(AsyncWebServerRequest *request);
 void handleGetStatistics(AsyncWebServerRequest *request);
+void handleGetAggregates(AsyncWebServerRequest *request);   // Rolling 1h/24h/7d cycle aggregates
+void handleGetArchive(AsyncWebServerRequest *request);      // RRD consumption archive by resolution
 
 void handleGetDailyVolume(AsyncWebServerRequest *request);
 void handleResetDailyVolume(AsyncWebServerRequest *request);
@@ -53,7 +63,48 @@ void handleGetCycleHistory(AsyncWebServerRequest* request);
 // System reset (works from any state except LOGGING)
 void handleSystemReset(AsyncWebServerRequest *request);
 
+// Per-channel summary (state, sensors, pump, volumes); other endpoints take ?channel=N
+void handleGetChannels(AsyncWebServerRequest *request);
+
 // Health check endpoint (no session required)
 void handleHealth(AsyncWebServerRequest *request);
 
+// Prometheus text-format metrics
+void handleMetrics(AsyncWebServerRequest *request);
+
+// Loop profiler (per-subsystem timing, worst tick, budget overruns)
+void handleGetProfiler(AsyncWebServerRequest *request);
+void handleResetProfiler(AsyncWebServerRequest *request);
+
+// Chrome trace-event JSON (load in ui.perfetto.dev / chrome://tracing)
+void handleGetTrace(AsyncWebServerRequest *request);
+void handleClearTrace(AsyncWebServerRequest *request);
+
+// FreeRTOS system tasks (priority, stack high-water, iterations)
+void handleGetTasks(AsyncWebServerRequest *request);
+
+// Power: idle power save, task busy vs outside time, wake sources
+void handleGetPower(AsyncWebServerRequest *request);
+
+// Float sensor edges captured by interrupt (per-sensor stats + recent history)
+void handleGetSensorEdges(AsyncWebServerRequest *request);
+
+// Adaptive Phase 1 schedule: learned noise score, current schedule, statistics
+void handleGetDebounceProfile(AsyncWebServerRequest *request);
+void handleResetDebounceProfile(AsyncWebServerRequest *request);
+
+// Pump flow auto-calibration: estimate, drift flag, manual apply
+void handleGetFlowCalibration(AsyncWebServerRequest *request);
+void handleApplyFlowCalibration(AsyncWebServerRequest *request);
+
+// Deficit-proportional dose sizing: consumption rate, last dose decision
+void handleGetDose(AsyncWebServerRequest *request);
+
+// Evaporation model: hourly profile, next refill and reservoir depletion forecast
+void handleGetEvaporation(AsyncWebServerRequest *request);
+
+// Statistical drift detection (EWMA + CUSUM): series state, acknowledge alarm
+void handleGetAnomaly(AsyncWebServerRequest *request);
+void handleAckAnomaly(AsyncWebServerRequest *request);
+
 #endif
\ No newline at end of file
@@ -5,56 +5,165 @@
 #include "../security/rate_limiter.h"
 #include "../security/auth_manager.h"
 #include "../core/logging.h"
+#include "../core/metrics.h"
+#include "../core/trace.h"
+#include "../core/power_manager.h"
 
 AsyncWebServer server(80);
 
+// ============== PER-CONNECTION AUTH CACHE ==============
+// Keep-alive requests arrive on the same AsyncClient - once a session cookie
+// was validated on a connection, later requests only re-check the session slot
+struct ConnectionAuth {
+    const AsyncClient* client;
+    uint32_t ip;
+    uint16_t port;
+    SessionRef session;
+};
+
+static const uint8_t AUTH_CACHE_SIZE = 8;
+static ConnectionAuth authCache[AUTH_CACHE_SIZE];
+static uint8_t authCacheNext = 0;
+
+static ConnectionAuth* findCachedAuth(const AsyncClient* client, uint32_t ip, uint16_t port) {
+    for (uint8_t i = 0; i < AUTH_CACHE_SIZE; i++) {
+        // Port + IP check protects against AsyncClient pointer reuse by a new connection
+        if (authCache[i].client == client && authCache[i].ip == ip && authCache[i].port == port) {
+            return &authCache[i];
+        }
+    }
+    return nullptr;
+}
+
+static void cacheAuth(const AsyncClient* client, uint32_t ip, uint16_t port, const SessionRef& ref) {
+    ConnectionAuth* entry = findCachedAuth(client, ip, port);
+    if (!entry) {
+        entry = &authCache[authCacheNext];
+        authCacheNext = (authCacheNext + 1) % AUTH_CACHE_SIZE;
+    }
+    entry->client = client;
+    entry->ip = ip;
+    entry->port = port;
+    entry->session = ref;
+}
+
+// Rejestracja endpointu z pomiarem handlera (/metrics + span HTTP w trace).
+// path to literał - służy też jako nazwa spanu. Dławienie (i blokada IP)
+// odpowiada 429 przed handlerem - nie 401, które dashboard traktuje jak
+// wygasłą sesję, i bez liczenia jako nieudane uwierzytelnienie.
+static void route(const char* path, WebRequestMethodComposite method, ArRequestHandlerFunction handler) {
+    server.on(path, method, [path, handler](AsyncWebServerRequest* request) {
+        MetricTimer timer(MH_HTTP_HANDLER_US);
+        TRACE_SCOPE(TRACE_TRACK_HTTP, path);
+        metricsInc(MC_HTTP_REQUESTS);
+        if (isRateLimited(request->client()->remoteIP())) {
+            request->send(429, "application/json", "{\"success\":false,\"error\":\"Too many requests\"}");
+            return;
+        }
+        uint32_t startUs = micros();
+        handler(request);
+        powerAccountActive(micros() - startUs);
+    });
+}
+
 void initWebServer() {
+    for (uint8_t i = 0; i < AUTH_CACHE_SIZE; i++) {
+        authCache[i].client = nullptr;
+    }
+
     // Static pages
-    server.on("/", HTTP_GET, handleDashboard);
-    server.on("/login", HTTP_GET, handleLoginPage);
+    route("/", HTTP_GET, handleDashboard);
+    route("/login", HTTP_GET, handleLoginPage);
     
     // Authentication
-    server.on("/api/login", HTTP_POST, handleLogin);
-    server.on("/api/logout", HTTP_POST, handleLogout);
+    route("/api/login", HTTP_POST, handleLogin);
+    route("/api/logout", HTTP_POST, handleLogout);
     
     // API endpoints
-    server.on("/api/status", HTTP_GET, handleStatus);
-    server.on("/api/pump/direct-on", HTTP_POST, handleDirectPumpOn);
-    server.on("/api/pump/direct-off", HTTP_POST, handleDirectPumpOff);
-    server.on("/api/pump/stop", HTTP_POST, handlePumpStop);
-    server.on("/api/pump-settings", HTTP_GET | HTTP_POST, handlePumpSettings);
+    route("/api/status", HTTP_GET, handleStatus);
+    route("/api/pump/direct-on", HTTP_POST, handleDirectPumpOn);
+    route("/api/pump/direct-off", HTTP_POST, handleDirectPumpOff);
+    route("/api/pump/stop", HTTP_POST, handlePumpStop);
+    route("/api/pump/manual", HTTP_POST, handlePumpManual);
+    route("/api/pump/audit", HTTP_GET, handleGetPumpAudit);
+    route("/api/pump/usage", HTTP_GET, handleGetPumpUsage);
+    route("/api/pump/usage/reset", HTTP_POST, handleResetPumpUsage);
+    route("/api/pump-settings", HTTP_GET | HTTP_POST, handlePumpSettings);
     
     // ============== SYSTEM TOGGLE (NEW) ==============
     // Replaces pump-toggle with full system control
-    server.on("/api/system-toggle", HTTP_GET | HTTP_POST, handleSystemToggle);
+    route("/api/system-toggle", HTTP_GET | HTTP_POST, handleSystemToggle);
     
     // LEGACY - kept for compatibility, will be removed
-    server.on("/api/pump-toggle", HTTP_GET | HTTP_POST, handlePumpToggle);
+    route("/api/pump-toggle", HTTP_GET | HTTP_POST, handlePumpToggle);
     
     // Statistics endpoints
-    server.on("/api/reset-statistics", HTTP_POST, handleResetStatistics);
-    server.on("/api/get-statistics", HTTP_GET, handleGetStatistics);
+    route("/api/reset-statistics", HTTP_POST, handleResetStatistics);
+    route("/api/get-statistics", HTTP_GET, handleGetStatistics);
+    route("/api/aggregates", HTTP_GET, handleGetAggregates);
+    route("/api/archive", HTTP_GET, handleGetArchive);
 
-    server.on("/api/daily-volume", HTTP_GET, handleGetDailyVolume);
-    server.on("/api/reset-daily-volume", HTTP_POST, handleResetDailyVolume);
+    route("/api/daily-volume", HTTP_GET, handleGetDailyVolume);
+    route("/api/reset-daily-volume", HTTP_POST, handleResetDailyVolume);
 
     // 🆕 NEW: Available Volume endpoints
-    server.on("/api/available-volume", HTTP_GET, handleGetAvailableVolume);
-    server.on("/api/set-available-volume", HTTP_POST, handleSetAvailableVolume);
-    server.on("/api/refill-available-volume", HTTP_POST, handleRefillAvailableVolume);
+    route("/api/available-volume", HTTP_GET, handleGetAvailableVolume);
+    route("/api/set-available-volume", HTTP_POST, handleSetAvailableVolume);
+    route("/api/refill-available-volume", HTTP_POST, handleRefillAvailableVolume);
     
     // 🆕 NEW: Fill Water Max endpoints
-    server.on("/api/fill-water-max", HTTP_GET, handleGetFillWaterMax);
-    server.on("/api/set-fill-water-max", HTTP_POST, handleSetFillWaterMax);
+    route("/api/fill-water-max", HTTP_GET, handleGetFillWaterMax);
+    route("/api/set-fill-water-max", HTTP_POST, handleSetFillWaterMax);
 
     // Cycle History endpoint
-    server.on("/api/cycle-history", HTTP_GET, handleGetCycleHistory);
+    route("/api/cycle-history", HTTP_GET, handleGetCycleHistory);
 
     // System reset
-    server.on("/api/system-reset", HTTP_POST, handleSystemReset);
+    route("/api/system-reset", HTTP_POST, handleSystemReset);
+
+    // Water channels (per-channel summary)
+    route("/api/channels", HTTP_GET, handleGetChannels);
 
     // Health check endpoint (no session required)
-    server.on("/api/health", HTTP_GET, handleHealth);
+    route("/api/health", HTTP_GET, handleHealth);
+
+    // Prometheus scrape endpoint (VPS proxy or session)
+    route("/metrics", HTTP_GET, handleMetrics);
+
+    // Loop profiler
+    route("/api/profiler", HTTP_GET, handleGetProfiler);
+    route("/api/profiler/reset", HTTP_POST, handleResetProfiler);
+
+    // Span trace (Chrome/Perfetto JSON)
+    route("/api/debug/trace", HTTP_GET, handleGetTrace);
+    route("/api/debug/trace/clear", HTTP_POST, handleClearTrace);
+
+    // System tasks (stack high-water)
+    route("/api/tasks", HTTP_GET, handleGetTasks);
+
+    // Power (idle power save, task busy time, wake sources)
+    route("/api/power", HTTP_GET, handleGetPower);
+
+    // Sensor edges (interrupt capture, bounce statistics)
+    route("/api/sensor-edges", HTTP_GET, handleGetSensorEdges);
+
+    // Adaptive debounce schedule (learned profile in FRAM)
+    route("/api/debounce-profile", HTTP_GET, handleGetDebounceProfile);
+    route("/api/debounce-profile/reset", HTTP_POST, handleResetDebounceProfile);
+
+    // Pump flow auto-calibration
+    route("/api/flow-calibration", HTTP_GET, handleGetFlowCalibration);
+    route("/api/flow-calibration/apply", HTTP_POST, handleApplyFlowCalibration);
+
+    // Dose sizing (last decision, consumption rate)
+    route("/api/dose", HTTP_GET, handleGetDose);
+
+    // Evaporation model and forecasts
+    route("/api/evaporation", HTTP_GET, handleGetEvaporation);
+
+    // Anomaly detection (drift alarms, ERR4)
+    route("/api/anomaly", HTTP_GET, handleGetAnomaly);
+    route("/api/anomaly/ack", HTTP_POST, handleAckAnomaly);
 
     // 404 handler - also enforce whitelist
     server.onNotFound([](AsyncWebServerRequest* request) {
@@ -72,7 +181,8 @@ void initWebServer() {
 }
 
 bool checkAuthentication(AsyncWebServerRequest* request) {
-    IPAddress clientIP = request->client()->remoteIP();
+    AsyncClient* client = request->client();
+    IPAddress clientIP = client->remoteIP();
     
     // ============== TRUSTED PROXY CHECK (PRIORITY) ==============
     // VPS proxy requests skip all authentication
@@ -84,38 +194,43 @@ bool checkAuthentication(AsyncWebServerRequest* request) {
     // Only whitelisted IPs can access the system
     if (!isIPAllowed(clientIP)) {
         LOG_WARNING("IP %s not on whitelist - access denied", clientIP.toString().c_str());
+        metricsInc(MC_HTTP_AUTH_DENIED);
         return false;
     }
 
-    // Check if IP is blocked
+    // Check if IP is blocked (dławienie - 429 już w route())
     if (isIPBlocked(clientIP)) {
-        return false;
-    }
-    
-    // Check rate limiting
-    if (isRateLimited(clientIP)) {
-        recordFailedAttempt(clientIP);
+        metricsInc(MC_HTTP_AUTH_DENIED);
         return false;
     }
     
     recordRequest(clientIP);
+
+    // ============== CACHED VERDICT (keep-alive) ==============
+    uint16_t port = client->remotePort();
+    ConnectionAuth* cached = findCachedAuth(client, clientIP, port);
+    if (cached) {
+        if (touchSession(cached->session, clientIP)) {
+            recordSuccessfulAuth(clientIP);
+            return true;
+        }
+        cached->client = nullptr;  // Sesja wygasła / wylogowana - pełna weryfikacja
+    }
     
-    // Check session cookie
+    // Check session cookie (parsed in place, no String copies)
     if (request->hasHeader("Cookie")) {
-        String cookie = request->getHeader("Cookie")->value();
-        int tokenStart = cookie.indexOf("session_token=");
-        if (tokenStart != -1) {
-            tokenStart += 14;
-            int tokenEnd = cookie.indexOf(";", tokenStart);
-            if (tokenEnd == -1) tokenEnd = cookie.length();
-            
-            String token = cookie.substring(tokenStart, tokenEnd);
-            if (validateSession(token, clientIP)) {
-                return true;
-            }
+        uint8_t token[SESSION_TOKEN_BYTES];
+        SessionRef ref;
+        const String& cookie = request->getHeader("Cookie")->value();
+        if (parseSessionCookie(cookie.c_str(), token) &&
+            validateSessionToken(token, clientIP, &ref)) {
+            cacheAuth(client, clientIP, port, ref);
+            recordSuccessfulAuth(clientIP);
+            return true;
         }
     }
     
     recordFailedAttempt(clientIP);
+    metricsInc(MC_HTTP_AUTH_DENIED);
     return false;
-}
\ No newline at end of file
+}